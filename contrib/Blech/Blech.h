@@ -65,10 +65,13 @@ Using Blech:
 #pragma once
 //#pragma warning(disable : 4996)
 
-#define BLECHVERSION "Lax/Blech 1.7.4"
+#define BLECHVERSION "Lax/Blech 1.7.5"
 
+#include <deque>
 #include <map>
 #include <string>
+#include <string_view>
+#include <vector>
 
 //#ifdef WIN32
 
@@ -178,6 +181,83 @@ struct BLECHEVENTNODE
 };
 using PBLECHEVENTNODE = BLECHEVENTNODE *;
 
+// Storage for the executions and captured values queued by a Feed. Entries are handed out
+// in order and reused by the next Feed, so a match does not allocate once the arena has
+// grown to the largest batch seen, and the value strings keep their capacity.
+class BlechArena
+{
+public:
+	BLECHVALUE* AllocValue(const char* Name, const char* Value, size_t ValueLength)
+	{
+		BLECHVALUE* pValue;
+		if (UsedValues < Values.size())
+			pValue = &Values[UsedValues];
+		else
+			pValue = &Values.emplace_back();
+		++UsedValues;
+
+		pValue->Name = Name;
+		pValue->Value.assign(Value, ValueLength);
+		pValue->pNext = nullptr;
+		return pValue;
+	}
+
+	BLECHVALUE* CopyValues(const BLECHVALUE* pValues)
+	{
+		BLECHVALUE* pHead = nullptr;
+		BLECHVALUE* pTail = nullptr;
+
+		for (; pValues; pValues = pValues->pNext)
+		{
+			BLECHVALUE* pValue = AllocValue(pValues->Name.c_str(), pValues->Value.c_str(), pValues->Value.length());
+			if (pTail)
+				pTail->pNext = pValue;
+			else
+				pHead = pValue;
+			pTail = pValue;
+		}
+
+		return pHead;
+	}
+
+	BLECHEXECUTE* AllocExecute()
+	{
+		BLECHEXECUTE* pExecute;
+		if (UsedExecutes < Executes.size())
+			pExecute = &Executes[UsedExecutes];
+		else
+			pExecute = &Executes.emplace_back();
+		++UsedExecutes;
+
+		pExecute->pValues = nullptr;
+		pExecute->pNext = nullptr;
+		return pExecute;
+	}
+
+	// Values handed out after Mark are given back. Used to drop the captures of a failed match.
+	size_t GetValueMark() const { return UsedValues; }
+	void ReleaseValues(size_t Mark) { if (Mark < UsedValues) UsedValues = Mark; }
+
+	void Reset()
+	{
+		UsedValues = 0;
+		UsedExecutes = 0;
+	}
+
+	void Clear()
+	{
+		Reset();
+		Values.clear();
+		Executes.clear();
+	}
+
+private:
+	std::deque<BLECHVALUE> Values;
+	size_t UsedValues = 0;
+	std::deque<BLECHEXECUTE> Executes;
+	size_t UsedExecutes = 0;
+};
+
 static unsigned int Equalness(const char* StringA, const char* StringB)
 {
 	BlechDebugFull("Equalness(%s,%s)", StringA, StringB);
@@ -502,6 +582,10 @@ public:
 		EventMap.clear();
 		//        ExactMatch.clear();
 		Initialize();
+
+		// give back the capture storage, unless we are being reset from inside a callback
+		if (!FeedDepth)
+			Arena.Clear();
 	}
 
 	~Blech()
@@ -521,7 +605,16 @@ public:
 		if (Root >= 'a' && Root <= 'z')
 			Root -= 32;
 #endif
-		return Chew(Tree[Root], text, length) + Chew(Tree[0], text, length);
+		unsigned int Length = (unsigned int)strlen(text);
+
+		++FeedDepth;
+		unsigned int Count = Chew(Tree[Root], text, Length, length) + Chew(Tree[0], text, Length, length);
+
+		// callbacks have all run, so the capture storage can be handed out again. A Feed from
+		// inside a callback keeps allocating past the outer Feed's entries instead.
+		if (!--FeedDepth)
+			Arena.Reset();
+		return Count;
 	}
 
 	template <unsigned int Size> unsigned int Feed(char(&Input)[Size]) { return Feed(Input, (size_t)Size); }
@@ -650,37 +743,6 @@ public:
 	char Version[32];
 
 private:
-	inline void FreeExecution(PBLECHEXECUTE pExecute)
-	{
-		if (pExecute)
-		{
-			if (PBLECHVALUE pValue = pExecute->pValues)
-			{
-				while (pValue)
-				{
-					PBLECHVALUE pNext = pValue->pNext;
-					delete pValue;
-					pValue = pNext;
-				}
-			}
-
-			delete pExecute;
-		}
-	}
-
-	void ClearExecutionList(PBLECHEXECUTE* ppExecuteList)
-	{
-		PBLECHEXECUTE pExecuteList = *ppExecuteList;
-		*ppExecuteList = nullptr;
-
-		while (pExecuteList)
-		{
-			PBLECHEXECUTE pExecuteNext = pExecuteList->pNext;
-			FreeExecution(pExecuteList);
-			pExecuteList = pExecuteNext;
-		}
-	}
-
 	unsigned int ProcessExecutionList(PBLECHEXECUTE* ppExecuteList)
 	{
 		unsigned int n = 0;
@@ -691,7 +753,6 @@ private:
 			n++;
 			PBLECHEXECUTE pExecuteNext = pExecuteList->pNext;
 			pExecuteList->Callback(pExecuteList->ID, pExecuteList->pData, pExecuteList->pValues);
-			FreeExecution(pExecuteList);
 			pExecuteList = pExecuteNext;
 		}
 		return n;
@@ -717,282 +778,198 @@ private:
 		BlechDebug("QueueEvent(%X,%X)", pEvent, pValues);
 		BLECHASSERT(pEvent);
 
-		PBLECHEXECUTE pNew = new BLECHEXECUTE;
+		PBLECHEXECUTE pNew = Arena.AllocExecute();
 		pNew->Callback = pEvent->Callback;
 		pNew->ID = pEvent->ID;
 		pNew->pData = pEvent->pData;
-
-		// make a COPY of values
-		if (pValues)
-		{
-			PBLECHVALUE pNewValueTail = nullptr;
-			pNew->pValues = nullptr;
-
-			while (pValues)
-			{
-				PBLECHVALUE pNewValue = new BLECHVALUE;
-				pNewValue->Name = pValues->Name;
-				pNewValue->Value = pValues->Value;
-				pNewValue->pNext = nullptr;
-
-				if (pNew->pValues)
-				{
-					pNewValueTail->pNext = pNewValue;
-					pNewValueTail = pNewValue;
-				}
-				else
-				{
-					pNewValueTail = pNew->pValues = pNewValue;
-
-				}
-				pValues = pValues->pNext;
-			}
-		}
-		else
-		{
-			pNew->pValues = nullptr;
-		}
+		pNew->pValues = pValues;
 
 		pNew->pNext = *ppExecuteList;
 		*ppExecuteList = pNew;
 	}
 
-	void QueueEvents(PBLECHEXECUTE* ppExecuteList, BlechNode* pNode, const char* Input, unsigned int InputLength, size_t BufferSize)
+	void AddValue(PBLECHVALUE* ppValues, PBLECHVALUE* ppValuesTail, BlechNode* pScanVar, const char* Value, size_t Length)
 	{
-		PBLECHEVENTNODE pEventNode;
-		BlechDebug("QueueEvents(%X,%s,%d)", pNode, Input, InputLength);
-		BLECHASSERT(pNode);
-		BLECHASSERT(Input);
-		BLECHASSERT(InputLength);
-		// ASSUME we have a complete match
+		PBLECHVALUE pNewValue = Arena.AllocValue(pScanVar->pString, Value, Length);
 
-		// Get forward traversal list (reverse the links, into a new list)
-		PBLECHLISTNODE pList = 0;
-		BlechNode* pCurrent = pNode;
-		int nVariableNodes = 0;
-		while (pCurrent)
-		{
-			PBLECHLISTNODE pNewHead = new BLECHLISTNODE;
-			pNewHead->pNext = pList;
-			pNewHead->pNode = pCurrent;
-			pList = pNewHead;
-			if (pCurrent->StringType == BST_SCANVAR)
-				nVariableNodes++;
-			pCurrent = pCurrent->pParent;
-		}
-
-		if (!nVariableNodes)
-		{
-			BlechDebugFull("No variable nodes");
-			// if there's no variable nodes, just make sure the lengths match
-			unsigned int TestLength = 0;
-			pCurrent = pNode;
-			while (pCurrent)
-			{
-				TestLength += pCurrent->Length;
-				pCurrent = pCurrent->pParent;
-			}
-			if (pNode && TestLength == InputLength)
-			{
-				PBLECHEVENTNODE pEventNode = pNode->pEvents;
-				while (pEventNode)
-				{
-					QueueEvent(ppExecuteList, pEventNode->pEvent, 0);
-					pEventNode = pEventNode->pNext;
-				}
-			}
-
-			// cleanup
-			while (pList)
-			{
-				PBLECHLISTNODE pNext = pList->pNext;
-				delete pList;
-				pList = pNext;
-			}
-			return;
-		}
-
-		// now do it forward, filling in the values. we KNOW they exist.
+		if (*ppValues)
+			(*ppValuesTail)->pNext = pNewValue;
+		else
+			*ppValues = pNewValue;
+		*ppValuesTail = pNewValue;
+	}
 
+	// Walks the matched path forward, filling in the scan variables. Returns false if the
+	// input does not really match.
+	bool CaptureValues(PBLECHVALUE* ppValues, BlechNode** pPath, unsigned int nPath, const char* Input,
+		unsigned int InputLength, size_t BufferSize)
+	{
 		char NonVariable[16384];
+		size_t NonVariableLength = 0;
 		char VarData[4096];
 		NonVariable[0] = 0;
 		const char* Pos = Input;
+		const char* pEnd = &Input[InputLength];
 
-		PBLECHVALUE pValues = 0;
-		PBLECHVALUE pValuesTail = 0;
+		PBLECHVALUE pValuesTail = nullptr;
+		BlechNode* pCurrentScanVar = nullptr;
 
-		BlechNode* pCurrentScanVar = 0;
-		while (pList)
+		for (unsigned int N = 0; N < nPath; ++N)
 		{
-			pCurrent = pList->pNode;
+			BlechNode* pCurrent = pPath[N];
+			const char* Fragment = nullptr;
+			size_t FragmentLength = 0;
+
 			switch (pCurrent->StringType)
 			{
 			case BST_NORMAL:
-				strcat_s(NonVariable, pCurrent->pString);
+				Fragment = pCurrent->pString;
+				FragmentLength = pCurrent->Length;
 				break;
 			case BST_PRINTVAR:
 				VarData[0] = 0;
 				BlechTry(VariableValue(pCurrent->pString, VarData, BufferSize));
-				strcat_s(NonVariable, VarData);
+				Fragment = VarData;
+				FragmentLength = strlen(VarData);
 				break;
 			case BST_SCANVAR:
 				if (pCurrentScanVar)
 				{
-					if (NonVariable[0])
+					const char* End = Pos;
+					if (NonVariableLength)
 					{
-						const char* End = STRFIND(Pos, NonVariable);
-						if (End)
-						{
-							PBLECHVALUE pNewValue = new BLECHVALUE;
-							pNewValue->Name = pCurrentScanVar->pString;
-
-							size_t Length = End - Pos;
-							pNewValue->Value = std::string_view{ Pos, Length };
-
-							// TODO: Check this
-							pNewValue->Value[Length] = 0;
-							pNewValue->pNext = nullptr;
-
-							if (pValues)
-							{
-								pValuesTail->pNext = pNewValue;
-								pValuesTail = pNewValue;
-							}
-							else
-							{
-								pValuesTail = pValues = pNewValue;
-							}
-
-							Pos = End + strlen(NonVariable);
-							NonVariable[0] = 0;
-						}
-						else
+						End = STRFIND(Pos, NonVariable);
+						if (!End)
 						{
 							// not a real match. goodbye!
 							// NOTE: this can be relatively normal, it is not a direct indication of an error
-							goto queueeventscleanup;
+							return false;
 						}
 					}
-					else
-					{
-						PBLECHVALUE pNewValue = new BLECHVALUE;
-						pNewValue->Name = pCurrentScanVar->pString;
-						pNewValue->pNext = nullptr;
 
-						if (pValues)
-						{
-							pValuesTail->pNext = pNewValue;
-							pValuesTail = pNewValue;
-						}
-						else
-						{
-							pValuesTail = pValues = pNewValue;
-						}
-					}
+					AddValue(ppValues, &pValuesTail, pCurrentScanVar, Pos, End - Pos);
+					Pos = End + NonVariableLength;
 				}
 				else
 				{
-					size_t NonVariableLength = strlen(NonVariable);
 					if (STRNCMP(NonVariable, Pos, NonVariableLength))
 					{
 						// not a real match. goodbye!
 						// NOTE: this can be relatively normal, it is not a direct indication of an error
-						goto queueeventscleanup;
+						return false;
 					}
 					Pos += NonVariableLength;
-					NonVariable[0] = 0;
 				}
+
+				NonVariable[0] = 0;
+				NonVariableLength = 0;
 				pCurrentScanVar = pCurrent;
 				break;
 			}
 
+			if (FragmentLength)
+			{
+				if (NonVariableLength + FragmentLength >= sizeof(NonVariable))
+					return false;
 
-			PBLECHLISTNODE pNext = pList->pNext;
-			delete pList;
-			pList = pNext;
+				memcpy(&NonVariable[NonVariableLength], Fragment, FragmentLength);
+				NonVariableLength += FragmentLength;
+				NonVariable[NonVariableLength] = 0;
+			}
 		}
 
 		if (pCurrentScanVar)
 		{
-			if (NonVariable[0])
+			const char* End = pEnd;
+			if (NonVariableLength)
 			{
-				const char* End = &Input[InputLength] - strlen(NonVariable);
-				size_t Length = End - Pos;
-				if (STRCMP(&Pos[Length], NonVariable))
-				{
-					goto queueeventscleanup;
-				}
+				if (NonVariableLength > (size_t)(pEnd - Pos))
+					return false;
 
-				PBLECHVALUE pNewValue = new BLECHVALUE;
-				pNewValue->Name = pCurrentScanVar->pString;
-				pNewValue->Value = std::string_view{ Pos, Length };
-				// TODO: Check this
-				pNewValue->Value[Length] = 0;
-				pNewValue->pNext = nullptr;
-
-				if (pValues)
-				{
-					pValuesTail->pNext = pNewValue;
-					pValuesTail = pNewValue;
-				}
-				else
-				{
-					pValuesTail = pValues = pNewValue;
-				}
-
-				Pos = End;
-				NonVariable[0] = 0;
-			}
-			else
-			{
-				PBLECHVALUE pNewValue = new BLECHVALUE;
-				pNewValue->Name = pCurrentScanVar->pString;
-				pNewValue->Value = Pos;
-				pNewValue->pNext = nullptr;
-				if (pValues)
-				{
-					pValuesTail->pNext = pNewValue;
-					pValuesTail = pNewValue;
-				}
-				else
-				{
-					pValuesTail = pValues = pNewValue;
-				}
+				End = pEnd - NonVariableLength;
+				if (STRCMP(End, NonVariable))
+					return false;
 			}
+
+			AddValue(ppValues, &pValuesTail, pCurrentScanVar, Pos, End - Pos);
 		}
-		else if (NonVariable[0])
+		else if (NonVariableLength)
 		{
 			if (STRCMP(NonVariable, Pos))
 			{
 				// not a real match. goodbye!
 				// NOTE: this can be relatively normal, it is not a direct indication of an error
-				goto queueeventscleanup;
+				return false;
 			}
 		}
 
-		// add to execution list
-		pEventNode = pNode->pEvents;
-		while (pEventNode)
+		return true;
+	}
+
+	void QueueEvents(PBLECHEXECUTE* ppExecuteList, BlechNode* pNode, const char* Input, unsigned int InputLength, size_t BufferSize)
+	{
+		BlechDebug("QueueEvents(%X,%s,%d)", pNode, Input, InputLength);
+		BLECHASSERT(pNode);
+		BLECHASSERT(Input);
+		BLECHASSERT(InputLength);
+		// ASSUME we have a complete match
+
+		unsigned int nPath = 0;
+		unsigned int TestLength = 0;
+		int nVariableNodes = 0;
+		for (BlechNode* pCurrent = pNode; pCurrent; pCurrent = pCurrent->pParent)
 		{
-			QueueEvent(ppExecuteList, pEventNode->pEvent, pValues);
-			pEventNode = pEventNode->pNext;
+			++nPath;
+			TestLength += pCurrent->Length;
+			if (pCurrent->StringType == BST_SCANVAR)
+				nVariableNodes++;
+		}
+
+		if (!nVariableNodes)
+		{
+			BlechDebugFull("No variable nodes");
+			// if there's no variable nodes, just make sure the lengths match
+			if (TestLength == InputLength)
+			{
+				for (PBLECHEVENTNODE pEventNode = pNode->pEvents; pEventNode; pEventNode = pEventNode->pNext)
+				{
+					QueueEvent(ppExecuteList, pEventNode->pEvent, nullptr);
+				}
+			}
+			return;
 		}
 
-		// cleanup
-	queueeventscleanup:
-		while (pValues)
+		// Get forward traversal list. Event paths are short, so this stays on the stack unless
+		// an event has an unusual number of parts.
+		BlechNode* PathBuffer[64];
+		std::vector<BlechNode*> PathOverflow;
+		BlechNode** pPath = PathBuffer;
+		if (nPath > sizeof(PathBuffer) / sizeof(PathBuffer[0]))
 		{
-			PBLECHVALUE pNext = pValues->pNext;
-			delete pValues;
-			pValues = pNext;
+			PathOverflow.resize(nPath);
+			pPath = PathOverflow.data();
 		}
 
-		while (pList)
+		unsigned int N = nPath;
+		for (BlechNode* pCurrent = pNode; pCurrent; pCurrent = pCurrent->pParent)
+			pPath[--N] = pCurrent;
+
+		// now do it forward, filling in the values. we KNOW they exist.
+		size_t ValueMark = Arena.GetValueMark();
+		PBLECHVALUE pValues = nullptr;
+
+		if (!CaptureValues(&pValues, pPath, nPath, Input, InputLength, BufferSize))
 		{
-			PBLECHLISTNODE pNext = pList->pNext;
-			delete pList;
-			pList = pNext;
+			Arena.ReleaseValues(ValueMark);
+			return;
+		}
+
+		// add to execution list. each event gets its own copy of the values.
+		for (PBLECHEVENTNODE pEventNode = pNode->pEvents; pEventNode; pEventNode = pEventNode->pNext)
+		{
+			QueueEvent(ppExecuteList, pEventNode->pEvent, pValues);
+			if (pEventNode->pNext)
+				pValues = Arena.CopyValues(pValues);
 		}
 	}
 
@@ -1002,14 +979,13 @@ private:
 		BlechNode* pNode;
 	};
 
-	unsigned int Chew(BlechNode* pNode, const char* Input, size_t BufferSize)
+	unsigned int Chew(BlechNode* pNode, const char* Input, unsigned int Length, size_t BufferSize)
 	{
 		BlechDebug("Chew(%X,%s)", pNode, Input);
 		BLECHASSERT(Input);
 		if (!pNode)
 			return 0;
 		PBLECHEXECUTE pExecuteList = 0;
-		unsigned int Length = (unsigned int)strlen(Input);
 		const char* pEnd = &Input[Length];
 		char VarData[4096] = { 0 };
 
@@ -1346,7 +1322,7 @@ private:
 			//            if (BlechNode *pFound=FindNode(Root,String,StringType))
 			//                return pFound;
 			BlechNode* pNew = AddNode(Root, String, StringType);
-			free(String);
+			delete[] String;
 			return pNew;
 		}
 		else
@@ -1356,7 +1332,7 @@ private:
 			// create new
 			BlechNode* pNew = pNode->AddChild(String, StringType);
 
-			free(String);
+			delete[] String;
 			if (oldlastid != LastID) {
 				Beep(1000, 100);
 				DebugBreak();
@@ -1391,4 +1367,6 @@ private:
 	fBlechVariableValue VariableValue = 0;
 	BlechEventMap EventMap;
 	BlechNode* Tree[256];
+	BlechArena Arena;
+	unsigned int FeedDepth = 0;
 };
\ No newline at end of file
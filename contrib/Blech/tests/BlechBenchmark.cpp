@@ -0,0 +1,110 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+// Times Blech.h against BlechReference.h on synthetic chat with a few hundred events.
+//
+//   BlechBenchmark [passes]
+
+#include "BlechPlatform.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+namespace reference {
+#include "BlechReference.h"
+}
+
+// Both headers define their version
+#undef BLECHVERSION
+
+namespace current {
+#include "Blech.h"
+}
+
+static unsigned int s_valueBytes = 0;
+
+static unsigned int CALLBACK VariableValue(char*, char* value, size_t length)
+{
+	std::snprintf(value, length, "Bob");
+	return 3;
+}
+
+template <typename BlechValue>
+static void CALLBACK Callback(unsigned int, void*, BlechValue* pValues)
+{
+	for (; pValues; pValues = pValues->pNext)
+		s_valueBytes += static_cast<unsigned int>(std::string_view(pValues->Value).size());
+}
+
+template <typename Blech, typename BlechValue>
+static double Run(const std::vector<std::string>& lines, int eventCount, int passes)
+{
+	Blech blech('#', '|', VariableValue);
+
+	for (int i = 0; i < eventCount; ++i)
+	{
+		std::string event = "#1# hits #2# for #3# points of damage" + std::to_string(i);
+		blech.AddEvent(event.c_str(), Callback<BlechValue>, nullptr);
+	}
+
+	blech.AddEvent("#1# hits #2# for #3# points of damage.", Callback<BlechValue>, nullptr);
+	blech.AddEvent("#1# tells you, '#2#'", Callback<BlechValue>, nullptr);
+	blech.AddEvent("#*#has been slain by#*#", Callback<BlechValue>, nullptr);
+	blech.AddEvent("You have gained #1# experience#*#", Callback<BlechValue>, nullptr);
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (int pass = 0; pass < passes; ++pass)
+	{
+		for (const std::string& line : lines)
+		{
+			char buffer[2048];
+			std::snprintf(buffer, sizeof(buffer), "%s", line.c_str());
+			blech.Feed(buffer, sizeof(buffer));
+		}
+	}
+
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+	const int passes = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 20;
+
+	std::vector<std::string> lines;
+	std::mt19937 rng(1);
+
+	for (int i = 0; i < 10000; ++i)
+	{
+		switch (rng() % 4)
+		{
+		case 0: lines.push_back("A gnoll hits YOU for " + std::to_string(rng() % 500) + " points of damage."); break;
+		case 1: lines.push_back("Bob tells you, 'inc " + std::to_string(rng() % 50) + "'"); break;
+		case 2: lines.push_back("a gnoll pup has been slain by Bob!"); break;
+		default: lines.push_back("You begin casting Complete Heal."); break;
+		}
+	}
+
+	for (int eventCount : { 10, 200 })
+	{
+		double referenceMS = Run<reference::Blech, reference::BLECHVALUE>(lines, eventCount, passes);
+		double currentMS = Run<current::Blech, current::BLECHVALUE>(lines, eventCount, passes);
+
+		std::printf("%3d events, %zu lines x %d: reference %.1f ms, current %.1f ms (%.0f%%)\n",
+			eventCount + 4, lines.size(), passes, referenceMS, currentMS, 100.0 * currentMS / referenceMS);
+	}
+
+	return 0;
+}
@@ -0,0 +1,226 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+// Feeds the same random events and lines through Blech.h and BlechReference.h and compares
+// every callback, with the values it was given. Some callbacks feed another line from inside
+// the callback, the way a macro event can.
+//
+//   BlechDifferentialTest [first seed] [seed count]
+
+#include "BlechPlatform.h"
+
+#include <random>
+
+namespace reference {
+#include "BlechReference.h"
+}
+
+// Both headers define their version
+#undef BLECHVERSION
+
+namespace current {
+#include "Blech.h"
+}
+
+// Which words make up events and lines. Chat words make realistic events, the short words make
+// lots of events that share prefixes, which is what splits nodes.
+static const std::vector<std::string> s_chatWords = {
+	"You", "hit", "a", "gnoll", "for", "damage", "tells", "you,", "says", "the", "Bob", "slain",
+	"points", "of", "GNOLL", "Hit", "'", "." };
+static const std::vector<std::string> s_shortWords = {
+	"a", "b", "ab", "ba", "alpha", "beta", " ", "x", "tells you", "Abc", "  " };
+
+template <typename Blech, typename BlechValue>
+struct Harness
+{
+	Blech blech{ '#', '|', &Harness::VariableValue };
+	std::string log;
+	bool nestedFeeds = false;
+
+	static inline Harness* s_current = nullptr;
+
+	static unsigned int CALLBACK VariableValue(char* name, char* value, size_t length)
+	{
+		std::snprintf(value, length, "V%s", name);
+		return 1;
+	}
+
+	static void CALLBACK Callback(unsigned int ID, void*, BlechValue* pValues)
+	{
+		Harness& harness = *s_current;
+
+		harness.log += "E" + std::to_string(ID) + ":";
+		for (; pValues; pValues = pValues->pNext)
+			harness.log += std::string(pValues->Name) + "=" + std::string(pValues->Value) + ";";
+		harness.log += "\n";
+
+		if (harness.nestedFeeds && ID % 5 == 0)
+		{
+			harness.nestedFeeds = false;
+			char line[64] = "alpha beta";
+			harness.log += "N" + std::to_string(harness.blech.Feed(line, sizeof(line))) + "\n";
+			harness.nestedFeeds = true;
+		}
+	}
+
+	unsigned int AddEvent(const std::string& event)
+	{
+		s_current = this;
+		return blech.AddEvent(event.c_str(), &Harness::Callback, nullptr);
+	}
+
+	unsigned int Feed(const std::string& line)
+	{
+		s_current = this;
+
+		char buffer[2048];
+		std::snprintf(buffer, sizeof(buffer), "%s", line.c_str());
+		return blech.Feed(buffer, sizeof(buffer));
+	}
+};
+
+static std::string RandomEvent(std::mt19937& rng, const std::vector<std::string>& words)
+{
+	std::string event;
+	int parts = 1 + rng() % 6;
+	int variable = 1;
+	bool lastWasVariable = false;
+
+	for (int part = 0; part < parts; ++part)
+	{
+		int kind = rng() % 10;
+		if (kind < 2 && !lastWasVariable)
+		{
+			event += "#" + std::to_string(variable++) + "#";
+			lastWasVariable = true;
+		}
+		else if (kind == 2 && !lastWasVariable)
+		{
+			event += "#*#";
+			lastWasVariable = true;
+		}
+		else if (kind == 3)
+		{
+			event += "|" + std::string(1, static_cast<char>('a' + rng() % 3)) + "|";
+			lastWasVariable = false;
+		}
+		else
+		{
+			if (!event.empty() && !lastWasVariable && rng() % 2)
+				event += " ";
+			event += words[rng() % words.size()];
+			lastWasVariable = false;
+		}
+	}
+
+	return event;
+}
+
+static std::string RandomLine(std::mt19937& rng, const std::vector<std::string>& words,
+	const std::vector<std::string>& events)
+{
+	std::string line;
+	int parts = 1 + rng() % 10;
+
+	for (int part = 0; part < parts; ++part)
+	{
+		int kind = rng() % 8;
+		if (kind == 0)
+			line += "Va";
+		else if (kind == 1 && !events.empty())
+			line += events[rng() % events.size()];
+		else if (kind == 2)
+			line += std::to_string(rng() % 1000);
+		else
+			line += words[rng() % words.size()];
+
+		if (rng() % 3)
+			line += " ";
+	}
+
+	return line;
+}
+
+static bool RunSeed(unsigned int seed)
+{
+	std::mt19937 rng(seed);
+
+	for (int round = 0; round < 20; ++round)
+	{
+		const std::vector<std::string>& words = round % 2 ? s_shortWords : s_chatWords;
+
+		Harness<reference::Blech, reference::BLECHVALUE> expected;
+		Harness<current::Blech, current::BLECHVALUE> actual;
+		expected.nestedFeeds = actual.nestedFeeds = round % 4 == 3;
+
+		std::vector<std::string> events;
+		int eventCount = 1 + rng() % 60;
+		for (int i = 0; i < eventCount; ++i)
+		{
+			std::string event = RandomEvent(rng, words);
+			if (expected.AddEvent(event) != actual.AddEvent(event))
+			{
+				std::printf("seed %u: event ids differ for '%s'\n", seed, event.c_str());
+				return false;
+			}
+
+			events.push_back(std::move(event));
+		}
+
+		for (int i = 0; i < 3; ++i)
+		{
+			unsigned int id = 1 + rng() % eventCount;
+			expected.blech.RemoveEvent(id);
+			actual.blech.RemoveEvent(id);
+		}
+
+		for (int i = 0; i < 300; ++i)
+		{
+			std::string line = RandomLine(rng, words, events);
+
+			expected.log.clear();
+			actual.log.clear();
+
+			unsigned int expectedCount = expected.Feed(line);
+			unsigned int actualCount = actual.Feed(line);
+
+			if (expectedCount != actualCount || expected.log != actual.log)
+			{
+				std::printf("seed %u: '%s'\n  reference %u\n%s  current %u\n%s", seed, line.c_str(),
+					expectedCount, expected.log.c_str(), actualCount, actual.log.c_str());
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int firstSeed = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : 1;
+	unsigned int seedCount = argc > 2 ? static_cast<unsigned int>(std::atoi(argv[2])) : 20;
+
+	for (unsigned int seed = firstSeed; seed < firstSeed + seedCount; ++seed)
+	{
+		if (!RunSeed(seed))
+		{
+			std::printf("FAILED\n");
+			return 1;
+		}
+	}
+
+	std::printf("%u seeds passed\n", seedCount);
+	return 0;
+}
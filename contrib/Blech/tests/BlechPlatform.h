@@ -0,0 +1,63 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+// The parts of the Windows CRT that Blech.h uses, so that it can be built on its own. Blech.h
+// is included inside a namespace by the tests, so the standard headers it uses are included
+// here first.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef _WIN32
+#include <strings.h>
+
+#define CALLBACK
+
+inline int _stricmp(const char* a, const char* b) { return strcasecmp(a, b); }
+inline int _strnicmp(const char* a, const char* b, size_t n) { return strncasecmp(a, b, n); }
+
+inline int strcpy_s(char* dest, size_t size, const char* src)
+{
+	std::snprintf(dest, size, "%s", src);
+	return 0;
+}
+
+template <size_t N>
+inline int strcpy_s(char(&dest)[N], const char* src) { return strcpy_s(dest, N, src); }
+
+// Used by the node dump and the debug checks
+typedef unsigned short WORD;
+inline void Beep(int, int) {}
+inline void DebugBreak() { std::abort(); }
+inline void Sleep(int) {}
+
+template <size_t N>
+inline int strcat_s(char(&dest)[N], const char* src)
+{
+	if (std::strlen(dest) + std::strlen(src) >= N)
+		std::abort();
+
+	std::strcat(dest, src);
+	return 0;
+}
+#endif
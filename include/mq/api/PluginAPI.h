@@ -41,6 +41,7 @@ using fMQCleanUI             = void(*)();
 using fMQDrawHUD             = void(*)();
 using fMQSetGameState        = void(*)(int GameState);
 using fMQSpawn               = void(*)(PlayerClient*);
+using fMQSpawns              = void(*)(PlayerClient* const* spawns, int count);
 using fMQGroundItem          = void(*)(EQGroundItem*);
 using fMQBeginZone           = void(*)();
 using fMQEndZone             = void(*)();
@@ -73,6 +74,8 @@ struct MQPlugin
 	fMQSetGameState      SetGameState = nullptr;
 	fMQSpawn             AddSpawn = nullptr;
 	fMQSpawn             RemoveSpawn = nullptr;
+	fMQSpawns            AddSpawns = nullptr;       // if present, used instead of AddSpawn for batches
+	fMQSpawns            RemoveSpawns = nullptr;    // if present, used instead of RemoveSpawn for batches
 	fMQGroundItem        AddGroundItem = nullptr;
 	fMQGroundItem        RemoveGroundItem = nullptr;
 	fMQBeginZone         BeginZone = nullptr;
@@ -24,43 +24,63 @@ namespace eqlib {
 	struct BMI;
 }
 
+struct IUnknown;
+
 namespace mq {
 
 class MQTexture
 {
 public:
-	explicit MQTexture(std::string_view name);
+	explicit MQTexture(std::string_view name, bool deferred = false);
 	MQLIB_OBJECT ~MQTexture();
 
 	MQTexture(const MQTexture&) = delete;
 	MQTexture& operator=(const MQTexture&) = delete;
 
-	bool IsValid() const { return m_bmi != nullptr; }
+	bool IsValid() const { return m_bmi != nullptr || m_texture != nullptr; }
 	const std::string& GetFilename() const { return m_name; }
 
+	// True while a texture created with LoadTexture is still waiting to be loaded.
+	bool IsLoading() const { return m_loading; }
+
 	MQLIB_OBJECT ImTextureID GetTextureID() const;
 	MQLIB_OBJECT eqlib::CXSize GetTextureSize() const;
 
 	void ReleaseTexture();
 	void AcquireTexture();
+	void FinishLoading(bool found);
+	void FinishLoading(const uint8_t* pixels, int width, int height);
 
 private:
 	std::string m_name;
 	eqlib::BMI* m_bmi = nullptr;
+	bool m_loading = false;
+
+	// Created from pixels decoded by LoadTexture. The shader resource view (DX11) or texture (DX9).
+	IUnknown* m_texture = nullptr;
+	int m_width = 0;
+	int m_height = 0;
 };
 
 using MQTexturePtr = std::shared_ptr<MQTexture>;
 
 // Creates a texture with a path to an image file. If the texture cannot be created, this
-// will return nullptr. The caller is responsible for calling DestroyTexture.
+// will return nullptr. The caller is responsible for calling DestroyTexture. Textures are
+// cached by filename, so creating the same file again returns the same texture.
 MQLIB_OBJECT MQTexture* CreateTexture(std::string_view filename);
 
 // Destroy a texture that was previously created with CreateTexture
 MQLIB_OBJECT void DestroyTexture(MQTexture* texture);
 
-// Create a shared pointer that manages the lifetime of a texture. This is a convenient function
-// that wraps CreateTexture/DestroyTexture in a shared_ptr.
+// Create a shared pointer that manages the lifetime of a texture. Every call with the same
+// filename shares the same texture. Textures that are no longer referenced are evicted from
+// the cache after a while.
 MQLIB_OBJECT MQTexturePtr CreateTexturePtr(std::string_view filename);
 
+// Like CreateTexturePtr, but returns right away and the texture is created on a later pulse.
+// Only a few textures are created each pulse, so loading many at once doesn't stall a frame.
+// The returned texture is never null: check IsLoading() and IsValid() before using it.
+MQLIB_OBJECT MQTexturePtr LoadTexture(std::string_view filename);
+
 } // namespace mq
 
@@ -0,0 +1,151 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mq {
+
+//----------------------------------------------------------------------------
+// Splits an argument string into its arguments in a single pass.
+//
+// The rules are the same as GetArg/GetNextArg: arguments are separated by spaces and
+// tabs (and commas if csv is set), or only by the custom separator if one is given.
+// Runs of separators count as one. Anything in double quotes is kept together. An
+// unterminated quote runs to the end of the line.
+//
+// Each argument is available with the quotes removed (as returned by GetArg) or as it
+// appears in the line (as returned by GetArg with LeaveQuotes). Indices are 0-based, so
+// args[0] is GetArg(..., 1). An index past the end returns an empty string, like GetArg.
+//
+// The views point into the line that was passed in, so the line must outlive the
+// tokenizer. The ToParen and AnyNonAlphaNum modes of GetArg are not supported.
+//
+// Usage:
+//     ArgTokenizer args(szLine);
+//     for (const auto& arg : args)
+//         WriteChatf("%.*s", arg.value.length(), arg.value.data());
+
+class ArgTokenizer
+{
+public:
+	struct Token
+	{
+		std::string_view value;      // the argument with its quotes removed
+		std::string_view raw;        // the argument as it appears in the line
+	};
+
+	using const_iterator = std::vector<Token>::const_iterator;
+
+	explicit ArgTokenizer(std::string_view line, bool csv = false, char separator = 0)
+		: m_line(line)
+	{
+		// Unquoted copies are never longer than the line, so reserving up front keeps the
+		// views into this buffer valid while we add to it.
+		m_unquoted.reserve(line.length());
+
+		size_t pos = 0;
+		while (true)
+		{
+			while (pos < line.length() && IsSeparator(line[pos], csv, separator))
+				++pos;
+
+			if (pos >= line.length())
+				break;
+
+			size_t start = pos;
+			bool inQuotes = false;
+			bool hasQuotes = false;
+
+			while (pos < line.length() && (inQuotes || !IsSeparator(line[pos], csv, separator)))
+			{
+				if (line[pos] == '"')
+				{
+					inQuotes = !inQuotes;
+					hasQuotes = true;
+				}
+
+				++pos;
+			}
+
+			Token& token = m_tokens.emplace_back();
+			token.raw = line.substr(start, pos - start);
+
+			if (hasQuotes)
+			{
+				size_t unquotedStart = m_unquoted.length();
+				for (char ch : token.raw)
+				{
+					if (ch != '"')
+						m_unquoted.push_back(ch);
+				}
+
+				token.value = std::string_view(m_unquoted.data() + unquotedStart, m_unquoted.length() - unquotedStart);
+			}
+			else
+			{
+				token.value = token.raw;
+			}
+		}
+	}
+
+	// The views may point into this object, so it can't be copied or moved.
+	ArgTokenizer(const ArgTokenizer&) = delete;
+	ArgTokenizer& operator=(const ArgTokenizer&) = delete;
+
+	size_t size() const { return m_tokens.size(); }
+	bool empty() const { return m_tokens.empty(); }
+
+	const_iterator begin() const { return m_tokens.begin(); }
+	const_iterator end() const { return m_tokens.end(); }
+
+	// The argument at index with its quotes removed.
+	std::string_view operator[](size_t index) const
+	{
+		return index < m_tokens.size() ? m_tokens[index].value : std::string_view();
+	}
+
+	// The argument at index as it appears in the line.
+	std::string_view raw(size_t index) const
+	{
+		return index < m_tokens.size() ? m_tokens[index].raw : std::string_view();
+	}
+
+	// The rest of the line starting at the argument at index. Equivalent to GetNextArg(line, index).
+	std::string_view rest(size_t index) const
+	{
+		if (index >= m_tokens.size())
+			return std::string_view();
+
+		return m_line.substr(m_tokens[index].raw.data() - m_line.data());
+	}
+
+private:
+	static bool IsSeparator(char ch, bool csv, char separator)
+	{
+		if (separator != 0)
+			return ch == separator;
+
+		return ch == ' ' || ch == '\t' || (csv && ch == ',');
+	}
+
+	std::string_view m_line;
+	std::vector<Token> m_tokens;
+	std::string m_unquoted;
+};
+
+} // namespace mq
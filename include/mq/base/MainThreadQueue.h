@@ -0,0 +1,509 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mq {
+
+//----------------------------------------------------------------------------
+// A move-only void() callable. Callables that fit in InlineSize bytes are stored in the
+// task itself, larger ones are allocated.
+
+class MainThreadTask
+{
+public:
+	static constexpr size_t InlineSize = 64;
+
+	MainThreadTask() = default;
+
+	template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, MainThreadTask>>>
+	MainThreadTask(F&& func)
+	{
+		using Func = std::decay_t<F>;
+
+		if constexpr (sizeof(Func) <= InlineSize
+			&& alignof(Func) <= alignof(std::max_align_t)
+			&& std::is_nothrow_move_constructible_v<Func>)
+		{
+			new (&m_storage) Func(std::forward<F>(func));
+			m_ops = &InlineOps<Func>::ops;
+		}
+		else
+		{
+			*reinterpret_cast<Func**>(&m_storage) = new Func(std::forward<F>(func));
+			m_ops = &HeapOps<Func>::ops;
+		}
+	}
+
+	MainThreadTask(MainThreadTask&& other) noexcept
+	{
+		MoveFrom(other);
+	}
+
+	MainThreadTask& operator=(MainThreadTask&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Reset();
+			MoveFrom(other);
+		}
+
+		return *this;
+	}
+
+	MainThreadTask(const MainThreadTask&) = delete;
+	MainThreadTask& operator=(const MainThreadTask&) = delete;
+
+	~MainThreadTask()
+	{
+		Reset();
+	}
+
+	explicit operator bool() const { return m_ops != nullptr; }
+
+	void operator()()
+	{
+		m_ops->invoke(&m_storage);
+	}
+
+	void Reset()
+	{
+		if (m_ops != nullptr)
+		{
+			m_ops->destroy(&m_storage);
+			m_ops = nullptr;
+		}
+	}
+
+private:
+	struct Ops
+	{
+		void (*invoke)(void* storage);
+		void (*move)(void* dest, void* src); // move into dest and destroy what is left in src
+		void (*destroy)(void* storage);
+	};
+
+	template <typename Func>
+	struct InlineOps
+	{
+		static void Invoke(void* storage) { (*static_cast<Func*>(storage))(); }
+		static void Destroy(void* storage) { static_cast<Func*>(storage)->~Func(); }
+		static void Move(void* dest, void* src)
+		{
+			new (dest) Func(std::move(*static_cast<Func*>(src)));
+			Destroy(src);
+		}
+
+		static constexpr Ops ops = { &Invoke, &Move, &Destroy };
+	};
+
+	template <typename Func>
+	struct HeapOps
+	{
+		static void Invoke(void* storage) { (**static_cast<Func**>(storage))(); }
+		static void Destroy(void* storage) { delete *static_cast<Func**>(storage); }
+		static void Move(void* dest, void* src) { *static_cast<Func**>(dest) = *static_cast<Func**>(src); }
+
+		static constexpr Ops ops = { &Invoke, &Move, &Destroy };
+	};
+
+	void MoveFrom(MainThreadTask& other)
+	{
+		if (other.m_ops != nullptr)
+		{
+			other.m_ops->move(&m_storage, &other.m_storage);
+			m_ops = other.m_ops;
+			other.m_ops = nullptr;
+		}
+	}
+
+	alignas(std::max_align_t) unsigned char m_storage[InlineSize];
+	const Ops* m_ops = nullptr;
+};
+
+//----------------------------------------------------------------------------
+
+enum class MainThreadPriority
+{
+	Normal,            // run in the order posted, within the per-pulse budget
+	High,              // run on the next pulse regardless of the budget
+};
+
+struct MainThreadQueueStats
+{
+	uint64_t posted = 0;
+	uint64_t executed = 0;
+	uint64_t overdue = 0;                           // tasks run over budget because they reached their max delay
+	uint64_t carriedOver = 0;                       // pulses that left tasks for the next pulse
+	size_t depth = 0;                               // tasks waiting to run
+	size_t maxDepth = 0;
+
+	std::chrono::nanoseconds totalWait{ 0 };        // time from being posted to being run
+	std::chrono::nanoseconds maxWait{ 0 };
+	std::chrono::nanoseconds totalCost{ 0 };        // time spent running tasks
+	std::chrono::nanoseconds maxCost{ 0 };
+	std::chrono::nanoseconds lastProcess{ 0 };      // time spent in the last call to Process
+};
+
+//----------------------------------------------------------------------------
+// Multi-producer, single-consumer queue of tasks for the main thread.
+//
+// Post can be called from any thread and never takes a lock: tasks are pushed onto an
+// atomic list. Process is called by the main thread once per pulse. It takes everything
+// that has been posted, runs the high priority tasks, and then runs normal tasks in order
+// until the budget is used up. At least one normal task is run per call so the queue
+// always makes progress. The rest are carried over to the next pulse, except for tasks
+// that have waited for their max delay, which are run anyway.
+
+class MainThreadQueue
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	MainThreadQueue() = default;
+	MainThreadQueue(const MainThreadQueue&) = delete;
+	MainThreadQueue& operator=(const MainThreadQueue&) = delete;
+
+	~MainThreadQueue()
+	{
+		DeleteList(m_incoming.exchange(nullptr));
+		DeleteList(m_high.head);
+		DeleteList(m_normal.head);
+	}
+
+	// Safe to call from any thread. A max delay of zero means the task can be carried over
+	// for as long as the budget requires. The owner is only used by RemoveTasks.
+	void Post(MainThreadTask&& task, MainThreadPriority priority = MainThreadPriority::Normal,
+		clock::duration maxDelay = clock::duration::zero(), uint64_t owner = 0)
+	{
+		Node* node = new Node;
+		node->task = std::move(task);
+		node->priority = priority;
+		node->owner = owner;
+		node->posted = clock::now();
+		node->deadline = maxDelay > clock::duration::zero() ? node->posted + maxDelay : clock::time_point::max();
+
+		// count it first so that the depth never goes below what is actually queued
+		m_incomingCount.fetch_add(1, std::memory_order_relaxed);
+		m_posted.fetch_add(1, std::memory_order_relaxed);
+
+		node->next = m_incoming.load(std::memory_order_relaxed);
+		while (!m_incoming.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	// Consumer thread only. Runs queued tasks, limited by the budget for normal priority
+	// tasks. A budget of zero runs everything. Returns the number of tasks that were run.
+	size_t Process(clock::duration budget = clock::duration::zero())
+	{
+		const clock::time_point start = clock::now();
+		TakeIncoming();
+
+		size_t ran = 0;
+		while (Node* node = m_high.pop_front())
+		{
+			Run(node);
+			++ran;
+		}
+
+		size_t ranNormal = 0;
+		while (!m_normal.empty())
+		{
+			if (budget > clock::duration::zero() && ranNormal > 0 && clock::now() - start >= budget)
+				break;
+
+			Run(m_normal.pop_front());
+			++ranNormal;
+		}
+
+		if (!m_normal.empty())
+		{
+			++m_stats.carriedOver;
+
+			// Anything that has waited as long as it is allowed to is run now, out of order. The
+			// list is only walked when the earliest max delay is due, and the walk finds the next one.
+			// The due tasks are taken out before any of them run, because a task can change the
+			// queue (unloading a plugin removes its tasks).
+			const clock::time_point now = clock::now();
+			if (m_timedCount > 0 && m_nextDeadline <= now)
+			{
+				m_nextDeadline = clock::time_point::max();
+
+				NodeList overdue;
+				Node* prev = nullptr;
+				Node* node = m_normal.head;
+				while (node != nullptr)
+				{
+					Node* next = node->next;
+					if (node->deadline <= now)
+					{
+						m_normal.remove(prev, node);
+						overdue.push_back(node);
+					}
+					else
+					{
+						if (node->deadline < m_nextDeadline)
+							m_nextDeadline = node->deadline;
+						prev = node;
+					}
+
+					node = next;
+				}
+
+				m_overdue = &overdue;
+				while (Node* due = overdue.pop_front())
+				{
+					Run(due);
+					++m_stats.overdue;
+					++ranNormal;
+				}
+				m_overdue = nullptr;
+			}
+		}
+
+		m_stats.lastProcess = clock::now() - start;
+		return ran + ranNormal;
+	}
+
+	// Consumer thread only. Destroys the tasks that owner has posted so far without running
+	// them. Returns the number of tasks that were removed.
+	size_t RemoveTasks(uint64_t owner)
+	{
+		TakeIncoming();
+
+		size_t removed = RemoveTasks(m_high, owner) + RemoveTasks(m_normal, owner);
+		if (m_overdue != nullptr)
+			removed += RemoveTasks(*m_overdue, owner);
+		m_pendingCount -= removed;
+
+		return removed;
+	}
+
+	// Consumer thread only
+	bool empty() const
+	{
+		return m_pendingCount == 0 && m_incoming.load(std::memory_order_acquire) == nullptr;
+	}
+
+	// Consumer thread only
+	MainThreadQueueStats GetStats() const
+	{
+		MainThreadQueueStats stats = m_stats;
+		stats.posted = m_posted.load(std::memory_order_relaxed) - m_postedAtReset;
+		stats.depth = m_pendingCount + m_incomingCount.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	// Consumer thread only
+	void ResetStats()
+	{
+		m_stats = MainThreadQueueStats();
+		m_postedAtReset = m_posted.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct Node
+	{
+		Node* next = nullptr;
+		MainThreadTask task;
+		MainThreadPriority priority = MainThreadPriority::Normal;
+		uint64_t owner = 0;
+		clock::time_point posted;
+		clock::time_point deadline;
+	};
+
+	struct NodeList
+	{
+		Node* head = nullptr;
+		Node* tail = nullptr;
+
+		bool empty() const { return head == nullptr; }
+
+		void push_back(Node* node)
+		{
+			node->next = nullptr;
+			if (tail != nullptr)
+				tail->next = node;
+			else
+				head = node;
+			tail = node;
+		}
+
+		Node* pop_front()
+		{
+			Node* node = head;
+			if (node != nullptr)
+			{
+				head = node->next;
+				if (head == nullptr)
+					tail = nullptr;
+				node->next = nullptr;
+			}
+
+			return node;
+		}
+
+		// Unlinks node, which follows prev (or is the head if prev is null)
+		void remove(Node* prev, Node* node)
+		{
+			if (prev != nullptr)
+				prev->next = node->next;
+			else
+				head = node->next;
+
+			if (tail == node)
+				tail = prev;
+
+			node->next = nullptr;
+		}
+	};
+
+	void TakeIncoming()
+	{
+		Node* list = m_incoming.exchange(nullptr, std::memory_order_acquire);
+		if (list == nullptr)
+			return;
+
+		// The list is newest first, so reverse it to get back to the order things were posted
+		Node* ordered = nullptr;
+		size_t count = 0;
+		while (list != nullptr)
+		{
+			Node* next = list->next;
+			list->next = ordered;
+			ordered = list;
+			list = next;
+			++count;
+		}
+
+		m_incomingCount.fetch_sub(count, std::memory_order_relaxed);
+
+		while (ordered != nullptr)
+		{
+			Node* next = ordered->next;
+			if (ordered->priority == MainThreadPriority::High)
+			{
+				m_high.push_back(ordered);
+			}
+			else
+			{
+				if (ordered->deadline != clock::time_point::max())
+				{
+					++m_timedCount;
+					if (ordered->deadline < m_nextDeadline)
+						m_nextDeadline = ordered->deadline;
+				}
+
+				m_normal.push_back(ordered);
+			}
+
+			ordered = next;
+		}
+
+		m_pendingCount += count;
+		if (m_pendingCount > m_stats.maxDepth)
+			m_stats.maxDepth = m_pendingCount;
+	}
+
+	void Run(Node* node)
+	{
+		std::unique_ptr<Node> owned(node);
+		--m_pendingCount;
+		if (node->priority == MainThreadPriority::Normal && node->deadline != clock::time_point::max())
+			--m_timedCount;
+
+		const clock::time_point begin = clock::now();
+		const clock::duration wait = begin - node->posted;
+
+		if (node->task)
+			node->task();
+
+		const clock::duration cost = clock::now() - begin;
+
+		++m_stats.executed;
+		m_stats.totalWait += wait;
+		m_stats.totalCost += cost;
+		if (wait > m_stats.maxWait)
+			m_stats.maxWait = wait;
+		if (cost > m_stats.maxCost)
+			m_stats.maxCost = cost;
+	}
+
+	// m_nextDeadline is left alone, it only has to be no later than the earliest max delay
+	size_t RemoveTasks(NodeList& list, uint64_t owner)
+	{
+		size_t removed = 0;
+
+		Node* prev = nullptr;
+		Node* node = list.head;
+		while (node != nullptr)
+		{
+			Node* next = node->next;
+			if (node->owner == owner)
+			{
+				list.remove(prev, node);
+				if (node->priority == MainThreadPriority::Normal && node->deadline != clock::time_point::max())
+					--m_timedCount;
+
+				delete node;
+				++removed;
+			}
+			else
+			{
+				prev = node;
+			}
+
+			node = next;
+		}
+
+		return removed;
+	}
+
+	static void DeleteList(Node* node)
+	{
+		while (node != nullptr)
+		{
+			Node* next = node->next;
+			delete node;
+			node = next;
+		}
+	}
+
+	// producer side
+	std::atomic<Node*> m_incoming{ nullptr };
+	std::atomic<size_t> m_incomingCount{ 0 };
+	std::atomic<uint64_t> m_posted{ 0 };
+
+	// consumer side
+	NodeList m_high;
+	NodeList m_normal;
+	size_t m_pendingCount = 0;
+	size_t m_timedCount = 0;                           // normal tasks that have a max delay
+	NodeList* m_overdue = nullptr;                     // overdue tasks waiting to run, while Process runs them
+	clock::time_point m_nextDeadline = clock::time_point::max(); // no later than the earliest max delay
+	uint64_t m_postedAtReset = 0;
+	MainThreadQueueStats m_stats;
+};
+
+} // namespace mq
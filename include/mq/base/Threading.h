@@ -15,13 +15,38 @@
 #pragma once
 
 #include <mq/base/Common.h>
+#include <mq/base/MainThreadQueue.h>
+#include <mq/base/PluginHandle.h>
+
+#include <chrono>
+#include <functional>
+#include <type_traits>
 
 namespace mq {
 
 MQLIB_API DWORD GetMainThreadId();
 MQLIB_API bool IsMainThread();
 
-// Queue a function to be called on the main thread on the next pulse
-MQLIB_OBJECT void PostToMainThread(std::function<void()>&& callback);
+// Queue a function to be called on the main thread on the next pulse. Tasks that a plugin
+// has queued are dropped without being called if the plugin is unloaded first.
+MQLIB_OBJECT void PostToMainThread(std::function<void()>&& callback,
+	const MQPluginHandle& pluginHandle = mqplugin::ThisPluginHandle);
+
+// Queue a task to be called on the main thread. High priority tasks run on the next pulse.
+// Normal priority tasks run in the order they were posted, as long as the pulse is within
+// its budget, and are otherwise carried over to the following pulse. A max delay makes the
+// task run once it has waited that long, even if that goes over the budget.
+MQLIB_OBJECT void PostToMainThread(MainThreadTask&& task, MainThreadPriority priority,
+	std::chrono::milliseconds maxDelay = std::chrono::milliseconds::zero(),
+	const MQPluginHandle& pluginHandle = mqplugin::ThisPluginHandle);
+
+// Lambdas are stored without going through std::function, so small ones aren't allocated.
+template <typename F, std::enable_if_t<!std::is_same_v<std::decay_t<F>, std::function<void()>>
+	&& !std::is_same_v<std::decay_t<F>, MainThreadTask>, int> = 0>
+void PostToMainThread(F&& callback, const MQPluginHandle& pluginHandle = mqplugin::ThisPluginHandle)
+{
+	PostToMainThread(MainThreadTask(std::forward<F>(callback)), MainThreadPriority::Normal,
+		std::chrono::milliseconds::zero(), pluginHandle);
+}
 
 } // namespace mq
\ No newline at end of file
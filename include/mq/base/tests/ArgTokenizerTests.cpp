@@ -0,0 +1,197 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "mq/base/ArgTokenizer.h"
+#include "mq/base/String.h"
+
+#include "TestCheck.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace mq;
+
+// The expected arguments are what GetArg and GetNextArg in MQ2Utilities.cpp return for the same
+// line: value is GetArg(dest, line, n), raw is GetArg with LeaveQuotes, and rest is
+// GetNextArg(line, n - 1).
+struct ExpectedArg
+{
+	std::string_view value;
+	std::string_view raw;
+	std::string_view rest;
+};
+
+static void CheckArgs(std::string_view line, bool csv, char separator, const std::vector<ExpectedArg>& expected)
+{
+	int failures = g_testFailures;
+
+	ArgTokenizer args(line, csv, separator);
+	CHECK(args.size() == expected.size());
+	CHECK(args.empty() == expected.empty());
+
+	for (size_t i = 0; i < expected.size(); ++i)
+	{
+		CHECK(args[i] == expected[i].value);
+		CHECK(args.raw(i) == expected[i].raw);
+		CHECK(args.rest(i) == expected[i].rest);
+	}
+
+	// Past the end is empty, like GetArg.
+	CHECK(args[expected.size()].empty());
+	CHECK(args.raw(expected.size()).empty());
+	CHECK(args.rest(expected.size()).empty());
+
+	if (g_testFailures != failures)
+		std::fprintf(stderr, "  in [%.*s] csv=%d separator='%c'\n", static_cast<int>(line.length()), line.data(), csv, separator);
+}
+
+static void TestSeparators()
+{
+	CheckArgs("one two three", false, 0, {
+		{ "one", "one", "one two three" },
+		{ "two", "two", "two three" },
+		{ "three", "three", "three" },
+	});
+
+	CheckArgs("  leading\t\ttabs  and   runs  ", false, 0, {
+		{ "leading", "leading", "leading\t\ttabs  and   runs  " },
+		{ "tabs", "tabs", "tabs  and   runs  " },
+		{ "and", "and", "and   runs  " },
+		{ "runs", "runs", "runs  " },
+	});
+
+	CheckArgs("a,b c", false, 0, {
+		{ "a,b", "a,b", "a,b c" },
+		{ "c", "c", "c" },
+	});
+
+	CheckArgs("a,b c", true, 0, {
+		{ "a", "a", "a,b c" },
+		{ "b", "b", "b c" },
+		{ "c", "c", "c" },
+	});
+
+	// A custom separator replaces spaces, tabs and commas.
+	CheckArgs("a|b c||d", false, '|', {
+		{ "a", "a", "a|b c||d" },
+		{ "b c", "b c", "b c||d" },
+		{ "d", "d", "d" },
+	});
+
+	CheckArgs(" a |,b", true, '|', {
+		{ " a ", " a ", " a |,b" },
+		{ ",b", ",b", ",b" },
+	});
+
+	CheckArgs("", false, 0, {});
+	CheckArgs(" \t ", false, 0, {});
+	CheckArgs(",,", true, 0, {});
+}
+
+static void TestQuotes()
+{
+	CheckArgs("\"quoted arg\" next", false, 0, {
+		{ "quoted arg", "\"quoted arg\"", "\"quoted arg\" next" },
+		{ "next", "next", "next" },
+	});
+
+	CheckArgs("a\"b c\"d e", false, 0, {
+		{ "ab cd", "a\"b c\"d", "a\"b c\"d e" },
+		{ "e", "e", "e" },
+	});
+
+	CheckArgs("a \"\" b", false, 0, {
+		{ "a", "a", "a \"\" b" },
+		{ "", "\"\"", "\"\" b" },
+		{ "b", "b", "b" },
+	});
+
+	CheckArgs("c,a,\"\",c", true, 0, {
+		{ "c", "c", "c,a,\"\",c" },
+		{ "a", "a", "a,\"\",c" },
+		{ "", "\"\"", "\"\",c" },
+		{ "c", "c", "c" },
+	});
+
+	// An unterminated quote runs to the end of the line.
+	CheckArgs("\"unterminated rest of line", false, 0, {
+		{ "unterminated rest of line", "\"unterminated rest of line", "\"unterminated rest of line" },
+	});
+
+	CheckArgs("one \"two, three", true, 0, {
+		{ "one", "one", "one \"two, three" },
+		{ "two, three", "\"two, three", "\"two, three" },
+	});
+}
+
+static void TestIterator()
+{
+	ArgTokenizer args("first \"second arg\" third");
+
+	std::vector<std::string_view> values, raws;
+	for (const ArgTokenizer::Token& arg : args)
+	{
+		values.push_back(arg.value);
+		raws.push_back(arg.raw);
+	}
+
+	CHECK((values == std::vector<std::string_view>{ "first", "second arg", "third" }));
+	CHECK((raws == std::vector<std::string_view>{ "first", "\"second arg\"", "third" }));
+}
+
+// ${Select[...]} does this with the tokenizer, see dataSelect in MQ2Data.cpp.
+static int Select(std::string_view index)
+{
+	ArgTokenizer args(index, true);
+
+	for (size_t n = 1; n < args.size() && !args[n].empty(); ++n)
+	{
+		if (ci_equals(args[0], args[n]))
+			return static_cast<int>(n);
+	}
+
+	return 0;
+}
+
+// The checks from data/macros/ArgsTest.mac
+static void TestSelect()
+{
+	CHECK(Select("b,a,b,c") == 2);
+	CHECK(Select("B,a,b") == 2); // case insensitive
+	CHECK(Select("c,a b c") == 3); // spaces separate
+	CHECK(Select("z,a,b") == 0); // no match
+	CHECK(Select("c,a,,  ,c") == 2); // separator runs
+	CHECK(Select("\"x,y\",a,\"x,y\"") == 2); // quoted comma
+	CHECK(Select("\"ab cd\",x,a\"b c\"d") == 2); // inner quotes
+	CHECK(Select("c,a,\"\",c") == 0); // an empty option ends the list
+	CHECK(Select("a,b,\"a,c") == 0); // unterminated quote
+	CHECK(Select("\"a b,a b") == 0); // unterminated first argument
+
+	// a long list of options, matching the last one
+	std::string options = "opt200";
+	for (int i = 1; i <= 200; ++i)
+		options += ",opt" + std::to_string(i);
+	CHECK(Select(options) == 200);
+}
+
+int main()
+{
+	TestSeparators();
+	TestQuotes();
+	TestIterator();
+	TestSelect();
+
+	return TEST_RESULT();
+}
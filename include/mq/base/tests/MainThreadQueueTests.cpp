@@ -0,0 +1,246 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "mq/base/MainThreadQueue.h"
+
+#include "TestCheck.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mq;
+using namespace std::chrono_literals;
+
+// Several threads post while the consumer processes with a small budget. Every task has to
+// run exactly once, and tasks from one thread with the same priority run in the order posted,
+// unless they have a max delay.
+static void TestMultipleProducers()
+{
+	constexpr int Producers = 8;
+	constexpr int TasksPerProducer = 20000;
+
+	struct Result
+	{
+		int value;
+		MainThreadPriority priority;
+		bool timed;
+	};
+
+	MainThreadQueue queue;
+	std::vector<std::vector<Result>> results(Producers);
+	std::atomic<int> finished{ 0 };
+
+	std::vector<std::thread> producers;
+	for (int p = 0; p < Producers; ++p)
+	{
+		producers.emplace_back([&queue, &results, &finished, p]()
+		{
+			for (int i = 0; i < TasksPerProducer; ++i)
+			{
+				const MainThreadPriority priority = i % 5 == 0 ? MainThreadPriority::High : MainThreadPriority::Normal;
+				const bool timed = priority == MainThreadPriority::Normal && i % 11 == 0;
+				std::vector<Result>& out = results[p];
+
+				if (i % 7 == 0)
+				{
+					// too large to be stored in the task
+					std::string padding(200, 'x');
+					queue.Post([&out, i, priority, timed, padding]() { out.push_back({ i, priority, timed }); },
+						priority, timed ? 100us : 0us);
+				}
+				else
+				{
+					queue.Post([&out, i, priority, timed]() { out.push_back({ i, priority, timed }); },
+						priority, timed ? 100us : 0us);
+				}
+			}
+
+			++finished;
+		});
+	}
+
+	size_t ran = 0;
+	while (finished < Producers || !queue.empty())
+		ran += queue.Process(50us);
+
+	for (std::thread& producer : producers)
+		producer.join();
+	ran += queue.Process();
+
+	CHECK(ran == size_t(Producers) * TasksPerProducer);
+
+	MainThreadQueueStats stats = queue.GetStats();
+	CHECK(stats.posted == size_t(Producers) * TasksPerProducer);
+	CHECK(stats.executed == stats.posted);
+	CHECK(stats.depth == 0);
+
+	for (int p = 0; p < Producers; ++p)
+	{
+		CHECK(results[p].size() == size_t(TasksPerProducer));
+
+		std::vector<bool> seen(TasksPerProducer, false);
+		int lastHigh = -1;
+		int lastNormal = -1;
+		for (const Result& result : results[p])
+		{
+			CHECK(!seen[result.value]);
+			seen[result.value] = true;
+
+			if (result.priority == MainThreadPriority::High)
+			{
+				CHECK(result.value > lastHigh);
+				lastHigh = result.value;
+			}
+			else if (!result.timed)
+			{
+				CHECK(result.value > lastNormal);
+				lastNormal = result.value;
+			}
+		}
+	}
+}
+
+static void TestHighPriorityRunsFirst()
+{
+	MainThreadQueue queue;
+	std::vector<int> order;
+
+	queue.Post([&order]() { order.push_back(1); });
+	queue.Post([&order]() { order.push_back(2); });
+	queue.Post([&order]() { order.push_back(3); }, MainThreadPriority::High);
+
+	// a budget that is used up straight away still runs the high priority task and one normal one
+	CHECK(queue.Process(1ns) == 2);
+	CHECK((order == std::vector<int>{ 3, 1 }));
+
+	CHECK(queue.Process(1ns) == 1);
+	CHECK((order == std::vector<int>{ 3, 1, 2 }));
+	CHECK(queue.empty());
+}
+
+static void TestMaxDelay()
+{
+	MainThreadQueue queue;
+	std::vector<int> order;
+
+	queue.Post([&order]() { order.push_back(1); });
+	queue.Post([&order]() { order.push_back(2); });
+	queue.Post([&order]() { order.push_back(3); }, MainThreadPriority::Normal, 1ms);
+	std::this_thread::sleep_for(2ms);
+
+	CHECK(queue.Process(1ns) == 2);
+	CHECK((order == std::vector<int>{ 1, 3 }));
+	CHECK(queue.GetStats().overdue == 1);
+	CHECK(queue.GetStats().carriedOver == 1);
+
+	CHECK(queue.Process() == 1);
+	CHECK((order == std::vector<int>{ 1, 3, 2 }));
+}
+
+// Tasks of an unloaded plugin are destroyed without running, whether or not the consumer has
+// taken them from the producers yet.
+static void TestRemoveTasks()
+{
+	MainThreadQueue queue;
+	auto captured = std::make_shared<int>(0);
+	int ranKept = 0;
+	int ranRemoved = 0;
+
+	queue.Post([captured, &ranRemoved]() { ++ranRemoved; }, MainThreadPriority::Normal, 0us, 1);
+	queue.Post([&ranKept]() { ++ranKept; }, MainThreadPriority::Normal, 0us, 2);
+	queue.Post([captured, &ranRemoved]() { ++ranRemoved; }, MainThreadPriority::Normal, 1ms, 1);
+
+	// leave the first three carried over in the queue
+	CHECK(queue.Process(1ns) == 1);
+	CHECK(ranRemoved == 1);
+	ranRemoved = 0;
+
+	std::thread producer([&]()
+	{
+		queue.Post([captured, &ranRemoved]() { ++ranRemoved; }, MainThreadPriority::High, 0us, 1);
+		queue.Post([&ranKept]() { ++ranKept; }, MainThreadPriority::High, 0us, 2);
+		queue.Post([captured, &ranRemoved]() { ++ranRemoved; }, MainThreadPriority::Normal, 0us, 1);
+	});
+	producer.join();
+
+	CHECK(captured.use_count() == 4);
+	CHECK(queue.RemoveTasks(1) == 3);
+	CHECK(captured.use_count() == 1);
+	CHECK(queue.GetStats().depth == 2);
+
+	std::this_thread::sleep_for(2ms);
+	CHECK(queue.Process() == 2);
+	CHECK(ranKept == 2);
+	CHECK(ranRemoved == 0);
+	CHECK(queue.empty());
+	CHECK(queue.RemoveTasks(1) == 0);
+}
+
+// A task that unloads a plugin removes that plugin's tasks while Process is running tasks,
+// including overdue ones that are waiting to run after it.
+static void TestRemoveTasksWhileRunningOverdue()
+{
+	MainThreadQueue queue;
+	auto captured = std::make_shared<int>(0);
+	int ranRemoved = 0;
+	int ranKept = 0;
+
+	queue.Post([&ranKept]() { ++ranKept; }, MainThreadPriority::Normal, 0us, 2);
+	queue.Post([captured, &ranRemoved]() { ++ranRemoved; }, MainThreadPriority::Normal, 0us, 1);
+	queue.Post([&queue, &ranKept]() { ++ranKept; queue.RemoveTasks(1); }, MainThreadPriority::Normal, 1ms, 2);
+	queue.Post([captured, &ranRemoved]() { ++ranRemoved; }, MainThreadPriority::Normal, 1ms, 1);
+	queue.Post([captured, &ranRemoved]() { ++ranRemoved; }, MainThreadPriority::Normal, 0us, 1);
+	queue.Post([&ranKept]() { ++ranKept; }, MainThreadPriority::Normal, 1ms, 2);
+	std::this_thread::sleep_for(2ms);
+
+	// runs the first task, then the three overdue ones, the second of which was removed
+	CHECK(queue.Process(1ns) == 3);
+	CHECK(ranKept == 3);
+	CHECK(ranRemoved == 0);
+	CHECK(captured.use_count() == 1);
+	CHECK(queue.GetStats().depth == 0);
+	CHECK(queue.empty());
+	CHECK(queue.Process() == 0);
+}
+
+static void TestDestroyWithPendingTasks()
+{
+	auto captured = std::make_shared<int>(0);
+
+	{
+		MainThreadQueue queue;
+		for (int i = 0; i < 100; ++i)
+			queue.Post([captured]() {});
+
+		queue.Process(1ns);
+		CHECK(captured.use_count() == 100);
+	}
+
+	CHECK(captured.use_count() == 1);
+}
+
+int main()
+{
+	TestMultipleProducers();
+	TestHighPriorityRunsFirst();
+	TestMaxDelay();
+	TestRemoveTasks();
+	TestRemoveTasksWhileRunningOverdue();
+	TestDestroyWithPendingTasks();
+
+	return TEST_RESULT();
+}
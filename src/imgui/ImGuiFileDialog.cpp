@@ -1478,6 +1478,10 @@ IGFD::FileManager::FileManager() {
     fsRoot = std::string(1u, PATH_SEP);
 }
 
+IGFD::FileManager::~FileManager() {
+    m_StopScan();
+}
+
 void IGFD::FileManager::OpenCurrentPath(const FileDialogInternal& vFileDialogInternal) {
     showDrives = false;
     ClearComposer();
@@ -1491,170 +1495,105 @@ void IGFD::FileManager::OpenCurrentPath(const FileDialogInternal& vFileDialogInt
 }
 
 void IGFD::FileManager::SortFields(const FileDialogInternal& vFileDialogInternal) {
-    m_SortFields(vFileDialogInternal, m_FileList, m_FilteredFileList);
-}
+    if (IsScanning() && m_ScanIsDirectory) {
+        // the batches of the scan are merged with its comparator, so we will sort again when the scan is done
+        m_UpdateSortingHeaders();
+        m_ScanResortNeeded = true;
+        return;
+    }
 
-void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogInternal,
-    std::vector<std::shared_ptr<FileInfos>>& vFileInfosList,
-    std::vector<std::shared_ptr<FileInfos>>& vFileInfosFilteredList) {
-    if (sortingField != SortingFieldEnum::FIELD_NONE) {
-        headerFileName = tableHeaderFileNameString;
-        headerFileType = tableHeaderFileTypeString;
-        headerFileSize = tableHeaderFileSizeString;
-        headerFileDate = tableHeaderFileDateString;
-#ifdef USE_THUMBNAILS
-        headerFileThumbnails = tableHeaderFileThumbnailsString;
-#endif  // #ifdef USE_THUMBNAILS
+    const auto comparator = m_UpdateSortingHeaders();
+    if (!comparator || m_FileList.size() < SCAN_BATCH_SIZE) {  // not worth a thread
+        m_StopScan();
+        m_SortFields(vFileDialogInternal, m_FileList, m_FilteredFileList);
+        return;
     }
-    if (sortingField == SortingFieldEnum::FIELD_FILENAME) {
-        if (sortingDirection[0]) {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileName = tableHeaderAscendingIcon + headerFileName;
-#endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(
-                vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+
+    // the list stay displayed in its current order until the worker give the sorted copy
+    m_StartScanThread([this, files = m_FileList, comparator]() mutable { m_ThreadSortFunc(files, comparator); });
+    m_ScanIsDirectory = false;
+}
+
+IGFD::FileManager::FileInfosComparator IGFD::FileManager::m_GetSortingComparator(SortingFieldEnum vSortingField, bool vAscending) {
+    switch (vSortingField) {
+        case SortingFieldEnum::FIELD_FILENAME:
+            // tofix : the strict ordering for file/directory types beginning in '.' from
+            // https://github.com/jackm97/ImGuiFileDialog/commit/bf40515f5a1de3043e60562dc1a494ee7ecd3571
+            // fail in c:\\Users with the link "All users". got a invalid comparator
+            if (vAscending) {
+                return [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                     if (!a.use_count() || !b.use_count())
                         return false;
-                    // tofix : this code fail in c:\\Users with the link "All users". got a invalid comparator
-                    /*
-                    // use code from
-                    https://github.com/jackm97/ImGuiFileDialog/commit/bf40515f5a1de3043e60562dc1a494ee7ecd3571
-                    // strict ordering for file/directory types beginning in '.'
-                    // common on _IGFD_WIN_ platforms
-                    if (a->fileNameExt[0] == '.' && b->fileNameExt[0] != '.')
-                        return false;
-                    if (a->fileNameExt[0] != '.' && b->fileNameExt[0] == '.')
-                        return true;
-                    if (a->fileNameExt[0] == '.' && b->fileNameExt[0] == '.')
-                    {
-                        return (stricmp(a->fileNameExt.c_str(), b->fileNameExt.c_str()) < 0); // sort in insensitive
-                    case
-                    }
-                    */
                     if (a->fileType != b->fileType)
                         return (a->fileType < b->fileType);                                // directories first
                     return (stricmp(a->fileNameExt.c_str(), b->fileNameExt.c_str()) < 0);  // sort in insensitive case
-                });
-        } else {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileName = tableHeaderDescendingIcon + headerFileName;
-#endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(
-                vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
-                    if (!a.use_count() || !b.use_count())
-                        return false;
-                    // tofix : this code fail in c:\\Users with the link "All users". got a invalid comparator
-                    /*
-                    // use code from
-                    https://github.com/jackm97/ImGuiFileDialog/commit/bf40515f5a1de3043e60562dc1a494ee7ecd3571
-                    // strict ordering for file/directory types beginning in '.'
-                    // common on _IGFD_WIN_ platforms
-                    if (a->fileNameExt[0] == '.' && b->fileNameExt[0] != '.')
-                        return false;
-                    if (a->fileNameExt[0] != '.' && b->fileNameExt[0] == '.')
-                        return true;
-                    if (a->fileNameExt[0] == '.' && b->fileNameExt[0] == '.')
-                    {
-                        return (stricmp(a->fileNameExt.c_str(), b->fileNameExt.c_str()) > 0); // sort in insensitive
-                    case
-                    }
-                    */
-                    if (a->fileType != b->fileType)
-                        return (a->fileType > b->fileType);                                // directories last
-                    return (stricmp(a->fileNameExt.c_str(), b->fileNameExt.c_str()) > 0);  // sort in insensitive case
-                });
-        }
-    } else if (sortingField == SortingFieldEnum::FIELD_TYPE) {
-        if (sortingDirection[1]) {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileType = tableHeaderAscendingIcon + headerFileType;
-#endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(
-                vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+                };
+            }
+            return [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+                if (!a.use_count() || !b.use_count())
+                    return false;
+                if (a->fileType != b->fileType)
+                    return (a->fileType > b->fileType);                                // directories last
+                return (stricmp(a->fileNameExt.c_str(), b->fileNameExt.c_str()) > 0);  // sort in insensitive case
+            };
+        case SortingFieldEnum::FIELD_TYPE:
+            if (vAscending) {
+                return [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                     if (!a.use_count() || !b.use_count())
                         return false;
                     if (a->fileType != b->fileType)
                         return (a->fileType < b->fileType);              // directory in first
                     return (a->fileExtLevels[0] < b->fileExtLevels[0]);  // else
-                });
-        } else {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileType = tableHeaderDescendingIcon + headerFileType;
-#endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(
-                vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
-                    if (!a.use_count() || !b.use_count())
-                        return false;
-                    if (a->fileType != b->fileType)
-                        return (a->fileType > b->fileType);              // directory in last
-                    return (a->fileExtLevels[0] > b->fileExtLevels[0]);  // else
-                });
-        }
-    } else if (sortingField == SortingFieldEnum::FIELD_SIZE) {
-        if (sortingDirection[2]) {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileSize = tableHeaderAscendingIcon + headerFileSize;
-#endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(
-                vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+                };
+            }
+            return [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+                if (!a.use_count() || !b.use_count())
+                    return false;
+                if (a->fileType != b->fileType)
+                    return (a->fileType > b->fileType);              // directory in last
+                return (a->fileExtLevels[0] > b->fileExtLevels[0]);  // else
+            };
+        case SortingFieldEnum::FIELD_SIZE:
+            if (vAscending) {
+                return [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                     if (!a.use_count() || !b.use_count())
                         return false;
                     if (a->fileType != b->fileType)
                         return (a->fileType < b->fileType);  // directory in first
                     return (a->fileSize < b->fileSize);      // else
-                });
-        } else {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileSize = tableHeaderDescendingIcon + headerFileSize;
-#endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(
-                vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
-                    if (!a.use_count() || !b.use_count())
-                        return false;
-                    if (a->fileType != b->fileType)
-                        return (a->fileType > b->fileType);  // directory in last
-                    return (a->fileSize > b->fileSize);      // else
-                });
-        }
-    } else if (sortingField == SortingFieldEnum::FIELD_DATE) {
-        if (sortingDirection[3]) {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileDate = tableHeaderAscendingIcon + headerFileDate;
-#endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(
-                vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+                };
+            }
+            return [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+                if (!a.use_count() || !b.use_count())
+                    return false;
+                if (a->fileType != b->fileType)
+                    return (a->fileType > b->fileType);  // directory in last
+                return (a->fileSize > b->fileSize);      // else
+            };
+        case SortingFieldEnum::FIELD_DATE:
+            if (vAscending) {
+                return [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                     if (!a.use_count() || !b.use_count())
                         return false;
                     if (a->fileType != b->fileType)
                         return (a->fileType < b->fileType);        // directory in first
                     return (a->fileModifDate < b->fileModifDate);  // else
-                });
-        } else {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileDate = tableHeaderDescendingIcon + headerFileDate;
-#endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(
-                vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
-                    if (!a.use_count() || !b.use_count())
-                        return false;
-                    if (a->fileType != b->fileType)
-                        return (a->fileType > b->fileType);        // directory in last
-                    return (a->fileModifDate > b->fileModifDate);  // else
-                });
-        }
-    }
+                };
+            }
+            return [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+                if (!a.use_count() || !b.use_count())
+                    return false;
+                if (a->fileType != b->fileType)
+                    return (a->fileType > b->fileType);        // directory in last
+                return (a->fileModifDate > b->fileModifDate);  // else
+            };
 #ifdef USE_THUMBNAILS
-    else if (sortingField == SortingFieldEnum::FIELD_THUMBNAILS) {
-        // we will compare thumbnails by :
-        // 1) width
-        // 2) height
-
-        if (sortingDirection[4]) {
-#ifdef USE_CUSTOM_SORTING_ICON
-            headerFileThumbnails = tableHeaderAscendingIcon + headerFileThumbnails;
-#endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(
-                vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+        case SortingFieldEnum::FIELD_THUMBNAILS:
+            // we will compare thumbnails by :
+            // 1) width
+            // 2) height
+            if (vAscending) {
+                return [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
                     if (!a.use_count() || !b.use_count())
                         return false;
                     if (a->fileType != b->fileType)
@@ -1662,31 +1601,81 @@ void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogIntern
                     if (a->thumbnailInfo.textureWidth == b->thumbnailInfo.textureWidth)
                         return (a->thumbnailInfo.textureHeight < b->thumbnailInfo.textureHeight);
                     return (a->thumbnailInfo.textureWidth < b->thumbnailInfo.textureWidth);
-                });
-        }
+                };
+            }
+            return [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
+                if (!a.use_count() || !b.use_count())
+                    return false;
+                if (a->fileType != b->fileType)
+                    return (!a->fileType.isDir());  // directory in last
+                if (a->thumbnailInfo.textureWidth == b->thumbnailInfo.textureWidth)
+                    return (a->thumbnailInfo.textureHeight > b->thumbnailInfo.textureHeight);
+                return (a->thumbnailInfo.textureWidth > b->thumbnailInfo.textureWidth);
+            };
+#endif  // USE_THUMBNAILS
+        default: break;
+    }
+    return nullptr;
+}
 
-        else {
+IGFD::FileManager::FileInfosComparator IGFD::FileManager::m_UpdateSortingHeaders() {
+    if (sortingField != SortingFieldEnum::FIELD_NONE) {
+        headerFileName = tableHeaderFileNameString;
+        headerFileType = tableHeaderFileTypeString;
+        headerFileSize = tableHeaderFileSizeString;
+        headerFileDate = tableHeaderFileDateString;
+#ifdef USE_THUMBNAILS
+        headerFileThumbnails = tableHeaderFileThumbnailsString;
+#endif  // #ifdef USE_THUMBNAILS
+    }
+
+    bool ascending = true;
+    if (sortingField == SortingFieldEnum::FIELD_FILENAME) {
+        ascending = sortingDirection[0];
 #ifdef USE_CUSTOM_SORTING_ICON
-            headerFileThumbnails = tableHeaderDescendingIcon + headerFileThumbnails;
+        headerFileName = (ascending ? tableHeaderAscendingIcon : tableHeaderDescendingIcon) + headerFileName;
+#endif  // USE_CUSTOM_SORTING_ICON
+    } else if (sortingField == SortingFieldEnum::FIELD_TYPE) {
+        ascending = sortingDirection[1];
+#ifdef USE_CUSTOM_SORTING_ICON
+        headerFileType = (ascending ? tableHeaderAscendingIcon : tableHeaderDescendingIcon) + headerFileType;
+#endif  // USE_CUSTOM_SORTING_ICON
+    } else if (sortingField == SortingFieldEnum::FIELD_SIZE) {
+        ascending = sortingDirection[2];
+#ifdef USE_CUSTOM_SORTING_ICON
+        headerFileSize = (ascending ? tableHeaderAscendingIcon : tableHeaderDescendingIcon) + headerFileSize;
+#endif  // USE_CUSTOM_SORTING_ICON
+    } else if (sortingField == SortingFieldEnum::FIELD_DATE) {
+        ascending = sortingDirection[3];
+#ifdef USE_CUSTOM_SORTING_ICON
+        headerFileDate = (ascending ? tableHeaderAscendingIcon : tableHeaderDescendingIcon) + headerFileDate;
+#endif  // USE_CUSTOM_SORTING_ICON
+    }
+#ifdef USE_THUMBNAILS
+    else if (sortingField == SortingFieldEnum::FIELD_THUMBNAILS) {
+        ascending = sortingDirection[4];
+#ifdef USE_CUSTOM_SORTING_ICON
+        headerFileThumbnails = (ascending ? tableHeaderAscendingIcon : tableHeaderDescendingIcon) + headerFileThumbnails;
 #endif  // USE_CUSTOM_SORTING_ICON
-            std::sort(
-                vFileInfosList.begin(), vFileInfosList.end(), [](const std::shared_ptr<FileInfos>& a, const std::shared_ptr<FileInfos>& b) -> bool {
-                    if (!a.use_count() || !b.use_count())
-                        return false;
-                    if (a->fileType != b->fileType)
-                        return (!a->fileType.isDir());  // directory in last
-                    if (a->thumbnailInfo.textureWidth == b->thumbnailInfo.textureWidth)
-                        return (a->thumbnailInfo.textureHeight > b->thumbnailInfo.textureHeight);
-                    return (a->thumbnailInfo.textureWidth > b->thumbnailInfo.textureWidth);
-                });
-        }
     }
 #endif  // USE_THUMBNAILS
 
+    return m_GetSortingComparator(sortingField, ascending);
+}
+
+void IGFD::FileManager::m_SortFields(const FileDialogInternal& vFileDialogInternal,
+    std::vector<std::shared_ptr<FileInfos>>& vFileInfosList,
+    std::vector<std::shared_ptr<FileInfos>>& vFileInfosFilteredList) {
+    const auto comparator = m_UpdateSortingHeaders();
+    if (comparator) {
+        std::stable_sort(vFileInfosList.begin(), vFileInfosList.end(), comparator);
+    }
+
     m_ApplyFilteringOnFileList(vFileDialogInternal, vFileInfosList, vFileInfosFilteredList);
 }
 
 void IGFD::FileManager::ClearFileLists() {
+    m_StopScan();
     m_FilteredFileList.clear();
     m_FileList.clear();
 }
@@ -1696,8 +1685,12 @@ void IGFD::FileManager::ClearPathLists() {
     m_PathList.clear();
 }
 
-void IGFD::FileManager::m_AddFile(
-    const FileDialogInternal& vFileDialogInternal, const std::string& vPath, const std::string& vFileName, const FileType& vFileType) {
+void IGFD::FileManager::m_AddFile(const FilterManager& vFilterManager,
+    ImGuiFileDialogFlags vFlags,
+    const std::string& vPath,
+    const std::string& vFileName,
+    const FileType& vFileType,
+    std::vector<std::shared_ptr<FileInfos>>& vFileInfosList) {
     auto infos = std::make_shared<FileInfos>();
 
     infos->filePath = vPath;
@@ -1706,30 +1699,27 @@ void IGFD::FileManager::m_AddFile(
     infos->fileType = vFileType;
 
     if (infos->fileNameExt.empty() ||
-        (infos->fileNameExt == "." &&
-            !vFileDialogInternal.filterManager.dLGFilters.empty())) {  // filename empty or filename is the current dir '.' //-V807
+        (infos->fileNameExt == "." && !vFilterManager.dLGFilters.empty())) {  // filename empty or filename is the current dir '.' //-V807
         return;
     }
 
-    if (infos->fileNameExt != ".." && (vFileDialogInternal.dLGflags & ImGuiFileDialogFlags_DontShowHiddenFiles) &&
-        infos->fileNameExt[0] == '.') {  // dont show hidden files
-        if (!vFileDialogInternal.filterManager.dLGFilters.empty() ||
-            (vFileDialogInternal.filterManager.dLGFilters.empty() && infos->fileNameExt != ".")) {  // except "." if in directory mode //-V728
+    if (infos->fileNameExt != ".." && (vFlags & ImGuiFileDialogFlags_DontShowHiddenFiles) && infos->fileNameExt[0] == '.') {  // dont show hidden files
+        if (!vFilterManager.dLGFilters.empty() ||
+            (vFilterManager.dLGFilters.empty() && infos->fileNameExt != ".")) {  // except "." if in directory mode //-V728
             return;
         }
     }
 
-    if (infos->FinalizeFileTypeParsing(vFileDialogInternal.filterManager.GetSelectedFilter().count_dots)) {
-        if (!vFileDialogInternal.filterManager.IsCoveredByFilters(
-                *infos.get(), (vFileDialogInternal.dLGflags & ImGuiFileDialogFlags_CaseInsensitiveExtention) != 0)) {
+    if (infos->FinalizeFileTypeParsing(vFilterManager.GetSelectedFilter().count_dots)) {
+        if (!vFilterManager.IsCoveredByFilters(*infos.get(), (vFlags & ImGuiFileDialogFlags_CaseInsensitiveExtention) != 0)) {
             return;
         }
     }
 
-    vFileDialogInternal.filterManager.m_FillFileStyle(infos);
+    vFilterManager.m_FillFileStyle(infos);
 
     m_CompleteFileInfos(infos);
-    m_FileList.push_back(infos);
+    vFileInfosList.push_back(infos);
 }
 
 void IGFD::FileManager::m_AddPath(
@@ -1777,96 +1767,220 @@ void IGFD::FileManager::ScanDir(const FileDialogInternal& vFileDialogInternal, c
             path += std::string(1u, PATH_SEP);
 #endif  // _IGFD_WIN_
 
-        ClearFileLists();
+        ClearFileLists();  // will cancel the previous scan
+
+        // the worker get its own copy of the filters, they can be changed while it is running
+        const auto comparator = m_UpdateSortingHeaders();
+        m_StartScanThread([this, path, filterManager = vFileDialogInternal.filterManager, flags = vFileDialogInternal.dLGflags, comparator]() {
+            m_ThreadScanDirFunc(path, filterManager, flags, comparator);
+        });
+        m_ScanIsDirectory = true;
+    }
+}
+
+void IGFD::FileManager::m_ThreadScanDirFunc(const std::string& vPath,
+    const FilterManager& vFilterManager,
+    ImGuiFileDialogFlags vFlags,
+    const FileInfosComparator& vComparator) {
+    std::vector<std::shared_ptr<FileInfos>> files;  // files found so far, sorted until countSorted
+    size_t countSorted = 0U;
+
+    auto sortAndPost = [&]() {
+        // the new files are sorted and merged here, so the ui thread only have to swap the list
+        if (vComparator) {
+            std::stable_sort(files.begin() + countSorted, files.end(), vComparator);
+            m_MergeSortedFiles(files, countSorted, vComparator);
+        }
+        countSorted = files.size();
+        m_PostScanResults(files);
+    };
+
+    auto addFile = [&](const std::string& vFileName, const FileType& vFileType) {
+        m_AddFile(vFilterManager, vFlags, vPath, vFileName, vFileType, files);
+
+        // a copy of the list is posted each time it grew by a quarter, so the cost of the merges, of the copies
+        // and of the filtering on the ui thread stay proportional to the size of the directory
+        if (files.size() - countSorted >= (std::max)(static_cast<size_t>(SCAN_BATCH_SIZE), countSorted / 4U)) {
+            sortAndPost();
+        }
+    };
 
 #ifdef USE_STD_FILESYSTEM
-        try {
-            const std::filesystem::path fspath(path);
-            const auto dir_iter = std::filesystem::directory_iterator(fspath);
-            FileType fstype = FileType(FileType::ContentType::Directory, std::filesystem::is_symlink(std::filesystem::status(fspath)));
-            m_AddFile(vFileDialogInternal, path, "..", fstype);
-            for (const auto& file : dir_iter) {
-                FileType fileType;
-                if (file.is_symlink()) {
-                    fileType.SetSymLink(file.is_symlink());
-                    fileType.SetContent(FileType::ContentType::LinkToUnknown);
-                }
+    try {
+        const std::filesystem::path fspath(vPath);
+        const auto dir_iter = std::filesystem::directory_iterator(fspath);
+        FileType fstype = FileType(FileType::ContentType::Directory, std::filesystem::is_symlink(std::filesystem::status(fspath)));
+        addFile("..", fstype);
+        for (const auto& file : dir_iter) {
+            if (m_ScanCancelled)
+                break;
 
-                if (file.is_directory()) {
-                    fileType.SetContent(FileType::ContentType::Directory);
-                }  // directory or symlink to directory
-                else if (file.is_regular_file()) {
-                    fileType.SetContent(FileType::ContentType::File);
-                }
+            FileType fileType;
+            if (file.is_symlink()) {
+                fileType.SetSymLink(file.is_symlink());
+                fileType.SetContent(FileType::ContentType::LinkToUnknown);
+            }
 
-                if (fileType.isValid()) {
-                    auto fileNameExt = file.path().filename().string();
-                    m_AddFile(vFileDialogInternal, path, fileNameExt, fileType);
-                }
+            if (file.is_directory()) {
+                fileType.SetContent(FileType::ContentType::Directory);
+            }  // directory or symlink to directory
+            else if (file.is_regular_file()) {
+                fileType.SetContent(FileType::ContentType::File);
+            }
+
+            if (fileType.isValid()) {
+                auto fileNameExt = file.path().filename().string();
+                addFile(fileNameExt, fileType);
             }
-        } catch (const std::exception& ex) {
-            printf("%s", ex.what());
         }
+    } catch (const std::exception& ex) {
+        printf("%s", ex.what());
+    }
 #else  // dirent
-        struct dirent** files = nullptr;
-        size_t n = scandir(path.c_str(), &files, nullptr, inAlphaSort);
-        if (n && files) {
-            size_t i;
-
-            for (i = 0; i < n; i++) {
-                struct dirent* ent = files[i];
-
-                FileType fileType;
-                switch (ent->d_type) {
-                    case DT_DIR: fileType.SetContent(FileType::ContentType::Directory); break;
-                    case DT_REG: fileType.SetContent(FileType::ContentType::File); break;
+    // readdir rather than scandir, so the first files can be shown before the whole directory is read
+    DIR* dir = opendir(vPath.c_str());
+    if (dir) {
+        struct dirent* ent = nullptr;
+        while (!m_ScanCancelled && (ent = readdir(dir)) != nullptr) {
+            FileType fileType;
+            switch (ent->d_type) {
+                case DT_DIR: fileType.SetContent(FileType::ContentType::Directory); break;
+                case DT_REG: fileType.SetContent(FileType::ContentType::File); break;
 #if defined(_IGFD_UNIX_) || (DT_LNK != DT_UNKNOWN)
-                    case DT_LNK:
+                case DT_LNK:
 #endif
-                    case DT_UNKNOWN: {
-                        struct stat sb = {};
+                case DT_UNKNOWN: {
+                    struct stat sb = {};
 #ifdef _IGFD_WIN_
-                        auto filePath = path + ent->d_name;
+                    auto filePath = vPath + ent->d_name;
 #else
-                        auto filePath = path + std::string(1u, PATH_SEP) + ent->d_name;
+                    auto filePath = vPath + std::string(1u, PATH_SEP) + ent->d_name;
 #endif
 
-                        if (!stat(filePath.c_str(), &sb)) {
-                            if (sb.st_mode & S_IFLNK) {
-                                fileType.SetSymLink(true);
-                                fileType.SetContent(FileType::ContentType::LinkToUnknown);  // by default if we can't figure out the
-                                                                                            // target type.
-                            }
-                            if (sb.st_mode & S_IFREG) {
-                                fileType.SetContent(FileType::ContentType::File);
-                                break;
-                            } else if (sb.st_mode & S_IFDIR) {
-                                fileType.SetContent(FileType::ContentType::Directory);
-                                break;
-                            }
+                    if (!stat(filePath.c_str(), &sb)) {
+                        if (sb.st_mode & S_IFLNK) {
+                            fileType.SetSymLink(true);
+                            fileType.SetContent(FileType::ContentType::LinkToUnknown);  // by default if we can't figure out the
+                                                                                        // target type.
+                        }
+                        if (sb.st_mode & S_IFREG) {
+                            fileType.SetContent(FileType::ContentType::File);
+                            break;
+                        } else if (sb.st_mode & S_IFDIR) {
+                            fileType.SetContent(FileType::ContentType::Directory);
+                            break;
                         }
-                        break;
                     }
-                    default: break;  // leave it invalid (devices, etc.)
+                    break;
                 }
+                default: break;  // leave it invalid (devices, etc.)
+            }
 
-                if (fileType.isValid()) {
-                    m_AddFile(vFileDialogInternal, path, ent->d_name, fileType);
-                }
+            if (fileType.isValid()) {
+                addFile(ent->d_name, fileType);
             }
+        }
 
-            for (i = 0; i < n; i++) {
-                free(files[i]);
+        closedir(dir);
+    }
+#endif  // USE_STD_FILESYSTEM
+
+    if (!m_ScanCancelled) {
+        sortAndPost();
+    }
+}
+
+void IGFD::FileManager::m_ThreadSortFunc(std::vector<std::shared_ptr<FileInfos>>& vFileInfosList, const FileInfosComparator& vComparator) {
+    std::stable_sort(vFileInfosList.begin(), vFileInfosList.end(), vComparator);
+
+    if (!m_ScanCancelled) {
+        m_PostScanResults(vFileInfosList);
+    }
+}
+
+void IGFD::FileManager::m_PostScanResults(const std::vector<std::shared_ptr<FileInfos>>& vFileInfosList) {
+    std::lock_guard<std::mutex> lock(m_ScanResultsMutex);
+    m_ScanResults = vFileInfosList;
+    m_ScanResultsReady = true;
+}
+
+void IGFD::FileManager::m_MergeSortedFiles(
+    std::vector<std::shared_ptr<FileInfos>>& vFileInfosList, size_t vCountSorted, const FileInfosComparator& vComparator) {
+    if (vCountSorted == 0 || vCountSorted == vFileInfosList.size())
+        return;
+
+    // only the tail of the sorted part who is after the first new file need to be merged.
+    // most of file systems give the entries in name order, so the new files are often all after
+    const auto middle = vFileInfosList.begin() + vCountSorted;
+    const auto first = std::upper_bound(vFileInfosList.begin(), middle, *middle, vComparator);
+    std::inplace_merge(first, middle, vFileInfosList.end(), vComparator);
+}
+
+void IGFD::FileManager::m_StartScanThread(std::function<void()> vThreadFunc) {
+    m_StopScan();
+
+    m_ScanFinished = false;
+    m_ScanThread = std::shared_ptr<std::thread>(
+        new std::thread([this, vThreadFunc]() {
+            vThreadFunc();
+            m_ScanFinished = true;
+        }),
+        [this](std::thread* obj) {
+            m_ScanCancelled = true;
+            if (obj) {
+                obj->join();
+                delete obj;
             }
+        });
+}
 
-            free(files);
+void IGFD::FileManager::m_StopScan() {
+    m_ScanThread.reset();  // cancel and join
+
+    m_ScanCancelled = false;
+    m_ScanFinished = true;
+    m_ScanResortNeeded = false;
+    m_ScanIsDirectory = false;
+
+    std::lock_guard<std::mutex> lock(m_ScanResultsMutex);
+    m_ScanResults.clear();
+    m_ScanResultsReady = false;
+}
+
+void IGFD::FileManager::UpdateScan(const FileDialogInternal& vFileDialogInternal) {
+    if (!m_ScanThread.use_count())
+        return;
+
+    // read before taking the results, the worker post its last results before finishing
+    const bool finished = m_ScanFinished;
+
+    bool ready = false;
+    {
+        std::lock_guard<std::mutex> lock(m_ScanResultsMutex);
+        if (m_ScanResultsReady) {
+            m_FileList.swap(m_ScanResults);
+            m_ScanResultsReady = false;
+            ready = true;
         }
-#endif  // USE_STD_FILESYSTEM
+    }
 
-        m_SortFields(vFileDialogInternal, m_FileList, m_FilteredFileList);
+    if (ready) {
+        m_ApplyFilteringOnFileList(vFileDialogInternal, m_FileList, m_FilteredFileList);
+    }
+
+    if (finished) {
+        const bool resort = m_ScanResortNeeded;
+        m_StopScan();
+        if (resort) {
+            SortFields(vFileDialogInternal);
+        }
     }
 }
 
+bool IGFD::FileManager::IsScanning() const {
+    return m_ScanThread.use_count() != 0;
+}
+
 void IGFD::FileManager::m_ScanDirForPathSelection(const FileDialogInternal& vFileDialogInternal, const std::string& vPath) {
     std::string path = vPath;
 
@@ -2040,19 +2154,22 @@ void IGFD::FileManager::ApplyFilteringOnFileList(const FileDialogInternal& vFile
     m_ApplyFilteringOnFileList(vFileDialogInternal, m_FileList, m_FilteredFileList);
 }
 
+bool IGFD::FileManager::m_IsFileShown(const FileDialogInternal& vFileDialogInternal, const std::shared_ptr<FileInfos>& vInfos) const {
+    if (!vInfos.use_count())
+        return false;
+    if (!vInfos->SearchForTag(vFileDialogInternal.searchManager.searchTag))  // if search tag
+        return false;
+    if (dLGDirectoryMode && !vInfos->fileType.isDir())
+        return false;
+    return true;
+}
+
 void IGFD::FileManager::m_ApplyFilteringOnFileList(const FileDialogInternal& vFileDialogInternal,
     std::vector<std::shared_ptr<FileInfos>>& vFileInfosList,
     std::vector<std::shared_ptr<FileInfos>>& vFileInfosFilteredList) {
     vFileInfosFilteredList.clear();
     for (const auto& file : vFileInfosList) {
-        if (!file.use_count())
-            continue;
-        bool show = true;
-        if (!file->SearchForTag(vFileDialogInternal.searchManager.searchTag))  // if search tag
-            show = false;
-        if (dLGDirectoryMode && !file->fileType.isDir())
-            show = false;
-        if (show)
+        if (m_IsFileShown(vFileDialogInternal, file))
             vFileInfosFilteredList.push_back(file);
     }
 }
@@ -3765,8 +3882,11 @@ bool IGFD::FileDialog::Display(const std::string& vKey, ImGuiWindowFlags vFlags,
 
                 fdFilter.SetDefaultFilterIfNotDefined();
 
+                // take the files found by the scan thread since the last frame
+                fdFile.UpdateScan(m_FileDialogInternal);
+
                 // init list of files
-                if (fdFile.IsFileListEmpty() && !fdFile.showDrives) {
+                if (fdFile.IsFileListEmpty() && !fdFile.showDrives && !fdFile.IsScanning()) {
                     if (fdFile.dLGpath != ".")  // Removes extension seperator in filename if we don't check
                         IGFD::Utils::ReplaceString(fdFile.dLGDefaultFileName, fdFile.dLGpath, "");  // local path
 
@@ -1257,6 +1257,7 @@ struct IGFD_Thumbnail_Info {
 #include <regex>
 #include <array>
 #include <mutex>
+#include <atomic>
 #include <thread>
 #include <cfloat>
 #include <memory>
@@ -1316,6 +1317,10 @@ struct IGFD_Thumbnail_Info {
 #define EXT_MAX_LEVEL 10U
 #endif  // EXT_MAX_LEVEL
 
+#ifndef SCAN_BATCH_SIZE
+#define SCAN_BATCH_SIZE 512U
+#endif  // SCAN_BATCH_SIZE
+
 #pragma endregion
 
 #pragma region IGFD NAMESPACE
@@ -1620,6 +1625,7 @@ public:                            // types
         FIELD_DATE,                // sorted by filedate
         FIELD_THUMBNAILS,          // sorted by thumbnails (comparaison by width then by height)
     };
+    typedef std::function<bool(const std::shared_ptr<FileInfos>&, const std::shared_ptr<FileInfos>&)> FileInfosComparator;
 
 #ifdef NEED_TO_BE_PUBLIC_FOR_TESTS
 public:
@@ -1637,6 +1643,17 @@ private:
     std::set<std::string> m_SelectedFileNames;                   // the user selection of FilePathNames
     bool m_CreateDirectoryMode = false;                          // for create directory widget
 
+    // the directory scan and the column sorting are done in a worker thread, who post sorted copies
+    // of its list. UpdateScan swap them with m_FileList on the ui thread
+    std::vector<std::shared_ptr<FileInfos>> m_ScanResults;          // sorted files posted by the worker
+    bool m_ScanResultsReady = false;                                // m_ScanResults was posted since the last UpdateScan
+    bool m_ScanResortNeeded = false;                                // the sorting was changed during a scan
+    bool m_ScanIsDirectory = false;                                 // the worker is scanning a directory, not sorting m_FileList
+    std::mutex m_ScanResultsMutex;                                  // guards m_ScanResults and m_ScanResultsReady
+    std::atomic<bool> m_ScanCancelled{false};                       // set on navigation, the worker stop at the next entry
+    std::atomic<bool> m_ScanFinished{true};                         // the worker has posted its last results
+    std::shared_ptr<std::thread> m_ScanThread = nullptr;            // the worker, cancelled and joined on reset
+
 public:
     bool inputPathActivated = false;                             // show input for path edition
     bool drivesClicked = false;                                  // event when a drive button is clicked
@@ -1675,12 +1692,15 @@ private:
     static std::string m_RoundNumber(double vvalue, int n);                        // custom rounding number
     static std::string m_FormatFileSize(size_t vByteSize);                         // format file size field
     static void m_CompleteFileInfos(const std::shared_ptr<FileInfos>& FileInfos);  // set time and date infos of a file (detail view mode)
+    static FileInfosComparator m_GetSortingComparator(SortingFieldEnum vSortingField, bool vAscending);  // comparator of a column
     void m_RemoveFileNameInSelection(const std::string& vFileName);                // selection : remove a file name
     void m_m_AddFileNameInSelection(const std::string& vFileName, bool vSetLastSelectionFileName);  // selection : add a file name
-    void m_AddFile(const FileDialogInternal& vFileDialogInternal,
+    static void m_AddFile(const FilterManager& vFilterManager,
+        ImGuiFileDialogFlags vFlags,
         const std::string& vPath,
         const std::string& vFileName,
-        const FileType& vFileType);  // add file called by scandir
+        const FileType& vFileType,
+        std::vector<std::shared_ptr<FileInfos>>& vFileInfosList);  // add file called by the scan thread
     void m_AddPath(const FileDialogInternal& vFileDialogInternal,
         const std::string& vPath,
         const std::string& vFileName,
@@ -1696,9 +1716,24 @@ private:
     void m_SortFields(const FileDialogInternal& vFileDialogInternal,
         std::vector<std::shared_ptr<FileInfos>>& vFileInfosList,
         std::vector<std::shared_ptr<FileInfos>>& vFileInfosFilteredList);  // will sort a column
+    FileInfosComparator m_UpdateSortingHeaders();                          // set the header names, return the comparator of the column
+    bool m_IsFileShown(const FileDialogInternal& vFileDialogInternal, const std::shared_ptr<FileInfos>& vInfos) const;  // search tag / dir mode
+    void m_PostScanResults(const std::vector<std::shared_ptr<FileInfos>>& vFileInfosList);  // called by the worker
+    static void m_MergeSortedFiles(std::vector<std::shared_ptr<FileInfos>>& vFileInfosList,
+        size_t vCountSorted,
+        const FileInfosComparator& vComparator);  // stable merge of the sorted tail from vCountSorted in the sorted head
+    void m_ThreadScanDirFunc(const std::string& vPath,
+        const FilterManager& vFilterManager,
+        ImGuiFileDialogFlags vFlags,
+        const FileInfosComparator& vComparator);  // the worker who will scan the directory
+    void m_ThreadSortFunc(std::vector<std::shared_ptr<FileInfos>>& vFileInfosList,
+        const FileInfosComparator& vComparator);         // the worker who will sort a copy of m_FileList
+    void m_StartScanThread(std::function<void()> vThreadFunc);  // cancel the running worker and start a new one
+    void m_StopScan();                                          // cancel and join the worker, drop its pending results
 
 public:
     FileManager();
+    ~FileManager();
     bool IsComposerEmpty();
     size_t GetComposerSize();
     bool IsFileListEmpty();
@@ -1735,7 +1770,9 @@ public:
         const std::shared_ptr<FileInfos>& vInfos);  // select filename
     void SetCurrentDir(const std::string& vPath);   // define current directory for scan
     void ScanDir(const FileDialogInternal& vFileDialogInternal,
-        const std::string& vPath);  // scan the directory for retrieve the file list
+        const std::string& vPath);  // scan the directory for retrieve the file list, in a worker thread
+    void UpdateScan(const FileDialogInternal& vFileDialogInternal);  // take the last files posted by the worker
+    bool IsScanning() const;                                         // a scan or a sort is running
 
     std::string GetResultingPath();
     std::string GetResultingFileName(FileDialogInternal& vFileDialogInternal, IGFD_ResultMode vFlag);
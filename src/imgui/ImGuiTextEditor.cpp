@@ -2417,13 +2417,103 @@ void TextEditor::Colorize(int fromLine, int lineCount)
 	m_checkComments = true;
 }
 
+void TextEditor::ColorizeAll()
+{
+	if (m_lines.empty() || !m_colorizerEnabled)
+		return;
+
+	do
+	{
+		ColorizeInternal();
+	} while (m_colorRangeMin < m_colorRangeMax);
+}
+
+// Colors an identifier token from the keywords and identifiers of the language
+static PaletteIndex GetIdentifierColor(const LanguageDefinition& languageDef, std::string& id, bool preprocessor)
+{
+	// todo : allmost all language definitions use lower case to specify keywords, so shouldn't this use ::tolower ?
+	if (!languageDef.caseSensitive)
+		std::transform(id.begin(), id.end(), id.begin(), ::toupper);
+
+	if (!preprocessor)
+	{
+		if (languageDef.keywords.count(id) != 0)
+			return PaletteIndex::Keyword;
+		if (languageDef.identifiers.count(id) != 0)
+			return PaletteIndex::KnownIdentifier;
+		if (languageDef.preprocIdentifiers.count(id) != 0)
+			return PaletteIndex::PreprocIdentifier;
+	}
+	else
+	{
+		if (languageDef.preprocIdentifiers.count(id) != 0)
+			return PaletteIndex::PreprocIdentifier;
+	}
+
+	return PaletteIndex::Identifier;
+}
+
+// Splits a line into tokens. onToken is called with where the search for the token started,
+// the token and its color.
+template <typename OnToken>
+static void TokenizeLine(const LanguageDefinition& languageDef, const RegexList& regexList,
+	const char* lineBegin, const char* lineEnd, OnToken&& onToken)
+{
+	std::cmatch results;
+
+	for (const char* first = lineBegin; first != lineEnd; )
+	{
+		const char* token_begin = nullptr;
+		const char* token_end = nullptr;
+		PaletteIndex token_color = PaletteIndex::Default;
+
+		bool hasTokenizeResult = false;
+
+		if (languageDef.tokenizeLine != nullptr)
+		{
+			if (languageDef.tokenizeLine(lineBegin, first, lineEnd, token_begin, token_end, token_color))
+				hasTokenizeResult = true;
+		}
+		else if (languageDef.tokenize != nullptr)
+		{
+			if (languageDef.tokenize(first, lineEnd, token_begin, token_end, token_color))
+				hasTokenizeResult = true;
+		}
+
+		if (hasTokenizeResult == false)
+		{
+			for (auto& [re, pi] : regexList)
+			{
+				if (std::regex_search(first, lineEnd, results, re, std::regex_constants::match_continuous))
+				{
+					hasTokenizeResult = true;
+					auto& v = *results.begin();
+					token_begin = v.first;
+					token_end = v.second;
+					token_color = pi;
+					break;
+				}
+			}
+		}
+
+		if (hasTokenizeResult == false)
+		{
+			first++;
+		}
+		else
+		{
+			onToken(first, token_begin, token_end, token_color);
+			first = token_end;
+		}
+	}
+}
+
 void TextEditor::ColorizeRange(int fromLine, int toLine)
 {
 	if (m_lines.empty() || fromLine >= toLine)
 		return;
 
 	std::string buffer;
-	std::cmatch results;
 	std::string id;
 
 	int endLine = std::max(0, std::min((int)m_lines.size(), toLine));
@@ -2446,82 +2536,52 @@ void TextEditor::ColorizeRange(int fromLine, int toLine)
 		const char* bufferBegin = &buffer.front();
 		const char* bufferEnd = bufferBegin + buffer.size();
 
-		const char* last = bufferEnd;
-
-		for (const char* first = bufferBegin; first != last; )
+		TokenizeLine(m_languageDefinition, m_regexList, bufferBegin, bufferEnd,
+			[&](const char* first, const char* token_begin, const char* token_end, PaletteIndex token_color)
 		{
-			const char* token_begin = nullptr;
-			const char* token_end = nullptr;
-			PaletteIndex token_color = PaletteIndex::Default;
-
-			bool hasTokenizeResult = false;
-
-			if (m_languageDefinition.tokenize != nullptr)
+			if (token_color == PaletteIndex::Identifier)
 			{
-				if (m_languageDefinition.tokenize(first, last, token_begin, token_end, token_color))
-					hasTokenizeResult = true;
+				id.assign(token_begin, token_end);
+				token_color = GetIdentifierColor(m_languageDefinition, id, line.glyphs[first - bufferBegin].preprocessor);
 			}
 
-			if (hasTokenizeResult == false)
+			for (const char* p = token_begin; p != token_end; ++p)
 			{
-				for (auto& [re, pi] : m_regexList)
-				{
-					if (std::regex_search(first, last, results, re, std::regex_constants::match_continuous))
-					{
-						hasTokenizeResult = true;
-						auto& v = *results.begin();
-						token_begin = v.first;
-						token_end = v.second;
-						token_color = pi;
-						break;
-					}
-				}
-			}
+				Glyph& g = line.glyphs[p - bufferBegin];
 
-			if (hasTokenizeResult == false)
-			{
-				first++;
+				g.colorIndex = token_color;
+				g.rawColor = false;
 			}
-			else
-			{
-				const size_t token_length = token_end - token_begin;
+		});
+	}
+}
 
-				if (token_color == PaletteIndex::Identifier)
-				{
-					id.assign(token_begin, token_end);
+std::vector<PaletteIndex> TextEditor::ColorizeLine(const LanguageDefinition& languageDef, std::string_view line)
+{
+	std::vector<PaletteIndex> colors(line.size(), PaletteIndex::Default);
+	if (line.empty() || !languageDef.enabled)
+		return colors;
 
-					// todo : allmost all language definitions use lower case to specify keywords, so shouldn't this use ::tolower ?
-					if (!m_languageDefinition.caseSensitive)
-						std::transform(id.begin(), id.end(), id.begin(), ::toupper);
+	RegexList regexList;
+	for (auto& r : languageDef.tokenRegexStrings)
+		regexList.emplace_back(std::regex(r.first, std::regex_constants::optimize), r.second);
 
-					if (!line.glyphs[first - bufferBegin].preprocessor)
-					{
-						if (m_languageDefinition.keywords.count(id) != 0)
-							token_color = PaletteIndex::Keyword;
-						else if (m_languageDefinition.identifiers.count(id) != 0)
-							token_color = PaletteIndex::KnownIdentifier;
-						else if (m_languageDefinition.preprocIdentifiers.count(id) != 0)
-							token_color = PaletteIndex::PreprocIdentifier;
-					}
-					else
-					{
-						if (m_languageDefinition.preprocIdentifiers.count(id) != 0)
-							token_color = PaletteIndex::PreprocIdentifier;
-					}
-				}
+	std::string id;
+	const char* lineBegin = line.data();
 
-				for (size_t j = 0; j < token_length; ++j)
-				{
-					Glyph& g = line.glyphs[(token_begin - bufferBegin) + j];
+	TokenizeLine(languageDef, regexList, lineBegin, lineBegin + line.size(),
+		[&](const char*, const char* token_begin, const char* token_end, PaletteIndex token_color)
+	{
+		if (token_color == PaletteIndex::Identifier)
+		{
+			id.assign(token_begin, token_end);
+			token_color = GetIdentifierColor(languageDef, id, false);
+		}
 
-					g.colorIndex = token_color;
-					g.rawColor = false;
-				}
+		std::fill(colors.begin() + (token_begin - lineBegin), colors.begin() + (token_end - lineBegin), token_color);
+	});
 
-				first = token_end;
-			}
-		}
-	}
+	return colors;
 }
 
 void TextEditor::ColorizeInternal()
@@ -2560,6 +2620,7 @@ void TextEditor::ColorizeInternal()
 			{
 				Glyph& g = line.glyphs[currentIndex];
 				char c = g.ch;
+				const bool canStartComment = !m_languageDefinition.commentsAtLineStart || firstChar;
 
 				if (c != m_languageDefinition.preprocChar && !isspace(c))
 					firstChar = false;
@@ -2610,14 +2671,14 @@ void TextEditor::ColorizeInternal()
 						const std::string& singleStartStr = m_languageDefinition.singleLineComment;
 						const std::string& endStr = m_languageDefinition.commentEnd;
 
-						if (!withinSingleLineComment
+						if (!withinSingleLineComment && canStartComment
 							&& currentIndex + startStr.size() <= line.glyphs.size()
 							&& equals(startStr.begin(), startStr.end(), from, from + startStr.size(), pred))
 						{
 							commentStartLine = currentLine;
 							commentStartIndex = currentIndex;
 						}
-						else if (!singleStartStr.empty()
+						else if (!singleStartStr.empty() && canStartComment
 							&& currentIndex + singleStartStr.size() <= line.glyphs.size()
 							&& equals(singleStartStr.begin(), singleStartStr.end(), from, from + singleStartStr.size(), pred))
 						{
@@ -3133,6 +3194,160 @@ static bool TokenizeLuaStylePunctuation(const char* in_begin, const char* in_end
 	return false;
 }
 
+static bool TokenizeCStylePreprocessor(const char* in_begin, const char* in_end, const char*& out_begin, const char*& out_end)
+{
+	const char* p = in_begin;
+
+	if (*p != '#')
+		return false;
+
+	p++;
+
+	while (p < in_end && (*p == ' ' || *p == '\t'))
+		p++;
+
+	const char* identifier_begin = nullptr;
+	const char* identifier_end = nullptr;
+	if (p == in_end || !TokenizeCStyleIdentifier(p, in_end, identifier_begin, identifier_end))
+		return false;
+
+	out_begin = in_begin;
+	out_end = identifier_end;
+	return true;
+}
+
+static bool TokenizeSqlStyleString(const char* in_begin, const char* in_end, const char*& out_begin, const char*& out_end)
+{
+	const char* p = in_begin;
+
+	if (*p == '\'')
+	{
+		p++;
+
+		while (p < in_end)
+		{
+			// handle end of string
+			if (*p == '\'')
+			{
+				out_begin = in_begin;
+				out_end = p + 1;
+				return true;
+			}
+
+			p++;
+		}
+	}
+
+	return false;
+}
+
+static bool IsMacroWordChar(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Returns the end of word (given in lower case) if p starts with it, or null
+static const char* SkipMacroWord(const char* p, const char* in_end, std::string_view word)
+{
+	for (char c : word)
+	{
+		if (p == in_end || ::tolower(static_cast<unsigned char>(*p)) != c)
+			return nullptr;
+		p++;
+	}
+
+	return p < in_end && IsMacroWordChar(*p) ? nullptr : p;
+}
+
+// A command is the first thing on a line, after a closing brace or an else, or the command
+// that follows the condition of an /if or a /while. Anything else that looks like a command
+// is an argument, like the /echo in "/docommand /echo".
+static bool IsMacroCommandStart(const char* line_begin, const char* in_end, const char* target)
+{
+	const char* p = line_begin;
+
+	while (p < target)
+	{
+		if (*p == ' ' || *p == '\t' || *p == '}')
+		{
+			p++;
+			continue;
+		}
+
+		if (const char* next = SkipMacroWord(p, in_end, "else"))
+		{
+			p = next;
+			continue;
+		}
+
+		if (*p != '/')
+			return false;
+
+		const char* next = SkipMacroWord(p + 1, in_end, "if");
+		if (next == nullptr)
+			next = SkipMacroWord(p + 1, in_end, "while");
+		if (next == nullptr)
+			return false;
+
+		p = next;
+		while (p < target && (*p == ' ' || *p == '\t'))
+			p++;
+
+		if (p == target || *p != '(')
+			return false;
+
+		int depth = 0;
+		for (; p < target; ++p)
+		{
+			if (*p == '(')
+				depth++;
+			else if (*p == ')' && --depth == 0)
+				break;
+		}
+
+		if (p == target)
+			return false;
+
+		p++;
+	}
+
+	return p == target;
+}
+
+static bool TokenizeMacroStyleCommand(const char* line_begin, const char* in_begin, const char* in_end, const char*& out_begin, const char*& out_end)
+{
+	const char* p = in_begin;
+
+	if (*p == '/' && p + 1 < in_end && ((p[1] >= 'a' && p[1] <= 'z') || (p[1] >= 'A' && p[1] <= 'Z'))
+		&& IsMacroCommandStart(line_begin, in_end, in_begin))
+	{
+		p += 2;
+
+		while (p < in_end && IsMacroWordChar(*p))
+			p++;
+
+		out_begin = in_begin;
+		out_end = p;
+		return true;
+	}
+
+	return false;
+}
+
+static bool TokenizeMacroStyleVariable(const char* in_begin, const char* in_end, const char*& out_begin, const char*& out_end)
+{
+	// Only the ${ that opens a variable is a token, the TLO and members that follow it
+	// are picked up as identifiers.
+	if (*in_begin == '$' && in_begin + 1 < in_end && in_begin[1] == '{')
+	{
+		out_begin = in_begin;
+		out_end = in_begin + 2;
+		return true;
+	}
+
+	return false;
+}
+
 const LanguageDefinition& LanguageDefinition::CPlusPlus()
 {
 	static bool inited = false;
@@ -3250,15 +3465,34 @@ const LanguageDefinition& LanguageDefinition::HLSL()
 			langDef.identifiers.emplace(std::string(k), id);
 		}
 
-		langDef.tokenRegexStrings.emplace_back("[ \\t]*#[ \\t]*[a-zA-Z_]+", PaletteIndex::Preprocessor);
-		langDef.tokenRegexStrings.emplace_back("L?\\\"(\\\\.|[^\\\"])*\\\"", PaletteIndex::String);
-		langDef.tokenRegexStrings.emplace_back("\\'\\\\?[^\\']\\'", PaletteIndex::CharLiteral);
-		langDef.tokenRegexStrings.emplace_back("[+-]?([0-9]+([.][0-9]*)?|[.][0-9]+)([eE][+-]?[0-9]+)?[fF]?", PaletteIndex::Number);
-		langDef.tokenRegexStrings.emplace_back("[+-]?[0-9]+[Uu]?[lL]?[lL]?", PaletteIndex::Number);
-		langDef.tokenRegexStrings.emplace_back("0[0-7]+[Uu]?[lL]?[lL]?", PaletteIndex::Number);
-		langDef.tokenRegexStrings.emplace_back("0[xX][0-9a-fA-F]+[uU]?[lL]?[lL]?", PaletteIndex::Number);
-		langDef.tokenRegexStrings.emplace_back("[a-zA-Z_][a-zA-Z0-9_]*", PaletteIndex::Identifier);
-		langDef.tokenRegexStrings.emplace_back("[\\[\\]\\{\\}\\!\\%\\^\\&\\*\\(\\)\\-\\+\\=\\~\\|\\<\\>\\?\\/\\;\\,\\.]", PaletteIndex::Punctuation);
+		langDef.tokenize = [](const char* in_begin, const char* in_end, const char*& out_begin, const char*& out_end, PaletteIndex& paletteIndex) -> bool
+		{
+			paletteIndex = PaletteIndex::Max;
+
+			while (in_begin < in_end && isascii(*in_begin) && isblank(*in_begin))
+				in_begin++;
+
+			if (in_begin == in_end)
+			{
+				out_begin = in_end;
+				out_end = in_end;
+				paletteIndex = PaletteIndex::Default;
+			}
+			else if (TokenizeCStylePreprocessor(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Preprocessor;
+			else if (TokenizeCStyleString(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::String;
+			else if (TokenizeCStyleCharacterLiteral(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::CharLiteral;
+			else if (TokenizeCStyleIdentifier(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Identifier;
+			else if (TokenizeCStyleNumber(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Number;
+			else if (TokenizeCStylePunctuation(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Punctuation;
+
+			return paletteIndex != PaletteIndex::Max;
+		};
 
 		langDef.commentStart = "/*";
 		langDef.commentEnd = "*/";
@@ -3299,15 +3533,34 @@ const LanguageDefinition& LanguageDefinition::GLSL()
 			langDef.identifiers.emplace(std::string(k), id);
 		}
 
-		langDef.tokenRegexStrings.emplace_back("[ \\t]*#[ \\t]*[a-zA-Z_]+", PaletteIndex::Preprocessor);
-		langDef.tokenRegexStrings.emplace_back("L?\\\"(\\\\.|[^\\\"])*\\\"", PaletteIndex::String);
-		langDef.tokenRegexStrings.emplace_back("\\'\\\\?[^\\']\\'", PaletteIndex::CharLiteral);
-		langDef.tokenRegexStrings.emplace_back("[+-]?([0-9]+([.][0-9]*)?|[.][0-9]+)([eE][+-]?[0-9]+)?[fF]?", PaletteIndex::Number);
-		langDef.tokenRegexStrings.emplace_back("[+-]?[0-9]+[Uu]?[lL]?[lL]?", PaletteIndex::Number);
-		langDef.tokenRegexStrings.emplace_back("0[0-7]+[Uu]?[lL]?[lL]?", PaletteIndex::Number);
-		langDef.tokenRegexStrings.emplace_back("0[xX][0-9a-fA-F]+[uU]?[lL]?[lL]?", PaletteIndex::Number);
-		langDef.tokenRegexStrings.emplace_back("[a-zA-Z_][a-zA-Z0-9_]*", PaletteIndex::Identifier);
-		langDef.tokenRegexStrings.emplace_back("[\\[\\]\\{\\}\\!\\%\\^\\&\\*\\(\\)\\-\\+\\=\\~\\|\\<\\>\\?\\/\\;\\,\\.]", PaletteIndex::Punctuation);
+		langDef.tokenize = [](const char* in_begin, const char* in_end, const char*& out_begin, const char*& out_end, PaletteIndex& paletteIndex) -> bool
+		{
+			paletteIndex = PaletteIndex::Max;
+
+			while (in_begin < in_end && isascii(*in_begin) && isblank(*in_begin))
+				in_begin++;
+
+			if (in_begin == in_end)
+			{
+				out_begin = in_end;
+				out_end = in_end;
+				paletteIndex = PaletteIndex::Default;
+			}
+			else if (TokenizeCStylePreprocessor(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Preprocessor;
+			else if (TokenizeCStyleString(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::String;
+			else if (TokenizeCStyleCharacterLiteral(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::CharLiteral;
+			else if (TokenizeCStyleIdentifier(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Identifier;
+			else if (TokenizeCStyleNumber(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Number;
+			else if (TokenizeCStylePunctuation(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Punctuation;
+
+			return paletteIndex != PaletteIndex::Max;
+		};
 
 		langDef.commentStart = "/*";
 		langDef.commentEnd = "*/";
@@ -3430,14 +3683,32 @@ const LanguageDefinition& LanguageDefinition::SQL()
 			langDef.identifiers.emplace(std::string(k), id);
 		}
 
-		langDef.tokenRegexStrings.emplace_back("L?\\\"(\\\\.|[^\\\"])*\\\"", PaletteIndex::String);
-		langDef.tokenRegexStrings.emplace_back("\\\'[^\\\']*\\\'", PaletteIndex::String);
-		langDef.tokenRegexStrings.emplace_back("[+-]?([0-9]+([.][0-9]*)?|[.][0-9]+)([eE][+-]?[0-9]+)?[fF]?", PaletteIndex::Number);
-		langDef.tokenRegexStrings.emplace_back("[+-]?[0-9]+[Uu]?[lL]?[lL]?", PaletteIndex::Number);
-		langDef.tokenRegexStrings.emplace_back("0[0-7]+[Uu]?[lL]?[lL]?", PaletteIndex::Number);
-		langDef.tokenRegexStrings.emplace_back("0[xX][0-9a-fA-F]+[uU]?[lL]?[lL]?", PaletteIndex::Number);
-		langDef.tokenRegexStrings.emplace_back("[a-zA-Z_][a-zA-Z0-9_]*", PaletteIndex::Identifier);
-		langDef.tokenRegexStrings.emplace_back("[\\[\\]\\{\\}\\!\\%\\^\\&\\*\\(\\)\\-\\+\\=\\~\\|\\<\\>\\?\\/\\;\\,\\.]", PaletteIndex::Punctuation);
+		langDef.tokenize = [](const char* in_begin, const char* in_end, const char*& out_begin, const char*& out_end, PaletteIndex& paletteIndex) -> bool
+		{
+			paletteIndex = PaletteIndex::Max;
+
+			while (in_begin < in_end && isascii(*in_begin) && isblank(*in_begin))
+				in_begin++;
+
+			if (in_begin == in_end)
+			{
+				out_begin = in_end;
+				out_end = in_end;
+				paletteIndex = PaletteIndex::Default;
+			}
+			else if (TokenizeCStyleString(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::String;
+			else if (TokenizeSqlStyleString(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::String;
+			else if (TokenizeCStyleIdentifier(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Identifier;
+			else if (TokenizeCStyleNumber(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Number;
+			else if (TokenizeCStylePunctuation(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Punctuation;
+
+			return paletteIndex != PaletteIndex::Max;
+		};
 
 		langDef.commentStart = "/*";
 		langDef.commentEnd = "*/";
@@ -3524,6 +3795,81 @@ const LanguageDefinition& LanguageDefinition::Lua()
 	return langDef;
 }
 
+const LanguageDefinition& LanguageDefinition::Macro()
+{
+	static bool inited = false;
+	static LanguageDefinition langDef;
+	if (!inited)
+	{
+		// Keywords are upper case because the macro language is not case sensitive
+		static const char* const keywords[] = {
+			"SUB", "ELSE", "TO", "DOWNTO", "STEP", "LOCAL", "GLOBAL", "OUTER", "BOOL", "BYTE", "DOUBLE", "FLOAT", "INT", "INT64", "STRING", "TIMER"
+		};
+		for (auto& k : keywords)
+			langDef.keywords.insert(k);
+
+		static const char* const identifiers[] = {
+			"ACHIEVEMENT", "ADVLOOT", "ALERT", "ALIAS", "ALTABILITY", "BANDOLIER", "CORPSE", "CURSOR", "DEFINED", "DISPLAYITEM", "DOOR", "DOORTARGET",
+			"DYNAMICZONE", "EVERQUEST", "FAMILIAR", "FINDITEM", "FINDITEMBANK", "FINDITEMBANKCOUNT", "FINDITEMCOUNT", "FRIENDS", "GAMETIME", "GROUND",
+			"GROUNDITEMCOUNT", "GROUP", "HEADING", "HOTBUTTON", "IF", "ILLUSION", "INI", "INVSLOT", "ITEMTARGET", "LASTSPAWN", "LINEOFSIGHT", "MACRO",
+			"MACROQUEST", "MATH", "ME", "MERCENARY", "MERCHANT", "MOUNT", "NAMINGSPAWN", "NEARESTSPAWN", "PARSE", "PET", "PLUGIN", "POINTMERCHANT", "RAID",
+			"RANGE", "SELECT", "SELECTEDITEM", "SKILL", "SOCIAL", "SPAWN", "SPAWNCOUNT", "SPELL", "SWITCH", "SWITCHTARGET", "TARGET", "TASK", "TELEPORT",
+			"TIME", "TRADESKILLDEPOT", "TYPE", "WINDOW", "ZONE"
+		};
+		for (auto& k : identifiers)
+		{
+			Identifier id;
+			id.declaration = "Top-level object";
+			langDef.identifiers.emplace(std::string(k), id);
+		}
+
+		langDef.tokenizeLine = [](const char* line_begin, const char* in_begin, const char* in_end, const char*& out_begin, const char*& out_end, PaletteIndex& paletteIndex) -> bool
+		{
+			paletteIndex = PaletteIndex::Max;
+
+			while (in_begin < in_end && isascii(*in_begin) && isblank(*in_begin))
+				in_begin++;
+
+			if (in_begin == in_end)
+			{
+				out_begin = in_end;
+				out_end = in_end;
+				paletteIndex = PaletteIndex::Default;
+			}
+			else if (TokenizeCStylePreprocessor(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Preprocessor;
+			else if (TokenizeCStyleString(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::String;
+			else if (TokenizeMacroStyleCommand(line_begin, in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Keyword;
+			else if (TokenizeMacroStyleVariable(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Punctuation;
+			else if (TokenizeCStyleIdentifier(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Identifier;
+			else if (TokenizeCStyleNumber(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Number;
+			else if (TokenizeCStylePunctuation(in_begin, in_end, out_begin, out_end))
+				paletteIndex = PaletteIndex::Punctuation;
+
+			return paletteIndex != PaletteIndex::Max;
+		};
+
+		// | starts a comment line, and |** ... **| is a block comment
+		langDef.commentStart = "|**";
+		langDef.commentEnd = "**|";
+		langDef.singleLineComment = "|";
+		langDef.commentsAtLineStart = true;
+
+		langDef.caseSensitive = false;
+		langDef.autoIndentation = true;
+
+		langDef.name = "Macro";
+
+		inited = true;
+	}
+	return langDef;
+}
+
 const LanguageDefinition& LanguageDefinition::PlainText()
 {
 	static bool inited = false;
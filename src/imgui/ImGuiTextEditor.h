@@ -218,6 +218,8 @@ struct LanguageDefinition
 
 	// inBegin, inEnd, outBegin, outEnd, palleteIndex
 	using TokenizeCallback = bool(*)(const char*, const char*, const char*&, const char*&, PaletteIndex&);
+	// lineBegin, inBegin, inEnd, outBegin, outEnd, palleteIndex
+	using TokenizeLineCallback = bool(*)(const char*, const char*, const char*, const char*&, const char*&, PaletteIndex&);
 
 	std::string name;
 	Keywords keywords;
@@ -227,9 +229,11 @@ struct LanguageDefinition
 	char preprocChar = '#';
 	bool autoIndentation = true;
 	TokenizeCallback tokenize = nullptr;
+	TokenizeLineCallback tokenizeLine = nullptr;   // used instead of tokenize when a token depends on what comes before it
 	TokenRegexStrings tokenRegexStrings;
 	bool caseSensitive = true;
 	bool enabled = true;
+	bool commentsAtLineStart = false;   // comments only start at the beginning of a line
 
 	IMGUI_API LanguageDefinition() = default;
 
@@ -239,6 +243,7 @@ struct LanguageDefinition
 	IMGUI_API static const LanguageDefinition& C();
 	IMGUI_API static const LanguageDefinition& SQL();
 	IMGUI_API static const LanguageDefinition& Lua();
+	IMGUI_API static const LanguageDefinition& Macro();
 	IMGUI_API static const LanguageDefinition& PlainText();
 };
 
@@ -332,6 +337,9 @@ public:
 	inline bool IsColorizerEnabled() const { return m_colorizerEnabled; }
 	IMGUI_API void SetColorizerEnable(bool vValue);
 
+	// Colorizes all of the pending lines now, instead of spreading it across frames
+	IMGUI_API void ColorizeAll();
+
 	inline Coordinates GetEnd() const
 	{
 		return Coordinates((int)m_lines.size() - 1, 0);
@@ -391,6 +399,10 @@ public:
 	IMGUI_API static const Palette& GetLightPalette();
 	IMGUI_API static const Palette& GetRetroBluePalette();
 
+	// Colors a line of text the way an editor with this language would, for showing code outside
+	// of an editor. Returns the palette index of each character.
+	IMGUI_API static std::vector<PaletteIndex> ColorizeLine(const LanguageDefinition& languageDef, std::string_view line);
+
 private:
 	void ProcessInputs();
 	void Colorize(int fromLine = 0, int count = -1);
@@ -69,6 +69,13 @@ private:
 			case mq::MQMessageId::MSG_ROUTE:
 			{
 				auto envelope = ProtoMessage::Parse<proto::routing::Envelope>(message);
+				if (envelope.has_trace())
+				{
+					MessageTracer::AddHop(*envelope.mutable_trace(), proto::routing::TraceStage::Forwarded);
+
+					std::string data(envelope.SerializeAsString());
+					message = std::make_unique<PipeMessage>(*message, &data[0], data.size());
+				}
 				const auto& address = envelope.address();
 				if ((address.has_pid() && address.pid() == GetCurrentProcessId()) || (address.has_name() && ci_equals(address.name(), "launcher")))
 				{
@@ -346,6 +353,8 @@ public:
 		PipeMessagePtr&& message,
 		const PipeMessageResponseCb& callback)
 	{
+		GetPostOffice().GetTracer().Drop(envelope, status);
+
 		// we can't assume that the mailbox exists here, so manually create the reply
 		proto::routing::Envelope outbound;
 		*outbound.mutable_address() = envelope.return_address();
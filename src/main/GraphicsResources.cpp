@@ -14,9 +14,21 @@
 
 #include "pch.h"
 #include "GraphicsResources.h"
+#include "TextureCache.h"
+#include "TextureDecoder.h"
 
 #include "MQ2Main.h"
 
+#include <wil/com.h>
+
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_ONLY_JPEG
+#define STBI_ONLY_BMP
+#define STBI_ONLY_TGA
+#include "stb/stb_image.h"
+
 namespace mq {
 
 //============================================================================
@@ -26,56 +38,179 @@ static bool s_shutdown = false;
 
 static int s_renderCallbacksId = -1;
 
+static TextureCache<MQTexture> s_textureCache;
+static std::chrono::steady_clock::time_point s_lastEviction;
+
+constexpr auto TEXTURE_EVICT_INTERVAL = std::chrono::seconds(1);
+
+// Textures queued by LoadTexture are decoded by the texture decoder's worker thread, and
+// created from the pixels on later pulses until this much time has been spent in a pulse. At
+// least one is created every pulse. Files the decoder can't handle are created with CreateBMI,
+// which decodes them on the main thread.
+constexpr auto TEXTURE_LOAD_BUDGET = std::chrono::milliseconds(2);
+
+static bool DecodeImageFile(const std::string& filename, DecodedImage& image);
+
+static TextureDecoder s_textureDecoder(DecodeImageFile);
+static std::map<std::string, std::weak_ptr<MQTexture>, ci_less> s_pendingLoads;
+
 //============================================================================
 
-MQTexture* CreateTexture(std::string_view filename)
+// Reads an image file and decodes it to RGBA pixels. Called on the decoder thread. DDS files
+// and files that aren't on disk (the resource manager also looks in the game's archives) are
+// left for CreateBMI.
+static bool DecodeImageFile(const std::string& filename, DecodedImage& image)
 {
-	MQTexture* newTexture = nullptr;
+	std::error_code ec;
+	if (!std::filesystem::is_regular_file(filename, ec))
+		return false;
 
-	if (pGraphicsEngine && pGraphicsEngine->pResourceManager)
+	std::vector<uint8_t> buffer;
+	if (FILE* file = _fsopen(filename.c_str(), "rb", _SH_DENYNO))
 	{
-		newTexture = new MQTexture(filename);
-		if (!newTexture->IsValid())
-		{
-			delete newTexture;
-			newTexture = nullptr;
-		}
+		uint8_t chunk[16384];
+		size_t count;
+		while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0)
+			buffer.insert(buffer.end(), chunk, chunk + count);
+
+		fclose(file);
 	}
 
-	return newTexture;
+	int width = 0, height = 0, components = 0;
+	stbi_uc* pixels = stbi_load_from_memory(buffer.data(), static_cast<int>(buffer.size()), &width, &height, &components, 4);
+	if (!pixels)
+		return false;
+
+	image.pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+	image.width = width;
+	image.height = height;
+	stbi_image_free(pixels);
+
+	return true;
 }
 
-MQTexture* GetTexture(std::string_view filename)
+//============================================================================
+
+static MQTexturePtr GetCachedTexture(std::string_view filename)
+{
+	if (!pGraphicsEngine || !pGraphicsEngine->pResourceManager)
+		return nullptr;
+
+	if (TextureCache<MQTexture>::Entry* entry = s_textureCache.Find(filename))
+	{
+		// Someone asked for this texture right away, so don't wait for it to be loaded.
+		if (entry->texture && entry->texture->IsLoading())
+			entry->texture->FinishLoading(true);
+
+		return entry->texture && entry->texture->IsValid() ? entry->texture : nullptr;
+	}
+
+	auto texture = std::make_shared<MQTexture>(filename);
+	if (!texture->IsValid())
+		texture.reset();
+
+	return s_textureCache.Add(filename, texture).texture;
+}
+
+MQTexture* CreateTexture(std::string_view filename)
 {
-	auto findIter = std::find_if(begin(s_textures), end(s_textures),
-		[&filename](MQTexture* texture) { return texture->GetFilename() == filename; });
+	MQTexturePtr texture = GetCachedTexture(filename);
+	if (!texture)
+		return nullptr;
 
-	return findIter == end(s_textures) ? nullptr : *findIter;
+	++s_textureCache.Find(filename)->rawRefs;
+	return texture.get();
+}
+
+MQTexture* GetTexture(std::string_view filename)
+{
+	return s_textureCache.Get(filename);
 }
 
 void DestroyTexture(MQTexture* texture)
 {
-	delete texture;
+	if (!texture)
+		return;
+
+	s_textureCache.Release(texture->GetFilename(), texture, s_shutdown);
 }
 
 MQTexturePtr CreateTexturePtr(std::string_view filename)
 {
-	return std::shared_ptr<MQTexture>(CreateTexture(filename), [](MQTexture* tex) { DestroyTexture(tex); });
+	return GetCachedTexture(filename);
 }
 
-//============================================================================
+MQTexturePtr LoadTexture(std::string_view filename)
+{
+	if (TextureCache<MQTexture>::Entry* entry = s_textureCache.Find(filename))
+	{
+		if (entry->texture)
+			return entry->texture;
 
-MQTexture::MQTexture(std::string_view name)
-	: m_name(name)
+		// A failed load, hand out a texture that isn't valid
+		auto texture = std::make_shared<MQTexture>(filename, true);
+		texture->FinishLoading(false);
+		return texture;
+	}
+
+	auto texture = std::make_shared<MQTexture>(filename, true);
+	s_textureCache.Add(filename, texture);
+	s_pendingLoads[std::string(filename)] = texture;
+	s_textureDecoder.Queue(std::string(filename));
+
+	return texture;
+}
+
+static void UpdateTextureLoads()
 {
-	AcquireTexture();
+	if (s_pendingLoads.empty() || !pGraphicsEngine || !pGraphicsEngine->pResourceManager)
+		return;
 
-	if (m_bmi)
+	auto start = std::chrono::steady_clock::now();
+	DecodedImage image;
+
+	while (s_textureDecoder.TakeResult(image))
 	{
-		m_bmi->Name = m_name.c_str();
-		m_bmi->pBmp->m_nTrackingType = 2; // EQG
+		auto iter = s_pendingLoads.find(image.filename);
+		if (iter == s_pendingLoads.end())
+			continue;
 
-		s_textures.push_back(this);
+		MQTexturePtr texture = iter->second.lock();
+		s_pendingLoads.erase(iter);
+
+		// The texture went away, or someone asked for it with CreateTexture in the meantime.
+		if (!texture || !texture->IsLoading())
+			continue;
+
+		if (image.decoded)
+			texture->FinishLoading(image.pixels.data(), image.width, image.height);
+		else
+			texture->FinishLoading(true);
+
+		if (std::chrono::steady_clock::now() - start >= TEXTURE_LOAD_BUDGET)
+			break;
+	}
+}
+
+static void EvictUnusedTextures()
+{
+	auto now = std::chrono::steady_clock::now();
+	if (now - s_lastEviction < TEXTURE_EVICT_INTERVAL)
+		return;
+
+	s_lastEviction = now;
+	s_textureCache.Evict(now);
+}
+
+//============================================================================
+
+MQTexture::MQTexture(std::string_view name, bool deferred /* = false */)
+	: m_name(name)
+	, m_loading(deferred)
+{
+	if (!deferred)
+	{
+		FinishLoading(true);
 	}
 }
 
@@ -94,7 +229,9 @@ MQTexture::~MQTexture()
 
 void MQTexture::AcquireTexture()
 {
-	if (m_bmi == nullptr)
+	// Textures created from decoded pixels are created again by the resource manager once the
+	// device is back, the pixels aren't kept around.
+	if (m_bmi == nullptr && m_texture == nullptr)
 	{
 		BMI* bmi = pGraphicsEngine->pResourceManager->CreateBMI(m_name.c_str(), m_name.c_str(),
 			nullptr, eMemoryPoolManagerTypePersistent);
@@ -117,6 +254,108 @@ void MQTexture::AcquireTexture()
 	}
 }
 
+void MQTexture::FinishLoading(bool found)
+{
+	m_loading = false;
+
+	if (found && pGraphicsEngine && pGraphicsEngine->pResourceManager)
+	{
+		AcquireTexture();
+	}
+
+	if (m_bmi)
+	{
+		m_bmi->Name = m_name.c_str();
+		m_bmi->pBmp->m_nTrackingType = 2; // EQG
+
+		s_textures.push_back(this);
+	}
+}
+
+// Creates the texture from RGBA pixels decoded by the texture decoder. Falls back to CreateBMI
+// if the device can't create it.
+void MQTexture::FinishLoading(const uint8_t* pixels, int width, int height)
+{
+	m_loading = false;
+
+	if (!pGraphicsEngine || !pGraphicsEngine->pResourceManager)
+		return;
+
+#if HAS_DIRECTX_11
+	if (gpD3D11Device)
+	{
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = width;
+		desc.Height = height;
+		desc.MipLevels = 1;
+		desc.ArraySize = 1;
+		desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		desc.SampleDesc.Count = 1;
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+		D3D11_SUBRESOURCE_DATA subResource = {};
+		subResource.pSysMem = pixels;
+		subResource.SysMemPitch = width * 4;
+
+		wil::com_ptr_nothrow<ID3D11Texture2D> texture;
+		if (SUCCEEDED(gpD3D11Device->CreateTexture2D(&desc, &subResource, &texture)))
+		{
+			D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+			srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+			srvDesc.Texture2D.MipLevels = desc.MipLevels;
+			srvDesc.Texture2D.MostDetailedMip = 0;
+
+			ID3D11ShaderResourceView* view = nullptr;
+			if (SUCCEEDED(gpD3D11Device->CreateShaderResourceView(texture.get(), &srvDesc, &view)))
+				m_texture = view;
+		}
+	}
+#elif HAS_DIRECTX_9
+	if (gpD3D9Device)
+	{
+		wil::com_ptr_nothrow<IDirect3DTexture9> texture;
+		if (SUCCEEDED(gpD3D9Device->CreateTexture(width, height, 1, D3DUSAGE_DYNAMIC, D3DFMT_A8R8G8B8,
+			D3DPOOL_DEFAULT, &texture, nullptr)))
+		{
+			D3DLOCKED_RECT lockedRect;
+			if (texture->LockRect(0, &lockedRect, nullptr, 0) == D3D_OK)
+			{
+				// D3DFMT_A8R8G8B8 is BGRA in memory
+				for (int y = 0; y < height; ++y)
+				{
+					const uint8_t* src = pixels + static_cast<size_t>(width) * 4 * y;
+					uint8_t* dst = static_cast<uint8_t*>(lockedRect.pBits) + static_cast<size_t>(lockedRect.Pitch) * y;
+
+					for (int x = 0; x < width; ++x, src += 4, dst += 4)
+					{
+						dst[0] = src[2];
+						dst[1] = src[1];
+						dst[2] = src[0];
+						dst[3] = src[3];
+					}
+				}
+
+				texture->UnlockRect(0);
+				m_texture = texture.detach();
+			}
+		}
+	}
+#endif
+
+	if (m_texture == nullptr)
+	{
+		FinishLoading(true);
+		return;
+	}
+
+	m_width = width;
+	m_height = height;
+
+	s_textures.push_back(this);
+}
+
 void MQTexture::ReleaseTexture()
 {
 	if (m_bmi != nullptr)
@@ -124,10 +363,25 @@ void MQTexture::ReleaseTexture()
 		pGraphicsEngine->pResourceManager->DestroyBMI(m_bmi);
 		m_bmi = nullptr;
 	}
+
+	if (m_texture != nullptr)
+	{
+		m_texture->Release();
+		m_texture = nullptr;
+	}
 }
 
 ImTextureID MQTexture::GetTextureID() const
 {
+	if (m_texture)
+	{
+#if HAS_DIRECTX_11
+		return static_cast<ID3D11ShaderResourceView*>(m_texture);
+#else
+		return static_cast<IDirect3DTexture9*>(m_texture);
+#endif
+	}
+
 	if (m_bmi && m_bmi->pBmp)
 	{
 #if HAS_DIRECTX_11
@@ -142,6 +396,11 @@ ImTextureID MQTexture::GetTextureID() const
 
 CXSize MQTexture::GetTextureSize() const
 {
+	if (m_texture)
+	{
+		return CXSize(m_width, m_height);
+	}
+
 	if (m_bmi && m_bmi->pBmp)
 	{
 		return CXSize(m_bmi->pBmp->m_uWidth, m_bmi->pBmp->m_uHeight);
@@ -183,8 +442,16 @@ void GraphicsResources_Initialize()
 	s_renderCallbacksId = AddRenderCallbacks(callbacks);
 }
 
+void GraphicsResources_OnPulse()
+{
+	UpdateTextureLoads();
+	EvictUnusedTextures();
+}
+
 void GraphicsResources_Shutdown()
 {
+	s_textureDecoder.Stop();
+	s_pendingLoads.clear();
 	s_shutdown = true;
 
 	if (pGraphicsEngine && pGraphicsEngine->pResourceManager)
@@ -197,6 +464,9 @@ void GraphicsResources_Shutdown()
 
 	s_textures.clear();
 
+	// Textures handed out by CreateTexture stay in the cache until DestroyTexture is called.
+	s_textureCache.Clear();
+
 	RemoveRenderCallbacks(s_renderCallbacksId);
 }
 
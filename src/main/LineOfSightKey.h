@@ -0,0 +1,96 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+
+namespace mq {
+
+//----------------------------------------------------------------------------
+// Key for the line of sight cache. Spawn checks are keyed by the two spawn IDs, location
+// checks by the race that is used for the ray cast, and both by the quantized positions.
+
+// Positions are quantized to tolerance units. A tolerance of 0 keeps the exact value.
+inline int32_t QuantizeLineOfSightPosition(float value, float tolerance)
+{
+	if (tolerance > 0.0f)
+		return static_cast<int32_t>(std::floor(value / tolerance));
+
+	// -0 is the same position as 0
+	if (value == 0.0f)
+		value = 0.0f;
+
+	int32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+struct LineOfSightKey
+{
+	uint32_t sourceID = 0;
+	uint32_t targetID = 0;
+	int race = -1;                             // Only used by location checks
+	int32_t source[3] = { 0, 0, 0 };
+	int32_t target[3] = { 0, 0, 0 };
+
+	// Vector is anything with X, Y and Z
+	template <typename Vector>
+	void SetPositions(const Vector& sourcePos, const Vector& targetPos, float tolerance)
+	{
+		source[0] = QuantizeLineOfSightPosition(sourcePos.X, tolerance);
+		source[1] = QuantizeLineOfSightPosition(sourcePos.Y, tolerance);
+		source[2] = QuantizeLineOfSightPosition(sourcePos.Z, tolerance);
+		target[0] = QuantizeLineOfSightPosition(targetPos.X, tolerance);
+		target[1] = QuantizeLineOfSightPosition(targetPos.Y, tolerance);
+		target[2] = QuantizeLineOfSightPosition(targetPos.Z, tolerance);
+	}
+
+	bool operator==(const LineOfSightKey& other) const
+	{
+		return sourceID == other.sourceID
+			&& targetID == other.targetID
+			&& race == other.race
+			&& std::equal(std::begin(source), std::end(source), std::begin(other.source))
+			&& std::equal(std::begin(target), std::end(target), std::begin(other.target));
+	}
+};
+
+struct LineOfSightKeyHash
+{
+	size_t operator()(const LineOfSightKey& key) const
+	{
+		size_t hash = std::hash<uint64_t>()((static_cast<uint64_t>(key.sourceID) << 32) | key.targetID);
+
+		auto combine = [&hash](int32_t value)
+		{
+			hash ^= std::hash<int32_t>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		};
+
+		combine(key.race);
+		for (int32_t value : key.source)
+			combine(value);
+		for (int32_t value : key.target)
+			combine(value);
+
+		return hash;
+	}
+};
+
+} // namespace mq
@@ -0,0 +1,103 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace mq {
+
+struct LoadTimelineEntry
+{
+	std::string Name;
+	std::chrono::steady_clock::time_point Start;
+	std::chrono::microseconds Duration = std::chrono::microseconds::zero();
+	uint32_t ThreadId = 0;
+	int Depth = 0;
+	bool Finished = false;
+};
+
+//----------------------------------------------------------------------------
+// Timed phases of startup and plugin loading. Phases can be recorded from any thread, and a
+// phase is nested under the phases that are still running on the same thread.
+
+class LoadTimeline
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	// Plugins can be loaded and unloaded for the lifetime of the session, so cap the timeline.
+	static constexpr size_t MaxEntries = 1000;
+
+	// Returns the phase to pass to End, or -1 if the timeline is full.
+	int Begin(std::string_view name, uint32_t threadId, clock::time_point now = clock::now())
+	{
+		std::scoped_lock lock(m_mutex);
+
+		if (m_entries.size() >= MaxEntries)
+			return -1;
+
+		LoadTimelineEntry& entry = m_entries.emplace_back();
+		entry.Name = name;
+		entry.ThreadId = threadId;
+		entry.Depth = m_depths[threadId]++;
+		entry.Start = now;
+
+		return static_cast<int>(m_entries.size()) - 1;
+	}
+
+	void End(int phase, clock::time_point now = clock::now())
+	{
+		std::scoped_lock lock(m_mutex);
+
+		if (phase < 0 || phase >= static_cast<int>(m_entries.size()) || m_entries[phase].Finished)
+			return;
+
+		LoadTimelineEntry& entry = m_entries[phase];
+		entry.Duration = std::chrono::duration_cast<std::chrono::microseconds>(now - entry.Start);
+		entry.Finished = true;
+
+		--m_depths[entry.ThreadId];
+	}
+
+	std::vector<LoadTimelineEntry> GetEntries() const
+	{
+		std::scoped_lock lock(m_mutex);
+		return m_entries;
+	}
+
+	// Milliseconds from the start of the first phase
+	static double GetOffsetMS(const LoadTimelineEntry& entry, const LoadTimelineEntry& first)
+	{
+		return std::chrono::duration<double, std::milli>(entry.Start - first.Start).count();
+	}
+
+	static double GetDurationMS(const LoadTimelineEntry& entry)
+	{
+		return static_cast<double>(entry.Duration.count()) / 1000.;
+	}
+
+private:
+	mutable std::mutex m_mutex;
+	std::vector<LoadTimelineEntry> m_entries;
+	std::unordered_map<uint32_t, int> m_depths;         // running phases on each thread
+};
+
+} // namespace mq
@@ -14,6 +14,7 @@
 
 #include "pch.h"
 #include "MQ2Main.h"
+#include "LoadTimeline.h"
 
 namespace mq {
 
@@ -157,11 +158,96 @@ void DumpBenchmarks()
 	DebugSpewAlways("End Benchmarks");
 }
 
+//----------------------------------------------------------------------------
+// Load timeline
+
+static LoadTimeline s_loadTimeline;
+
+int BeginLoadPhase(std::string_view name)
+{
+	return s_loadTimeline.Begin(name, ::GetCurrentThreadId());
+}
+
+void EndLoadPhase(int phase)
+{
+	s_loadTimeline.End(phase);
+}
+
+static void ExportLoadTimeline(const std::vector<LoadTimelineEntry>& entries)
+{
+	std::filesystem::path filePath = std::filesystem::path(mq::internal_paths::Logs) / "LoadTimeline.csv";
+
+	FILE* file = _fsopen(filePath.string().c_str(), "wt", _SH_DENYWR);
+	if (!file)
+	{
+		WriteChatf("\arCould not open \ay%s\ar for writing.", filePath.string().c_str());
+		return;
+	}
+
+	fputs("Phase,Thread,Depth,StartMS,DurationMS\n", file);
+
+	for (const LoadTimelineEntry& entry : entries)
+	{
+		fmt::print(file, "\"{}\",{},{},{:.3f},{}\n", entry.Name, entry.ThreadId, entry.Depth, LoadTimeline::GetOffsetMS(entry, entries[0]),
+			entry.Finished ? fmt::format("{:.3f}", LoadTimeline::GetDurationMS(entry)) : std::string());
+	}
+
+	fclose(file);
+	WriteChatf("Load timeline written to \ay%s\ax", filePath.string().c_str());
+}
+
+void Cmd_LoadTimeline(SPAWNINFO* pChar, char* szLine)
+{
+	char szArg[MAX_STRING] = { 0 };
+	GetArg(szArg, szLine, 1);
+
+	const std::vector<LoadTimelineEntry> entries = s_loadTimeline.GetEntries();
+
+	if (entries.empty())
+	{
+		WriteChatColor("The load timeline is empty.");
+		return;
+	}
+
+	if (ci_equals(szArg, "export"))
+	{
+		ExportLoadTimeline(entries);
+		return;
+	}
+
+	if (szArg[0] != 0)
+	{
+		WriteChatColor("Usage: /loadtimeline [export]");
+		return;
+	}
+
+	WriteChatColor("Load Timeline");
+	WriteChatColor("-------------");
+
+	for (const LoadTimelineEntry& entry : entries)
+	{
+		if (entry.Finished)
+		{
+			WriteChatf("\at%10.3f\axms %*s\ay%s\ax \at%.3f\axms", LoadTimeline::GetOffsetMS(entry, entries[0]), entry.Depth * 2, "",
+				entry.Name.c_str(), LoadTimeline::GetDurationMS(entry));
+		}
+		else
+		{
+			WriteChatf("\at%10.3f\axms %*s\ay%s\ax \a-w(running)\ax", LoadTimeline::GetOffsetMS(entry, entries[0]), entry.Depth * 2, "",
+				entry.Name.c_str());
+		}
+	}
+
+	WriteChatColor("-------------");
+	WriteChatColor("End Load Timeline");
+}
+
 void InitializeMQ2Benchmarks()
 {
 	DebugSpew("Initializing MQ2 Benchmarks");;
 
 	AddCommand("/benchmark", Cmd_DumpBenchmarks, false, false);
+	AddCommand("/loadtimeline", Cmd_LoadTimeline, false, false);
 }
 
 void ShutdownMQ2Benchmarks()
@@ -170,6 +256,7 @@ void ShutdownMQ2Benchmarks()
 
 	DumpBenchmarks();
 	RemoveCommand("/benchmark");
+	RemoveCommand("/loadtimeline");
 
 	gBenchmarks.clear();
 }
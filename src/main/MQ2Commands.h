@@ -148,6 +148,7 @@ MQLIB_API void VarCalcCmd                          (PlayerClient* pChar, const c
 MQLIB_API void VarDataCmd                          (PlayerClient* pChar, const char* szLine);
 
 MQLIB_API void ProfileCmd                          (PlayerClient* pChar, const char* szLine);
+MQLIB_API void MacroCoverageCmd                    (PlayerClient* pChar, const char* szLine);
 MQLIB_API void ReloadUICmd                         (PlayerClient* pChar, const char* szLine);
 
 } // namespace mq
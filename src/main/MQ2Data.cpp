@@ -24,28 +24,22 @@ bool dataSelect(const char* szIndex, MQTypeVar& Ret)
 	if (!szIndex[0])
 		return false;
 
-	char szArg[MAX_STRING] = { 0 };
-	char szArg1[MAX_STRING] = { 0 };
-	int N = 2;
-	GetArg(szArg1, szIndex, 1, false, false, true);
-	while (true)
-	{
-		GetArg(szArg, szIndex, N, false, false, true);
-		N++;
-		if (!szArg[0])
-		{
-			Ret.DWord = 0;
-			Ret.Type = pIntType;
-			return true;
-		}
+	ArgTokenizer args(szIndex, true);
+
+	Ret.DWord = 0;
+	Ret.Type = pIntType;
 
-		if (!_stricmp(szArg1, szArg))
+	// The list of options ends at the first empty one
+	for (size_t N = 1; N < args.size() && !args[N].empty(); ++N)
+	{
+		if (ci_equals(args[0], args[N]))
 		{
-			Ret.DWord = N - 2;
-			Ret.Type = pIntType;
-			return true;
+			Ret.DWord = static_cast<uint32_t>(N);
+			break;
 		}
 	}
+
+	return true;
 }
 
 bool dataIf(const char* szIndex, MQTypeVar& Ret)
@@ -214,7 +208,7 @@ bool dataLineOfSight(const char* szIndex, MQTypeVar& Ret)
 
 		// This is possibly inaccurate because it adjusts the ray for the player model,
 		// despite not necessarily using player model as the source location.
-		Ret.Set(CastRayLoc(SourcePos, pControlledPlayer->GetRace(), DestPos.X, DestPos.Y, DestPos.Z));
+		Ret.Set(CachedCastRayLoc(SourcePos, pControlledPlayer->GetRace(), DestPos.X, DestPos.Y, DestPos.Z));
 		Ret.Type = pBoolType;
 		return true;
 	}
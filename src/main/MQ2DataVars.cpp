@@ -21,8 +21,51 @@
 using namespace mq::datatypes;
 namespace mq {
 
+// Defined in MQ2MacroCommands.cpp
+void InvalidateMacroLoopVariable(MQDataVar* pVar);
+
 static std::recursive_mutex s_dataVarMutex;
 
+// Locals and parameters are created and destroyed on every /call and /return, so
+// variables are recycled through a small free list. Guarded by s_dataVarMutex.
+static std::vector<MQDataVar*> s_freeDataVars;
+constexpr size_t MaxFreeDataVars = 128;
+
+static MQDataVar* AllocateDataVar()
+{
+	if (s_freeDataVars.empty())
+		return new MQDataVar;
+
+	MQDataVar* pVar = s_freeDataVars.back();
+	s_freeDataVars.pop_back();
+
+	return new (pVar) MQDataVar;
+}
+
+static void FreeDataVar(MQDataVar* pVar)
+{
+	if (s_freeDataVars.size() >= MaxFreeDataVars)
+	{
+		delete pVar;
+		return;
+	}
+
+	pVar->~MQDataVar();
+	s_freeDataVars.push_back(pVar);
+}
+
+void ClearFreeDataVariables()
+{
+	std::scoped_lock lock(s_dataVarMutex);
+
+	// These have already been destroyed, only their memory is left.
+	for (MQDataVar* pVar : s_freeDataVars)
+		::operator delete(pVar);
+
+	s_freeDataVars.clear();
+	s_freeDataVars.shrink_to_fit();
+}
+
 void DeleteMQ2DataVariable(MQDataVar* pVar)
 {
 	std::scoped_lock lock(s_dataVarMutex);
@@ -36,7 +79,8 @@ void DeleteMQ2DataVariable(MQDataVar* pVar)
 	else
 		*pVar->ppHead = pVar->pNext;
 	pVar->Var.Type->FreeVariable(pVar->Var.VarPtr);
-	delete pVar;
+	InvalidateMacroLoopVariable(pVar);
+	FreeDataVar(pVar);
 }
 
 MQDataVar* FindMacroVariable(const char* Name)
@@ -154,7 +198,7 @@ static bool AddMQ2DataEventVariable(const char* Name, const char* Index, MQ2Type
 		return false;
 
 	// create variable
-	MQDataVar* pVar = new MQDataVar;
+	MQDataVar* pVar = AllocateDataVar();
 	pVar->ppHead = ppHead;
 	pVar->pNext = *ppHead;
 	*ppHead = pVar;
@@ -202,7 +246,7 @@ static bool AddMQ2DataVariableBy(const char* Name, const char* Index, MQ2Type* p
 		return false;
 
 	// create variable
-	MQDataVar* pVar = new MQDataVar;
+	MQDataVar* pVar = AllocateDataVar();
 	pVar->ppHead = ppHead;
 	pVar->pNext = *ppHead;
 	*ppHead = pVar;
@@ -644,11 +688,152 @@ void VarDataCmd(PlayerClient* pChar, const char* szLine)
 	}
 }
 
+// Event buckets by name, only valid while a macro is running.
+static ci_unordered::map<std::string, MQEventBucket> s_eventBuckets;
+static MQEventQueue* s_eventQueueTail = nullptr;
+
+MQEventBucket* GetMacroEventBucket(const std::string& name, bool create)
+{
+	auto iter = s_eventBuckets.find(name);
+	if (iter != s_eventBuckets.end())
+		return &iter->second;
+
+	if (!create)
+		return nullptr;
+
+	MQEventBucket& bucket = s_eventBuckets[name];
+	bucket.Name = name;
+	return &bucket;
+}
+
+static MQEventBucket* GetMacroEventBucket(MQEventType Event)
+{
+	switch (Event)
+	{
+	case EVENT_CHAT: return GetMacroEventBucket("Chat", true);
+	case EVENT_TIMER: return GetMacroEventBucket("Timer", true);
+	default: return nullptr;
+	}
+}
+
+static void UnlinkMacroEvent(MQEventQueue* pEvent)
+{
+	if (pEvent->pPrev)
+		pEvent->pPrev->pNext = pEvent->pNext;
+	else
+		gEventQueue = pEvent->pNext;
+
+	if (pEvent->pNext)
+		pEvent->pNext->pPrev = pEvent->pPrev;
+	else
+		s_eventQueueTail = pEvent->pPrev;
+
+	if (MQEventBucket* pBucket = pEvent->pBucket)
+	{
+		if (pEvent->pBucketPrev)
+			pEvent->pBucketPrev->pBucketNext = pEvent->pBucketNext;
+		else
+			pBucket->pFirst = pEvent->pBucketNext;
+
+		if (pEvent->pBucketNext)
+			pEvent->pBucketNext->pBucketPrev = pEvent->pBucketPrev;
+		else
+			pBucket->pLast = pEvent->pBucketPrev;
+
+		--pBucket->Count;
+	}
+
+	pEvent->pPrev = pEvent->pNext = nullptr;
+	pEvent->pBucketPrev = pEvent->pBucketNext = nullptr;
+	pEvent->pBucket = nullptr;
+}
+
+static void DeleteMacroEvent(MQEventQueue* pEvent)
+{
+	ClearMQ2DataVariables(&pEvent->Parameters);
+	DebugSpewNoFile("Deleting event %d %s", pEvent->Type, pEvent->Name.c_str());
+
+	delete pEvent;
+}
+
+// Returns false if the bucket is full and keeps the events that are already queued.
+static bool CanQueueMacroEvent(MQEventBucket* pBucket)
+{
+	if (pBucket && pBucket->Limit > 0 && pBucket->Count >= pBucket->Limit && !pBucket->KeepLatest)
+	{
+		++pBucket->Dropped;
+		return false;
+	}
+
+	return true;
+}
+
+static void QueueMacroEvent(MQEventQueue* pEvent, MQEventBucket* pBucket)
+{
+	if (pBucket)
+	{
+		// Make room by dropping the oldest event of this kind
+		if (pBucket->Limit > 0 && pBucket->Count >= pBucket->Limit && pBucket->pFirst)
+		{
+			MQEventQueue* pOldest = pBucket->pFirst;
+			UnlinkMacroEvent(pOldest);
+			DeleteMacroEvent(pOldest);
+
+			++pBucket->Dropped;
+		}
+
+		pEvent->pBucket = pBucket;
+		pEvent->pBucketPrev = pBucket->pLast;
+		if (pBucket->pLast)
+			pBucket->pLast->pBucketNext = pEvent;
+		else
+			pBucket->pFirst = pEvent;
+		pBucket->pLast = pEvent;
+
+		++pBucket->Count;
+		++pBucket->Queued;
+	}
+
+	pEvent->pPrev = s_eventQueueTail;
+	if (s_eventQueueTail)
+		s_eventQueueTail->pNext = pEvent;
+	else
+		gEventQueue = pEvent;
+	s_eventQueueTail = pEvent;
+}
+
+MQEventQueue* PopMacroEvent(MQEventBucket* pBucket)
+{
+	MQEventQueue* pEvent = pBucket ? pBucket->pFirst : gEventQueue;
+	if (pEvent)
+		UnlinkMacroEvent(pEvent);
+
+	return pEvent;
+}
+
+void FlushMacroEvents(MQEventBucket* pBucket)
+{
+	while (MQEventQueue* pEvent = PopMacroEvent(pBucket))
+	{
+		DeleteMacroEvent(pEvent);
+	}
+}
+
+void ClearMacroEvents()
+{
+	FlushMacroEvents(nullptr);
+	s_eventBuckets.clear();
+}
+
 static void AddEvent(MQEventType Event, const char* FirstArg, ...)
 {
 	if (!gEventFunc[Event])
 		return;
 
+	MQEventBucket* pBucket = GetMacroEventBucket(Event);
+	if (!CanQueueMacroEvent(pBucket))
+		return;
+
 	// this is deleted in 2 locations DoEvents and EndMacro
 	DebugSpewNoFile("Adding Event %d %s", Event, FirstArg);
 
@@ -689,17 +874,7 @@ static void AddEvent(MQEventType Event, const char* FirstArg, ...)
 		va_end(marker);
 	}
 
-	if (!gEventQueue)
-	{
-		gEventQueue = pEvent;
-	}
-	else
-	{
-		MQEventQueue* pTemp;
-		for (pTemp = gEventQueue; pTemp->pNext; pTemp = pTemp->pNext) {}
-		pTemp->pNext = pEvent;
-		pEvent->pPrev = pTemp;
-	}
+	QueueMacroEvent(pEvent, pBucket);
 }
 
 void CALLBACK EventBlechCallback(unsigned int ID, void* pData, PBLECHVALUE pValues)
@@ -714,11 +889,10 @@ void CALLBACK EventBlechCallback(unsigned int ID, void* pData, PBLECHVALUE pValu
 		return;
 	}
 
-	MQEventQueue* pEvent = new MQEventQueue();
-	if (!pEvent)
+	if (!CanQueueMacroEvent(pEList->pBucket))
 		return;
 
-	ZeroMemory(pEvent, sizeof(MQEventQueue));
+	MQEventQueue* pEvent = new MQEventQueue();
 	pEvent->Type = EVENT_CUSTOM;
 	pEvent->pEventList = pEList;
 	char szParamName[MAX_STRING] = { 0 };
@@ -756,17 +930,7 @@ void CALLBACK EventBlechCallback(unsigned int ID, void* pData, PBLECHVALUE pValu
 		pValues = pValues->pNext;
 	}
 
-	if (!gEventQueue)
-	{
-		gEventQueue = pEvent;
-	}
-	else
-	{
-		MQEventQueue* pTemp;
-		for (pTemp = gEventQueue; pTemp->pNext; pTemp = pTemp->pNext) {}
-		pTemp->pNext = pEvent;
-		pEvent->pPrev = pTemp;
-	}
+	QueueMacroEvent(pEvent, pEList->pBucket);
 }
 
 static DWORD CALLBACK BeepOnTellThread(void* pData)
@@ -16,6 +16,8 @@
 #include "MQ2DeveloperTools.h"
 
 #include "imgui/ImGuiUtils.h"
+#include "imgui/ImGuiFileDialog.h"
+#include "imgui/ImGuiTextEditor.h"
 #include "imgui/fonts/IconsFontAwesome.h"
 #include "imgui/implot/implot.h"
 #include "imgui/misc/cpp/imgui_stdlib.h"
@@ -23,8 +25,11 @@
 #include <mq/imgui/Widgets.h>
 
 #include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include <memory>
 #include <string>
+#include <thread>
 #include <unordered_map>
 
 #include <fmt/format.h>
@@ -4279,6 +4284,46 @@ public:
 			DrawTable();
 		}
 
+		if (ImGui::CollapsingHeader("Syntax Highlighting"))
+		{
+			DrawSyntaxHighlighting();
+		}
+
+		if (ImGui::CollapsingHeader("File Dialog Scan"))
+		{
+			DrawFileDialogScan();
+		}
+
+		if (ImGui::CollapsingHeader("Texture Cache"))
+		{
+			DrawTextureCache();
+		}
+
+		if (ImGui::CollapsingHeader("Spell Stacking"))
+		{
+			DrawSpellStacking();
+		}
+
+		if (ImGui::CollapsingHeader("Event Matching"))
+		{
+			DrawEventMatching();
+		}
+
+		if (ImGui::CollapsingHeader("Main Thread Queue"))
+		{
+			DrawMainThreadQueue();
+		}
+
+		if (ImGui::CollapsingHeader("Spawn Search"))
+		{
+			DrawSpawnSearch();
+		}
+
+		if (ImGui::CollapsingHeader("Macro Loading"))
+		{
+			DrawMacroLoading();
+		}
+
 		ResetLastTimes();
 	}
 
@@ -4420,7 +4465,699 @@ public:
 		}
 	}
 
+	void DrawSyntaxHighlighting()
+	{
+		ImGui::TextWrapped("Colors a %d line file with each of the built in language definitions.", SYNTAX_HIGHLIGHTING_LINES);
+
+		if (ImGui::Button("Run"))
+		{
+			RunSyntaxHighlighting();
+		}
+
+		for (const auto& [name, milliseconds] : m_syntaxHighlightingResults)
+		{
+			ImGui::Text("%s: %.3f ms", name.c_str(), milliseconds);
+		}
+	}
+
+	void RunSyntaxHighlighting()
+	{
+		using namespace mq::imgui::texteditor;
+
+		static const char* const macroSample =
+			"|** Block comment\n"
+			"    spanning lines **|\n"
+			"#event Tell \"#1# tells you, '#2#'\"\n"
+			"Sub Main(int count)\n"
+			"    /declare i int local 0\n"
+			"    | count up to the limit\n"
+			"    /for i 1 to ${count}\n"
+			"        /if (${Me.PctHPs} < 50 && ${Target.ID}) /varset count ${Math.Calc[${count} - 1]}\n"
+			"        /echo ${If[${Spawn[npc radius 50].ID},\"found\",\"none\"]}\n"
+			"    /next i\n"
+			"/return\n";
+
+		static const char* const luaSample =
+			"--[[ Block comment\n"
+			"     spanning lines ]]\n"
+			"local mq = require('mq')\n"
+			"local function main(count)\n"
+			"    -- count up to the limit\n"
+			"    for i = 1, count do\n"
+			"        if mq.TLO.Me.PctHPs() < 50 and mq.TLO.Target.ID() > 0 then count = count - 1 end\n"
+			"        print(string.format(\"%d\", i))\n"
+			"    end\n"
+			"end\n";
+
+		static const char* const cppSample =
+			"/* Block comment\n"
+			"   spanning lines */\n"
+			"#include <vector>\n"
+			"int main(int count)\n"
+			"{\n"
+			"    // count up to the limit\n"
+			"    for (int i = 0; i < count; ++i)\n"
+			"        if (std::max(i, 50) < 0x50 && count > 1.5f) count -= 1;\n"
+			"    return 'a';\n"
+			"}\n";
+
+		static const char* const sqlSample =
+			"/* Block comment\n"
+			"   spanning lines */\n"
+			"SELECT name, COUNT(*) FROM items -- count them\n"
+			"WHERE id > 50 AND name LIKE 'abc%'\n"
+			"GROUP BY name;\n";
+
+		auto run = [this](const LanguageDefinition& language, std::string_view sample)
+		{
+			const int sampleLines = static_cast<int>(std::count(sample.begin(), sample.end(), '\n'));
+
+			std::string text;
+			text.reserve((SYNTAX_HIGHLIGHTING_LINES / sampleLines + 1) * sample.size());
+			for (int lines = 0; lines < SYNTAX_HIGHLIGHTING_LINES; lines += sampleLines)
+				text.append(sample);
+
+			TextEditor editor;
+			editor.SetLanguageDefinition(language);
+			editor.SetText(text);
+
+			auto start = std::chrono::steady_clock::now();
+			editor.ColorizeAll();
+			std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+			m_syntaxHighlightingResults.emplace_back(language.name, elapsed.count());
+		};
+
+		m_syntaxHighlightingResults.clear();
+
+		run(LanguageDefinition::Macro(), macroSample);
+		run(LanguageDefinition::Lua(), luaSample);
+		run(LanguageDefinition::CPlusPlus(), cppSample);
+		run(LanguageDefinition::HLSL(), cppSample);
+		run(LanguageDefinition::SQL(), sqlSample);
+	}
+
+	void DrawFileDialogScan()
+	{
+		ImGui::TextWrapped("Scans a directory of %d files with the file dialog, then sorts it again by size. "
+			"The files are created in the temp directory by the first run.", FILE_DIALOG_SCAN_FILES);
+
+		if (ImGui::Button("Run##FileDialogScan"))
+		{
+			RunFileDialogScan();
+		}
+
+		for (const std::string& result : m_fileDialogScanResults)
+		{
+			ImGui::TextUnformatted(result.c_str());
+		}
+	}
+
+	void RunFileDialogScan()
+	{
+		std::error_code ec;
+		const std::filesystem::path path = std::filesystem::temp_directory_path(ec) / "MacroQuest File Dialog Benchmark";
+
+		if (!std::filesystem::exists(path / fmt::format("file{:06}.txt", FILE_DIALOG_SCAN_FILES - 1), ec))
+		{
+			std::filesystem::create_directories(path, ec);
+
+			for (int i = 0; i < FILE_DIALOG_SCAN_FILES; ++i)
+			{
+				std::ofstream(path / fmt::format("file{:06}.txt", i)) << std::string(i % 1024, 'x');
+			}
+		}
+
+		IGFD::FileDialogInternal dialog;
+		dialog.filterManager.ParseFilters(".*");
+		dialog.filterManager.SetDefaultFilterIfNotDefined();
+
+		// The time spent in the calls made by the ui thread is what would stall the frame, the
+		// rest of the work is done by the scan thread.
+		auto run = [&](std::string_view name, const std::function<void()>& start)
+		{
+			using milliseconds = std::chrono::duration<float, std::milli>;
+
+			auto begin = std::chrono::steady_clock::now();
+			start();
+			milliseconds blocked = std::chrono::steady_clock::now() - begin;
+			milliseconds longest = blocked;
+			int updates = 0;
+
+			while (dialog.fileManager.IsScanning())
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+				auto updateBegin = std::chrono::steady_clock::now();
+				dialog.fileManager.UpdateScan(dialog);
+				milliseconds update = std::chrono::steady_clock::now() - updateBegin;
+
+				blocked += update;
+				longest = (std::max)(longest, update);
+				++updates;
+			}
+
+			milliseconds total = std::chrono::steady_clock::now() - begin;
+
+			m_fileDialogScanResults.push_back(fmt::format("{}: {} files in {:.3f} ms, ui thread {:.3f} ms over {} updates (longest {:.3f} ms)",
+				name, dialog.fileManager.GetFullFileListSize(), total.count(), blocked.count(), updates, longest.count()));
+		};
+
+		m_fileDialogScanResults.clear();
+
+		run("Scan", [&]() { dialog.fileManager.ScanDir(dialog, path.string()); });
+
+		dialog.fileManager.sortingField = IGFD::FileManager::SortingFieldEnum::FIELD_SIZE;
+		run("Sort by size", [&]() { dialog.fileManager.SortFields(dialog); });
+	}
+
+	void DrawTextureCache()
+	{
+		ImGui::TextWrapped("Creates a texture from an image file %d times without the cache, then %d times "
+			"through the cache.", TEXTURE_UNCACHED_LOADS, TEXTURE_CACHED_LOADS);
+
+		ImGui::InputText("Image file", &m_textureCacheFile);
+
+		if (ImGui::Button("Run##TextureCache"))
+		{
+			RunTextureCache();
+		}
+
+		for (const std::string& result : m_textureCacheResults)
+		{
+			ImGui::TextUnformatted(result.c_str());
+		}
+	}
+
+	void RunTextureCache()
+	{
+		using milliseconds = std::chrono::duration<float, std::milli>;
+
+		m_textureCacheResults.clear();
+
+		if (!pGraphicsEngine || !pGraphicsEngine->pResourceManager)
+		{
+			m_textureCacheResults.push_back("The graphics engine is not available");
+			return;
+		}
+
+		// Each load goes through the resource manager, which is what CreateTexture used to do every time.
+		auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < TEXTURE_UNCACHED_LOADS; ++i)
+		{
+			MQTexture texture(m_textureCacheFile);
+			if (!texture.IsValid())
+			{
+				m_textureCacheResults.push_back(fmt::format("Could not load {}", m_textureCacheFile));
+				return;
+			}
+		}
+		milliseconds uncached = std::chrono::steady_clock::now() - begin;
+
+		begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < TEXTURE_CACHED_LOADS; ++i)
+		{
+			MQTexturePtr texture = CreateTexturePtr(m_textureCacheFile);
+		}
+		milliseconds cached = std::chrono::steady_clock::now() - begin;
+
+		m_textureCacheResults.push_back(fmt::format("Uncached: {} loads in {:.3f} ms ({:.3f} ms per load)",
+			TEXTURE_UNCACHED_LOADS, uncached.count(), uncached.count() / TEXTURE_UNCACHED_LOADS));
+		m_textureCacheResults.push_back(fmt::format("Cached: {} loads in {:.3f} ms ({:.4f} ms per load)",
+			TEXTURE_CACHED_LOADS, cached.count(), cached.count() / TEXTURE_CACHED_LOADS));
+	}
+
+	void DrawSpellStacking()
+	{
+		SpellStackingCacheStats stats = GetSpellStackingCacheStats();
+		uint64_t lookups = stats.Hits + stats.Misses;
+
+		ImGui::Text("Stacking cache: %d entries, %llu hits, %llu misses (%.1f%% hit rate)", static_cast<int>(stats.Entries),
+			stats.Hits, stats.Misses, lookups ? 100.0 * stats.Hits / lookups : 0.0);
+
+		ImGui::SameLine();
+		if (ImGui::SmallButton("Clear##SpellStacking"))
+		{
+			ClearSpellStackingCache(true);
+		}
+
+		ImGui::TextWrapped("Checks whether %d buffs stack on a synthetic raid of %d members with %d buffs each, "
+			"first with an empty stacking cache and then again with the cache filled.",
+			SPELL_STACKING_CANDIDATES, SPELL_STACKING_MEMBERS, SPELL_STACKING_BUFFS);
+
+		if (ImGui::Button("Run##SpellStacking"))
+		{
+			RunSpellStacking();
+		}
+
+		for (const std::string& result : m_spellStackingResults)
+		{
+			ImGui::TextUnformatted(result.c_str());
+		}
+	}
+
+	void RunSpellStacking()
+	{
+		using milliseconds = std::chrono::duration<float, std::milli>;
+
+		m_spellStackingResults.clear();
+
+		if (!pLocalPC || !pLocalPlayer)
+		{
+			m_spellStackingResults.push_back("Must be in game to run this benchmark");
+			return;
+		}
+
+		// Use the beneficial buffs from the spell database to build the raid's buffs.
+		std::vector<EQ_Spell*> buffs;
+		for (int spellId = 1; spellId < TOTAL_SPELL_COUNT; ++spellId)
+		{
+			EQ_Spell* pSpell = GetSpellByID(spellId);
+			if (pSpell && pSpell->SpellType != SpellType_Detrimental && pSpell->DurationType != 0)
+				buffs.push_back(pSpell);
+		}
+
+		if (buffs.size() < static_cast<size_t>(SPELL_STACKING_BUFFS))
+		{
+			m_spellStackingResults.push_back("Not enough buffs in the spell database");
+			return;
+		}
+
+		auto buffAt = [&](size_t index) { return buffs[(index * 7919) % buffs.size()]; };
+
+		auto run = [&]()
+		{
+			int stacking = 0;
+
+			for (int candidate = 0; candidate < SPELL_STACKING_CANDIDATES; ++candidate)
+			{
+				EQ_Spell* pSpell = buffAt(candidate * 31);
+
+				for (int member = 0; member < SPELL_STACKING_MEMBERS; ++member)
+				{
+					bool stacks = true;
+
+					for (int buff = 0; buff < SPELL_STACKING_BUFFS && stacks; ++buff)
+					{
+						stacks = WillStackWith(pSpell, buffAt(member * 3 + buff * 13));
+					}
+
+					stacking += stacks;
+				}
+			}
+
+			return stacking;
+		};
+
+		ClearSpellStackingCache();
+		SpellStackingCacheStats before = GetSpellStackingCacheStats();
+
+		auto begin = std::chrono::steady_clock::now();
+		int coldStacking = run();
+		milliseconds cold = std::chrono::steady_clock::now() - begin;
+
+		begin = std::chrono::steady_clock::now();
+		int warmStacking = run();
+		milliseconds warm = std::chrono::steady_clock::now() - begin;
+
+		SpellStackingCacheStats after = GetSpellStackingCacheStats();
+
+		m_spellStackingResults.push_back(fmt::format("Empty cache: {:.3f} ms, {} of {} checks stack",
+			cold.count(), coldStacking, SPELL_STACKING_CANDIDATES * SPELL_STACKING_MEMBERS));
+		m_spellStackingResults.push_back(fmt::format("Filled cache: {:.3f} ms, {} of {} checks stack",
+			warm.count(), warmStacking, SPELL_STACKING_CANDIDATES * SPELL_STACKING_MEMBERS));
+		m_spellStackingResults.push_back(fmt::format("{} hits, {} misses, {} entries",
+			after.Hits - before.Hits, after.Misses - before.Misses, after.Entries));
+	}
+
+	void DrawEventMatching()
+	{
+		ImGui::TextWrapped("Feeds chat lines through a Blech with %d #event patterns, %d times. Lines are read "
+			"from the log file if one is given, with the timestamps removed, otherwise %d synthetic lines are used.",
+			EVENT_MATCHING_EVENTS, EVENT_MATCHING_PASSES, EVENT_MATCHING_LINES);
+
+		ImGui::InputText("Log file", &m_eventMatchingFile);
+
+		if (ImGui::Button("Run##EventMatching"))
+		{
+			RunEventMatching();
+		}
+
+		for (const std::string& result : m_eventMatchingResults)
+		{
+			ImGui::TextUnformatted(result.c_str());
+		}
+	}
+
+	static void CALLBACK EventMatchingCallback(unsigned int ID, void* pData, PBLECHVALUE pValues)
+	{
+		++*static_cast<int*>(pData);
+	}
+
+	void RunEventMatching()
+	{
+		using milliseconds = std::chrono::duration<float, std::milli>;
+
+		m_eventMatchingResults.clear();
+
+		std::vector<std::string> lines;
+		if (!m_eventMatchingFile.empty())
+		{
+			std::ifstream file(m_eventMatchingFile);
+			if (!file)
+			{
+				m_eventMatchingResults.push_back(fmt::format("Could not open {}", m_eventMatchingFile));
+				return;
+			}
+
+			std::string line;
+			while (std::getline(file, line))
+			{
+				// [Mon Jan 01 00:00:00 2024] text
+				if (line[0] == '[')
+				{
+					size_t end = line.find("] ");
+					if (end != std::string::npos)
+						line.erase(0, end + 2);
+				}
+
+				if (!line.empty() && line.length() < MAX_STRING)
+					lines.push_back(std::move(line));
+			}
+		}
+		else
+		{
+			for (int i = 0; i < EVENT_MATCHING_LINES; ++i)
+			{
+				switch (i % 5)
+				{
+				case 0: lines.push_back(fmt::format("A gnoll pup hits YOU for {} points of damage.", i % 300)); break;
+				case 1: lines.push_back(fmt::format("Soandso tells you, 'inc {}'", i % 50)); break;
+				case 2: lines.push_back("a gnoll pup has been slain by Soandso!"); break;
+				case 3: lines.push_back(fmt::format("You have gained {} experience!", i % 1000)); break;
+				default: lines.push_back("You begin casting Complete Heal."); break;
+				}
+			}
+		}
+
+		int matches = 0;
+		Blech blech('#');
+
+		static const char* patterns[] = {
+			"#1# hits YOU for #2# points of damage.",
+			"#1# tells you, '#2#'",
+			"#*#has been slain by#*#",
+			"You have gained #1# experience#*#",
+			"#1# tells the group, '#2#'",
+			"Your #1# spell has worn off of #2#.",
+		};
+
+		for (int i = 0; i < EVENT_MATCHING_EVENTS; ++i)
+		{
+			const char* pattern = patterns[i % lengthof(patterns)];
+
+			// Only the first copy of each pattern is a real event, the rest differ by a suffix
+			// so the tree has as many events as a big macro and a few Lua scripts would have.
+			if (static_cast<size_t>(i) < lengthof(patterns))
+				blech.AddEvent(pattern, EventMatchingCallback, &matches);
+			else
+				blech.AddEvent(fmt::format("{} {}", pattern, i).c_str(), EventMatchingCallback, &matches);
+		}
+
+		char buffer[MAX_STRING];
+
+		auto begin = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < EVENT_MATCHING_PASSES; ++pass)
+		{
+			for (const std::string& line : lines)
+			{
+				strcpy_s(buffer, line.c_str());
+				blech.Feed(buffer);
+			}
+		}
+		milliseconds elapsed = std::chrono::steady_clock::now() - begin;
+
+		size_t fed = lines.size() * EVENT_MATCHING_PASSES;
+		m_eventMatchingResults.push_back(fmt::format("{} lines in {:.3f} ms ({:.3f} us per line), {} matches",
+			fed, elapsed.count(), fed ? elapsed.count() * 1000.0f / fed : 0.0f, matches));
+	}
+
+	void DrawMainThreadQueue()
+	{
+		using microseconds = std::chrono::duration<float, std::micro>;
+
+		MainThreadQueueStats stats = GetMainThreadQueueStats();
+		const float executed = static_cast<float>(std::max<uint64_t>(stats.executed, 1));
+
+		ImGui::Text("Posted: %llu  Executed: %llu  Depth: %d (max %d)", stats.posted, stats.executed,
+			static_cast<int>(stats.depth), static_cast<int>(stats.maxDepth));
+		ImGui::Text("Carried over: %llu pulses  Run past budget: %llu", stats.carriedOver, stats.overdue);
+		ImGui::Text("Wait: %.1f us avg, %.1f us max", microseconds(stats.totalWait).count() / executed,
+			microseconds(stats.maxWait).count());
+		ImGui::Text("Cost: %.2f us avg, %.1f us max, last pulse %.1f us", microseconds(stats.totalCost).count() / executed,
+			microseconds(stats.maxCost).count(), microseconds(stats.lastProcess).count());
+
+		if (ImGui::Button("Reset##MainThreadQueue"))
+		{
+			ResetMainThreadQueueStats();
+		}
+
+		ImGui::SameLine();
+		if (ImGui::Button("Flood##MainThreadQueue"))
+		{
+			RunMainThreadQueueFlood();
+		}
+
+		ImGui::SameLine();
+		ImGui::TextWrapped("Posts %d tasks from each of %d threads. Each task takes about %d us.",
+			MAIN_THREAD_QUEUE_TASKS, MAIN_THREAD_QUEUE_PRODUCERS, MAIN_THREAD_QUEUE_TASK_US);
+
+		if (m_mainThreadQueueFloodRan)
+		{
+			ImGui::Text("Flood: %d of %d run, posted in %.3f ms", *m_mainThreadQueueFloodRan,
+				MAIN_THREAD_QUEUE_TASKS * MAIN_THREAD_QUEUE_PRODUCERS, m_mainThreadQueueFloodPostTime);
+		}
+	}
+
+	void RunMainThreadQueueFlood()
+	{
+		using milliseconds = std::chrono::duration<float, std::milli>;
+
+		// The count is shared with the tasks so it stays valid if this window goes away first
+		auto ran = std::make_shared<int>(0);
+		m_mainThreadQueueFloodRan = ran;
+
+		auto begin = std::chrono::steady_clock::now();
+
+		std::vector<std::thread> producers;
+		for (int i = 0; i < MAIN_THREAD_QUEUE_PRODUCERS; ++i)
+		{
+			producers.emplace_back([ran]()
+			{
+				for (int task = 0; task < MAIN_THREAD_QUEUE_TASKS; ++task)
+				{
+					PostToMainThread([ran]()
+					{
+						auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(MAIN_THREAD_QUEUE_TASK_US);
+						while (std::chrono::steady_clock::now() < end) {}
+
+						++*ran;
+					});
+				}
+			});
+		}
+
+		for (std::thread& producer : producers)
+		{
+			producer.join();
+		}
+
+		m_mainThreadQueueFloodPostTime = milliseconds(std::chrono::steady_clock::now() - begin).count();
+	}
+
+	void DrawSpawnSearch()
+	{
+		ImGui::TextWrapped("Runs a spawn search %d times as ${Spawn[]} and ${SpawnCount[]} would, with the "
+			"spawn name index and without it.", SPAWN_SEARCH_PASSES);
+
+		ImGui::InputText("Search", &m_spawnSearchText);
+
+		if (ImGui::Button("Run##SpawnSearch"))
+		{
+			RunSpawnSearch();
+		}
+
+		for (const std::string& result : m_spawnSearchResults)
+		{
+			ImGui::TextUnformatted(result.c_str());
+		}
+	}
+
+	void RunSpawnSearch()
+	{
+		using milliseconds = std::chrono::duration<float, std::milli>;
+
+		m_spawnSearchResults.clear();
+
+		if (!pLocalPlayer)
+		{
+			m_spawnSearchResults.push_back("Not in game");
+			return;
+		}
+
+		MQSpawnSearch search;
+		ClearSearchSpawn(&search);
+		ParseSearchSpawn(m_spawnSearchText.c_str(), &search);
+
+		const bool wasEnabled = IsSpawnNameIndexEnabled();
+
+		for (bool useIndex : { false, true })
+		{
+			SetSpawnNameIndexEnabled(useIndex);
+
+			SPAWNINFO* pFound = nullptr;
+			int count = 0;
+
+			auto begin = std::chrono::steady_clock::now();
+			for (int pass = 0; pass < SPAWN_SEARCH_PASSES; ++pass)
+			{
+				pFound = NthNearestSpawn(&search, 1, pLocalPlayer, true);
+				count = CountMatchingSpawns(&search, pLocalPlayer, true);
+			}
+			milliseconds elapsed = std::chrono::steady_clock::now() - begin;
+
+			m_spawnSearchResults.push_back(fmt::format("{}: {:.3f} ms ({:.3f} us per search), {} matches, nearest {}",
+				useIndex ? "Index" : "Full scan", elapsed.count(), elapsed.count() * 1000.0f / (SPAWN_SEARCH_PASSES * 2),
+				count, pFound ? pFound->Name : "none"));
+		}
+
+		SetSpawnNameIndexEnabled(wasEnabled);
+	}
+
+	void DrawMacroLoading()
+	{
+		ImGui::TextWrapped("Generates a %d line macro with %d includes and %d #defines in the temp folder, and "
+			"preprocesses it %d times without the macro cache and %d times with it.", MACRO_LOADING_LINES,
+			MACRO_LOADING_INCLUDES, MACRO_LOADING_DEFINES, MACRO_LOADING_PASSES, MACRO_LOADING_PASSES);
+
+		if (ImGui::Button("Run##MacroLoading"))
+		{
+			RunMacroLoading();
+		}
+
+		for (const std::string& result : m_macroLoadingResults)
+		{
+			ImGui::TextUnformatted(result.c_str());
+		}
+	}
+
+	void RunMacroLoading()
+	{
+		using milliseconds = std::chrono::duration<float, std::milli>;
+
+		m_macroLoadingResults.clear();
+
+		std::error_code ec;
+		const std::filesystem::path folder = std::filesystem::temp_directory_path(ec) / "MacroLoadBenchmark";
+		std::filesystem::create_directories(folder, ec);
+
+		const std::filesystem::path macroPath = folder / "MacroLoadBenchmark.mac";
+		{
+			std::ofstream macro(macroPath);
+			macro << "#turbo 500\n";
+
+			for (int i = 0; i < MACRO_LOADING_DEFINES; ++i)
+				macro << "#define LIMIT" << i << " " << i << "\n";
+
+			for (int i = 0; i < MACRO_LOADING_INCLUDES; ++i)
+				macro << "#include MacroLoadBenchmark" << i << ".inc\n";
+
+			macro << "\nSub Main\n/echo done\n/return\n";
+		}
+
+		const int linesPerInclude = MACRO_LOADING_LINES / MACRO_LOADING_INCLUDES;
+		for (int i = 0; i < MACRO_LOADING_INCLUDES; ++i)
+		{
+			std::ofstream include(folder / fmt::format("MacroLoadBenchmark{}.inc", i));
+
+			for (int line = 0; line < linesPerInclude; ++line)
+			{
+				switch (line % 10)
+				{
+				case 0: include << "Sub Bench" << i << "_" << line << "\n"; break;
+				case 1: include << "\t/declare total int local 0\n"; break;
+				case 2: include << "\t| check the limit\n"; break;
+				case 8: include << "\t/varcalc total ${total}+LIMIT" << line % MACRO_LOADING_DEFINES << "\n"; break;
+				case 9: include << "/return ${total}\n"; break;
+				default:
+					include << "\t/if (${Me.PctHPs} < LIMIT" << line % MACRO_LOADING_DEFINES
+						<< " && ${Target.ID}) /echo LIMIT" << (line + 1) % MACRO_LOADING_DEFINES << "\n";
+					break;
+				}
+			}
+		}
+
+		std::shared_ptr<const MQMacroImage> image;
+
+		auto begin = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < MACRO_LOADING_PASSES; ++pass)
+			image = LoadMacroImage(macroPath, false);
+		milliseconds uncached = std::chrono::steady_clock::now() - begin;
+
+		LoadMacroImage(macroPath, true);
+
+		begin = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < MACRO_LOADING_PASSES; ++pass)
+			image = LoadMacroImage(macroPath, true);
+		milliseconds cached = std::chrono::steady_clock::now() - begin;
+
+		if (image)
+		{
+			m_macroLoadingResults.push_back(fmt::format("{} lines from {} files", image->Lines.size(), image->Sources.size()));
+			m_macroLoadingResults.push_back(fmt::format("Preprocessed: {:.3f} ms per load", uncached.count() / MACRO_LOADING_PASSES));
+			m_macroLoadingResults.push_back(fmt::format("Cached: {:.3f} ms per load", cached.count() / MACRO_LOADING_PASSES));
+		}
+		else
+		{
+			m_macroLoadingResults.push_back(fmt::format("Could not load {}", macroPath.string()));
+		}
+
+		std::filesystem::remove_all(folder, ec);
+	}
+
 private:
+	static constexpr int SYNTAX_HIGHLIGHTING_LINES = 20000;
+	static constexpr int FILE_DIALOG_SCAN_FILES = 100000;
+	static constexpr int TEXTURE_UNCACHED_LOADS = 20;
+	static constexpr int TEXTURE_CACHED_LOADS = 1000;
+	static constexpr int SPELL_STACKING_CANDIDATES = 20;
+	static constexpr int SPELL_STACKING_MEMBERS = 72;
+	static constexpr int SPELL_STACKING_BUFFS = 40;
+	static constexpr int EVENT_MATCHING_EVENTS = 200;
+	static constexpr int EVENT_MATCHING_LINES = 10000;
+	static constexpr int EVENT_MATCHING_PASSES = 10;
+	static constexpr int MAIN_THREAD_QUEUE_PRODUCERS = 4;
+	static constexpr int MAIN_THREAD_QUEUE_TASKS = 5000;
+	static constexpr int MAIN_THREAD_QUEUE_TASK_US = 5;
+	static constexpr int SPAWN_SEARCH_PASSES = 1000;
+	static constexpr int MACRO_LOADING_LINES = 50000;
+	static constexpr int MACRO_LOADING_INCLUDES = 4;
+	static constexpr int MACRO_LOADING_DEFINES = 100;
+	static constexpr int MACRO_LOADING_PASSES = 5;
+
+	std::vector<std::pair<std::string, float>> m_syntaxHighlightingResults;
+	std::vector<std::string> m_fileDialogScanResults;
+	std::vector<std::string> m_textureCacheResults;
+	std::vector<std::string> m_spellStackingResults;
+	std::vector<std::string> m_eventMatchingResults;
+	std::string m_eventMatchingFile;
+	std::shared_ptr<int> m_mainThreadQueueFloodRan;
+	float m_mainThreadQueueFloodPostTime = 0.0f;
+	std::vector<std::string> m_spawnSearchResults;
+	std::string m_spawnSearchText = "npc a_";
+	std::vector<std::string> m_macroLoadingResults;
+	std::string m_textureCacheFile = "uifiles\\default\\window_pieces01.tga";
+
 	std::map<std::string, std::unique_ptr<ScrollingData>> m_data;
 	float m_history = 30.0f; // 30 seconds
 	float m_time = 0.0f;
@@ -5310,6 +6047,87 @@ private:
 
 static MacroExpressionEvaluator* s_macroEvaluator = nullptr;
 
+#pragma endregion
+
+#pragma region Macro Viewer
+
+// Shows the lines of the running macro as they were loaded, with the macro syntax highlighting.
+// The line that runs next is selected.
+
+class MacroViewer : public ImGuiWindowBase
+{
+public:
+	MacroViewer() : ImGuiWindowBase("Macro Viewer")
+	{
+		SetDefaultSize(ImVec2(600, 400));
+
+		m_editor.SetLanguageDefinition(imgui::texteditor::LanguageDefinition::Macro());
+		m_editor.SetPalette(imgui::TextEditor::GetDarkPalette());
+		m_editor.SetReadOnly(true);
+		m_editor.SetShowWhitespace(false);
+	}
+
+protected:
+	void Draw() override
+	{
+		MQMacroBlockPtr pBlock = GetCurrentMacroBlock();
+		if (!pBlock)
+		{
+			ImGui::TextColored(ImColor(255, 255, 0), "No macro is running");
+			m_block.reset();
+			return;
+		}
+
+		if (pBlock != m_block.lock() || pBlock->Line.size() != m_lineIndices.size())
+			LoadMacro(pBlock);
+
+		ImGui::Text("%s", pBlock->Name.c_str());
+		if (pBlock->Paused)
+		{
+			ImGui::SameLine();
+			ImGui::TextColored(ImColor(255, 255, 0), "(paused)");
+		}
+
+		auto iter = std::lower_bound(m_lineIndices.begin(), m_lineIndices.end(), pBlock->CurrIndex);
+		const int currentLine = static_cast<int>(iter - m_lineIndices.begin());
+		if (currentLine != m_currentLine)
+		{
+			m_currentLine = currentLine;
+			m_editor.SetCursorPosition(imgui::texteditor::Coordinates(currentLine, 0));
+			m_editor.SetSelection(imgui::texteditor::Coordinates(currentLine, 0), imgui::texteditor::Coordinates(currentLine, 0),
+				imgui::texteditor::SelectionMode::Line);
+		}
+
+		m_editor.Render("##MacroSource", ImGui::GetContentRegionAvail());
+	}
+
+private:
+	void LoadMacro(const MQMacroBlockPtr& pBlock)
+	{
+		std::vector<std::string> lines;
+		lines.reserve(pBlock->Line.size());
+		m_lineIndices.clear();
+		m_lineIndices.reserve(pBlock->Line.size());
+
+		for (const auto& [index, line] : pBlock->Line)
+		{
+			m_lineIndices.push_back(index);
+			lines.push_back(line.Command);
+		}
+
+		m_editor.SetTextLines(lines);
+		m_block = pBlock;
+		m_currentLine = -1;
+	}
+
+	imgui::TextEditor m_editor;
+	std::weak_ptr<MQMacroBlock> m_block;
+	std::vector<int> m_lineIndices;                 // macro line index of each line in the editor
+	int m_currentLine = -1;
+};
+
+static MacroViewer* s_macroViewer = nullptr;
+
 
 #pragma endregion
 
@@ -5647,6 +6465,9 @@ static void DeveloperTools_Initialize()
 	s_macroEvaluator = new MacroExpressionEvaluator();
 	DeveloperTools_RegisterMenuItem(s_macroEvaluator, "Macro Expression Evaluator", s_menuNameTools);
 
+	s_macroViewer = new MacroViewer();
+	DeveloperTools_RegisterMenuItem(s_macroViewer, "Macro Viewer", s_menuNameTools);
+
 	DeveloperTools_RegisterMenuItem("/squelch /lua run mq/eval", "Lua Expression Evaluator", s_menuNameTools);
 
 #if HAS_GAMEFACE_UI
@@ -5695,6 +6516,9 @@ static void DeveloperTools_Shutdown()
 	DeveloperTools_UnregisterMenuItem(s_macroEvaluator);
 	delete s_macroEvaluator; s_macroEvaluator = nullptr;
 
+	DeveloperTools_UnregisterMenuItem(s_macroViewer);
+	delete s_macroViewer; s_macroViewer = nullptr;
+
 	DeveloperTools_UnregisterMenuItem("Lua Expression Evaluator");
 
 #if HAS_GAMEFACE_UI
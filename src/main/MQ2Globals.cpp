@@ -124,6 +124,7 @@ uint64_t gRunning = 0;
 bool gbMoving = false;
 int gMaxTurbo = 80;
 int gTurboLimit = 240;
+bool gbCacheMacros = true;
 bool gReturn = true;
 bool gTargetbuffs = false;
 bool gItemsReceived = false;
@@ -153,6 +153,7 @@ MQLIB_VAR uint64_t gRunning;
 MQLIB_VAR bool gbMoving;
 MQLIB_VAR int gMaxTurbo;
 MQLIB_VAR int gTurboLimit;
+MQLIB_VAR bool gbCacheMacros;
 
 MQLIB_VAR bool gReturn;
 MQLIB_VAR bool gTargetbuffs;
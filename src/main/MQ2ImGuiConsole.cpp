@@ -20,6 +20,7 @@
 #include "ImGuiZepEditor.h"
 #include "ImGuiManager.h"
 
+#include "imgui/ImGuiTextEditor.h"
 #include "imgui/ImGuiTreePanelWindow.h"
 #include "mq/imgui/ConsoleWidget.h"
 
@@ -813,6 +814,32 @@ struct ImGuiZepConsole : public mq::imgui::ConsoleWidget, public mq::imgui::ImGu
 		}
 	}
 
+	// Appends text with a color (in ABGR) for each character. Color codes and links are not parsed.
+	void AppendColoredText(std::string_view text, const std::vector<ImU32>& colors, bool newline = false)
+	{
+		bool cursorAtEnd = m_window->IsAtBottom();
+
+		size_t runStart = 0;
+		for (size_t i = 1; i <= text.length(); ++i)
+		{
+			if (i == text.length() || colors[i] != colors[runStart])
+			{
+				InsertText(m_buffer->End(), text.substr(runStart, i - runStart), colors[runStart]);
+				runStart = i;
+			}
+		}
+
+		if (newline)
+			InsertText(m_buffer->End(), "\n");
+
+		PruneBuffer();
+
+		if (cursorAtEnd)
+		{
+			TriggerAutoScroll();
+		}
+	}
+
 	void AppendText(std::string_view text, MQColor defaultColor /* = DEFAULT_COLOR */, bool appendNewLine /* = false */) override
 	{
 		AppendFormattedText(text, defaultColor.ToImU32(), appendNewLine);
@@ -1280,10 +1307,26 @@ public:
 		ImGui::End();
 	}
 
+	// Echoes a command with the same highlighting as a line of a macro
+	void EchoCommand(std::string_view commandLine)
+	{
+		using namespace imgui::texteditor;
+
+		const Palette& palette = TextEditor::GetDarkPalette();
+		const std::vector<PaletteIndex> commandColors = TextEditor::ColorizeLine(LanguageDefinition::Macro(), commandLine);
+
+		std::string text = fmt::format("> {}", commandLine);
+		std::vector<ImU32> colors(text.length(), palette[static_cast<int>(PaletteIndex::Default)]);
+		for (size_t i = 0; i < commandColors.size(); ++i)
+			colors[i + 2] = palette[static_cast<int>(commandColors[i])];
+
+		m_zepEditor->AppendColoredText(text, colors, true);
+	}
+
 	void ExecCommand(const char* commandLine)
 	{
 		if (GetLocalEcho())
-			AddLog(Zep::ZepColor(128, 128, 128), "> {0}\n", commandLine);
+			EchoCommand(commandLine);
 
 		// Insert into history. First find match and delete it so i can be pushed to the back. This isn't
 		// trying to be smart or optimal.
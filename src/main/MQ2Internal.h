@@ -18,10 +18,12 @@
 #include "mq/api/Main.h"
 #include "mq/api/PluginAPI.h"
 #include "mq/base/PluginHandle.h"
+#include "mq/base/String.h"
 
 #include <map>
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 #include <variant>
 
@@ -241,8 +243,14 @@ struct MQMacroLine
 	std::string SourceFile;
 	int LineNumber = 0;
 
+	// index of the Sub line that contains this line, or 0 if it comes before any Sub.
+	int SubLine = 0;
+
+	// how many times the line has run, and for a Sub line, how many times the sub has been called.
+	uint32_t HitCount = 0;
+	uint32_t CallCount = 0;
+
 #ifdef MQ2_PROFILING
-	int ExecutionCount = 0;
 	uint64_t ExecutionTime = 0;
 #endif
 
@@ -268,6 +276,10 @@ struct MQMacroBlock
 	std::map<int, MQMacroLine> Line;
 	bool Removed = false;
 
+	// :labels indexed by the line of the Sub that contains them. Each label maps
+	// to the lines it appears on, in order.
+	std::unordered_map<int, ci_unordered::map<std::string, std::vector<int>>> Labels;
+
 	MQMacroBlock(std::string name) : Name(std::move(name)) {}
 
 	MQMacroBlock(const MQMacroBlock&) = delete;
@@ -314,12 +326,44 @@ struct MQDefine
 	MQDefine* pNext = nullptr;
 };
 
+// A macro and its includes after #include and #define have been applied, ready to be added
+// to a macro block. Images are cached by the contents of the files that went into them.
+struct MQMacroImageLine
+{
+	std::string Command;
+	int FileIndex = 0;                          // index into MQMacroImage::Files
+	int LocalLine = 0;                          // line number in its own file
+	int LineNumber = 0;                         // line number in the macro block
+};
+
+struct MQMacroImageSource
+{
+	std::filesystem::path Path;
+	bool Exists = false;                        // includes that were looked for but not found are sources too
+	size_t Size = 0;
+	size_t Hash = 0;
+
+	// when the file was read. Moved forward if the file is saved without being changed.
+	mutable std::filesystem::file_time_type WriteTime = std::filesystem::file_time_type::min();
+};
+
+struct MQMacroImage
+{
+	std::vector<std::string> Files;             // file names of the lines, as shown in errors
+	std::vector<MQMacroImageSource> Sources;
+	std::vector<MQMacroImageLine> Lines;
+	bool Cacheable = true;                      // false if the result depends on more than the files
+};
+
+struct MQEventBucket;
+
 struct MQEventList
 {
 	char szName[MAX_STRING];
 	char szMatch[MAX_STRING];
 	int pEventFunc = 0;
 	DWORD BlechID = 0;
+	MQEventBucket* pBucket = nullptr;
 
 	MQEventList* pNext = nullptr;
 };
@@ -659,6 +703,17 @@ struct MQLoop
 	int	firstLine = 0;
 	int lastLine = 0;
 	std::string forVariable;
+
+	// /for state resolved once when the loop is entered. Bounds that don't reference
+	// macro data are kept as values, otherwise the raw expression is kept so that
+	// /next only has to evaluate the part that can change. forVar is cleared if the
+	// variable is deleted while the loop is running.
+	std::shared_ptr<MQDataVar*> forVar;
+	bool downTo = false;
+	int endValue = 0;
+	int stepValue = 1;
+	std::string endExpr;
+	std::string stepExpr;
 };
 
 struct MQMacroStack
@@ -703,6 +758,25 @@ struct MQEventQueue
 	std::string   Name;
 	MQEventList*  pEventList = nullptr;
 	MQDataVar*    Parameters = nullptr;
+
+	// Links to the other queued events for the same sub
+	MQEventBucket* pBucket = nullptr;
+	MQEventQueue* pBucketPrev = nullptr;
+	MQEventQueue* pBucketNext = nullptr;
+};
+
+// Queued events grouped by the sub that handles them, so that they can be counted,
+// limited and run by name without searching the whole queue.
+struct MQEventBucket
+{
+	std::string Name;                           // name of the event without the "Sub Event_" prefix
+	MQEventQueue* pFirst = nullptr;
+	MQEventQueue* pLast = nullptr;
+	int Count = 0;                              // events currently queued
+	int Limit = 0;                              // maximum queued events, 0 for no limit
+	bool KeepLatest = false;                    // when full, replace the oldest event instead of dropping the new one
+	uint64_t Queued = 0;                        // total events queued
+	uint64_t Dropped = 0;                       // total events dropped because of the limit
 };
 using EVENTQUEUE DEPRECATE("Use MQEventQueue instead of EVENTQUEUE") = MQEventQueue;
 using PEVENTQUEUE DEPRECATE("Use MQEventQueue* instead of PEVENTQUEUE") = MQEventQueue *;
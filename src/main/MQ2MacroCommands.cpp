@@ -210,28 +210,67 @@ private:
 
 ProfileSession* g_pProfile = nullptr;
 
+// Stack frames are recycled between /call and /return for the lifetime of a macro,
+// instead of being allocated for every call.
+static std::vector<std::unique_ptr<MQMacroStack>> s_macroStackPool;
+
+static MQMacroStack* AcquireMacroStack(int locationIndex)
+{
+	if (s_macroStackPool.empty())
+		return new MQMacroStack(locationIndex);
+
+	MQMacroStack* pStack = s_macroStackPool.back().release();
+	s_macroStackPool.pop_back();
+
+	pStack->LocationIndex = locationIndex;
+	return pStack;
+}
+
+static void ReleaseMacroStack(MQMacroStack* pStack)
+{
+	pStack->bIsBind = false;
+	pStack->LocationIndex = 0;
+	pStack->Parameters = nullptr;
+	pStack->LocalVariables = nullptr;
+	pStack->loopStack.clear();
+	pStack->Return.clear();
+	pStack->pNext = nullptr;
+
+	s_macroStackPool.emplace_back(pStack);
+}
+
 static std::vector<std::string> ArgsToVector(const char* szLine)
 {
 	std::vector<std::string> args;
 
-	int i = 1;
-	while (true)
+	for (const ArgTokenizer::Token& arg : ArgTokenizer(szLine))
 	{
-		char szArg[MAX_STRING] = { 0 };
-		GetArg(szArg, szLine, i);
-
-		if (!szArg[0])
+		if (arg.value.empty())
 			break;
 
-		if (i > 0)
-			args.emplace_back(szArg);
-
-		++i;
+		args.emplace_back(arg.value);
 	}
 
 	return args;
 }
 
+// Name for the reports written about the running macro: the macro name and the current time
+static std::string GetMacroReportName()
+{
+	auto time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+	std::tm now = {};
+	localtime_s(&now, &time);
+	char dateTime[32] = { 0 };
+	std::strftime(dateTime, 32, "%Y%m%d_%H%M%S", &now);
+
+	// strip directories if any
+	char* pMacroName = strrchr(gszMacroName, '\\') + 1;
+	if (pMacroName == (char*)1) pMacroName = strrchr(gszMacroName, '//') + 1;
+	if (pMacroName == (char*)1) pMacroName = gszMacroName;
+
+	return fmt::format("{}_{}", pMacroName, dateTime);
+}
+
 void ProfileCmd(PlayerClient* pChar, const char* szLine)
 {
 	Macro(pChar, szLine);
@@ -247,25 +286,101 @@ void ProfileCmd(PlayerClient* pChar, const char* szLine)
 
 	std::vector<std::string> args = ArgsToVector(szLine);
 
-	auto time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-	std::tm now = {};
-	localtime_s(&now, &time);
-	char dateTime[32] = { 0 };
-	std::strftime(dateTime, 32, "%Y%m%d_%H%M%S", &now);
-
 	s_commandCount = 0;
 
-	// strip directories if any
-	char* pMacroName = strrchr(gszMacroName, '\\') + 1;
-	if (pMacroName == (char*)1) pMacroName = strrchr(gszMacroName, '//') + 1;
-	if (pMacroName == (char*)1) pMacroName = gszMacroName;
-
 	WriteChatf("\ag[Profiler]\ax Profiling session started!");
 
-	g_pProfile = new ProfileSession(fmt::format("{}_{}", pMacroName, dateTime));
+	g_pProfile = new ProfileSession(GetMacroReportName());
 	g_pProfile->Call("Main", std::move(args));
 }
 
+// ***************************************************************************
+// Function:    MacroCoverageCmd
+// Description: Shows how much of the running macro has run, resets the counts,
+//              or saves a coverage report with the hits of every line
+// Usage:       /maccoverage [reset|snapshot]
+// ***************************************************************************
+void MacroCoverageCmd(PlayerClient* pChar, const char* szLine)
+{
+	char szArg[MAX_STRING] = { 0 };
+	GetArg(szArg, szLine, 1);
+
+	if (szArg[0] && _stricmp(szArg, "reset") && _stricmp(szArg, "snapshot"))
+	{
+		SyntaxError("Usage: /maccoverage [reset|snapshot]");
+		return;
+	}
+
+	if (!gMacroBlock)
+	{
+		WriteChatf("\ar[Coverage]\ax No macro is running.");
+		return;
+	}
+
+	if (!_stricmp(szArg, "reset"))
+	{
+		for (auto& [index, line] : gMacroBlock->Line)
+		{
+			line.HitCount = 0;
+			line.CallCount = 0;
+		}
+
+		WriteChatf("\ag[Coverage]\ax Counts reset.");
+		return;
+	}
+
+	// Sub lines are called rather than run, and # lines never run
+	int lines = 0, linesRun = 0, subs = 0, subsCalled = 0;
+	for (const auto& [index, line] : gMacroBlock->Line)
+	{
+		if (!_strnicmp(line.Command.c_str(), "sub ", 4))
+		{
+			++subs;
+			if (line.CallCount)
+				++subsCalled;
+		}
+		else if (line.Command[0] != '#')
+		{
+			++lines;
+			if (line.HitCount)
+				++linesRun;
+		}
+	}
+
+	WriteChatf("\ag[Coverage]\ax \ay%d\ax of \ay%d\ax lines run (\ay%.1f%%\ax), \ay%d\ax of \ay%d\ax subs called",
+		linesRun, lines, lines ? linesRun * 100.0f / lines : 0.0f, subsCalled, subs);
+
+	for (MQEventList* pEvent = pEventList; pEvent; pEvent = pEvent->pNext)
+	{
+		auto iter = gMacroBlock->Line.find(pEvent->pEventFunc);
+		if (iter == gMacroBlock->Line.end())
+			WriteChatf("\ag[Coverage]\ax #event \ay%s\ax has no handler", &pEvent->szName[10]);
+		else if (iter->second.CallCount == 0)
+			WriteChatf("\ag[Coverage]\ax #event \ay%s\ax never fired", &pEvent->szName[10]);
+	}
+
+	if (!_stricmp(szArg, "snapshot"))
+	{
+		std::string coverageDirectoryPath = fmt::format("{}\\coverage\\", gPathMacros);
+		std::error_code ec;
+
+		if (!std::filesystem::exists(coverageDirectoryPath, ec))
+			std::filesystem::create_directory(coverageDirectoryPath, ec);
+
+		const std::string name = GetMacroReportName();
+		std::ofstream reportFile(coverageDirectoryPath + name + ".csv");
+		reportFile << "File,Line,Hits,Calls,Command\n";
+
+		for (const auto& [index, line] : gMacroBlock->Line)
+		{
+			reportFile << fmt::format("\"{}\",{},{},{},\"{}\"\n", line.SourceFile, line.LineNumber, line.HitCount,
+				line.CallCount, mq::replace(line.Command, "\"", "\"\""));
+		}
+
+		WriteChatf("\ag[Coverage]\ax Saved coverage to: %s", name.c_str());
+	}
+}
+
 void FailIf(SPAWNINFO* pChar, const char* szCommand, int StartLine, bool All = false)
 {
 	int Scope = 1;
@@ -394,15 +509,10 @@ void Delay(PlayerClient* pChar, const char* szLine)
 
 	if (gDelayCondition[0])
 	{
-		char szCond[MAX_STRING];
-		strcpy_s(szCond, gDelayCondition);
-
-		ParseMacroData(szCond, MAX_STRING);
-
 		double Result;
-		if (!Calculate(szCond, Result))
+		if (!EvaluateMacroCondition(gDelayCondition, Result))
 		{
-			FatalError("Failed to parse /delay condition '%s', non-numeric encountered", szCond);
+			FatalError("Failed to parse /delay condition '%s', non-numeric encountered", gDelayCondition);
 			return;
 		}
 
@@ -508,34 +618,356 @@ void CleanMacroLine(char* szLine)
 		szLine[NewLength] = '\0';
 }
 
-// ***************************************************************************
-// Function:    Include
-// Description: Includes another macro file
-// Usage:       #include <filename>
-// ***************************************************************************
-// TODO:  Switch this to take input of filesystem::path instead of const char*  Breaking change?
-bool Include(const char* szFile, int* LineNumber)
+#pragma region Macro Preprocessor
+//----------------------------------------------------------------------------
+// Loading a macro happens in two steps. The macro and its includes are preprocessed into an
+// image: lines are cleaned up, comments are dropped, includes are read in and defines are
+// applied. The image is then added to the macro block, which handles the remaining #
+// commands, events and subs.
+//
+// Defines are looked up by token, so a define only replaces whole words. Names that aren't
+// a single word are still replaced wherever they appear. A define's replacement has the
+// defines before it applied when it is defined, so each line only needs one pass.
+//
+// Images are cached by path, and reused as long as every file that went into the image still
+// has the same contents.
+//----------------------------------------------------------------------------
+
+static std::unordered_map<std::string_view, const MQDefine*> s_defineTokens; // keys point into MQDefine::szName
+static std::vector<const MQDefine*> s_defineSubstrings;                     // newest first
+
+struct MacroImageCacheEntry
+{
+	std::shared_ptr<const MQMacroImage> image;
+	uint64_t lastUsed = 0;
+};
+
+static std::unordered_map<std::string, MacroImageCacheEntry> s_macroImageCache;
+static constexpr size_t MaxCachedMacroImages = 16;
+
+static bool IsDefineTokenChar(char ch)
+{
+	return isalnum(static_cast<unsigned char>(ch)) || ch == '_';
+}
+
+static bool IsDefineToken(const char* szName)
 {
-	FILE* fMacro = _fsopen(szFile, "rt", _SH_DENYNO);
-	if (fMacro == nullptr)
+	if (szName[0] == 0)
+		return false;
+
+	for (const char* pChar = szName; *pChar; ++pChar)
 	{
-		FatalError("Couldn't open include file: %s", szFile);
+		if (!IsDefineTokenChar(*pChar))
+			return false;
+	}
+
+	return true;
+}
+
+static void ClearDefines()
+{
+	s_defineTokens.clear();
+	s_defineSubstrings.clear();
+
+	while (pDefines)
+	{
+		MQDefine* pDef = pDefines->pNext;
+		delete pDefines;
+
+		pDefines = pDef;
+	}
+}
+
+static void ApplyDefines(char* szLine, size_t Linelen)
+{
+	if (s_defineTokens.empty() && s_defineSubstrings.empty())
+		return;
+
+	std::string line;
+	bool changed = false;
+
+	// Copy the line a token at a time, but only once a token has been replaced
+	const char* pCopied = szLine;
+	const char* pChar = szLine;
+	while (*pChar)
+	{
+		if (!IsDefineTokenChar(*pChar))
+		{
+			++pChar;
+			continue;
+		}
+
+		const char* pToken = pChar;
+		while (IsDefineTokenChar(*pChar))
+			++pChar;
+
+		auto iter = s_defineTokens.find(std::string_view(pToken, pChar - pToken));
+		if (iter != s_defineTokens.end())
+		{
+			line.append(pCopied, pToken - pCopied);
+			line.append(iter->second->szReplace);
+			pCopied = pChar;
+			changed = true;
+		}
+	}
+
+	if (!s_defineSubstrings.empty())
+	{
+		if (!changed)
+			line.assign(szLine);
+		else
+			line.append(pCopied);
+		pCopied = pChar;
+
+		for (const MQDefine* pDef : s_defineSubstrings)
+		{
+			const size_t nameLength = strlen(pDef->szName);
+			const size_t replaceLength = strlen(pDef->szReplace);
+
+			size_t pos = 0;
+			while ((pos = line.find(pDef->szName, pos)) != std::string::npos)
+			{
+				line.replace(pos, nameLength, pDef->szReplace);
+				pos += replaceLength;
+				changed = true;
+			}
+		}
+	}
+
+	if (changed)
+	{
+		line.append(pCopied);
+		strncpy_s(szLine, Linelen, line.c_str(), _TRUNCATE);
+	}
+}
+
+static void AddDefine(const char* szName, const char* szReplace)
+{
+	MQDefine* define = new MQDefine();
+
+	strcpy_s(define->szName, szName);
+	strcpy_s(define->szReplace, szReplace);
+	ApplyDefines(define->szReplace, MAX_STRING);
+
+	define->pNext = pDefines;
+	pDefines = define;
+
+	// A later define of the same name replaces the earlier one
+	if (IsDefineToken(define->szName))
+		s_defineTokens[define->szName] = define;
+	else
+		s_defineSubstrings.insert(s_defineSubstrings.begin(), define);
+}
+
+// The write time is taken before reading, so a change made while reading is seen as a change
+static bool ReadMacroFile(const std::filesystem::path& path, std::string& contents,
+	std::filesystem::file_time_type* writeTime = nullptr)
+{
+	if (writeTime)
+	{
+		std::error_code ec;
+		*writeTime = std::filesystem::last_write_time(path, ec);
+		if (ec)
+			*writeTime = std::filesystem::file_time_type::min();
+	}
+
+	FILE* file = _fsopen(path.string().c_str(), "rb", _SH_DENYNO);
+	if (file == nullptr)
 		return false;
+
+	char buffer[16384];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		contents.append(buffer, read);
+
+	fclose(file);
+	return true;
+}
+
+static void AddMacroImageSource(MQMacroImage& image, const std::filesystem::path& path, const std::string* contents,
+	std::filesystem::file_time_type writeTime = std::filesystem::file_time_type::min())
+{
+	for (const MQMacroImageSource& source : image.Sources)
+	{
+		if (source.Path == path)
+			return;
+	}
+
+	MQMacroImageSource& source = image.Sources.emplace_back();
+	source.Path = path;
+	if (contents)
+	{
+		source.Exists = true;
+		source.Size = contents->size();
+		source.Hash = std::hash<std::string_view>()(*contents);
+		source.WriteTime = writeTime;
+	}
+}
+
+// Files are only read and hashed if their size or write time has changed
+static bool IsMacroImageCurrent(const MQMacroImage& image)
+{
+	for (const MQMacroImageSource& source : image.Sources)
+	{
+		std::error_code ec;
+		const uintmax_t size = std::filesystem::file_size(source.Path, ec);
+		if (ec)
+		{
+			if (source.Exists)
+				return false;
+
+			continue;
+		}
+
+		if (!source.Exists || size != source.Size)
+			return false;
+
+		std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(source.Path, ec);
+		if (!ec && writeTime == source.WriteTime)
+			continue;
+
+		std::string contents;
+		if (!ReadMacroFile(source.Path, contents, &writeTime)
+			|| contents.size() != source.Size
+			|| std::hash<std::string_view>()(contents) != source.Hash)
+		{
+			return false;
+		}
+
+		// Saved without being changed, don't hash it again next time
+		source.WriteTime = writeTime;
 	}
 
-	DebugSpewNoFile("Include - Including: %s", szFile);
+	return true;
+}
+
+static bool PreprocessMacroFile(MQMacroImage& image, const std::filesystem::path& path, int* LineNumber);
+
+static bool PreprocessMacroLine(MQMacroImage& image, int fileIndex, char* szLine, size_t Linelen, int* LineNumber, int localLine)
+{
+	if ((szLine[0] == 0) || (szLine[0] == '|'))
+		return true;
+
+	if (szLine[0] != '#')
+	{
+		ApplyDefines(szLine, Linelen);
+	}
+	else if (!_strnicmp(szLine, "#include ", 9) || !_strnicmp(szLine, "#include_optional ", 18))
+	{
+		char* szDirective = szLine;
+		bool optional = false;
+		szLine += 8;
+		// account for include_optional
+		if (szLine[0] == '_')
+		{
+			szLine += 9;
+			optional = true;
+		}
+
+		while (szLine[0] == ' ')
+		{
+			szLine++;
+		}
+
+		// An include that depends on a variable can't be cached
+		const std::string unparsed = szLine;
+		ParseMacroData(szLine, Linelen - (szLine - szDirective));
+		if (unparsed != szLine)
+			image.Cacheable = false;
+
+		std::filesystem::path incFilePath = szLine;
+		if (incFilePath.is_relative())
+		{
+			incFilePath = mq::internal_paths::Macros / incFilePath;
+		}
+
+		// Files that were looked for and not found are sources too, in case they show up later
+		auto found = [&image](const std::filesystem::path& path)
+		{
+			std::error_code ec_exists;
+			if (exists(path, ec_exists))
+				return true;
+
+			AddMacroImageSource(image, path, nullptr);
+			return false;
+		};
+
+		// If the file exists, use it, but if not try inc, then mac, then settle on inc
+		if (!incFilePath.has_extension() && !found(incFilePath))
+		{
+			if (!found(incFilePath.replace_extension("inc")))
+			{
+				if (!found(incFilePath.replace_extension("mac")))
+				{
+					incFilePath.replace_extension("inc");
+				}
+			}
+		}
+
+		if (!optional)
+		{
+			// PreprocessMacroFile contains the error messages, so let it error if it doesn't exist
+			return PreprocessMacroFile(image, incFilePath, LineNumber);
+		}
+
+		// if we're here, it was optional so only include if it exists
+		if (found(incFilePath))
+		{
+			return PreprocessMacroFile(image, incFilePath, LineNumber);
+		}
+
+		return true;
+	}
+	else if (!_strnicmp(szLine, "#define ", 8))
+	{
+		char szArg1[MAX_STRING] = { 0 };
+		char szArg2[MAX_STRING] = { 0 };
+		GetArg(szArg1, szLine, 2);
+		GetArg(szArg2, szLine, 3);
+
+		if ((szArg1[0] != 0) && (szArg2[0] != 0))
+		{
+			AddDefine(szArg1, szArg2);
+		}
+		else
+		{
+			// not cached so that the error is shown every time
+			MacroError("Bad #define: %s", szLine);
+			image.Cacheable = false;
+		}
+	}
+
+	MQMacroImageLine& line = image.Lines.emplace_back();
+	line.Command = szLine;
+	line.FileIndex = fileIndex;
+	line.LocalLine = localLine;
+	line.LineNumber = *LineNumber;
+	return true;
+}
+
+static bool PreprocessMacroContents(MQMacroImage& image, const std::filesystem::path& path, const std::string& contents,
+	std::filesystem::file_time_type writeTime, int* LineNumber)
+{
+	AddMacroImageSource(image, path, &contents, writeTime);
+
+	const int fileIndex = static_cast<int>(image.Files.size());
+	image.Files.push_back(path.filename().string());
 
 	int LocalLine = 0;
 	bool InBlockComment = false;
-	const char* Macroname = GetFilenameFromFullPath(szFile);
 	char szTemp[MAX_STRING] = { 0 };
 
-	while (!feof(fMacro))
+	size_t pos = 0;
+	while (pos < contents.size())
 	{
-		char* tmp = fgets(szTemp, MAX_STRING, fMacro);
+		// Lines are split the same way fgets would split them
+		size_t length = contents.find('\n', pos);
+		length = (length == std::string::npos ? contents.size() : length + 1) - pos;
+		length = std::min<size_t>(length, MAX_STRING - 1);
 
-		if (!tmp && feof(fMacro))
-			break;
+		memcpy(szTemp, &contents[pos], length);
+		szTemp[length] = 0;
+		pos += length;
 
 		CleanMacroLine(szTemp);
 		LocalLine++;
@@ -548,110 +980,110 @@ bool Include(const char* szFile, int* LineNumber)
 
 		if (!InBlockComment)
 		{
-			if (!AddMacroLine(Macroname, szTemp, MAX_STRING, LineNumber, LocalLine))
-			{
-				MacroError("Unable to add macro line.");
-
-				fclose(fMacro);
-				gszMacroName[0] = 0;
-				gRunning = 0;
-
+			if (!PreprocessMacroLine(image, fileIndex, szTemp, MAX_STRING, LineNumber, LocalLine))
 				return false;
-			}
 		}
 		else
 		{
 			DebugSpewNoFile("Macro - BlockComment: %s", szTemp);
 
-			if (!strncmp(&szTemp[strlen(szTemp) - 3], "**|", 3))
+			const size_t tempLength = strlen(szTemp);
+			if (tempLength >= 3 && !strncmp(&szTemp[tempLength - 3], "**|", 3))
 			{
 				InBlockComment = false;
 			}
 		}
 	}
 
-	fclose(fMacro);
 	return true;
 }
 
+static bool PreprocessMacroFile(MQMacroImage& image, const std::filesystem::path& path, int* LineNumber)
+{
+	std::string contents;
+	std::filesystem::file_time_type writeTime;
+	if (!ReadMacroFile(path, contents, &writeTime))
+	{
+		FatalError("Couldn't open include file: %s", path.string().c_str());
+		return false;
+	}
+
+	DebugSpewNoFile("Include - Including: %s", path.string().c_str());
+
+	return PreprocessMacroContents(image, path, contents, writeTime, LineNumber);
+}
+
 // ***************************************************************************
-// Function:    AddMacroLine
-// Description: Add a line to the MacroBlock
+// Function:    LoadMacroImage
+// Description: Preprocesses a macro and its includes, or returns the cached
+//              image if none of its files have changed
 // ***************************************************************************
-bool AddMacroLine(const char* FileName, char* szLine, size_t Linelen, int* LineNumber, int localLine)
+std::shared_ptr<const MQMacroImage> LoadMacroImage(const std::filesystem::path& path, bool useCache)
 {
-	// replace all tabs with spaces
-	if ((szLine[0] == 0) || (szLine[0] == '|'))
-		return true;
-
-	MQDefine* pDef = pDefines;
+	const std::string key = to_lower_copy(path.string());
 
-	if (szLine[0] != '#')
+	if (useCache)
 	{
-		while (pDef)
+		auto iter = s_macroImageCache.find(key);
+		if (iter != s_macroImageCache.end())
 		{
-			while (strstr(szLine, pDef->szName))
+			if (IsMacroImageCurrent(*iter->second.image))
 			{
-				char szNew[MAX_STRING] = { 0 };
-				strncpy_s(szNew, szLine, strstr(szLine, pDef->szName) - szLine);
-				strcat_s(szNew, pDef->szReplace);
-				strcat_s(szNew, strstr(szLine, pDef->szName) + strlen(pDef->szName));
-				strcpy_s(szLine, Linelen, szNew);
+				iter->second.lastUsed = MQGetTickCount64();
+				return iter->second.image;
 			}
-			pDef = pDef->pNext;
+
+			s_macroImageCache.erase(iter);
 		}
 	}
-	else
-	{
-		if (!_strnicmp(szLine, "#include ", 9) || !_strnicmp(szLine, "#include_optional ", 18))
-		{
-			bool optional = false;
-			szLine += 8;
-			// account for include_optional
-			if (szLine[0] == '_')
-			{
-				szLine += 9;
-				optional = true;
-			}
 
-			while (szLine[0] == ' ')
-			{
-				szLine++;
-			}
-			ParseMacroData(szLine, Linelen);
+	std::string contents;
+	std::filesystem::file_time_type writeTime;
+	if (!ReadMacroFile(path, contents, &writeTime))
+	{
+		FatalError("Couldn't open macro file: %s", path.string().c_str());
+		return nullptr;
+	}
 
-			std::filesystem::path incFilePath = szLine;
-			if (incFilePath.is_relative())
-			{
-				incFilePath = mq::internal_paths::Macros / incFilePath;
-			}
+	auto image = std::make_shared<MQMacroImage>();
+	int LineNumber = 0;
 
-			std::error_code ec_exists;
-			// If the file exists, use it, but if not try inc, then mac, then settle on inc
-			if (!incFilePath.has_extension() && !exists(incFilePath, ec_exists))
-			{
-				if (!exists(incFilePath.replace_extension("inc"), ec_exists))
-				{
-					if (!exists(incFilePath.replace_extension("mac"), ec_exists))
-					{
-						incFilePath.replace_extension("inc");
-					}
-				}
-			}
+	ClearDefines();
+	const bool success = PreprocessMacroContents(*image, path, contents, writeTime, &LineNumber);
+	ClearDefines();
 
-			if (!optional)
-			{
-				// Include() contains the error messages, so let it error if it doesn't exist
-				return Include(incFilePath.string().c_str(), LineNumber);
-			}
+	if (!success)
+	{
+		MacroError("Unable to add macro line.");
+		return nullptr;
+	}
 
-			// if we're here, it was optional so only include if it exists
-			if (exists(incFilePath, ec_exists))
-			{
-				return Include(incFilePath.string().c_str(), LineNumber);
-			}
+	if (useCache && image->Cacheable)
+	{
+		if (s_macroImageCache.size() >= MaxCachedMacroImages)
+		{
+			auto oldest = std::min_element(s_macroImageCache.begin(), s_macroImageCache.end(),
+				[](const auto& a, const auto& b) { return a.second.lastUsed < b.second.lastUsed; });
+			s_macroImageCache.erase(oldest);
 		}
-		else if (!_strnicmp(szLine, "#warning", 8))
+
+		s_macroImageCache[key] = { image, MQGetTickCount64() };
+	}
+
+	return image;
+}
+
+#pragma endregion
+
+// ***************************************************************************
+// Function:    AddMacroBlockLine
+// Description: Add a preprocessed line to the MacroBlock
+// ***************************************************************************
+static bool AddMacroBlockLine(const char* FileName, char* szLine, size_t Linelen, int LineNumber, int localLine)
+{
+	if (szLine[0] == '#')
+	{
+		if (!_strnicmp(szLine, "#warning", 8))
 		{
 			gWarning = true;
 		}
@@ -673,24 +1105,7 @@ bool AddMacroLine(const char* FileName, char* szLine, size_t Linelen, int* LineN
 		}
 		else if (!_strnicmp(szLine, "#define ", 8))
 		{
-			char szArg1[MAX_STRING] = { 0 };
-			char szArg2[MAX_STRING] = { 0 };
-			GetArg(szArg1, szLine, 2);
-			GetArg(szArg2, szLine, 3);
-
-			if ((szArg1[0] != 0) && (szArg2[0] != 0))
-			{
-				MQDefine* define = new MQDefine();
-
-				strcpy_s(define->szName, szArg1);
-				strcpy_s(define->szReplace, szArg2);
-				define->pNext = pDefines;
-				pDefines = define;
-			}
-			else
-			{
-				MacroError("Bad #define: %s", szLine);
-			}
+			// applied when the macro was preprocessed
 		}
 		else if (!_strnicmp(szLine, "#event ", 7))
 		{
@@ -727,6 +1142,7 @@ bool AddMacroLine(const char* FileName, char* szLine, size_t Linelen, int* LineN
 				}
 
 				strcpy_s(pEvent->szMatch, szArg2);
+				pEvent->pBucket = GetMacroEventBucket(szArg1, true);
 				pEvent->BlechID = pEventBlech->AddEvent(pEvent->szMatch, EventBlechCallback, pEvent);
 				pEvent->pEventFunc = 0;
 				pEvent->pNext = pEventList;
@@ -737,6 +1153,28 @@ bool AddMacroLine(const char* FileName, char* szLine, size_t Linelen, int* LineN
 				MacroError("Bad #event: %s", szLine);
 			}
 		}
+		else if (!_strnicmp(szLine, "#eventlimit ", 12))
+		{
+			// #eventlimit <name> <max> [first|latest]
+			char szArg1[MAX_STRING] = { 0 };
+			char szArg2[MAX_STRING] = { 0 };
+			char szArg3[MAX_STRING] = { 0 };
+			GetArg(szArg1, szLine, 2);
+			GetArg(szArg2, szLine, 3);
+			GetArg(szArg3, szLine, 4);
+
+			const int limit = GetIntFromString(szArg2, -1);
+			if (szArg1[0] != 0 && limit >= 0 && (szArg3[0] == 0 || !_stricmp(szArg3, "first") || !_stricmp(szArg3, "latest")))
+			{
+				MQEventBucket* pBucket = GetMacroEventBucket(szArg1, true);
+				pBucket->Limit = limit;
+				pBucket->KeepLatest = !_stricmp(szArg3, "latest");
+			}
+			else
+			{
+				MacroError("Bad #eventlimit: %s", szLine);
+			}
+		}
 		else if (!_strnicmp(szLine, "#bind ", 6) || !_strnicmp(szLine, "#bind_noparse ", 14))
 		{
 			bool parse = true;
@@ -806,20 +1244,20 @@ bool AddMacroLine(const char* FileName, char* szLine, size_t Linelen, int* LineN
 
 	if ((!_stricmp(szLine, "Sub Event_Chat")) || (!_strnicmp(szLine, "Sub Event_Chat(", 15)))
 	{
-		gEventFunc[EVENT_CHAT] = *LineNumber;
+		gEventFunc[EVENT_CHAT] = LineNumber;
 	}
 	else if ((!_stricmp(szLine, "Sub Event_Timer")) || (!_strnicmp(szLine, "Sub Event_Timer(", 16)))
 	{
-		gEventFunc[EVENT_TIMER] = *LineNumber;
+		gEventFunc[EVENT_TIMER] = LineNumber;
 	}
-	else
+	else if (!_strnicmp(szLine, "Sub Event_", 10))
 	{
 		MQEventList* pEvent = pEventList;
 		while (pEvent)
 		{
 			if (!_stricmp(szLine, pEvent->szName))
 			{
-				pEvent->pEventFunc = *LineNumber;
+				pEvent->pEventFunc = LineNumber;
 			}
 			else
 			{
@@ -828,7 +1266,7 @@ bool AddMacroLine(const char* FileName, char* szLine, size_t Linelen, int* LineN
 
 				if (!_strnicmp(szLine, szNameP, strlen(szNameP)))
 				{
-					pEvent->pEventFunc = *LineNumber;
+					pEvent->pEventFunc = LineNumber;
 				}
 			}
 			pEvent = pEvent->pNext;
@@ -837,28 +1275,85 @@ bool AddMacroLine(const char* FileName, char* szLine, size_t Linelen, int* LineN
 
 	auto [iter, success] = gMacroBlock->Line.emplace(
 		std::piecewise_construct,
-		std::forward_as_tuple(*LineNumber),
+		std::forward_as_tuple(LineNumber),
 		std::forward_as_tuple(szLine, FileName, localLine));
 	if (!success)
 	{
-		MacroError("Duplicate line number detected! %s@%d", FileName, localLine);
-	}
+		MacroError("Duplicate line number detected! %s@%d", FileName, localLine);
+	}
+	else
+	{
+		// Lines are added in order, so the containing sub is either this line or the one before it.
+		MQMacroLine& macroLine = iter->second;
+		if (!_strnicmp(szLine, "sub ", 4))
+			macroLine.SubLine = iter->first;
+		else if (iter != gMacroBlock->Line.begin())
+			macroLine.SubLine = std::prev(iter)->second.SubLine;
+
+		if (szLine[0] == ':')
+			gMacroBlock->Labels[macroLine.SubLine][szLine].push_back(iter->first);
+	}
+
+	static const std::regex subrx("^sub (\\w+)", std::regex_constants::icase);
+	std::cmatch submatch;
+	if (!_strnicmp(szLine, "sub ", 4) && std::regex_search(szLine, submatch, subrx))
+	{
+		gMacroSubLookupMap[submatch.str(1)] = LineNumber;
+	}
+
+	return true;
+}
+
+static bool AddMacroImage(const MQMacroImage& image)
+{
+	char szLine[MAX_STRING] = { 0 };
+
+	for (const MQMacroImageLine& line : image.Lines)
+	{
+		strcpy_s(szLine, line.Command.c_str());
+
+		if (!AddMacroBlockLine(image.Files[line.FileIndex].c_str(), szLine, MAX_STRING, line.LineNumber, line.LocalLine))
+			return false;
+	}
+
+	return true;
+}
+
+// ***************************************************************************
+// Function:    Include
+// Description: Includes another macro file
+// Usage:       #include <filename>
+// ***************************************************************************
+// TODO:  Switch this to take input of filesystem::path instead of const char*  Breaking change?
+bool Include(const char* szFile, int* LineNumber)
+{
+	MQMacroImage image;
+	if (!PreprocessMacroFile(image, szFile, LineNumber) || !AddMacroImage(image))
+	{
+		MacroError("Unable to add macro line.");
 
-#ifdef MQ2_PROFILING
-	iter->second.ExecutionCount = 0;
-	iter->second.ExecutionTime = 0;
-#endif
+		gszMacroName[0] = 0;
+		gRunning = 0;
 
-	static const std::regex subrx("^sub (\\w+)", std::regex_constants::icase);
-	std::cmatch submatch;
-	if (std::regex_search(szLine, submatch, subrx))
-	{
-		gMacroSubLookupMap[submatch.str(1)] = *LineNumber;
+		return false;
 	}
 
 	return true;
 }
 
+// ***************************************************************************
+// Function:    AddMacroLine
+// Description: Add a line to the MacroBlock
+// ***************************************************************************
+bool AddMacroLine(const char* FileName, char* szLine, size_t Linelen, int* LineNumber, int localLine)
+{
+	MQMacroImage image;
+	image.Files.emplace_back(FileName);
+
+	return PreprocessMacroLine(image, 0, szLine, Linelen, LineNumber, localLine)
+		&& AddMacroImage(image);
+}
+
 static MQMacroBlockPtr AddMacroBlock(std::string Name)
 {
 	auto macroBlock = std::make_shared<MQMacroBlock>(Name);
@@ -982,7 +1477,6 @@ void Macro(PlayerClient* pChar, const char* szLine)
 	bRunNextCommand = true;
 
 	char* szNext = nullptr;
-	bool InBlockComment = false;
 
 	if (szLine[0] == 0)
 	{
@@ -1030,70 +1524,29 @@ void Macro(PlayerClient* pChar, const char* szLine)
 		macFilePath = mq::internal_paths::Macros / macFilePath;
 	}
 
-	FILE* fMacro = _fsopen(macFilePath.string().c_str(), "rt", _SH_DENYNO);
-
-	if (fMacro == nullptr)
-	{
-		FatalError("Couldn't open macro file: %s", macFilePath.string().c_str());
-		gszMacroName[0] = 0;
-		gRunning = 0;
-		return;
-	}
-
 	gEventChat = 0;
 	strcpy_s(gszMacroName, szTemp);
 	DebugSpew("Macro - Loading macro: %s", macFilePath.string().c_str());
 
-	int LineIndex = 0;
-	int LocalLine = 0;
 	gMacroSubLookupMap.clear();
 
 	const std::string strMacroName = macFilePath.filename().string();
 
-	while (!feof(fMacro))
+	std::shared_ptr<const MQMacroImage> image = LoadMacroImage(macFilePath, gbCacheMacros);
+	if (!image)
 	{
-		fgets(szTemp, MAX_STRING, fMacro);
-		CleanMacroLine(szTemp);
-
-		LineIndex++;
-		LocalLine++;
-
-		if (!strncmp(szTemp, "|**", 3))
-		{
-			InBlockComment = true;
-		}
-
-		if (!InBlockComment)
-		{
-			if (!AddMacroLine(strMacroName.c_str(), szTemp, MAX_STRING, &LineIndex, LocalLine))
-			{
-				MacroError("Unable to add macro line.");
-				fclose(fMacro);
-
-				gszMacroName[0] = 0;
-				gRunning = 0;
-				return;
-			}
-		}
-		else
-		{
-			DebugSpew("Macro - BlockComment: %s", szTemp);
-
-			if (!strncmp(&szTemp[strlen(szTemp) - 3], "**|", 3))
-			{
-				InBlockComment = false;
-			}
-		}
+		gszMacroName[0] = 0;
+		gRunning = 0;
+		return;
 	}
 
-	fclose(fMacro);
-
-	while (pDefines)
+	if (!AddMacroImage(*image))
 	{
-		MQDefine* pDef = pDefines->pNext;
-		delete pDefines;
+		MacroError("Unable to add macro line.");
 
-		pDefines = pDef;
+		gszMacroName[0] = 0;
+		gRunning = 0;
+		return;
 	}
 
 	strcpy_s(szTemp, "Main");
@@ -1205,50 +1658,25 @@ void Goto(PlayerClient* pChar, const char* szLine)
 	}
 
 	bRunNextCommand = true;
-	int FromIndex = gMacroBlock->CurrIndex;
-
-	const auto goto_line = gMacroBlock->Line.find(FromIndex);
-	if (goto_line->second.LoopEnd)
-	{
-		gMacroBlock->CurrIndex = goto_line->second.LoopEnd;
-		return;
-	}
-
-	std::map<int, MQMacroLine>::reverse_iterator ri(goto_line);
-
-	// search up first we only search until we find a "Sub "
-	for (; ri != gMacroBlock->Line.rend(); ri++)
-	{
-		if (!_strnicmp(ri->second.Command.c_str(), "Sub ", 4))
-		{
-			ri--;
-			FromIndex = ri->first;
-			break;
-		}
-
-		if (!_stricmp(szLine, ri->second.Command.c_str()))
-		{
-			// Label found....
-			gMacroBlock->CurrIndex = ri->first;
-			goto_line->second.LoopEnd = ri->first;
-			return;
-		}
-	}
+	const int FromIndex = gMacroBlock->CurrIndex;
 
-	// now that we found our start lets look forward for the goto label:
-	for (auto iter = gMacroBlock->Line.find(FromIndex); iter != gMacroBlock->Line.end(); iter++)
+	auto lineIter = gMacroBlock->Line.find(FromIndex);
+	if (lineIter != gMacroBlock->Line.end())
 	{
-		if (!_strnicmp(iter->second.Command.c_str(), "Sub ", 4))
+		// Labels are only visible within the sub that contains the /goto.
+		auto subIter = gMacroBlock->Labels.find(lineIter->second.SubLine);
+		if (subIter != gMacroBlock->Labels.end())
 		{
-			break;
-		}
+			auto labelIter = subIter->second.find(szLine);
+			if (labelIter != subIter->second.end())
+			{
+				// Prefer the closest label above the /goto, otherwise the first one below it.
+				const std::vector<int>& labelLines = labelIter->second;
+				auto upper = std::upper_bound(labelLines.begin(), labelLines.end(), FromIndex);
 
-		if (!_stricmp(szLine, iter->second.Command.c_str()))
-		{
-			// Label found
-			gMacroBlock->CurrIndex = iter->first;
-			goto_line->second.LoopEnd = iter->first;
-			return;
+				gMacroBlock->CurrIndex = upper != labelLines.begin() ? *std::prev(upper) : labelLines.front();
+				return;
+			}
 		}
 	}
 
@@ -1257,13 +1685,15 @@ void Goto(PlayerClient* pChar, const char* szLine)
 
 char* GetSubFromLine(int Line, char* szSub, size_t Sublen)
 {
-	std::map<int, MQMacroLine>::reverse_iterator ri(gMacroBlock->Line.find(Line));
-
-	for (; ri != gMacroBlock->Line.rend(); ri++)
+	if (gMacroBlock && !gMacroBlock->Line.empty())
 	{
-		if (!_strnicmp(ri->second.Command.c_str(), "sub ", 4))
+		auto lineIter = gMacroBlock->Line.find(Line);
+		const int subLine = lineIter != gMacroBlock->Line.end()
+			? lineIter->second.SubLine : gMacroBlock->Line.rbegin()->second.SubLine;
+
+		if (subLine != 0)
 		{
-			strcpy_s(szSub, Sublen, ri->second.Command.c_str() + 4);
+			strcpy_s(szSub, Sublen, gMacroBlock->Line.at(subLine).Command.c_str() + 4);
 			return szSub;
 		}
 	}
@@ -1332,7 +1762,6 @@ void EndMacro(PlayerClient* pChar, const char* szLine)
 
 	gWarning = false;
 	MQMacroStack* pStack = nullptr;
-	MQEventQueue* pEvent = nullptr;
 	MQEventList* pEventL = nullptr;
 	MQBindList* pBindL = nullptr;
 
@@ -1370,7 +1799,7 @@ void EndMacro(PlayerClient* pChar, const char* szLine)
 					MQMacroStack* pNext = gMacroStack->pNext;
 
 					// Delete the current stack item
-					delete gMacroStack;
+					ReleaseMacroStack(gMacroStack);
 
 					// Move to the next item in the stack
 					gMacroStack = pNext;
@@ -1424,7 +1853,7 @@ void EndMacro(PlayerClient* pChar, const char* szLine)
 		// Log execution/profiling information.  Output format is:
 		// Execution Count | Microseconds | Line # | Macro Source
 		if (fMacro) {
-			DWORD count = i->second.ExecutionCount;
+			DWORD count = i->second.HitCount;
 			DWORD total = (DWORD)(i->second.ExecutionTime * 1000000 / PerformanceFrequency.QuadPart);
 			DWORD avg = 0;
 			if (count > 0) {
@@ -1457,20 +1886,15 @@ void EndMacro(PlayerClient* pChar, const char* szLine)
 		if (gMacroStack->Parameters)
 			ClearMQ2DataVariables(&gMacroStack->Parameters);
 
-		delete gMacroStack;
+		ReleaseMacroStack(gMacroStack);
 		gMacroStack = pStack;
 	}
 
+	s_macroStackPool.clear();
 	gMacroSubLookupMap.clear();
 	gUndeclaredVars.clear();
 
-	while (gEventQueue)
-	{
-		pEvent = gEventQueue->pNext;
-		delete gEventQueue;
-
-		gEventQueue = pEvent;
-	}
+	ClearMacroEvents();
 
 	while (pEventList)
 	{
@@ -1516,6 +1940,7 @@ void EndMacro(PlayerClient* pChar, const char* szLine)
 	}
 
 	ClearMQ2DataVariables(&pMacroVariables);
+	ClearFreeDataVariables();
 
 	DebugSpewNoFile("EndMacro - Ended");
 	if (gFilterMacro != FILTERMACRO_NONE && gFilterMacro != FILTERMACRO_MACROENDED)
@@ -1590,7 +2015,7 @@ void Call(PlayerClient*, const char* szLine)
 	int MacroLine = iter->second;
 
 	// Prep to call the Sub
-	MQMacroStack* pStack = new MQMacroStack(MacroLine);
+	MQMacroStack* pStack = AcquireMacroStack(MacroLine);
 
 	gMacroBlock->CurrIndex = MacroLine;
 	if (gMacroStack && gMacroBlock->BindStackIndex != -1)
@@ -1620,6 +2045,7 @@ void Call(PlayerClient*, const char* szLine)
 	gMacroStack = pStack;
 
 	MQMacroLine& ml = gMacroBlock->Line.at(MacroLine);
+	++ml.CallCount;
 	int numsubargs = GetNumArgsFromSub(ml.Command);
 
 	if (SubParam[0] != 0 || numsubargs)
@@ -1654,8 +2080,68 @@ void Call(PlayerClient*, const char* szLine)
 	}
 }
 
+// Defined in MQDataAPI.cpp
+size_t FindMacroClosingBrace(std::string_view strOrigString, size_t iCurrentPosition);
+
+// Finds the end of the (<conditions>) at the start of an /if or /while.  With Parser 2 the
+// condition hasn't been parsed yet, so any parentheses inside of a variable are skipped.
+// Returns a pointer to the character after the closing parenthesis, or nullptr if there isn't one.
+static const char* FindConditionEnd(const char* szLine)
+{
+	std::string_view line{ szLine };
+	int nParens = 0;
+
+	size_t pos = 0;
+	while (pos < line.length())
+	{
+		if (gParserVersion == 2 && line[pos] == '$' && pos + 1 < line.length() && line[pos + 1] == '{')
+		{
+			pos = FindMacroClosingBrace(line, pos);
+			if (pos == std::string_view::npos)
+				return nullptr;
+
+			continue;
+		}
+
+		if (line[pos] == '(')
+			nParens++;
+		else if (line[pos] == ')' && --nParens == 0)
+			return szLine + pos + 1;
+
+		++pos;
+	}
+
+	return nullptr;
+}
+
+// /if and /while parse their own line.  With Parser 2 this is deferred until the condition
+// is evaluated, so that the parts of it that aren't needed are skipped.  With Parser 1 the
+// line is parsed up front the same as any other command.  Under /noparse the line is left
+// as it is with either parser.
+static const char* ParseConditionalLine(const char* szLine, char (&szParsed)[MAX_STRING])
+{
+	if (gParserVersion == 2 || !bAllowCommandParse)
+		return szLine;
+
+	strcpy_s(szParsed, szLine);
+	ParseMacroParameter(szParsed);
+	return szParsed;
+}
+
+static bool CalculateCondition(const char* szCond, double& Result)
+{
+	// under /noparse the condition is calculated as it is written
+	if (gParserVersion == 2 && bAllowCommandParse)
+		return EvaluateMacroCondition(szCond, Result);
+
+	return Calculate(szCond, Result);
+}
+
 void MacroIfCmd(PlayerClient* pChar, const char* szLine)
 {
+	char szParsedLine[MAX_STRING] = { 0 };
+	szLine = ParseConditionalLine(szLine, szParsedLine);
+
 	if (szLine[0] != '(')
 	{
 		FatalError("Failed to parse /if command.  Expected () around conditions.");
@@ -1663,35 +2149,12 @@ void MacroIfCmd(PlayerClient* pChar, const char* szLine)
 		return;
 	}
 
-	const char* pEnd = &szLine[1];
-	int nParens = 1;
-
-	while (true)
+	const char* pEnd = FindConditionEnd(szLine);
+	if (pEnd == nullptr || *pEnd != ' ')
 	{
-		if (*pEnd == '(')
-			nParens++;
-		else if (*pEnd == ')')
-		{
-			nParens--;
-			if (nParens == 0)
-			{
-				pEnd++;
-				if (*pEnd != ' ')
-				{
-					FatalError("Failed to parse /if command.  Could not find command to execute.");
-					SyntaxError("Usage: /if (<conditions>) <command>");
-					return;
-				}
-				break;
-			}
-		}
-		else if (*pEnd == 0)
-		{
-			FatalError("Failed to parse /if command.  Could not find command to execute.");
-			SyntaxError("Usage: /if (<conditions>) <command>");
-			return;
-		}
-		++pEnd;
+		FatalError("Failed to parse /if command.  Could not find command to execute.");
+		SyntaxError("Usage: /if (<conditions>) <command>");
+		return;
 	}
 
 	char szCond[MAX_STRING] = { 0 };
@@ -1700,7 +2163,7 @@ void MacroIfCmd(PlayerClient* pChar, const char* szLine)
 	++pEnd;
 
 	double Result = 0;
-	if (!Calculate(szCond, Result))
+	if (!CalculateCondition(szCond, Result))
 	{
 		FatalError("Failed to parse /if condition '%s', non-numeric encountered", szCond);
 		return;
@@ -1710,13 +2173,12 @@ void MacroIfCmd(PlayerClient* pChar, const char* szLine)
 	{
 		if (gParserVersion == 2)
 		{
-			// Due to the way that MQ2 currently processes the whole line before reaching this point:
-			// At this point the command has already passed through the parser once.  We don't want
-			// it to be parsed again since the parser already knew how to handle it and has given us
-			// the correct output.  So let's wrap this in a ${Parse[0 until we can fix /if to short
-			// circuit prior to processing.
-			// Cast it as a char*, Modify the command, and run it
-			std::string str = ModifyMacroString(pEnd, true, ModifyMacroMode::Wrap);
+			// Only the command that is going to run gets parsed.  Once it has been parsed, wrap
+			// the result in a ${Parse[0 so that it isn't parsed a second time when it is dispatched.
+			// Under /noparse it is only wrapped, so that it isn't parsed at all.
+			std::string str = bAllowCommandParse
+				? ModifyMacroString(ModifyMacroString(pEnd), true, ModifyMacroMode::Wrap)
+				: ModifyMacroString(pEnd, true, ModifyMacroMode::Wrap);
 
 			DoCommand(&str[0], false);
 		}
@@ -1750,25 +2212,52 @@ static void PushMacroLoop(const MQLoop& loop)
 	gMacroStack->loopStack.push_back(loop);
 }
 
-static void EndWhile()
+// /for loops reach their variable through a slot shared by every loop that uses it, so that
+// deleting the variable only has to clear its slot.
+static std::unordered_map<MQDataVar*, std::shared_ptr<MQDataVar*>> s_loopVariables;
+
+static std::shared_ptr<MQDataVar*> BindMacroLoopVariable(MQDataVar* pVar)
+{
+	std::shared_ptr<MQDataVar*>& slot = s_loopVariables[pVar];
+	if (!slot)
+		slot = std::make_shared<MQDataVar*>(pVar);
+
+	return slot;
+}
+
+// Called when a macro variable is deleted so that no /for loop keeps using it.
+void InvalidateMacroLoopVariable(MQDataVar* pVar)
+{
+	auto iter = s_loopVariables.find(pVar);
+	if (iter != s_loopVariables.end())
+	{
+		*iter->second = nullptr;
+		s_loopVariables.erase(iter);
+	}
+}
+
+static void EndWhile(const MQLoop& loop)
 {
-	gMacroBlock->CurrIndex = gMacroBlock->Line.at(gMacroBlock->CurrIndex).LoopEnd;
+	gMacroBlock->CurrIndex = loop.lastLine;
 	bRunNextCommand = true;
 }
 
 static void MarkWhile(const char* szCommand, MQLoop& loop)
 {
-	if (szCommand[strlen(szCommand) - 1] == '{')
+	auto lineIter = gMacroBlock->Line.find(gMacroBlock->CurrIndex);
+
+	// The bounds are discovered the first time the /while is seen, after that they are stored on the line.
+	if (lineIter != gMacroBlock->Line.end() && lineIter->second.LoopStart && lineIter->second.LoopEnd)
 	{
 		loop.type = MQLoop::Type::While;
+		loop.firstLine = lineIter->second.LoopStart;
+		loop.lastLine = lineIter->second.LoopEnd;
+		return;
+	}
 
-		auto lineIter = gMacroBlock->Line.find(gMacroBlock->CurrIndex);
-		if (lineIter->second.LoopStart && lineIter->second.LoopEnd)
-		{
-			loop.firstLine = lineIter->second.LoopStart;
-			loop.lastLine = lineIter->second.LoopEnd;
-			return;
-		}
+	if (szCommand[strlen(szCommand) - 1] == '{')
+	{
+		loop.type = MQLoop::Type::While;
 
 		const auto currentLine = lineIter;
 		--lineIter;
@@ -1821,7 +2310,8 @@ static void MarkWhile(const char* szCommand, MQLoop& loop)
 // ***************************************************************************
 void MacroWhileCmd(PlayerClient* pChar, const char* szLine)
 {
-	char szCond[MAX_STRING] = { 0 };
+	char szParsedLine[MAX_STRING] = { 0 };
+	szLine = ParseConditionalLine(szLine, szParsedLine);
 
 	if (szLine[0] != '(')
 	{
@@ -1830,43 +2320,21 @@ void MacroWhileCmd(PlayerClient* pChar, const char* szLine)
 		return;
 	}
 
-	const char* pEnd = &szLine[1];
-	DWORD nParens = 1;
-	while (true)
+	const char* pEnd = FindConditionEnd(szLine);
+	if (pEnd == nullptr || *pEnd != ' ')
 	{
-		if (*pEnd == '(')
-			nParens++;
-		else if (*pEnd == ')')
-		{
-			nParens--;
-			if (nParens == 0)
-			{
-				pEnd++;
-				if (*pEnd != ' ')
-				{
-					FatalError("Failed to parse /while command.  Could not find command to execute.");
-					SyntaxError("Usage: /while (<conditions>) <command>");
-					return;
-				}
-				break;
-			}
-		}
-		else if (*pEnd == 0)
-		{
-			FatalError("Failed to parse /while command.  Could not find command to execute.");
-			SyntaxError("Usage: /while (<conditions>) <command>");
-			return;
-		}
-		++pEnd;
+		FatalError("Failed to parse /while command.  Could not find command to execute.");
+		SyntaxError("Usage: /while (<conditions>) <command>");
+		return;
 	}
 
-	strcpy_s(szCond, szLine);
+	char szCond[MAX_STRING] = { 0 };
 	strncpy_s(szCond, szLine, pEnd - szLine);
 	szCond[pEnd - szLine] = 0;
 	++pEnd;
 
 	double Result = 0;
-	if (!Calculate(szCond, Result))
+	if (!CalculateCondition(szCond, Result))
 	{
 		FatalError("Failed to parse /while condition '%s', non-numeric encountered", szCond);
 		return;
@@ -1883,7 +2351,7 @@ void MacroWhileCmd(PlayerClient* pChar, const char* szLine)
 	if (Result != 0)
 		PushMacroLoop(loop);
 	else
-		EndWhile();
+		EndWhile(loop);
 }
 
 // ***************************************************************************
@@ -1906,48 +2374,12 @@ void DoEvents(PlayerClient* pChar, const char* szLine)
 
 		if (Arg2[0])
 		{
-			char szSub[64] = { 0 };
-			sprintf_s(szSub, "Sub Event_%s", Arg2);
-			MQEventQueue* pEvent = gEventQueue;
-
-			while (pEvent)
-			{
-				if ((pEvent->Type == EVENT_CHAT && !_stricmp("Sub Event_Chat", szSub))
-					|| (pEvent->Type == EVENT_TIMER && !_stricmp("Sub Event_Timer", szSub))
-					|| (pEvent->Type == EVENT_CUSTOM && !_stricmp(pEvent->pEventList->szName, szSub)))
-				{
-					MQEventQueue* pEventNext;
-					if (pEventNext = pEvent->pNext)
-						pEventNext->pPrev = pEvent->pPrev;
-					if (pEvent->pPrev)
-						pEvent->pPrev->pNext = pEvent->pNext;
-					else
-						gEventQueue = pEvent->pNext;
-
-					ClearMQ2DataVariables(&pEvent->Parameters);
-					DebugSpewNoFile("Doevents: Deleting pEvent %d %s", pEvent->Type, pEvent->Name.c_str());
-
-					delete pEvent;
-					pEvent = pEventNext;
-
-					continue;
-				}
-
-				pEvent = pEvent->pNext;
-			}
+			if (MQEventBucket* pBucket = GetMacroEventBucket(Arg2))
+				FlushMacroEvents(pBucket);
 		}
 		else
 		{
-			while (gEventQueue)
-			{
-				MQEventQueue* pEventNext = gEventQueue->pNext;
-
-				ClearMQ2DataVariables(&gEventQueue->Parameters);
-				DebugSpewNoFile("Doevents: Deleting gEventQueue %d %s", gEventQueue->Type, gEventQueue->Name.c_str());
-
-				delete gEventQueue;
-				gEventQueue = pEventNext;
-			}
+			FlushMacroEvents();
 		}
 		return;
 	}
@@ -1959,34 +2391,17 @@ void DoEvents(PlayerClient* pChar, const char* szLine)
 		return;
 	}
 
-	MQEventQueue* pEvent = gEventQueue;
+	MQEventBucket* pBucket = nullptr;
 	if (Arg1[0])
 	{
-		char szSub[64] = { 0 };
-		sprintf_s(szSub, "Sub Event_%s", Arg1);
-
-		while (pEvent)
-		{
-			if ((pEvent->Type == EVENT_CHAT && !_stricmp("Sub Event_Chat", szSub))
-				|| (pEvent->Type == EVENT_TIMER && !_stricmp("Sub Event_Timer", szSub))
-				|| (pEvent->Type == EVENT_CUSTOM && !_stricmp(pEvent->pEventList->szName, szSub)))
-			{
-				break;
-			}
-
-			pEvent = pEvent->pNext;
-		}
-
-		if (!pEvent)
-			return;// no event found
+		pBucket = GetMacroEventBucket(Arg1);
+		if (!pBucket)
+			return; // no event found
 	}
 
-	if (pEvent->pPrev)
-		pEvent->pPrev->pNext = pEvent->pNext;
-	else
-		gEventQueue = pEvent->pNext;
-	if (pEvent->pNext)
-		pEvent->pNext->pPrev = pEvent->pPrev;
+	MQEventQueue* pEvent = PopMacroEvent(pBucket);
+	if (!pEvent)
+		return; // no event found
 
 	DebugSpewNoFile("DoEvents: Running event type %d (%s) = 0x%p", pEvent->Type, (pEvent->pEventList) ? pEvent->pEventList->szName : "NONE", pEvent);
 
@@ -2001,7 +2416,7 @@ void DoEvents(PlayerClient* pChar, const char* szLine)
 		locationIndex = lineIter->first;
 	}
 
-	MQMacroStack* pStack = new MQMacroStack(locationIndex);
+	MQMacroStack* pStack = AcquireMacroStack(locationIndex);
 	pStack->Parameters = pEvent->Parameters;
 
 	MQDataVar* pParam = pStack->Parameters;
@@ -2022,9 +2437,10 @@ void DoEvents(PlayerClient* pChar, const char* szLine)
 		gMacroBlock->CurrIndex = gEventFunc[pEvent->Type];
 	}
 
-	DebugSpewNoFile("DoEvents - Deleted event: %d %s", pEvent->Type, pEvent->Name.c_str());
+	auto handlerIter = gMacroBlock->Line.find(gMacroBlock->CurrIndex);
+	if (handlerIter != gMacroBlock->Line.end())
+		++handlerIter->second.CallCount;
 
-	delete pEvent;
 	bRunNextCommand = true;
 
 	if (g_pProfile)
@@ -2061,7 +2477,7 @@ void DoEvents(PlayerClient* pChar, const char* szLine)
 
 		while (parameters)
 		{
-			if (parameters->Var.Type->ToString(pParam->Var.VarPtr, szArg))
+			if (parameters->Var.Type->ToString(parameters->Var.VarPtr, szArg))
 				args.emplace_back(szArg);
 			else
 				args.emplace_back("NULL");
@@ -2071,6 +2487,12 @@ void DoEvents(PlayerClient* pChar, const char* szLine)
 
 		g_pProfile->Call(std::move(eventName), std::move(args));
 	}
+
+	DebugSpewNoFile("DoEvents - Deleted event: %d %s", pEvent->Type, pEvent->Name.c_str());
+
+	// The parameters now belong to the stack frame.
+	pEvent->Parameters = nullptr;
+	delete pEvent;
 }
 
 // ***************************************************************************
@@ -2108,7 +2530,7 @@ void Return(PlayerClient* pChar, const char* szLine)
 	gMacroBlock->CurrIndex = pStack->pNext->LocationIndex;
 	gMacroStack = pStack->pNext;
 
-	delete pStack;
+	ReleaseMacroStack(pStack);
 
 	if (g_pProfile)
 	{
@@ -2116,6 +2538,72 @@ void Return(PlayerClient* pChar, const char* szLine)
 	}
 }
 
+// Splits an unparsed macro line into its space separated arguments, keeping ${...} and [...]
+// groups together so that the individual arguments can be evaluated on their own.
+static std::vector<std::string_view> SplitRawMacroLine(std::string_view line)
+{
+	std::vector<std::string_view> args;
+	size_t pos = 0;
+
+	while (pos < line.size())
+	{
+		while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t'))
+			++pos;
+		if (pos >= line.size())
+			break;
+
+		const size_t start = pos;
+		int depth = 0;
+		bool inQuotes = false;
+
+		for (; pos < line.size(); ++pos)
+		{
+			const char ch = line[pos];
+
+			if (ch == '"')
+				inQuotes = !inQuotes;
+			else if (ch == '{' || ch == '[')
+				++depth;
+			else if ((ch == '}' || ch == ']') && depth > 0)
+				--depth;
+			else if ((ch == ' ' || ch == '\t') && depth == 0 && !inQuotes)
+				break;
+		}
+
+		args.push_back(line.substr(start, pos - start));
+	}
+
+	return args;
+}
+
+// Keep the raw expressions for the bounds of a /for loop that need to be evaluated on each /next.
+static void ResolveForExpressions(MQLoop& loop, const std::string& forLine)
+{
+	// /for <variable> <start> <to|downto> <end> [step x]
+	std::vector<std::string_view> args = SplitRawMacroLine(forLine);
+	if (args.size() < 5 || (!ci_equals(args[3], "to") && !ci_equals(args[3], "downto")))
+	{
+		// The arguments don't line up with the parsed line, so the bounds
+		// resolved on entry are used for the whole loop.
+		return;
+	}
+
+	if (args[4].find('$') != std::string_view::npos)
+		loop.endExpr = args[4];
+
+	if (args.size() >= 7 && ci_equals(args[5], "step") && args[6].find('$') != std::string_view::npos)
+		loop.stepExpr = args[6];
+}
+
+static int EvaluateForExpression(const std::string& expression, int defaultValue)
+{
+	char szValue[MAX_STRING];
+	strcpy_s(szValue, expression.c_str());
+
+	ParseMacroData(szValue, MAX_STRING);
+	return GetIntFromString(szValue, defaultValue);
+}
+
 // ***************************************************************************
 // Function:    For
 // Description: Our '/for' command
@@ -2128,6 +2616,7 @@ void For(PlayerClient* pChar, const char* szLine)
 	char ArgStart[MAX_STRING] = { 0 };
 	char ArgDirection[MAX_STRING] = { 0 };
 	char ArgEnd[MAX_STRING] = { 0 };
+	char ArgStep[MAX_STRING] = { 0 };
 
 	GetArg(ArgLoop, szLine, 1);
 	GetArg(ArgStart, szLine, 2);
@@ -2171,6 +2660,23 @@ void For(PlayerClient* pChar, const char* szLine)
 	loop.firstLine = gMacroBlock->CurrIndex;
 	loop.lastLine = 0;
 	loop.forVariable = ArgLoop;
+	loop.forVar = BindMacroLoopVariable(pVar);
+	loop.downTo = !strcmp(ArgDirection, "downto");
+	loop.endValue = GetIntFromString(ArgEnd, 0);
+
+	GetArg(ArgStep, szLine, 5);
+	if (!_stricmp(ArgStep, "step"))
+	{
+		GetArg(ArgStep, szLine, 6);
+		loop.stepValue = GetIntFromString(ArgStep, 1);
+	}
+
+	auto lineIter = gMacroBlock->Line.find(loop.firstLine);
+	if (lineIter != gMacroBlock->Line.end())
+	{
+		ResolveForExpressions(loop, lineIter->second.Command);
+	}
+
 	PushMacroLoop(loop);
 }
 
@@ -2186,7 +2692,17 @@ void Next(PlayerClient* pChar, const char* szLine)
 	char szNext[MAX_STRING];
 	GetArg(szNext, szLine, 1);
 
-	MQDataVar* pVar = FindMacroVariable(szNext);
+	MQLoop* pLoop = nullptr;
+	if (gMacroStack && !gMacroStack->loopStack.empty() && gMacroStack->loopStack.back().type == MQLoop::Type::For)
+		pLoop = &gMacroStack->loopStack.back();
+
+	// Use the variable that was bound when the loop was entered, if it is the one being stepped.
+	MQDataVar* pVar = nullptr;
+	if (pLoop && pLoop->forVar && *pLoop->forVar && pLoop->forVariable == szNext)
+		pVar = *pLoop->forVar;
+	else
+		pVar = FindMacroVariable(szNext);
+
 	if (!pVar)
 	{
 		FatalError("/next using invalid variable");
@@ -2205,50 +2721,21 @@ void Next(PlayerClient* pChar, const char* szLine)
 		return;
 	}
 
-	const auto size = gMacroStack->loopStack.size();
-	if (size == 0 || gMacroStack->loopStack[size - 1].type != MQLoop::Type::For)
+	if (!pLoop)
 	{
 		FatalError("/next without matching /for");
 		return;
 	}
 
-	gMacroStack->loopStack[size - 1].lastLine = gMacroBlock->CurrIndex;
-	auto MacroLine = gMacroStack->loopStack[size - 1].firstLine;
-	auto iter = gMacroBlock->Line.find(MacroLine);
+	pLoop->lastLine = gMacroBlock->CurrIndex;
+	const int MacroLine = pLoop->firstLine;
 
-	char ForLine[MAX_STRING];
-	strcpy_s(ForLine, iter->second.Command.c_str());
+	// Only the bounds that reference macro data need to be evaluated again.
+	const int StepSize = pLoop->stepExpr.empty() ? pLoop->stepValue : EvaluateForExpression(pLoop->stepExpr, 1);
+	const int Loop = pLoop->endExpr.empty() ? pLoop->endValue : EvaluateForExpression(pLoop->endExpr, 0);
 
-	ParseMacroData(ForLine, MAX_STRING);
-	int VarNum = GetIntFromString(&szLine[1], 0);
-	int StepSize = 1;
-
-	int pos = ci_find_substr(ForLine, "step");
-	if (pos != -1)
-	{
-		char* pTemp = ForLine + pos + 4;
-
-		while ((pTemp[0] != 0) && (pTemp[0] != ' ') && (pTemp[0] != '\t'))
-			pTemp++;
-		if (pTemp[0] != 0)
-			StepSize = GetIntFromString(pTemp, StepSize);
-	}
-
-	pVar = FindMacroVariable(szNext);
-	if (!pVar)
-	{
-		FatalError("/next without badly matching /for");
-		return;
-	}
-
-	pos = ci_find_substr(ForLine, "downto");
-	if (pos != -1)
+	if (pLoop->downTo)
 	{
-		char* pDest = ForLine + pos;
-		// TODO: This is easily broken, should search for the param rather than getting the specific point
-		auto Loop = GetIntFromString(&pDest[7], 0);
-
-		//DebugSpewNoFile("Next - End of loop %d downto %d", pVar->Var.Int, Loop);
 		pVar->Var.Int -= StepSize;
 		if (pVar->Var.Int >= Loop)
 		{
@@ -2261,18 +2748,7 @@ void Next(PlayerClient* pChar, const char* szLine)
 	}
 	else
 	{
-		auto Loop = 0;
-
-		pos = ci_find_substr(ForLine, "to");
-		if (pos != -1)
-		{
-			char* pDest = ForLine + pos + 3;
-			Loop = GetIntFromString(pDest, 0);
-		}
-
-		//DebugSpewNoFile("Next - End of loop %d to %d", pVar->Var.Int, Loop);
 		pVar->Var.Int += StepSize;
-
 		if (pVar->Var.Int <= Loop)
 		{
 			gMacroBlock->CurrIndex = MacroLine;
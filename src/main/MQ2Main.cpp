@@ -399,6 +399,7 @@ bool ParseINIFile(const std::string& iniFile)
 	gbIgnoreAlertRecursion   = GetPrivateProfileBool("MacroQuest", "IgnoreAlertRecursion", gbIgnoreAlertRecursion, iniFile);
 	gbShowCurrentCamera      = GetPrivateProfileBool("MacroQuest", "ShowCurrentCamera", gbShowCurrentCamera, iniFile);
 	gTurboLimit              = GetPrivateProfileInt("MacroQuest", "TurboLimit", gTurboLimit, iniFile);
+	gbCacheMacros            = GetPrivateProfileBool("MacroQuest", "CacheMacros", gbCacheMacros, iniFile);
 	gCreateMQ2NewsWindow     = GetPrivateProfileBool("MacroQuest", "CreateMQ2NewsWindow", gCreateMQ2NewsWindow, iniFile);
 	gNetStatusXPos           = GetPrivateProfileInt("MacroQuest", "NetStatusXPos", gNetStatusXPos, iniFile);
 	gNetStatusYPos           = GetPrivateProfileInt("MacroQuest", "NetStatusYPos", gNetStatusYPos, iniFile);
@@ -434,6 +435,7 @@ bool ParseINIFile(const std::string& iniFile)
 		WritePrivateProfileBool("MacroQuest", "IgnoreAlertRecursion", gbIgnoreAlertRecursion, iniFile);
 		WritePrivateProfileBool("MacroQuest", "ShowCurrentCamera", gbShowCurrentCamera, iniFile);
 		WritePrivateProfileInt("MacroQuest", "TurboLimit", gTurboLimit, iniFile);
+		WritePrivateProfileBool("MacroQuest", "CacheMacros", gbCacheMacros, iniFile);
 		WritePrivateProfileBool("MacroQuest", "CreateMQ2NewsWindow", gCreateMQ2NewsWindow, iniFile);
 		WritePrivateProfileInt("MacroQuest", "NetStatusXPos", gNetStatusXPos, iniFile);
 		WritePrivateProfileInt("MacroQuest", "NetStatusYPos", gNetStatusYPos, iniFile);
@@ -601,30 +603,45 @@ void SetMainThreadId()
 // Perform first time initialization on the main thread.
 void DoMainThreadInitialization()
 {
-	gpMainAPI->DoMainThreadInitialization();
+	ScopedLoadPhase phase("Main thread initialization");
 
-	InitializeDisplayHook();
-	GraphicsResources_Initialize();
-	ImGuiManager_Initialize();
+	{
+		ScopedLoadPhase apiPhase("Main API");
+		gpMainAPI->DoMainThreadInitialization();
+	}
+
+	{
+		ScopedLoadPhase graphicsPhase("Graphics and ImGui");
+		InitializeDisplayHook();
+		GraphicsResources_Initialize();
+		ImGuiManager_Initialize();
+	}
 
 	// this needs to be done before anything that would need to add a callback to string message parsing
-	InitializeStringDB();
-
-	InitializeChatHook();
-	InitializeMQ2CrashHandler();
-	InitializeAnonymizer();
-	InitializeInternalModules();
-	AddInternalModule(GetWindowsModule());
-	AddInternalModule(GetImGuiToolsModule());
-	AddInternalModule(GetSpellsModule());
-	AddInternalModule(GetDataAPIModule());
-	AddInternalModule(GetActorAPIModule());
-	AddInternalModule(GetGroundSpawnsModule());
-	AddInternalModule(GetSpawnsModule());
-	AddInternalModule(GetItemsModule());
-	AddInternalModule(GetPostOfficeModule());
-	InitializeMQ2AutoInventory();
-	InitializeMQ2KeyBinds();
+	{
+		ScopedLoadPhase stringDBPhase("String DB");
+		InitializeStringDB();
+	}
+
+	{
+		ScopedLoadPhase modulesPhase("Internal modules");
+		InitializeChatHook();
+		InitializeMQ2CrashHandler();
+		InitializeAnonymizer();
+		InitializeInternalModules();
+		AddInternalModule(GetWindowsModule());
+		AddInternalModule(GetImGuiToolsModule());
+		AddInternalModule(GetSpellsModule());
+		AddInternalModule(GetDataAPIModule());
+		AddInternalModule(GetActorAPIModule());
+		AddInternalModule(GetGroundSpawnsModule());
+		AddInternalModule(GetSpawnsModule());
+		AddInternalModule(GetItemsModule());
+		AddInternalModule(GetPostOfficeModule());
+		InitializeMQ2AutoInventory();
+		InitializeMQ2KeyBinds();
+	}
+
 	InitializePlugins();
 	InitializeCachedBuffs();
 }
@@ -47,6 +47,7 @@ using namespace eqlib;
 #define MAX_VARNAME           64
 
 #include "mq/base/Traits.h"
+#include "mq/base/ArgTokenizer.h"
 #include "../common/Common.h"
 #include "MQ2Prototypes.h"
 #include "MQ2Internal.h"
@@ -82,12 +83,36 @@ namespace mq {
 void ShutdownMQ2Benchmarks();
 void InitializeMQ2Benchmarks();
 
+// Load timeline. Records how long each phase of startup and plugin loading takes, see /loadtimeline
+int BeginLoadPhase(std::string_view name);
+void EndLoadPhase(int phase);
+
+class ScopedLoadPhase
+{
+public:
+	explicit ScopedLoadPhase(std::string_view name) : m_phase(BeginLoadPhase(name)) {}
+	~ScopedLoadPhase() { EndLoadPhase(m_phase); }
+
+	ScopedLoadPhase(const ScopedLoadPhase&) = delete;
+	ScopedLoadPhase& operator=(const ScopedLoadPhase&) = delete;
+
+private:
+	int m_phase;
+};
+
 void InitializeDisplayHook();
 void ShutdownDisplayHook();
 
 void InitializeMQ2Pulse();
 void ShutdownMQ2Pulse();
 
+// Statistics for the queue behind PostToMainThread
+MainThreadQueueStats GetMainThreadQueueStats();
+void ResetMainThreadQueueStats();
+
+// Drops the tasks a plugin has queued with PostToMainThread, so none run after it is unloaded
+void RemoveMainThreadTasks(const MQPluginHandle& pluginHandle);
+
 void InitializeChatHook();
 void ShutdownChatHook();
 
@@ -108,6 +133,11 @@ MQLIB_API void DebugSpewNoFile(const char* szFormat, ...);
 MQLIB_API bool SetNameSpriteState(SPAWNINFO* pSpawn, bool Show);
 MQLIB_API bool IsTargetable(SPAWNINFO* pSpawn);
 MQLIB_API bool AreNameSpritesCustomized();
+bool CachedLineOfSight(PlayerClient* pSource, PlayerClient* pTarget);
+bool CachedCastRayLoc(const CVector3& source, int race, float x, float y, float z);
+bool GetSpawnNameCandidates(const MQSpawnSearch* pSearchSpawn, std::vector<SPAWNINFO*>& candidates, bool sorted = false);
+bool IsSpawnNameIndexEnabled();
+void SetSpawnNameIndexEnabled(bool enabled);
 
 /* OVERLAY */
 MQLIB_API bool IsImGuiForeground();
@@ -268,6 +298,7 @@ struct RefreshKeyRingsThreadData
 MQLIB_API ItemDefinition* GetItemFromContents(ItemClient* c);
 
 MQLIB_API bool AddMacroLine(const char* FileName, char* szLine, size_t Linelen, int* LineNumber, int localLine);
+std::shared_ptr<const MQMacroImage> LoadMacroImage(const std::filesystem::path& path, bool useCache);
 
 MQLIB_API const char* GetLightForSpawn(SPAWNINFO* pSpawn);
 MQLIB_API int GetDeityTeamByID(int DeityID);
@@ -335,6 +366,22 @@ MQLIB_API char* GetFuncParam(const char* szMacroLine, int ParamNum, char* szPara
 
 MQLIB_API void DropTimers();
 
+/* MACRO EVENTS */
+MQEventBucket* GetMacroEventBucket(const std::string& name, bool create = false);
+MQEventQueue* PopMacroEvent(MQEventBucket* pBucket = nullptr);
+void FlushMacroEvents(MQEventBucket* pBucket = nullptr);
+void ClearMacroEvents();
+
+/* SPELL STACKING */
+struct SpellStackingCacheStats
+{
+	uint64_t Hits = 0;
+	uint64_t Misses = 0;
+	size_t Entries = 0;
+};
+SpellStackingCacheStats GetSpellStackingCacheStats();
+void ClearSpellStackingCache(bool resetStats = false);
+
 /*                 */
 
 MQLIB_API bool LoadCfgFile(const char* Filename, bool Delayed = FromPlugin);
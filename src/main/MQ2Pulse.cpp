@@ -18,9 +18,11 @@
 
 #include "MQ2Main.h"
 #include "CrashHandler.h"
+#include "GraphicsResources.h"
 #include "ImGuiManager.h"
 
 #include "MQCommandAPI.h"
+#include "MQDataAPI.h"
 #include "MQPluginHandler.h"
 #include "MQPostOffice.h"
 
@@ -42,31 +44,48 @@ void UpdateMQ2SpawnSort();
 
 //----------------------------------------------------------------------------
 
-std::vector<std::function<void()>> s_queuedEvents;
-std::recursive_mutex s_queuedEventMutex;
+static MainThreadQueue s_mainThreadQueue;
+static std::chrono::milliseconds s_mainThreadBudget{ 0 };
 extern wil::unique_event g_hLoadComplete;
 
-void PostToMainThread(std::function<void()>&& callback)
+void PostToMainThread(std::function<void()>&& callback,
+	const MQPluginHandle& pluginHandle /* = mqplugin::ThisPluginHandle */)
 {
-	std::scoped_lock lock(s_queuedEventMutex);
-
-	s_queuedEvents.push_back(std::move(callback));
+	if (callback)
+	{
+		s_mainThreadQueue.Post(MainThreadTask(std::move(callback)), MainThreadPriority::Normal,
+			MainThreadQueue::clock::duration::zero(), pluginHandle.pluginID);
+	}
 }
 
-static void ProcessQueuedEvents()
+void PostToMainThread(MainThreadTask&& task, MainThreadPriority priority,
+	std::chrono::milliseconds maxDelay /* = std::chrono::milliseconds::zero() */,
+	const MQPluginHandle& pluginHandle /* = mqplugin::ThisPluginHandle */)
 {
-	std::unique_lock lock(s_queuedEventMutex);
+	if (task)
+	{
+		s_mainThreadQueue.Post(std::move(task), priority, maxDelay, pluginHandle.pluginID);
+	}
+}
 
-	if (s_queuedEvents.empty())
-		return;
+void RemoveMainThreadTasks(const MQPluginHandle& pluginHandle)
+{
+	s_mainThreadQueue.RemoveTasks(pluginHandle.pluginID);
+}
 
-	std::vector<std::function<void()>> events;
-	events.swap(s_queuedEvents);
+MainThreadQueueStats GetMainThreadQueueStats()
+{
+	return s_mainThreadQueue.GetStats();
+}
 
-	lock.unlock();
+void ResetMainThreadQueueStats()
+{
+	s_mainThreadQueue.ResetStats();
+}
 
-	for (auto& ev : events)
-		std::invoke(ev);
+static void ProcessQueuedEvents()
+{
+	s_mainThreadQueue.Process(s_mainThreadBudget);
 }
 
 //----------------------------------------------------------------------------
@@ -95,15 +114,10 @@ static bool DoNextCommand(MQMacroBlockPtr pBlock)
 
 	if (gDelay && gDelayCondition[0])
 	{
-		char szCond[MAX_STRING];
-		strcpy_s(szCond, gDelayCondition);
-
-		ParseMacroData(szCond, MAX_STRING);
-
 		double Result;
-		if (!Calculate(szCond, Result))
+		if (!EvaluateMacroCondition(gDelayCondition, Result))
 		{
-			FatalError("Failed to parse /delay condition '%s', non-numeric encountered", szCond);
+			FatalError("Failed to parse /delay condition '%s', non-numeric encountered", gDelayCondition);
 			return false;
 		}
 
@@ -116,7 +130,7 @@ static bool DoNextCommand(MQMacroBlockPtr pBlock)
 
 	if (!gDelay && pBlock && !pBlock->Paused && (!gMQPauseOnChat || pEverQuestInfo->KeyboardMode) && gMacroStack)
 	{
-		const MQMacroLine& ml = pBlock->Line.at(pBlock->CurrIndex);
+		MQMacroLine& ml = pBlock->Line.at(pBlock->CurrIndex);
 
 		if (pBlock->BindStackIndex == pBlock->CurrIndex)
 		{
@@ -133,6 +147,7 @@ static bool DoNextCommand(MQMacroBlockPtr pBlock)
 
 		if (gbInZone && !gZoning)
 		{
+			++ml.HitCount;
 			DoCommand(ml.Command.c_str(), false);
 			MQMacroBlockPtr pCurrentBlock = GetCurrentMacroBlock();
 
@@ -169,7 +184,6 @@ static bool DoNextCommand(MQMacroBlockPtr pBlock)
 #ifdef MQ2_PROFILING
 			LARGE_INTEGER AfterCommand;
 			QueryPerformanceCounter(&AfterCommand);
-			pCurrentBlock->Line[ThisMacroBlock].ExecutionCount++;
 			pCurrentBlock->Line[ThisMacroBlock].ExecutionTime += AfterCommand.QuadPart - BeforeCommand.QuadPart;
 #endif
 
@@ -738,6 +752,7 @@ static HeartbeatState Heartbeat()
 	}
 
 	ImGuiManager_Pulse();
+	GraphicsResources_OnPulse();
 
 	if (gGameState == -1)
 	{
@@ -864,6 +879,11 @@ void InitializeMQ2Pulse()
 
 	std::scoped_lock lock(s_pulseMutex);
 
+	// 0 (the default) runs everything that was posted to the main thread on the next pulse. A
+	// budget in milliseconds carries normal priority tasks over to later pulses once it is used up.
+	s_mainThreadBudget = std::chrono::milliseconds(
+		std::max(GetPrivateProfileInt("MacroQuest", "MainThreadBudget", 0, mq::internal_paths::MQini), 0));
+
 	AddDetour(reinterpret_cast<uintptr_t>(ProcessGameEvents), Detour_ProcessGameEvents, Trampoline_ProcessGameEvents, "ProcessGameEvents");
 	EzDetour(CEverQuest__SetGameState, &CEverQuestHook::SetGameState_Detour, &CEverQuestHook::SetGameState_Trampoline);
 	EzDetour(CMerchantWnd__PurchasePageHandler__UpdateList, &CEverQuestHook::CMerchantWnd__PurchasePageHandler__UpdateList_Detour, &CEverQuestHook::CMerchantWnd__PurchasePageHandler__UpdateList_Trampoline);
@@ -14,8 +14,10 @@
 
 #include "pch.h"
 #include "MQ2Main.h"
+#include "LineOfSightKey.h"
 #include "MQDataAPI.h"
 #include "MQPluginHandler.h"
+#include "SpawnBatch.h"
 
 namespace mq {
 
@@ -23,6 +25,7 @@ static void Spawns_Initialize();
 static void Spawns_Shutdown();
 static void Spawns_Pulse();
 static void Spawns_BeginZone();
+static void Spawns_SpawnAdded(SPAWNINFO* pSpawn);
 static void Spawns_SpawnRemoved(SPAWNINFO* pSpawn);
 
 static MQModule gSpawnsModule = {
@@ -35,7 +38,7 @@ static MQModule gSpawnsModule = {
 	nullptr,                      // UpdateImGui
 	nullptr,                      // Zoned
 	nullptr,                      // WriteChatColor
-	nullptr,                      // SpawnAdded
+	Spawns_SpawnAdded,            // SpawnAdded
 	Spawns_SpawnRemoved,          // SpawnRemoved
 	Spawns_BeginZone,             // BeginZone
 };
@@ -357,6 +360,7 @@ static void CaptionColorCmd(SPAWNINFO* pChar, char* szLine)
 }
 
 void SetNameSpriteTint(SPAWNINFO* pSpawn);
+static void UpdateSpawnNameIndex(SPAWNINFO* pSpawn);
 
 static unsigned int lastRemovedSpawnID = 0;
 
@@ -393,12 +397,11 @@ public:
 	DETOUR_TRAMPOLINE_DEF(void, DestroyAllPlayers_Trampoline, ())
 		void DestroyAllPlayers_Detour()
 	{
-		SPAWNINFO* pSpawn = FirstSpawn;
-		while (pSpawn)
-		{
-			PluginsRemoveSpawn(pSpawn);
-			pSpawn = pSpawn->pNext;
-		}
+		std::vector<PlayerClient*> spawns;
+		for (SPAWNINFO* pSpawn = FirstSpawn; pSpawn; pSpawn = pSpawn->pNext)
+			spawns.push_back(pSpawn);
+
+		PluginsRemoveSpawns(spawns.data(), static_cast<int>(spawns.size()));
 
 		return DestroyAllPlayers_Trampoline();
 	}
@@ -444,6 +447,9 @@ public:
 	DETOUR_TRAMPOLINE_DEF(int, SetNameSpriteState_Trampoline, (bool Show))
 	int SetNameSpriteState_Detour(bool Show)
 	{
+		// The client updates the name sprite when the name changes
+		UpdateSpawnNameIndex(reinterpret_cast<SPAWNINFO*>(this));
+
 		if (gGameState != GAMESTATE_INGAME || !Show || !gMQCaptions)
 			return SetNameSpriteState_Trampoline(Show);
 
@@ -635,6 +641,31 @@ bool SetNameSpriteState(SPAWNINFO* pSpawn, bool Show)
 	return reinterpret_cast<PlayerClientHook*>(pSpawn)->SetNameSpriteState_Trampoline(Show) != 0;
 }
 
+// Spawns that were added as a batch while zoning.
+static SpawnCaptionQueue s_pendingCaptionSpawns;
+static constexpr int MAX_PENDING_CAPTIONS_PER_FRAME = 50;
+
+void QueueSpawnCaption(SPAWNINFO* pSpawn)
+{
+	// Queued even without MQ captions, SetNameSpriteState then sets the client's own caption.
+	if (pSpawn)
+		s_pendingCaptionSpawns.Push(pSpawn->SpawnID);
+}
+
+static void UpdatePendingSpawnCaptions()
+{
+	s_pendingCaptionSpawns.Update(MAX_PENDING_CAPTIONS_PER_FRAME, [](uint32_t spawnID)
+		{
+			// The spawn may have gone away while it was waiting.
+			SPAWNINFO* pSpawn = GetSpawnByID(spawnID);
+			if (!pSpawn)
+				return false;
+
+			SetNameSpriteState(pSpawn, true);
+			return true;
+		});
+}
+
 static void UpdateSpawnCaptions()
 {
 	if (!gMQCaptions)
@@ -827,6 +858,405 @@ static void ProcessPendingGroundItems()
 
 #pragma endregion
 
+#pragma region Line of Sight Cache
+//----------------------------------------------------------------------------
+// Line of sight checks are ray casts, and the same checks tend to be repeated many times
+// in a frame by spawn searches, ${Spawn[].LineOfSight} and ${LineOfSight[]}.  Results are
+// kept until the next pulse.  Positions are quantized to LineOfSightTolerance units so that
+// checks made from nearly the same place share a result.  A tolerance of 0 only matches
+// identical positions.
+//----------------------------------------------------------------------------
+
+static float gLineOfSightTolerance = 0.0f;
+
+static std::unordered_map<LineOfSightKey, bool, LineOfSightKeyHash> s_lineOfSightCache;
+static uint64_t s_lineOfSightHits = 0;
+static uint64_t s_lineOfSightMisses = 0;
+
+template <typename Func>
+static bool GetCachedLineOfSight(const LineOfSightKey& key, Func&& check)
+{
+	auto iter = s_lineOfSightCache.find(key);
+	if (iter != s_lineOfSightCache.end())
+	{
+		++s_lineOfSightHits;
+		return iter->second;
+	}
+
+	++s_lineOfSightMisses;
+
+	bool result = check();
+	s_lineOfSightCache.emplace(key, result);
+	return result;
+}
+
+bool CachedLineOfSight(PlayerClient* pSource, PlayerClient* pTarget)
+{
+	if (!pSource || !pTarget)
+		return false;
+
+	LineOfSightKey key;
+	key.sourceID = pSource->SpawnID;
+	key.targetID = pTarget->SpawnID;
+	key.SetPositions(CVector3(pSource->X, pSource->Y, pSource->Z), CVector3(pTarget->X, pTarget->Y, pTarget->Z), gLineOfSightTolerance);
+
+	return GetCachedLineOfSight(key, [&]() { return pSource->CanSee(*pTarget); });
+}
+
+bool CachedCastRayLoc(const CVector3& source, int race, float x, float y, float z)
+{
+	LineOfSightKey key;
+	key.race = race;
+	key.SetPositions(source, CVector3(x, y, z), gLineOfSightTolerance);
+
+	return GetCachedLineOfSight(key, [&]() { return CastRayLoc(source, race, x, y, z); });
+}
+
+static void ClearLineOfSightCache()
+{
+	s_lineOfSightCache.clear();
+}
+
+// ***************************************************************************
+// Function:    LineOfSightCacheCmd
+// Description: Shows or resets the line of sight cache counters
+// Usage:       /loscache [reset]
+// ***************************************************************************
+static void LineOfSightCacheCmd(PlayerClient*, const char* szLine)
+{
+	char Arg1[MAX_STRING] = { 0 };
+	GetArg(Arg1, szLine, 1);
+
+	if (!_stricmp(Arg1, "reset"))
+	{
+		s_lineOfSightHits = 0;
+		s_lineOfSightMisses = 0;
+		WriteChatf("Line of sight cache counters reset.");
+		return;
+	}
+
+	const uint64_t total = s_lineOfSightHits + s_lineOfSightMisses;
+	WriteChatf("Line of sight cache: \ay%llu\ax hits, \ay%llu\ax misses (\ay%.1f%%\ax hit rate), \ay%d\ax cached this frame, tolerance \ay%.2f\ax",
+		s_lineOfSightHits, s_lineOfSightMisses, total ? 100.0 * s_lineOfSightHits / total : 0.0,
+		static_cast<int>(s_lineOfSightCache.size()), gLineOfSightTolerance);
+}
+
+#pragma endregion
+
+#pragma region Spawn Name Index
+//----------------------------------------------------------------------------
+// Spawn searches by name test every spawn in the zone, and have to clean up each spawn's
+// name to do it.  The index keeps lowercased copies of each spawn's name, clean name and
+// exact match name so a name search can go straight to the spawns that could match.  The
+// candidates still go through SpawnMatchesSearch, so results are the same as a full scan.
+//
+// The index is built from the spawn list the first time it is used after a zone, and after
+// that it is kept up to date by the spawn added and removed hooks, and by SetNameSpriteState
+// for renames (the client updates the name sprite when a spawn's name changes, such as a mob
+// becoming a corpse).
+//----------------------------------------------------------------------------
+
+static bool gbSpawnNameIndex = true;
+
+struct SpawnNameEntry
+{
+	SPAWNINFO* pSpawn = nullptr;
+	char name[EQ_MAX_NAME] = { 0 };            // the name the entry was built from
+	std::string lowerName;
+	std::string lowerCleanName;
+	std::string lowerExactName;
+	size_t sortIndex = 0;                      // position in gSpawnsArray
+	uint32_t sortGeneration = 0;               // the sort that sortIndex is from
+};
+
+class SpawnNameIndex
+{
+public:
+	void Clear()
+	{
+		m_entries.clear();
+		m_bySpawn.clear();
+		m_byExactName.clear();
+		m_nameless.clear();
+		m_built = false;
+		m_sortStamped = false;
+	}
+
+	// gSpawnsArray was rebuilt. Positions are picked up the next time they are needed.
+	void SpawnsSorted()
+	{
+		++m_sortGeneration;
+		m_sortStamped = false;
+	}
+
+	void AddSpawn(SPAWNINFO* pSpawn)
+	{
+		// Until the index is built, it will pick the spawn up from the spawn list
+		if (m_built && m_bySpawn.find(pSpawn) == m_bySpawn.end())
+			AddEntry(pSpawn);
+	}
+
+	void RemoveSpawn(SPAWNINFO* pSpawn)
+	{
+		auto iter = m_bySpawn.find(pSpawn);
+		if (iter != m_bySpawn.end())
+			RemoveEntry(iter->second);
+	}
+
+	void UpdateSpawn(SPAWNINFO* pSpawn)
+	{
+		if (!m_built)
+			return;
+
+		auto iter = m_bySpawn.find(pSpawn);
+		if (iter == m_bySpawn.end())
+		{
+			AddEntry(pSpawn);
+			return;
+		}
+
+		SpawnNameEntry& entry = m_entries[iter->second];
+		if (strcmp(entry.name, pSpawn->Name) != 0)
+		{
+			++m_renames;
+			RemoveNames(entry);
+			SetNames(entry);
+		}
+	}
+
+	// With sorted set, only spawns that are in gSpawnsArray are returned, in the same order, so
+	// that ties in distance come out the same way they do when searching gSpawnsArray.
+	void GetCandidates(const char* szName, bool exact, bool sorted, std::vector<SPAWNINFO*>& candidates)
+	{
+		if (m_exactCleanNames != gbExactSearchCleanNames)
+		{
+			// exact names are built differently, so start over
+			Clear();
+			m_exactCleanNames = gbExactSearchCleanNames;
+		}
+
+		if (!m_built)
+			Build();
+
+		++m_lookups;
+
+		std::string search = to_lower_copy(szName);
+
+		if (exact)
+		{
+			auto iter = m_byExactName.find(search);
+			if (iter != m_byExactName.end())
+				candidates.insert(candidates.end(), iter->second.begin(), iter->second.end());
+		}
+		else
+		{
+			for (const SpawnNameEntry& entry : m_entries)
+			{
+				if (entry.lowerName.find(search) != std::string::npos
+					|| entry.lowerCleanName.find(search) != std::string::npos)
+				{
+					candidates.push_back(entry.pSpawn);
+				}
+			}
+		}
+
+		// Spawns without a name are never filtered by name
+		candidates.insert(candidates.end(), m_nameless.begin(), m_nameless.end());
+
+		if (sorted)
+			SortCandidates(candidates);
+
+		m_candidates += candidates.size();
+	}
+
+	size_t size() const { return m_entries.size(); }
+
+	uint64_t m_lookups = 0;
+	uint64_t m_candidates = 0;
+	uint64_t m_builds = 0;
+	uint64_t m_renames = 0;
+
+private:
+	void Build()
+	{
+		++m_builds;
+
+		SPAWNINFO* pSpawn = pSpawnManager ? pSpawnManager->FirstSpawn : nullptr;
+		while (pSpawn)
+		{
+			if (m_bySpawn.find(pSpawn) == m_bySpawn.end())
+				AddEntry(pSpawn);
+
+			pSpawn = pSpawn->pNext;
+		}
+
+		m_built = true;
+	}
+
+	void SortCandidates(std::vector<SPAWNINFO*>& candidates)
+	{
+		if (!m_sortStamped)
+		{
+			for (size_t index = 0; index < gSpawnsArray.size(); ++index)
+			{
+				auto iter = m_bySpawn.find(gSpawnsArray[index].GetSpawn());
+				if (iter != m_bySpawn.end())
+				{
+					SpawnNameEntry& entry = m_entries[iter->second];
+					entry.sortIndex = index;
+					entry.sortGeneration = m_sortGeneration;
+				}
+			}
+
+			m_sortStamped = true;
+		}
+
+		// Spawns that arrived since the sort aren't in gSpawnsArray
+		candidates.erase(
+			std::remove_if(candidates.begin(), candidates.end(),
+				[this](SPAWNINFO* pSpawn) { return GetEntry(pSpawn).sortGeneration != m_sortGeneration; }),
+			candidates.end());
+
+		std::sort(candidates.begin(), candidates.end(),
+			[this](SPAWNINFO* a, SPAWNINFO* b) { return GetEntry(a).sortIndex < GetEntry(b).sortIndex; });
+	}
+
+	const SpawnNameEntry& GetEntry(SPAWNINFO* pSpawn) const
+	{
+		return m_entries[m_bySpawn.at(pSpawn)];
+	}
+
+	void AddEntry(SPAWNINFO* pSpawn)
+	{
+		SpawnNameEntry& entry = m_entries.emplace_back();
+		entry.pSpawn = pSpawn;
+		SetNames(entry);
+
+		m_bySpawn[pSpawn] = m_entries.size() - 1;
+	}
+
+	void RemoveEntry(size_t index)
+	{
+		RemoveNames(m_entries[index]);
+		m_bySpawn.erase(m_entries[index].pSpawn);
+
+		if (index != m_entries.size() - 1)
+		{
+			m_entries[index] = std::move(m_entries.back());
+			m_bySpawn[m_entries[index].pSpawn] = index;
+		}
+
+		m_entries.pop_back();
+	}
+
+	void SetNames(SpawnNameEntry& entry)
+	{
+		// The same name forms that SpawnMatchesSearch compares against
+		strcpy_s(entry.name, entry.pSpawn->Name);
+		entry.lowerName = to_lower_copy(entry.name);
+
+		char szCleanName[EQ_MAX_NAME] = { 0 };
+		strcpy_s(szCleanName, entry.name);
+		CleanupName(szCleanName, sizeof(szCleanName), false);
+		entry.lowerCleanName = to_lower_copy(szCleanName);
+
+		strcpy_s(szCleanName, entry.name);
+		CleanupName(szCleanName, sizeof(szCleanName), false, !m_exactCleanNames);
+		entry.lowerExactName = to_lower_copy(szCleanName);
+
+		m_byExactName[entry.lowerExactName].push_back(entry.pSpawn);
+
+		if (entry.name[0] == 0)
+			m_nameless.push_back(entry.pSpawn);
+	}
+
+	void RemoveNames(const SpawnNameEntry& entry)
+	{
+		if (entry.name[0] == 0)
+			m_nameless.erase(std::remove(m_nameless.begin(), m_nameless.end(), entry.pSpawn), m_nameless.end());
+
+		auto iter = m_byExactName.find(entry.lowerExactName);
+		if (iter == m_byExactName.end())
+			return;
+
+		std::vector<SPAWNINFO*>& spawns = iter->second;
+		spawns.erase(std::remove(spawns.begin(), spawns.end(), entry.pSpawn), spawns.end());
+
+		if (spawns.empty())
+			m_byExactName.erase(iter);
+	}
+
+	std::vector<SpawnNameEntry> m_entries;
+	std::unordered_map<SPAWNINFO*, size_t> m_bySpawn;
+	std::unordered_map<std::string, std::vector<SPAWNINFO*>> m_byExactName;
+	std::vector<SPAWNINFO*> m_nameless;
+	uint32_t m_sortGeneration = 1;
+	bool m_built = false;
+	bool m_sortStamped = false;
+	bool m_exactCleanNames = false;
+};
+
+static SpawnNameIndex s_spawnNameIndex;
+
+static void UpdateSpawnNameIndex(SPAWNINFO* pSpawn)
+{
+	s_spawnNameIndex.UpdateSpawn(pSpawn);
+}
+
+bool GetSpawnNameCandidates(const MQSpawnSearch* pSearchSpawn, std::vector<SPAWNINFO*>& candidates, bool sorted)
+{
+	if (!gbSpawnNameIndex || !pSearchSpawn || !pSearchSpawn->szName[0])
+		return false;
+
+	s_spawnNameIndex.GetCandidates(pSearchSpawn->szName, pSearchSpawn->bExactName, sorted, candidates);
+	return true;
+}
+
+bool IsSpawnNameIndexEnabled()
+{
+	return gbSpawnNameIndex;
+}
+
+void SetSpawnNameIndexEnabled(bool enabled)
+{
+	gbSpawnNameIndex = enabled;
+}
+
+// ***************************************************************************
+// Function:    SpawnNameIndexCmd
+// Description: Shows the spawn name index counters, or turns the index on or off
+// Usage:       /spawnindex [on|off|reset]
+// ***************************************************************************
+static void SpawnNameIndexCmd(PlayerClient*, const char* szLine)
+{
+	char Arg1[MAX_STRING] = { 0 };
+	GetArg(Arg1, szLine, 1);
+
+	if (!_stricmp(Arg1, "reset"))
+	{
+		s_spawnNameIndex.m_lookups = 0;
+		s_spawnNameIndex.m_candidates = 0;
+		s_spawnNameIndex.m_builds = 0;
+		s_spawnNameIndex.m_renames = 0;
+		WriteChatf("Spawn name index counters reset.");
+		return;
+	}
+
+	if (!_stricmp(Arg1, "on") || !_stricmp(Arg1, "off"))
+	{
+		gbSpawnNameIndex = !_stricmp(Arg1, "on");
+		WritePrivateProfileBool("MacroQuest", "SpawnNameIndex", gbSpawnNameIndex, mq::internal_paths::MQini);
+	}
+
+	const uint64_t lookups = s_spawnNameIndex.m_lookups;
+	WriteChatf("Spawn name index is \ay%s\ax: \ay%d\ax spawns, \ay%llu\ax lookups (\ay%.1f\ax candidates per lookup), \ay%llu\ax builds, \ay%llu\ax renames",
+		gbSpawnNameIndex ? "on" : "off", static_cast<int>(s_spawnNameIndex.size()), lookups,
+		lookups ? static_cast<double>(s_spawnNameIndex.m_candidates) / lookups : 0.0,
+		s_spawnNameIndex.m_builds, s_spawnNameIndex.m_renames);
+}
+
+#pragma endregion
+
 void UpdateMQ2SpawnSort()
 {
 	EnterMQ2Benchmark(bmUpdateSpawnSort);
@@ -859,6 +1289,7 @@ void UpdateMQ2SpawnSort()
 
 	gSpawnCount = static_cast<int>(gSpawnsArray.size());
 	EQP_DistArray = gSpawnCount > 0 ? &gSpawnsArray[0] : nullptr;
+	s_spawnNameIndex.SpawnsSorted();
 
 	ExitMQ2Benchmark(bmUpdateSpawnSort);
 }
@@ -941,8 +1372,13 @@ static void Spawns_Initialize()
 
 	pDataAPI->AddTopLevelObject("NamingSpawn", dataNamingSpawn);
 
+	gLineOfSightTolerance = std::max(GetPrivateProfileFloat("MacroQuest", "LineOfSightTolerance", gLineOfSightTolerance, mq::internal_paths::MQini), 0.0f);
+	gbSpawnNameIndex = GetPrivateProfileBool("MacroQuest", "SpawnNameIndex", gbSpawnNameIndex, mq::internal_paths::MQini);
+
 	AddCommand("/caption", CaptionCmd, false, false);
 	AddCommand("/captioncolor", CaptionColorCmd, false, false);
+	AddCommand("/loscache", LineOfSightCacheCmd, false, false);
+	AddCommand("/spawnindex", SpawnNameIndexCmd, false, false);
 }
 
 static void Spawns_Shutdown()
@@ -953,6 +1389,8 @@ static void Spawns_Shutdown()
 
 	RemoveCommand("/caption");
 	RemoveCommand("/captioncolor");
+	RemoveCommand("/loscache");
+	RemoveCommand("/spawnindex");
 
 	RemoveDetour(PlayerManagerClient__CreatePlayer);
 	RemoveDetour(PlayerManagerBase__PrepForDestroyPlayer);
@@ -981,6 +1419,7 @@ static void Spawns_Shutdown()
 	EQP_DistArray = nullptr;
 	gSpawnCount = 0;
 	gSpawnsArray.clear();
+	s_spawnNameIndex.Clear();
 
 	RemoveMQ2Benchmark(bmUpdateSpawnSort);
 	RemoveMQ2Benchmark(bmUpdateSpawnCaptions);
@@ -988,6 +1427,8 @@ static void Spawns_Shutdown()
 
 static void Spawns_Pulse()
 {
+	ClearLineOfSightCache();
+
 	if (gGameState != GAMESTATE_INGAME)
 		return;
 
@@ -1016,6 +1457,12 @@ static void Spawns_Pulse()
 		
 		UpdateSpawnCaptions();
 	}
+	else if (!s_pendingCaptionSpawns.empty())
+	{
+		MQScopedBenchmark bm(bmUpdateSpawnCaptions);
+
+		UpdatePendingSpawnCaptions();
+	}
 
 	if (pTarget)
 	{
@@ -1030,10 +1477,20 @@ static void Spawns_Pulse()
 static void Spawns_BeginZone()
 {
 	gSpawnsArray.clear();
+	s_pendingCaptionSpawns.Clear();
+	ClearLineOfSightCache();
+	s_spawnNameIndex.Clear();
+}
+
+static void Spawns_SpawnAdded(SPAWNINFO* pSpawn)
+{
+	s_spawnNameIndex.AddSpawn(pSpawn);
 }
 
 static void Spawns_SpawnRemoved(SPAWNINFO* pSpawn)
 {
+	s_spawnNameIndex.RemoveSpawn(pSpawn);
+
 	if (gSpawnsArray.empty())
 		return;
 
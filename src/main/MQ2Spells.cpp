@@ -885,7 +885,10 @@ DWORD CALLBACK InitializeMQ2SpellDb(void* pData)
 	}
 
 	// ok everything checks out lets fill our own map with spells
-	Benchmark(bmSpellLoad, PopulateSpellMap());
+	{
+		ScopedLoadPhase phase("Spell DB");
+		Benchmark(bmSpellLoad, PopulateSpellMap());
+	}
 
 	ghInitializeSpellDbThread = nullptr;
 	return 0;
@@ -2957,12 +2957,21 @@ SPAWNINFO* NthNearestSpawn(MQSpawnSearch* pSearchSpawn, int Nth, SPAWNINFO* pOri
 		return nullptr;
 
 	std::vector<MQSpawnArrayItem> spawnSet;
-	spawnSet.reserve(gSpawnsArray.size());
 
-	for (const MQSpawnArrayItem& item : gSpawnsArray)
+	// Name searches only need to look at the spawns the name index says could match. They come
+	// back in gSpawnsArray order so that spawns at the same distance sort the same way.
+	std::vector<SPAWNINFO*> candidates;
+	if (!GetSpawnNameCandidates(pSearchSpawn, candidates, true))
 	{
-		SPAWNINFO* pSpawn = item.GetSpawn();
+		candidates.reserve(gSpawnsArray.size());
+		for (const MQSpawnArrayItem& item : gSpawnsArray)
+			candidates.push_back(item.GetSpawn());
+	}
+
+	spawnSet.reserve(candidates.size());
 
+	for (SPAWNINFO* pSpawn : candidates)
+	{
 		if (!IncludeOrigin && pSpawn == pOrigin)
 			continue;
 
@@ -2994,6 +3003,19 @@ int CountMatchingSpawns(MQSpawnSearch* pSearchSpawn, SPAWNINFO* pOrigin, bool In
 		return 0;
 
 	int TotalMatching = 0;
+
+	std::vector<SPAWNINFO*> candidates;
+	if (GetSpawnNameCandidates(pSearchSpawn, candidates))
+	{
+		for (SPAWNINFO* pSpawn : candidates)
+		{
+			if ((IncludeOrigin || pSpawn != pOrigin) && SpawnMatchesSearch(pSearchSpawn, pOrigin, pSpawn))
+				TotalMatching++;
+		}
+
+		return TotalMatching;
+	}
+
 	SPAWNINFO* pSpawn = pSpawnList;
 
 	if (IncludeOrigin)
@@ -3438,7 +3460,7 @@ bool SpawnMatchesSearch(MQSpawnSearch* pSearchSpawn, SPAWNINFO* pChar, SPAWNINFO
 		return false;
 	if (pSearchSpawn->szRace[0] && _stricmp(pSearchSpawn->szRace, pEverQuest->GetRaceDesc(pSpawn->GetRace())))
 		return false;
-	if (pSearchSpawn->bLoS && !pControlledPlayer->CanSee(*pSpawn))
+	if (pSearchSpawn->bLoS && !CachedLineOfSight(pControlledPlayer, pSpawn))
 		return false;
 	if (pSearchSpawn->bTargetable && !IsTargetable(pSpawn))
 		return false;
@@ -4840,6 +4862,28 @@ bool BuffStackTest(SPELL* aSpell, SPELL* bSpell, bool bIgnoreTriggeringEffects,
 	return true;
 }
 
+// The test behind WillStackWith, without the cache.
+static bool WillStackWithUncached(const EQ_Spell* testSpell, const EQ_Spell* existingSpell)
+{
+	EQ_Affect buff;
+	buff.Level = pLocalPlayer->Level;
+	buff.CasterGuid = pLocalPC->Guid;
+
+	buff.PopulateFromSpell(existingSpell);
+
+	int SlotIndex = -1;
+	EQ_Affect* ret = pLocalPC->FindAffectSlot(testSpell->ID, pLocalPlayer, &SlotIndex, true, pLocalPlayer->Level, &buff, 1);
+
+	return ret && SlotIndex != -1;
+}
+
+// Whether two spells stack only depends on the spell data and the caster level, so the result
+// is remembered per (test spell, existing spell, level) until the character changes.
+static std::unordered_map<uint64_t, bool> s_spellStackingCache;
+static std::string s_spellStackingCacheCharacter;
+static SpellStackingCacheStats s_spellStackingCacheStats;
+constexpr size_t MAX_SPELL_STACKING_CACHE_SIZE = 250000;
+
 /**
  * @fn WillStackWith
  *
@@ -4859,16 +4903,50 @@ bool WillStackWith(const EQ_Spell* testSpell, const EQ_Spell* existingSpell)
 	if (!pLocalPlayer || !pLocalPC)
 		return false;
 
-	EQ_Affect buff;
-	buff.Level = pLocalPlayer->Level;
-	buff.CasterGuid = pLocalPC->Guid;
+	// The client can reuse the same PcClient for the next character, so go by the name.
+	if (s_spellStackingCacheCharacter != pLocalPC->Name)
+	{
+		s_spellStackingCache.clear();
+		s_spellStackingCacheCharacter = pLocalPC->Name;
+	}
 
-	buff.PopulateFromSpell(existingSpell);
+	uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(testSpell->ID)) << 32)
+		| (static_cast<uint64_t>(static_cast<uint32_t>(existingSpell->ID) & 0xffffff) << 8)
+		| static_cast<uint8_t>(pLocalPlayer->Level);
 
-	int SlotIndex = -1;
-	EQ_Affect* ret = pLocalPC->FindAffectSlot(testSpell->ID, pLocalPlayer, &SlotIndex, true, pLocalPlayer->Level, &buff, 1);
+	auto iter = s_spellStackingCache.find(key);
+	if (iter != s_spellStackingCache.end())
+	{
+		++s_spellStackingCacheStats.Hits;
+		return iter->second;
+	}
 
-	return ret && SlotIndex != -1;
+	++s_spellStackingCacheStats.Misses;
+
+	// Keep the table from growing without bound if something walks the whole spell database.
+	if (s_spellStackingCache.size() >= MAX_SPELL_STACKING_CACHE_SIZE)
+		s_spellStackingCache.clear();
+
+	bool result = WillStackWithUncached(testSpell, existingSpell);
+	s_spellStackingCache.emplace(key, result);
+
+	return result;
+}
+
+SpellStackingCacheStats GetSpellStackingCacheStats()
+{
+	SpellStackingCacheStats stats = s_spellStackingCacheStats;
+	stats.Entries = s_spellStackingCache.size();
+
+	return stats;
+}
+
+void ClearSpellStackingCache(bool resetStats)
+{
+	s_spellStackingCache.clear();
+
+	if (resetStats)
+		s_spellStackingCacheStats = SpellStackingCacheStats();
 }
 
 bool IsSpellTooPowerful(PlayerClient* caster, PlayerClient* target, EQ_Spell* spell)
@@ -185,7 +185,7 @@ MQCommandAPI::MQCommandAPI()
 		{ "/hotbutton",         DoHotButton,                true,  true  },
 		{ "/hud",               HudCmd,                     true,  false },
 		{ "/identify",          Identify,                   true,  true  },
-		{ "/if",                MacroIfCmd,                      true,  false },
+		{ "/if",                MacroIfCmd,                      false, false },
 		{ "/ini",               IniOutput,                  true,  false },
 		{ "/insertaug",         InsertAugCmd,               true,  true  },
 		{ "/invoke",            InvokeCmd,                  true,  false },
@@ -200,6 +200,7 @@ MQCommandAPI::MQCommandAPI()
 		{ "/loginname",         DisplayLoginName,           true,  false },
 		{ "/look",              Look,                       true,  true  },
 		{ "/lootall",           LootAll,                    true,  false },
+		{ "/maccoverage",       MacroCoverageCmd,           true,  false },
 		{ "/macro",             Macro,                      true,  false },
 		{ "/makemevisible",     MakeMeVisible,              false, true  },
 		{ "/memspell",          MemSpell,                   true,  true  },
@@ -253,7 +254,7 @@ MQCommandAPI::MQCommandAPI()
 		{ "/vardata",           VarDataCmd,                 true,  false },
 		{ "/varset",            VarSetCmd,                  true,  false },
 		{ "/where",             Where,                      true,  true  },
-		{ "/while",             MacroWhileCmd,                   true,  false },
+		{ "/while",             MacroWhileCmd,                   false, false },
 		{ "/who",               SuperWho,                   true,  true  },
 		{ "/whofilter",         SWhoFilter,                 true,  true  },
 		{ "/whotarget",         SuperWhoTarget,             true,  true  },
@@ -4146,7 +4146,10 @@ void NoParseCmd(PlayerClient*, const char* szLine)
 		// Cast it as a char*, Modify the line, and run the command
 		std::string macroString = ModifyMacroString(szLine, true, ModifyMacroMode::WrapNoDoubles);
 
+		// commands that parse their own line (/if, /while) check this instead
+		bAllowCommandParse = false;
 		DoCommand(&macroString[0], false);
+		bAllowCommandParse = true;
 	}
 	else
 	{
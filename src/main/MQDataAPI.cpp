@@ -134,6 +134,8 @@ MQDataAPI::~MQDataAPI()
 {
 	datatypes::UnregisterDataTypes();
 	RemoveMQ2Benchmark(bmParseMacroData);
+
+	ClearFreeDataVariables();
 }
 
 void MQDataAPI::Initialize()
@@ -1204,6 +1206,201 @@ std::string HandleParseParam(std::string_view strOriginal, const bool bParseOnce
 	return strReturn;
 }
 
+/**
+ * @fn FindIfDelimiters
+ *
+ * @brief Finds the two delimiters in the index of an ${If[]} before it has been parsed
+ *
+ * This follows the same rules as dataIf: if there are exactly two alternate delimiters
+ * those are used, otherwise the first two regular delimiters are used.  The difference
+ * is that the index has not been parsed yet, so any variables in it are skipped over
+ * instead of being searched for delimiters.
+ *
+ * @param strIndex The unparsed index of the ${If[]}
+ * @param iFirst Receives the position of the delimiter after the condition
+ * @param iSecond Receives the position of the delimiter after the true branch
+ *
+ * @return bool True if both delimiters were found
+ */
+static bool FindIfDelimiters(std::string_view strIndex, size_t& iFirst, size_t& iSecond)
+{
+	size_t altDelimiters[2] = { std::string::npos, std::string::npos };
+	size_t delimiters[2] = { std::string::npos, std::string::npos };
+	int iAltCount = 0;
+	int iCount = 0;
+	int iBracketDepth = 0;
+
+	size_t iPosition = 0;
+	while (iPosition < strIndex.length())
+	{
+		const char ch = strIndex[iPosition];
+
+		// Skip over variables, they get searched after they have been parsed (if they need to be)
+		if (ch == '$' && iPosition + 1 < strIndex.length() && strIndex[iPosition + 1] == '{')
+		{
+			iPosition = FindMacroClosingBrace(strIndex, iPosition);
+			if (iPosition == std::string::npos)
+				return false;
+
+			continue;
+		}
+
+		if (ch == '[')
+		{
+			iBracketDepth++;
+		}
+		else if (ch == ']')
+		{
+			// This isn't a plain ${If[]}, something follows the index
+			if (--iBracketDepth < 0)
+				return false;
+		}
+		else if (ch == gIfAltDelimiter)
+		{
+			if (iAltCount < 2)
+				altDelimiters[iAltCount] = iPosition;
+			iAltCount++;
+		}
+		else if (ch == gIfDelimiter && iCount < 2)
+		{
+			delimiters[iCount++] = iPosition;
+		}
+
+		++iPosition;
+	}
+
+	if (iAltCount == 2)
+	{
+		iFirst = altDelimiters[0];
+		iSecond = altDelimiters[1];
+		return true;
+	}
+
+	if (iCount == 2)
+	{
+		iFirst = delimiters[0];
+		iSecond = delimiters[1];
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * @fn ParseIfParam
+ *
+ * @brief Evaluates an ${If[]} without parsing the branch that isn't taken
+ *
+ * The condition is parsed and calculated first, and then only the branch that was
+ * selected is parsed.  This means that something like:
+ *         ${If[${Target.ID},${Target.Distance},0]}
+ * doesn't evaluate ${Target.Distance} when there is no target.
+ *
+ * Only a whole ${If[]} with nothing following the index is handled here.  If the parsed
+ * condition or selected branch contains a delimiter, dataIf would have split it
+ * differently, so the remaining parts are parsed and the whole thing is handed to
+ * dataIf to keep the result the same as it has always been.
+ *
+ * @param strVar The variable to evaluate (including ${ })
+ * @param strResult Receives the result
+ *
+ * @return bool True if the variable was an ${If[]} that was evaluated here
+ */
+static bool ParseIfParam(std::string_view strVar, std::string& strResult)
+{
+	if (strVar.length() < 7 || !ci_starts_with(strVar, "${If[") || strVar.substr(strVar.length() - 2) != "]}")
+		return false;
+
+	const std::string_view strIndex = strVar.substr(5, strVar.length() - 7);
+
+	size_t iFirst = 0, iSecond = 0;
+	if (!FindIfDelimiters(strIndex, iFirst, iSecond))
+		return false;
+
+	const char delimiter = strIndex[iFirst];
+	const std::string_view strTrue = strIndex.substr(iFirst + 1, iSecond - iFirst - 1);
+	const std::string_view strFalse = strIndex.substr(iSecond + 1);
+
+	auto containsDelimiter = [](std::string_view str)
+	{
+		return str.find(gIfDelimiter) != std::string::npos || str.find(gIfAltDelimiter) != std::string::npos;
+	};
+
+	auto evaluateEagerly = [&](const std::string& strCondition, const std::string& strParsedTrue)
+	{
+		strResult = GetMacroVarData(fmt::format("${{If[{}{}{}{}{}]}}", strCondition, delimiter,
+			strParsedTrue, delimiter, ModifyMacroString(strFalse)));
+		return true;
+	};
+
+	std::string strCondition = ModifyMacroString(strIndex.substr(0, iFirst));
+	if (containsDelimiter(strCondition))
+		return evaluateEagerly(strCondition, ModifyMacroString(strTrue));
+
+	double CalcResult = 0;
+	if (strCondition.length() >= MAX_STRING || !Calculate(strCondition.c_str(), CalcResult))
+	{
+		strResult = "NULL";
+		return true;
+	}
+
+	if (CalcResult != 0.0)
+	{
+		strResult = ModifyMacroString(strTrue);
+		if (containsDelimiter(strResult))
+			return evaluateEagerly(strCondition, strResult);
+	}
+	else
+	{
+		strResult = ModifyMacroString(strFalse);
+	}
+
+	if (strResult.length() >= MAX_STRING)
+		strResult.resize(MAX_STRING - 1);
+
+	return true;
+}
+
+/**
+ * @fn ParseIfParams
+ *
+ * @brief Evaluates every ${If[]} in a string, left to right, ahead of the regular parse
+ *
+ * ParseMacroVar works from the right, which would parse both branches of an ${If[]}
+ * before the If itself is seen.  Resolving them first lets each If skip the branch
+ * it doesn't need.  Variables that aren't an ${If[]} are searched for nested Ifs.
+ *
+ * @param strReturn The string to modify in place
+ */
+static void ParseIfParams(std::string& strReturn)
+{
+	size_t iPosition = strReturn.find("${");
+
+	while (iPosition != std::string::npos)
+	{
+		const size_t iCloseBrace = FindMacroClosingBrace(strReturn, iPosition);
+		if (iCloseBrace == std::string::npos)
+			break;
+
+		std::string strResult;
+		if (ParseIfParam(std::string_view(strReturn).substr(iPosition, iCloseBrace - iPosition), strResult))
+		{
+			// Same as ParseMacroVar, a result that contains a variable gets parsed again
+			if (strResult.find("${") != std::string::npos)
+			{
+				strResult = ModifyMacroString(strResult);
+			}
+
+			strReturn.replace(iPosition, iCloseBrace - iPosition, strResult);
+			iPosition = strReturn.find("${", iPosition + strResult.length());
+		}
+		else
+		{
+			iPosition = strReturn.find("${", iPosition + 2);
+		}
+	}
+}
+
 /**
  * @fn ParseMacroVar
  *
@@ -1221,6 +1418,9 @@ std::string HandleParseParam(std::string_view strOriginal, const bool bParseOnce
  * In the case of a ${Parse[ parameter, the function will pass handling off to
  * HandleParseParam if it is found immediately, or during recursion if it is found buried.
  *
+ * When parsing all iterations, any ${If[]} is evaluated before anything else so
+ * that the branch that isn't taken is never parsed (see ParseIfParam).
+ *
  * Where ModifyMacroString will tokenize the string and find the longest variables
  * before passing them in whole to ParseMacroVar, ParseMacroVar expects that it
  * is being passed an already tokenized variable.  While ParseMacroVar could be
@@ -1241,6 +1441,12 @@ std::string ParseMacroVar(std::string_view strOriginal, const bool bParseOnce =
 	// If there is no parse parameter
 	if (strOriginal.find(PARSE_PARAM_BEG) == std::string::npos)
 	{
+		// Resolve any ${If[]} first so that only the branch that is taken gets parsed
+		if (!bParseOnce)
+		{
+			ParseIfParams(strReturn);
+		}
+
 		// Track our position and we're starting from the right
 		size_t iCurrentPosition = strReturn.length();
 
@@ -1620,6 +1826,177 @@ bool ParseMacroData(char* szOriginal, size_t BufferSize)
 	return Changed;
 }
 
+/**
+ * @fn IsWrappedInParens
+ *
+ * @brief Checks if the parenthesis at the start of a condition closes at the very end of it
+ *
+ * Variables are skipped over since they haven't been parsed yet, so a parenthesis inside
+ * of one doesn't count.
+ *
+ * @param strCondition The (trimmed) condition to check
+ *
+ * @return bool True if the whole condition is wrapped in one pair of parentheses
+ */
+static bool IsWrappedInParens(std::string_view strCondition)
+{
+	if (strCondition.length() < 2 || strCondition.front() != '(' || strCondition.back() != ')')
+		return false;
+
+	int iDepth = 0;
+	size_t iPosition = 0;
+	while (iPosition < strCondition.length())
+	{
+		if (strCondition[iPosition] == '$' && iPosition + 1 < strCondition.length() && strCondition[iPosition + 1] == '{')
+		{
+			iPosition = FindMacroClosingBrace(strCondition, iPosition);
+			if (iPosition == std::string::npos)
+				return false;
+
+			continue;
+		}
+
+		if (strCondition[iPosition] == '(')
+		{
+			iDepth++;
+		}
+		else if (strCondition[iPosition] == ')' && --iDepth == 0)
+		{
+			return iPosition == strCondition.length() - 1;
+		}
+
+		++iPosition;
+	}
+
+	return false;
+}
+
+/**
+ * @fn SplitCondition
+ *
+ * @brief Splits a condition on a logical operator that is outside of any parentheses or variables
+ *
+ * @param strCondition The condition to split
+ * @param strOperator The operator to split on (&& or ||)
+ *
+ * @return std::vector<std::string_view> The operands, or an empty vector if the operator wasn't found
+ */
+static std::vector<std::string_view> SplitCondition(std::string_view strCondition, std::string_view strOperator)
+{
+	std::vector<std::string_view> operands;
+
+	int iDepth = 0;
+	size_t iStart = 0;
+	size_t iPosition = 0;
+	while (iPosition < strCondition.length())
+	{
+		if (strCondition[iPosition] == '$' && iPosition + 1 < strCondition.length() && strCondition[iPosition + 1] == '{')
+		{
+			iPosition = FindMacroClosingBrace(strCondition, iPosition);
+			if (iPosition == std::string::npos)
+				return {};
+
+			continue;
+		}
+
+		if (strCondition[iPosition] == '(')
+		{
+			iDepth++;
+		}
+		else if (strCondition[iPosition] == ')')
+		{
+			iDepth--;
+		}
+		else if (iDepth == 0 && strCondition.substr(iPosition, strOperator.length()) == strOperator)
+		{
+			operands.push_back(strCondition.substr(iStart, iPosition - iStart));
+			iPosition += strOperator.length();
+			iStart = iPosition;
+			continue;
+		}
+
+		++iPosition;
+	}
+
+	if (!operands.empty())
+	{
+		operands.push_back(strCondition.substr(iStart));
+	}
+
+	return operands;
+}
+
+/**
+ * @fn EvaluateMacroCondition
+ *
+ * @brief Parses and calculates a condition, skipping the parts of it that aren't needed
+ *
+ * With Parser 2 the condition is split on the || and && operators that are outside of
+ * any parentheses before anything is parsed.  The operands are evaluated from left to
+ * right and evaluation stops as soon as the result is known, so something like:
+ *         (${Target.ID} && ${Target.Distance} < 50)
+ * doesn't evaluate ${Target.Distance} when there is no target.  The operands that are
+ * evaluated are parsed and calculated the same way as the whole condition would be.
+ *
+ * With Parser 1 the whole condition is parsed and calculated.
+ *
+ * @param strCondition The unparsed condition
+ * @param Result Receives the result of the condition
+ *
+ * @return bool False if the condition (or one of the operands evaluated) couldn't be calculated
+ */
+bool EvaluateMacroCondition(std::string_view strCondition, double& Result)
+{
+	if (gParserVersion != 2)
+	{
+		char szCondition[MAX_STRING] = { 0 };
+		strncpy_s(szCondition, strCondition.data(), std::min(strCondition.length(), sizeof(szCondition) - 1));
+		ParseMacroData(szCondition, MAX_STRING);
+
+		return Calculate(szCondition, Result);
+	}
+
+	strCondition = trim(strCondition);
+
+	while (IsWrappedInParens(strCondition))
+	{
+		strCondition = trim(strCondition.substr(1, strCondition.length() - 2));
+	}
+
+	// || has the lowest precedence, so split on that first
+	for (std::string_view strOperator : { "||", "&&" })
+	{
+		std::vector<std::string_view> operands = SplitCondition(strCondition, strOperator);
+		if (operands.empty())
+			continue;
+
+		const bool bIsOr = strOperator == "||";
+		for (std::string_view strOperand : operands)
+		{
+			double OperandResult = 0;
+			if (!EvaluateMacroCondition(strOperand, OperandResult))
+				return false;
+
+			if ((OperandResult != 0.0) == bIsOr)
+			{
+				Result = bIsOr ? 1.0 : 0.0;
+				return true;
+			}
+		}
+
+		Result = bIsOr ? 0.0 : 1.0;
+		return true;
+	}
+
+	std::string strParsed = ModifyMacroString(strCondition);
+	if (strParsed.length() >= MAX_STRING)
+	{
+		strParsed.resize(MAX_STRING - 1);
+	}
+
+	return Calculate(strParsed.c_str(), Result);
+}
+
 //============================================================================
 
 namespace datatypes {
@@ -122,6 +122,8 @@ enum class ModifyMacroMode { Default, Wrap, WrapNoDoubles };
 std::string ModifyMacroString(std::string_view strOriginal, bool bParseOnce = false,
 	ModifyMacroMode iOperation = ModifyMacroMode::Default);
 
+bool EvaluateMacroCondition(std::string_view strCondition, double& Result);
+
 //============================================================================
 
 bool AddMQ2DataVariable(const char* Name, const char* Index, MQ2Type* pType, MQDataVar** ppHead, const char* Default);
@@ -130,5 +132,8 @@ MQDataVar** FindVariableScope(const char* Name);
 bool DeleteMQ2DataVariable(const char* Name);
 void ClearMQ2DataVariables(MQDataVar** ppHead);
 
+// Releases the variables kept for reuse by /call and /return. Called when a macro ends and at shutdown.
+void ClearFreeDataVariables();
+
 
 } // namespace mq
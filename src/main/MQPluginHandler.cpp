@@ -14,6 +14,8 @@
 
 #include "pch.h"
 #include "MQ2Main.h"
+#include "MQPluginManifest.h"
+#include "SpawnBatch.h"
 
 #include <mq/utils/OS.h>
 
@@ -70,6 +72,9 @@ static std::string s_pluginLoadFailure;
 
 static bool s_hotReloadEnabled = true;
 
+// snapshot of the plugins directory, read again by FindPluginFile when the directory changes.
+static std::unique_ptr<PluginDirectoryManifest> s_pluginManifest;
+
 //----------------------------------------------------------------------------
 
 uint32_t bmWriteChatColor = 0;
@@ -83,6 +88,7 @@ uint32_t bmPluginsSetGameState = 0;
 uint32_t bmCalculate = 0;
 uint32_t bmBeginZone = 0;
 uint32_t bmEndZone = 0;
+uint32_t bmPluginsAddSpawns = 0;
 
 //----------------------------------------------------------------------------
 // If true, imgui should not run on plugins.
@@ -91,6 +97,12 @@ extern bool gbManualResetRequired;
 // Defined in MQ2Utilities.cpp
 DWORD CALLBACK InitializeMQ2SpellDb(void* pData);
 
+// Defined in MQ2Spawns.cpp
+void QueueSpawnCaption(SPAWNINFO* pSpawn);
+
+// Spawns that were added while zoning.
+static PendingSpawnBatch<PlayerClient> s_pendingAddedSpawns;
+
 //----------------------------------------------------------------------------
 // Module handling
 std::vector<MQModule*> gInternalModules;
@@ -185,36 +197,6 @@ MQPluginHandle CreatePluginHandle()
 	return MQPluginHandle(pluginID);
 }
 
-// Strips MQ2/MQ off of the name and returns it back
-std::string_view GetCanonicalPluginName(std::string_view name, bool stripExtension = true)
-{
-	if (stripExtension && name.length() >= 5)
-	{
-		if (name[name.length() - 4] == '.'
-			&& (name[name.length() - 3] == 'd' || name[name.length() - 3] == 'D')
-			&& (name[name.length() - 2] == 'l' || name[name.length() - 2] == 'L')
-			&& (name[name.length() - 1] == 'l' || name[name.length() - 1] == 'L'))
-		{
-			name = name.substr(0, name.length() - 4);
-		}
-	}
-
-	if (name.length() >= 2)
-	{
-		if ((name[0] == 'm' || name[0] == 'M')
-			&& name[1] == 'q' || name[1] == 'Q')
-		{
-			name = name.substr(2);
-
-			if (name.length() >= 1 && name[0] == '2')
-				name = name.substr(1);
-		}
-	}
-
-	// At this point we have a plugin name without the MQ[2]
-	return name;
-}
-
 void PrintModules()
 {
 	HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, false, GetCurrentProcessId());
@@ -273,53 +255,18 @@ MQPlugin* GetPluginByHandle(MQPluginHandle handle, bool noMain /* = false */)
 // Locate a plugin dll that matches the given name (canonical or otherwise).
 std::string FindPluginFile(std::string_view name)
 {
-	namespace fs = std::filesystem;
-	std::error_code ec;
+	// The manifest is kept between lookups and only read again once the directory changes.
+	if (!s_pluginManifest || !s_pluginManifest->IsCurrent())
+		s_pluginManifest = std::make_unique<PluginDirectoryManifest>(mq::internal_paths::Plugins);
 
-	// Start with our search directory and plugin name
-	fs::path pathToPlugins = fs::path(mq::internal_paths::Plugins);
-	fs::path pluginName = name;
-	pluginName.replace_extension(".dll");
+	std::string fileName = s_pluginManifest->Find(name);
 
-	std::string_view canonicalName = GetCanonicalPluginName(name, false);
-	bool isCanonical = (canonicalName == name);
-
-	// If the plugin is not canonical, it means that we removed MQ2 or MQ. First check to see
-	// if we have the exact match before we start making guesses.
-	if (!isCanonical)
+	if (!fileName.empty() && fileName != name)
 	{
-		if (fs::is_regular_file(pathToPlugins / pluginName, ec))
-			return pluginName.replace_extension().string();
-
-		return {};
+		DebugSpew("Found non-exact plugin match: %.*s -> %s", name.length(), name.data(), fileName.c_str());
 	}
 
-	// Scan the directory looking for a match. We want this so that we can
-	// get the casing that matches the filename.
-	fs::directory_iterator directoryIterator(pathToPlugins, fs::directory_options::skip_permission_denied, ec);
-
-	std::string checkName1 = fmt::format("MQ{}", pluginName.string());
-	std::string checkName2 = fmt::format("MQ2{}", pluginName.string());
-
-	for (const std::filesystem::directory_entry& dirEntry : directoryIterator)
-	{
-		// Only deal with files
-		if (!dirEntry.is_regular_file(ec))
-			continue;
-
-		const std::filesystem::path& filePath = dirEntry.path();
-
-		fs::path existingFile = filePath.filename();
-
-		if (ci_equals(existingFile.string(), checkName1) || ci_equals(existingFile.string(), checkName2))
-		{
-			DebugSpew("Found non-exact plugin match: %.*s -> %s", name.length(), name.data(), existingFile.string().c_str());
-			return existingFile.replace_extension().string();
-		}
-	}
-
-	// didn't find a file that matches
-	return {};
+	return fileName;
 }
 
 //class HotReloadModule
@@ -361,10 +308,17 @@ std::pair<wil::unique_hmodule, std::string> LoadPluginModule(std::string_view na
 	{
 	}
 
-	wil::unique_hmodule hModule{ ::LoadLibraryA(pathToPlugin.string().c_str()) };
+	wil::unique_hmodule hModule;
+	DWORD lastError = 0;
+	{
+		ScopedLoadPhase phase(fmt::format("{}: LoadLibrary", fileName));
+
+		hModule.reset(::LoadLibraryA(pathToPlugin.string().c_str()));
+		lastError = ::GetLastError();
+	}
+
 	if (!hModule)
 	{
-		DWORD lastError = ::GetLastError();
 		char* szError = nullptr;
 
 		FormatMessage(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
@@ -454,6 +408,8 @@ int LoadPlugin(std::string_view pluginName, bool save)
 		return 3;
 	}
 
+	ScopedLoadPhase loadPhase(fmt::format("Load plugin {}", pluginName));
+
 	auto [hModule, pluginPath] = LoadPluginModule(pluginName);
 	if (!hModule)
 	{
@@ -490,6 +446,8 @@ int LoadPlugin(std::string_view pluginName, bool save)
 	pPlugin->SetGameState      = (fMQSetGameState)GetProcAddress(pPlugin->hModule, "SetGameState");
 	pPlugin->AddSpawn          = (fMQSpawn)GetProcAddress(pPlugin->hModule, "OnAddSpawn");
 	pPlugin->RemoveSpawn       = (fMQSpawn)GetProcAddress(pPlugin->hModule, "OnRemoveSpawn");
+	pPlugin->AddSpawns         = (fMQSpawns)GetProcAddress(pPlugin->hModule, "OnAddSpawns");
+	pPlugin->RemoveSpawns      = (fMQSpawns)GetProcAddress(pPlugin->hModule, "OnRemoveSpawns");
 	pPlugin->AddGroundItem     = (fMQGroundItem)GetProcAddress(pPlugin->hModule, "OnAddGroundItem");
 	pPlugin->RemoveGroundItem  = (fMQGroundItem)GetProcAddress(pPlugin->hModule, "OnRemoveGroundItem");
 	pPlugin->BeginZone         = (fMQBeginZone)GetProcAddress(pPlugin->hModule, "OnBeginZone");
@@ -509,16 +467,37 @@ int LoadPlugin(std::string_view pluginName, bool save)
 
 	// initialize plugin
 	if (pPlugin->Initialize)
+	{
+		ScopedLoadPhase phase(fmt::format("{}: InitializePlugin", pPlugin->szFilename));
 		pPlugin->Initialize();
+	}
 
 	// init gamestate
 	if (pPlugin->SetGameState)
+	{
+		ScopedLoadPhase phase(fmt::format("{}: SetGameState", pPlugin->szFilename));
 		pPlugin->SetGameState(GetGameState());
+	}
 
 	if (GetGameState() == GAMESTATE_INGAME)
 	{
+		ScopedLoadPhase phase(fmt::format("{}: Spawns and ground items", pPlugin->szFilename));
+
+		// The spawn list already includes anything still waiting to be delivered, so deliver
+		// those to everyone else first. Otherwise this plugin would see them twice.
+		FlushPendingSpawns();
+
 		// init spawns
-		if (pPlugin->AddSpawn)
+		if (pPlugin->AddSpawns)
+		{
+			std::vector<PlayerClient*> spawns;
+			for (SPAWNINFO* pSpawn = pSpawnList; pSpawn; pSpawn = pSpawn->pNext)
+				spawns.push_back(pSpawn);
+
+			if (!spawns.empty())
+				pPlugin->AddSpawns(spawns.data(), static_cast<int>(spawns.size()));
+		}
+		else if (pPlugin->AddSpawn)
 		{
 			SPAWNINFO* pSpawn = pSpawnList;
 			while (pSpawn)
@@ -605,6 +584,9 @@ bool UnloadPlugin(std::string_view pluginName)
 	if (pPlugin->Shutdown)
 		pPlugin->Shutdown();
 
+	// Queued tasks hold the plugin's code, drop them before it is unloaded
+	RemoveMainThreadTasks(rec.handle);
+
 	// Cleanup
 	if (FreeLibrary(pPlugin->hModule))
 	{
@@ -770,6 +752,9 @@ void PulsePlugins()
 
 	PluginDebug("PulsePlugins()");
 
+	if (!gZoning)
+		FlushPendingSpawns();
+
 	ForEachModule([](const MQModule* module)
 		{
 			if (module->Pulse)
@@ -785,6 +770,9 @@ void PulsePlugins()
 
 void PluginsZoned()
 {
+	// spawns for the new zone are delivered before the zoned notification
+	FlushPendingSpawns();
+
 	if (!s_pluginsInitialized)
 		return;
 
@@ -951,57 +939,135 @@ void PluginsDrawHUD()
 		});
 }
 
-void PluginsAddSpawn(PlayerClient* pNewSpawn)
+static void DispatchAddSpawns(PlayerClient* const* spawns, int count)
 {
-	if (!s_pluginsInitialized)
-		return;
+	MQScopedBenchmark bm(bmPluginsAddSpawns);
 
-	int BodyType = GetBodyType(pNewSpawn);
-	PluginDebug("PluginsAddSpawn(%s,%d,%d)", pNewSpawn->Name, pNewSpawn->GetRace(), BodyType);
+	// With a single spawn the caption is set right away. A batch spreads them over the next few frames.
+	bool setCaptions = GetGameState() > GAMESTATE_CHARSELECT;
+	bool deferCaptions = count > 1;
 
-	if (GetGameState() > GAMESTATE_CHARSELECT)
-		SetNameSpriteState(pNewSpawn, true);
+	for (int i = 0; i < count; ++i)
+	{
+		PlayerClient* pNewSpawn = spawns[i];
+
+		int BodyType = GetBodyType(pNewSpawn);
+		PluginDebug("PluginsAddSpawn(%s,%d,%d)", pNewSpawn->Name, pNewSpawn->GetRace(), BodyType);
 
-	if (GetBodyTypeDesc(BodyType)[0] == '*')
-		WriteChatf("Spawn '%s' has unknown bodytype %d", pNewSpawn->Name, BodyType);
+		if (setCaptions)
+		{
+			if (deferCaptions)
+				QueueSpawnCaption(pNewSpawn);
+			else
+				SetNameSpriteState(pNewSpawn, true);
+		}
+
+		if (GetBodyTypeDesc(BodyType)[0] == '*')
+			WriteChatf("Spawn '%s' has unknown bodytype %d", pNewSpawn->Name, BodyType);
+	}
 
-	ForEachModule([pNewSpawn](const MQModule* module)
+	ForEachModule([spawns, count](const MQModule* module)
 		{
 			if (module->SpawnAdded)
-				module->SpawnAdded(pNewSpawn);
+			{
+				for (int i = 0; i < count; ++i)
+					module->SpawnAdded(spawns[i]);
+			}
 		});
 
-	ForEachPlugin([pNewSpawn](const MQPlugin* plugin)
+	ForEachPlugin([spawns, count](const MQPlugin* plugin)
 		{
-			if (plugin->AddSpawn)
-				plugin->AddSpawn(pNewSpawn);
+			if (plugin->AddSpawns)
+			{
+				plugin->AddSpawns(spawns, count);
+			}
+			else if (plugin->AddSpawn)
+			{
+				for (int i = 0; i < count; ++i)
+					plugin->AddSpawn(spawns[i]);
+			}
 		});
 }
 
-void PluginsRemoveSpawn(PlayerClient* pSpawn)
+void FlushPendingSpawns()
 {
-	InvalidateObservedEQObject(pSpawn);
+	if (s_pendingAddedSpawns.empty())
+		return;
+
+	// Take the batch first, a callback could cause more spawns to be added.
+	std::vector<PlayerClient*> spawns = s_pendingAddedSpawns.Take();
 
+	if (s_pluginsInitialized)
+	{
+		DispatchAddSpawns(spawns.data(), static_cast<int>(spawns.size()));
+	}
+}
+
+void PluginsAddSpawn(PlayerClient* pNewSpawn)
+{
 	if (!s_pluginsInitialized)
 		return;
 
-	PluginDebug("PluginsRemoveSpawn(%s)", pSpawn->Name);
+	// While zoning, hold on to new spawns so they can be delivered together.
+	if (gZoning)
+	{
+		s_pendingAddedSpawns.Add(pNewSpawn);
+		return;
+	}
 
-	ClearCachedBuffsSpawn(pSpawn);
+	DispatchAddSpawns(&pNewSpawn, 1);
+}
 
-	ForEachModule([pSpawn](const MQModule* module)
+void PluginsRemoveSpawns(PlayerClient* const* spawns, int count)
+{
+	if (count <= 0)
+		return;
+
+	for (int i = 0; i < count; ++i)
+	{
+		InvalidateObservedEQObject(spawns[i]);
+	}
+
+	s_pendingAddedSpawns.Remove(spawns, count);
+
+	if (!s_pluginsInitialized)
+		return;
+
+	for (int i = 0; i < count; ++i)
+	{
+		PluginDebug("PluginsRemoveSpawn(%s)", spawns[i]->Name);
+
+		ClearCachedBuffsSpawn(spawns[i]);
+	}
+
+	ForEachModule([spawns, count](const MQModule* module)
 		{
 			if (module->SpawnRemoved)
-				module->SpawnRemoved(pSpawn);
+			{
+				for (int i = 0; i < count; ++i)
+					module->SpawnRemoved(spawns[i]);
+			}
 		});
 
-	ForEachPlugin([pSpawn](const MQPlugin* plugin)
+	ForEachPlugin([spawns, count](const MQPlugin* plugin)
 		{
-			if (plugin->RemoveSpawn)
-				plugin->RemoveSpawn(pSpawn);
+			if (plugin->RemoveSpawns)
+			{
+				plugin->RemoveSpawns(spawns, count);
+			}
+			else if (plugin->RemoveSpawn)
+			{
+				for (int i = 0; i < count; ++i)
+					plugin->RemoveSpawn(spawns[i]);
+			}
 		});
 }
 
+void PluginsRemoveSpawn(PlayerClient* pSpawn)
+{
+	PluginsRemoveSpawns(&pSpawn, 1);
+}
+
 void PluginsAddGroundItem(EQGroundItem* pNewGroundItem)
 {
 	if (!s_pluginsInitialized)
@@ -1412,6 +1478,7 @@ void InitializePlugins()
 	bmCalculate = AddMQ2Benchmark("Calculate");
 	bmBeginZone = AddMQ2Benchmark("BeginZone");
 	bmEndZone = AddMQ2Benchmark("EndZone");
+	bmPluginsAddSpawns = AddMQ2Benchmark("PluginsAddSpawns");
 
 	// lock plugin list before manipulating it
 	std::scoped_lock lock(s_pluginsMutex);
@@ -1419,12 +1486,20 @@ void InitializePlugins()
 
 	DebugSpew("Initializing plugins");
 
-	const std::vector<std::string> plugins = GetPrivateProfileKeys<MAX_STRING * 2>("Plugins", mq::internal_paths::MQini);
-	for (const std::string& pluginName : plugins)
+	ScopedLoadPhase phase("Plugins");
+
+	// Read the [Plugins] section once, rather than once per plugin. The plugins directory is
+	// read once by the first FindPluginFile.
+	const auto plugins = GetPrivateProfileKeyValues<MAX_STRING * 2>("Plugins", mq::internal_paths::MQini);
+	for (const auto& [key, value] : plugins)
 	{
-		if (GetPrivateProfileBool("Plugins", pluginName, false, mq::internal_paths::MQini))
+		std::string_view pluginName = trim(std::string_view(key));
+		if (pluginName.empty() || pluginName[0] == ';')
+			continue;
+
+		if (GetBoolFromString(value, false))
 		{
-			LoadPlugin(pluginName.c_str(), false);
+			LoadPlugin(pluginName, false);
 		}
 	}
 }
@@ -1432,8 +1507,10 @@ void InitializePlugins()
 void ShutdownPlugins()
 {
 	s_pluginsInitialized = false;
+	s_pendingAddedSpawns.Clear();
 
 	UnloadPlugins();
+	s_pluginManifest.reset();
 	RemoveCommand("/plugin");
 }
 
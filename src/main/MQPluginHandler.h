@@ -45,6 +45,8 @@ void PluginsSetGameState(int GameState);
 void PluginsDrawHUD();
 void PluginsAddSpawn(PlayerClient* pNewSpawn);
 void PluginsRemoveSpawn(PlayerClient* pSpawn);
+void PluginsRemoveSpawns(PlayerClient* const* spawns, int count);
+void FlushPendingSpawns();
 void PluginsAddGroundItem(EQGroundItem* pNewGroundItem);
 void PluginsRemoveGroundItem(EQGroundItem* pGroundItem);
 void PluginsBeginZone();
@@ -0,0 +1,116 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "pch.h"
+#include "MQPluginManifest.h"
+
+namespace mq {
+
+std::string_view GetCanonicalPluginName(std::string_view name, bool stripExtension)
+{
+	if (stripExtension && name.length() >= 5)
+	{
+		if (name[name.length() - 4] == '.'
+			&& (name[name.length() - 3] == 'd' || name[name.length() - 3] == 'D')
+			&& (name[name.length() - 2] == 'l' || name[name.length() - 2] == 'L')
+			&& (name[name.length() - 1] == 'l' || name[name.length() - 1] == 'L'))
+		{
+			name = name.substr(0, name.length() - 4);
+		}
+	}
+
+	if (name.length() >= 2)
+	{
+		if ((name[0] == 'm' || name[0] == 'M')
+			&& (name[1] == 'q' || name[1] == 'Q'))
+		{
+			name = name.substr(2);
+
+			if (name.length() >= 1 && name[0] == '2')
+				name = name.substr(1);
+		}
+	}
+
+	// At this point we have a plugin name without the MQ[2]
+	return name;
+}
+
+PluginDirectoryManifest::PluginDirectoryManifest(const std::filesystem::path& directory)
+	: m_directory(directory)
+{
+	namespace fs = std::filesystem;
+	std::error_code ec;
+
+	// Taken before reading, so that a change made while reading shows up as out of date
+	m_writeTime = fs::last_write_time(directory, ec);
+
+	fs::directory_iterator directoryIterator(directory, fs::directory_options::skip_permission_denied, ec);
+
+	for (const fs::directory_entry& dirEntry : directoryIterator)
+	{
+		// Only deal with files
+		if (!dirEntry.is_regular_file(ec))
+			continue;
+
+		const fs::path& filePath = dirEntry.path();
+		if (!ci_equals(filePath.extension().string(), ".dll"))
+			continue;
+
+		std::string fileName = filePath.filename().string();
+		m_files.emplace(fileName, fileName);
+	}
+}
+
+bool PluginDirectoryManifest::IsCurrent() const
+{
+	std::error_code ec;
+	const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(m_directory, ec);
+
+	return !ec && writeTime == m_writeTime;
+}
+
+std::string PluginDirectoryManifest::Find(std::string_view name) const
+{
+	namespace fs = std::filesystem;
+
+	fs::path pluginName = name;
+	pluginName.replace_extension(".dll");
+
+	std::string_view canonicalName = GetCanonicalPluginName(name, false);
+	bool isCanonical = (canonicalName == name);
+
+	// If the plugin is not canonical, it means that we removed MQ2 or MQ. Only an exact
+	// match will do, and we keep the casing that was asked for.
+	if (!isCanonical)
+	{
+		if (m_files.count(pluginName.string()) != 0)
+			return pluginName.replace_extension().string();
+
+		return {};
+	}
+
+	// Look for a prefixed match. We want this so that we can get the casing that matches
+	// the filename.
+	for (const char* prefix : { "MQ2", "MQ" })
+	{
+		auto iter = m_files.find(prefix + pluginName.string());
+		if (iter != m_files.end())
+			return fs::path(iter->second).replace_extension().string();
+	}
+
+	// didn't find a file that matches
+	return {};
+}
+
+} // namespace mq
@@ -0,0 +1,57 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "mq/base/String.h"
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace mq {
+
+// Strips MQ2/MQ off of the name and returns it back
+std::string_view GetCanonicalPluginName(std::string_view name, bool stripExtension = true);
+
+//----------------------------------------------------------------------------
+// A snapshot of the plugin dlls in a directory. The directory is read once when
+// the manifest is created, after which plugin names can be resolved to files
+// without going back to the disk. IsCurrent checks whether the directory has
+// changed since, which only needs the directory's write time.
+
+class PluginDirectoryManifest
+{
+public:
+	explicit PluginDirectoryManifest(const std::filesystem::path& directory);
+
+	// Locate a plugin dll that matches the given name (canonical or otherwise). Returns
+	// the file name without its extension, or an empty string if there is no match.
+	std::string Find(std::string_view name) const;
+
+	// Whether the directory is unchanged since the manifest was created. Adding, removing
+	// or renaming a file updates the directory's write time.
+	bool IsCurrent() const;
+
+	size_t size() const { return m_files.size(); }
+
+private:
+	std::filesystem::path m_directory;
+	std::filesystem::file_time_type m_writeTime;
+
+	// dll file name -> file name with the casing found on disk
+	ci_unordered::map<std::string, std::string> m_files;
+};
+
+} // namespace mq
@@ -20,6 +20,9 @@
 
 #include "routing/PostOffice.h"
 
+#include <chrono>
+#include <optional>
+
 namespace mq {
 using namespace postoffice;
 
@@ -78,6 +81,10 @@ private:
 			{
 				auto envelope = ProtoMessage::Parse<proto::routing::Envelope>(message);
 				auto address = envelope.has_address() ? std::make_optional(envelope.address()) : std::nullopt;
+				auto dropped = [this, &envelope](int status, PipeMessagePtr&&)
+					{
+						m_postOffice->GetTracer().Drop(envelope, status);
+					};
 				// either this message is coming off the pipe, so assume it was routed correctly by the server,
 				// or it was routed internally after checking to make sure that the destination of the message
 				// was within the client. In either case, we can safely assume that we should route it to an
@@ -95,12 +102,12 @@ private:
 						else if (m_postOffice->FindMailbox(*address, std::next(mailbox)) != m_postOffice->m_mailboxes.end()) // multiple addresses
 							RoutingFailed(envelope, MsgError_AmbiguousRecipient, std::move(message), nullptr);
 						else // we have exactly one recipient, this is valid
-							m_postOffice->DeliverTo(address->mailbox(), std::move(message));
+							m_postOffice->DeliverTo(address->mailbox(), std::move(message), dropped);
 					}
 					else
 					{
 						// in any other case, just route the message
-						m_postOffice->DeliverTo(address->mailbox(), std::move(message));
+						m_postOffice->DeliverTo(address->mailbox(), std::move(message), dropped);
 					}
 				}
 				else
@@ -109,7 +116,7 @@ private:
 					// be reached, we would have to have a client that packages a message in an envelope
 					// that is intended to be parsed directly by the server and not routed anywhere (so
 					// no mailbox routing information is included), rather than just send the message
-					m_postOffice->DeliverTo("pipe_client", std::move(message));
+					m_postOffice->DeliverTo("pipe_client", std::move(message), dropped);
 				}
 
 				break;
@@ -256,6 +263,8 @@ public:
 		PipeMessagePtr&& message,
 		const PipeMessageResponseCb& callback)
 	{
+		GetPostOffice().GetTracer().Drop(envelope, status);
+
 		// we can't assume that the mailbox exists here, so manually create the reply
 		proto::routing::Envelope outbound;
 		*outbound.mutable_address() = envelope.return_address();
@@ -286,12 +295,19 @@ public:
 		{
 			auto& envelope = ProtoMessage::Parse<proto::routing::Envelope>(message);
 
-			// always enrich the return address if in game
-			if (pLocalPC)
+			bool traced = m_tracer.Start(envelope);
+			if (traced)
+				MessageTracer::AddHop(*envelope.mutable_trace(), proto::routing::TraceStage::Routed);
+
+			// always enrich the return address if in game, and repack the envelope if it was stamped
+			if (pLocalPC || traced)
 			{
-				envelope.mutable_return_address()->set_account(GetLoginName());
-				envelope.mutable_return_address()->set_server(GetServerShortName());
-				envelope.mutable_return_address()->set_character(pLocalPC->Name);
+				if (pLocalPC)
+				{
+					envelope.mutable_return_address()->set_account(GetLoginName());
+					envelope.mutable_return_address()->set_server(GetServerShortName());
+					envelope.mutable_return_address()->set_character(pLocalPC->Name);
+				}
 
 				std::string data(envelope.SerializeAsString());
 				message = std::make_unique<PipeMessage>(*message->GetHeader(), &data[0], data.size());
@@ -482,6 +498,319 @@ PostOffice& postoffice::GetPostOffice()
 	return s_postOffice;
 }
 
+#pragma region Actor Tracing
+
+// Sends traced messages to a mailbox in this client by way of the launcher, and times how long
+// each takes to come back. This exercises the whole pipe route without needing the game.
+class ActorLoopbackTest
+{
+public:
+	static constexpr const char* MailboxName = "actortrace_loopback";
+	static constexpr std::chrono::seconds Timeout{ 5 };
+
+	bool IsRunning() const { return m_running; }
+
+	void Start(int count)
+	{
+		m_roundTrip.Clear();
+		m_sent.assign(count, {});
+		m_received = 0;
+		m_running = true;
+
+		m_dropbox = GetPostOffice().RegisterAddress(MailboxName,
+			[this](ProtoMessagePtr&& message)
+			{
+				auto sequence = static_cast<uint32_t>(GetIntFromString(std::string_view(message->get<const char>(), message->size()), -1));
+				if (sequence < m_sent.size())
+				{
+					auto elapsed = std::chrono::steady_clock::now() - m_sent[sequence];
+					m_roundTrip.Add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+					++m_received;
+				}
+			});
+
+		if (!m_dropbox.IsValid())
+		{
+			WriteChatf("\arCould not register the \ay%s\ar mailbox.", MailboxName);
+			m_running = false;
+			return;
+		}
+
+		proto::routing::Envelope envelope;
+		envelope.mutable_address()->set_pid(GetCurrentProcessId());
+		envelope.mutable_address()->set_mailbox(MailboxName);
+		envelope.mutable_return_address()->set_pid(GetCurrentProcessId());
+		envelope.mutable_return_address()->set_mailbox(MailboxName);
+
+		m_started = std::chrono::steady_clock::now();
+
+		for (int sequence = 0; sequence < count; ++sequence)
+		{
+			envelope.clear_trace();
+			GetPostOffice().GetTracer().Start(envelope, true);
+			envelope.set_payload(std::to_string(sequence));
+
+			m_sent[sequence] = std::chrono::steady_clock::now();
+			GetPostOffice().RouteMessage(envelope.SerializeAsString(), nullptr);
+		}
+
+		WriteChatf("Sent \ag%d\ax loopback messages through the launcher.", count);
+	}
+
+	void Pulse()
+	{
+		if (!m_running)
+			return;
+
+		bool timedOut = std::chrono::steady_clock::now() - m_started > Timeout;
+		if (m_received < m_sent.size() && !timedOut)
+			return;
+
+		m_running = false;
+		m_dropbox.Remove();
+
+		WriteChatf("Loopback: \ag%d\ax of \ag%d\ax messages came back%s.", static_cast<int>(m_received),
+			static_cast<int>(m_sent.size()), timedOut ? " before timing out" : "");
+
+		if (m_roundTrip.GetCount() > 0)
+		{
+			WriteChatf("Round trip: avg \ay%.3f\ax ms, min \ay%.3f\ax ms, p50 \ay%.3f\ax ms, p95 \ay%.3f\ax ms, max \ay%.3f\ax ms",
+				m_roundTrip.GetAverage() / 1000.0, m_roundTrip.GetMin() / 1000.0, m_roundTrip.GetPercentile(50) / 1000.0,
+				m_roundTrip.GetPercentile(95) / 1000.0, m_roundTrip.GetMax() / 1000.0);
+		}
+	}
+
+	const LatencyHistogram& GetRoundTrip() const { return m_roundTrip; }
+
+private:
+	Dropbox m_dropbox;
+	std::vector<std::chrono::steady_clock::time_point> m_sent;
+	size_t m_received = 0;
+	LatencyHistogram m_roundTrip;
+	std::chrono::steady_clock::time_point m_started;
+	bool m_running = false;
+};
+static ActorLoopbackTest s_actorLoopbackTest;
+
+static std::optional<TraceRoute> FindTraceRoute(std::string_view name)
+{
+	if (name.empty())
+		return TraceRoute::Total;
+
+	for (int route = 0; route < static_cast<int>(TraceRoute::Count); ++route)
+	{
+		if (ci_equals(name, GetTraceRouteName(static_cast<TraceRoute>(route))))
+			return static_cast<TraceRoute>(route);
+	}
+
+	return std::nullopt;
+}
+
+static void ExportActorTraces()
+{
+	std::filesystem::path filePath = std::filesystem::path(mq::internal_paths::Logs) / "ActorTrace.csv";
+
+	FILE* file = _fsopen(filePath.string().c_str(), "wt", _SH_DENYWR);
+	if (!file)
+	{
+		WriteChatf("\arCould not open \ay%s\ar for writing.", filePath.string().c_str());
+		return;
+	}
+
+	fputs(TraceCsvHeader, file);
+
+	const auto& traces = GetPostOffice().GetTracer().GetRecentTraces();
+	for (const CompletedTrace& trace : traces)
+	{
+		fputs(FormatTraceCsv(trace).c_str(), file);
+	}
+
+	fclose(file);
+	WriteChatf("\ag%d\ax actor traces written to \ay%s\ax", static_cast<int>(traces.size()), filePath.string().c_str());
+}
+
+static void Cmd_ActorTrace(SPAWNINFO* pChar, char* szLine)
+{
+	char szArg[MAX_STRING] = { 0 };
+	GetArg(szArg, szLine, 1);
+
+	MessageTracer& tracer = GetPostOffice().GetTracer();
+
+	if (ci_equals(szArg, "on") || ci_equals(szArg, "off"))
+	{
+		tracer.SetEnabled(ci_equals(szArg, "on"));
+		WriteChatf("Actor message tracing is now %s.", tracer.IsEnabled() ? "\agon\ax" : "\aroff\ax");
+		return;
+	}
+
+	if (ci_equals(szArg, "clear"))
+	{
+		tracer.Clear();
+		WriteChatColor("Actor traces cleared.");
+		return;
+	}
+
+	if (ci_equals(szArg, "export"))
+	{
+		ExportActorTraces();
+		return;
+	}
+
+	if (ci_equals(szArg, "loopback"))
+	{
+		if (s_actorLoopbackTest.IsRunning())
+		{
+			WriteChatColor("A loopback test is already running.");
+			return;
+		}
+
+		GetArg(szArg, szLine, 2);
+		int count = std::clamp(GetIntFromString(szArg, 100), 1, 10000);
+		s_actorLoopbackTest.Start(count);
+		return;
+	}
+
+	if (szArg[0] != 0)
+	{
+		WriteChatColor("Usage: /actortrace [on|off|clear|export|loopback [count]]");
+		return;
+	}
+
+	WriteChatf("Actor message tracing is %s: \ag%llu\ax received, \ar%llu\ax dropped",
+		tracer.IsEnabled() ? "\agon\ax" : "\aroff\ax", tracer.GetCompleted(), tracer.GetDropped());
+
+	for (int route = 0; route < static_cast<int>(TraceRoute::Count); ++route)
+	{
+		const LatencyHistogram& histogram = tracer.GetHistogram(static_cast<TraceRoute>(route));
+		if (histogram.GetCount() == 0)
+			continue;
+
+		WriteChatf("  \ay%s\ax: %llu, avg %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms",
+			GetTraceRouteName(static_cast<TraceRoute>(route)), histogram.GetCount(), histogram.GetAverage() / 1000.0,
+			histogram.GetPercentile(50) / 1000.0, histogram.GetPercentile(95) / 1000.0,
+			histogram.GetPercentile(99) / 1000.0, histogram.GetMax() / 1000.0);
+	}
+}
+
+namespace datatypes {
+
+enum class ActorTraceTypeMembers
+{
+	Enabled,
+	Received,
+	Dropped,
+	Count,
+	Average,
+	Min,
+	Max,
+	P50,
+	P95,
+	P99,
+};
+
+MQActorTraceType::MQActorTraceType() : MQ2Type("actortrace")
+{
+	ScopedTypeMember(ActorTraceTypeMembers, Enabled);
+	ScopedTypeMember(ActorTraceTypeMembers, Received);
+	ScopedTypeMember(ActorTraceTypeMembers, Dropped);
+	ScopedTypeMember(ActorTraceTypeMembers, Count);
+	ScopedTypeMember(ActorTraceTypeMembers, Average);
+	ScopedTypeMember(ActorTraceTypeMembers, Min);
+	ScopedTypeMember(ActorTraceTypeMembers, Max);
+	ScopedTypeMember(ActorTraceTypeMembers, P50);
+	ScopedTypeMember(ActorTraceTypeMembers, P95);
+	ScopedTypeMember(ActorTraceTypeMembers, P99);
+}
+
+bool MQActorTraceType::GetMember(MQVarPtr VarPtr, const char* Member, char* Index, MQTypeVar& Dest)
+{
+	auto pMember = MQActorTraceType::FindMember(Member);
+	if (pMember == nullptr)
+		return false;
+
+	const MessageTracer& tracer = GetPostOffice().GetTracer();
+
+	// latency members take the route as the index, and default to the whole route
+	auto route = FindTraceRoute(Index);
+	if (!route)
+		return false;
+
+	const LatencyHistogram& histogram = tracer.GetHistogram(*route);
+
+	switch (static_cast<ActorTraceTypeMembers>(pMember->ID))
+	{
+	case ActorTraceTypeMembers::Enabled:
+		Dest.Type = pBoolType;
+		Dest.Set(tracer.IsEnabled());
+		return true;
+
+	case ActorTraceTypeMembers::Received:
+		Dest.Type = pInt64Type;
+		Dest.Set(static_cast<int64_t>(tracer.GetCompleted()));
+		return true;
+
+	case ActorTraceTypeMembers::Dropped:
+		Dest.Type = pInt64Type;
+		Dest.Set(static_cast<int64_t>(tracer.GetDropped()));
+		return true;
+
+	case ActorTraceTypeMembers::Count:
+		Dest.Type = pInt64Type;
+		Dest.Set(static_cast<int64_t>(histogram.GetCount()));
+		return true;
+
+	case ActorTraceTypeMembers::Average:
+		Dest.Type = pFloatType;
+		Dest.Set(static_cast<float>(histogram.GetAverage() / 1000.0));
+		return true;
+
+	case ActorTraceTypeMembers::Min:
+		Dest.Type = pFloatType;
+		Dest.Set(static_cast<float>(histogram.GetMin() / 1000.0));
+		return true;
+
+	case ActorTraceTypeMembers::Max:
+		Dest.Type = pFloatType;
+		Dest.Set(static_cast<float>(histogram.GetMax() / 1000.0));
+		return true;
+
+	case ActorTraceTypeMembers::P50:
+		Dest.Type = pFloatType;
+		Dest.Set(static_cast<float>(histogram.GetPercentile(50) / 1000.0));
+		return true;
+
+	case ActorTraceTypeMembers::P95:
+		Dest.Type = pFloatType;
+		Dest.Set(static_cast<float>(histogram.GetPercentile(95) / 1000.0));
+		return true;
+
+	case ActorTraceTypeMembers::P99:
+		Dest.Type = pFloatType;
+		Dest.Set(static_cast<float>(histogram.GetPercentile(99) / 1000.0));
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+bool MQActorTraceType::ToString(MQVarPtr VarPtr, char* Destination)
+{
+	strcpy_s(Destination, MAX_STRING, GetPostOffice().GetTracer().IsEnabled() ? "TRUE" : "FALSE");
+	return true;
+}
+
+bool MQActorTraceType::dataActorTrace(const char* szIndex, MQTypeVar& Ret)
+{
+	Ret.Ptr = nullptr;
+	Ret.Type = pActorTraceType;
+	return true;
+}
+
+} // namespace datatypes
+
+#pragma endregion
+
 namespace pipeclient {
 
 void NotifyIsForegroundWindow(bool isForeground)
@@ -502,16 +831,23 @@ void SendNotification(const std::string& message, const std::string& title)
 void InitializePostOffice()
 {
 	static_cast<MQPostOffice&>(GetPostOffice()).Initialize();
+
+	pDataAPI->AddTopLevelObject("ActorTrace", datatypes::MQActorTraceType::dataActorTrace);
+	AddCommand("/actortrace", Cmd_ActorTrace, false, false);
 }
 
 void ShutdownPostOffice()
 {
+	RemoveCommand("/actortrace");
+	pDataAPI->RemoveTopLevelObject("ActorTrace");
+
 	static_cast<MQPostOffice&>(GetPostOffice()).Shutdown();
 }
 
 void PulsePostOffice()
 {
 	static_cast<MQPostOffice&>(GetPostOffice()).ProcessPipeClient();
+	s_actorLoopbackTest.Pulse();
 }
 
 void SetGameStatePostOffice(int GameState)
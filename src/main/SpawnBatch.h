@@ -0,0 +1,108 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <unordered_set>
+#include <vector>
+
+namespace mq {
+
+//----------------------------------------------------------------------------
+// Spawns that were added while zoning. They are held here and delivered to plugins as a single
+// batch once the zone is ready, instead of one at a time as the game creates them.
+
+template <typename Spawn>
+class PendingSpawnBatch
+{
+public:
+	void Add(Spawn* spawn)
+	{
+		m_spawns.push_back(spawn);
+	}
+
+	// A spawn that goes away before its add was delivered is dropped from the batch.
+	void Remove(Spawn* const* spawns, int count)
+	{
+		if (m_spawns.empty() || count <= 0)
+			return;
+
+		const std::unordered_set<Spawn*> removed(spawns, spawns + count);
+
+		m_spawns.erase(
+			std::remove_if(m_spawns.begin(), m_spawns.end(),
+				[&removed](Spawn* spawn) { return removed.count(spawn) != 0; }),
+			m_spawns.end());
+	}
+
+	// Hands over the batch and leaves this one empty, so that spawns added while the batch is
+	// being delivered start a new one.
+	std::vector<Spawn*> Take()
+	{
+		std::vector<Spawn*> spawns;
+		spawns.swap(m_spawns);
+		return spawns;
+	}
+
+	void Clear() { m_spawns.clear(); }
+	bool empty() const { return m_spawns.empty(); }
+	size_t size() const { return m_spawns.size(); }
+
+private:
+	std::vector<Spawn*> m_spawns;
+};
+
+//----------------------------------------------------------------------------
+// Spawns from a batch that still need their caption set. Captions are set a few at a time over
+// the following frames, rather than all of them in the frame the batch was delivered.
+
+class SpawnCaptionQueue
+{
+public:
+	void Push(uint32_t spawnID)
+	{
+		m_spawnIDs.push_back(spawnID);
+	}
+
+	// Calls setCaption(spawnID) for queued spawns, oldest first, until maxCount captions have been
+	// set. setCaption returns false if the spawn went away while it was waiting, and that one
+	// doesn't count toward maxCount. Returns the number of captions set.
+	template <typename SetCaption>
+	int Update(int maxCount, SetCaption&& setCaption)
+	{
+		int count = 0;
+		while (!m_spawnIDs.empty() && count < maxCount)
+		{
+			uint32_t spawnID = m_spawnIDs.front();
+			m_spawnIDs.pop_front();
+
+			if (setCaption(spawnID))
+				++count;
+		}
+
+		return count;
+	}
+
+	void Clear() { m_spawnIDs.clear(); }
+	bool empty() const { return m_spawnIDs.empty(); }
+	size_t size() const { return m_spawnIDs.size(); }
+
+private:
+	std::deque<uint32_t> m_spawnIDs;
+};
+
+} // namespace mq
@@ -0,0 +1,160 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "mq/base/String.h"
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace mq {
+
+//----------------------------------------------------------------------------
+// Textures shared by filename. An entry stays in the cache while anything holds a reference
+// to its texture, and for EvictTime after the last reference goes away.
+//
+// A file that failed to load is cached too (without a texture, or with one that isn't valid),
+// so that a missing file isn't retried every frame. Looking it up doesn't keep it alive: once
+// it is RetryTime old, Find drops it and the next request loads the file again.
+//
+// Texture only needs IsLoading() and IsValid(), so this can be used without a graphics device.
+
+template <typename Texture>
+class TextureCache
+{
+public:
+	using clock = std::chrono::steady_clock;
+	using TexturePtr = std::shared_ptr<Texture>;
+
+	static constexpr clock::duration EvictTime = std::chrono::seconds(30);
+	static constexpr clock::duration RetryTime = std::chrono::seconds(5);
+
+	struct Entry
+	{
+		TexturePtr texture;
+		int rawRefs = 0;                                // references handed out by CreateTexture
+		clock::time_point lastUsed;                     // when it was added, for failed loads
+
+		bool IsFailed() const { return !texture || (!texture->IsLoading() && !texture->IsValid()); }
+	};
+
+	// Returns nullptr if there is no entry, or if the entry is a failed load that is due to be retried.
+	Entry* Find(std::string_view filename, clock::time_point now = clock::now())
+	{
+		auto iter = m_entries.find(filename);
+		if (iter == m_entries.end())
+			return nullptr;
+
+		Entry& entry = iter->second;
+		if (entry.IsFailed())
+		{
+			if (entry.rawRefs == 0 && now - entry.lastUsed >= RetryTime)
+			{
+				m_entries.erase(iter);
+				return nullptr;
+			}
+
+			return &entry;
+		}
+
+		entry.lastUsed = now;
+		return &entry;
+	}
+
+	Entry& Add(std::string_view filename, TexturePtr texture, clock::time_point now = clock::now())
+	{
+		Entry& entry = m_entries[std::string(filename)];
+		entry.texture = std::move(texture);
+		entry.lastUsed = now;
+
+		return entry;
+	}
+
+	Texture* Get(std::string_view filename) const
+	{
+		auto iter = m_entries.find(filename);
+		return iter == m_entries.end() ? nullptr : iter->second.texture.get();
+	}
+
+	// Releases a reference handed out by CreateTexture. The entry is removed when the last one
+	// goes away if eraseUnused is set.
+	void Release(std::string_view filename, const Texture* texture, bool eraseUnused)
+	{
+		auto iter = m_entries.find(filename);
+		if (iter == m_entries.end() || iter->second.texture.get() != texture)
+			return;
+
+		Entry& entry = iter->second;
+		if (entry.rawRefs > 0)
+			--entry.rawRefs;
+
+		if (eraseUnused && entry.rawRefs == 0)
+			m_entries.erase(iter);
+	}
+
+	// Removes textures that nothing has referenced for EvictTime, and failed loads that are due
+	// to be retried.
+	void Evict(clock::time_point now = clock::now())
+	{
+		for (auto iter = m_entries.begin(); iter != m_entries.end();)
+		{
+			Entry& entry = iter->second;
+
+			const bool failed = entry.IsFailed();
+
+			if (failed && entry.rawRefs == 0 && now - entry.lastUsed >= RetryTime)
+			{
+				iter = m_entries.erase(iter);
+			}
+			else if (entry.rawRefs > 0 || (entry.texture && (entry.texture.use_count() > 1 || entry.texture->IsLoading())))
+			{
+				if (!failed)
+					entry.lastUsed = now;
+
+				++iter;
+			}
+			else if (!failed && now - entry.lastUsed > EvictTime)
+			{
+				iter = m_entries.erase(iter);
+			}
+			else
+			{
+				++iter;
+			}
+		}
+	}
+
+	// Removes everything except the textures that are still referenced by CreateTexture.
+	void Clear()
+	{
+		for (auto iter = m_entries.begin(); iter != m_entries.end();)
+		{
+			if (iter->second.rawRefs == 0)
+				iter = m_entries.erase(iter);
+			else
+				++iter;
+		}
+	}
+
+	size_t size() const { return m_entries.size(); }
+
+private:
+	std::map<std::string, Entry, ci_less> m_entries;
+};
+
+} // namespace mq
@@ -0,0 +1,163 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mq {
+
+//----------------------------------------------------------------------------
+// Decodes image files to RGBA pixels on a worker thread. Files are decoded in the order they
+// were queued, and the main thread picks up the results with TakeResult and creates the
+// textures from the pixels.
+//
+// The decode function is passed in, so this can be used without a graphics device. The worker
+// is started by the first Queue and stopped by Stop or the destructor.
+
+struct DecodedImage
+{
+	std::string filename;
+	std::vector<uint8_t> pixels;            // width * height RGBA pixels
+	int width = 0;
+	int height = 0;
+	bool decoded = false;                   // false if the file couldn't be decoded
+};
+
+class TextureDecoder
+{
+public:
+	// Fills in the pixels and size of the image and returns true, or returns false if the file
+	// can't be decoded. Called on the worker thread.
+	using DecodeFunc = std::function<bool(const std::string& filename, DecodedImage& image)>;
+
+	explicit TextureDecoder(DecodeFunc decode)
+		: m_decode(std::move(decode))
+	{
+	}
+
+	~TextureDecoder()
+	{
+		Stop();
+	}
+
+	TextureDecoder(const TextureDecoder&) = delete;
+	TextureDecoder& operator=(const TextureDecoder&) = delete;
+
+	void Queue(std::string filename)
+	{
+		{
+			std::scoped_lock lock(m_mutex);
+
+			if (!m_thread.joinable())
+			{
+				m_stop = false;
+				m_thread = std::thread([this] { WorkerThread(); });
+			}
+
+			m_queue.push_back(std::move(filename));
+		}
+
+		m_condition.notify_one();
+	}
+
+	// Moves the oldest finished result into image. Returns false if nothing has finished.
+	bool TakeResult(DecodedImage& image)
+	{
+		std::scoped_lock lock(m_mutex);
+
+		if (m_results.empty())
+			return false;
+
+		image = std::move(m_results.front());
+		m_results.pop_front();
+		return true;
+	}
+
+	// Files that are queued or being decoded, plus results that haven't been taken yet.
+	size_t GetPendingCount() const
+	{
+		std::scoped_lock lock(m_mutex);
+		return m_queue.size() + m_results.size() + (m_busy ? 1 : 0);
+	}
+
+	// Stops the worker. Files that haven't been decoded yet and results that haven't been taken
+	// are dropped. Queue starts the worker again.
+	void Stop()
+	{
+		{
+			std::scoped_lock lock(m_mutex);
+			m_stop = true;
+			m_queue.clear();
+		}
+
+		m_condition.notify_one();
+
+		if (m_thread.joinable())
+			m_thread.join();
+
+		std::scoped_lock lock(m_mutex);
+		m_results.clear();
+	}
+
+private:
+	void WorkerThread()
+	{
+		std::unique_lock lock(m_mutex);
+
+		while (true)
+		{
+			m_condition.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+			if (m_stop)
+				break;
+
+			DecodedImage image;
+			image.filename = std::move(m_queue.front());
+			m_queue.pop_front();
+			m_busy = true;
+
+			lock.unlock();
+			image.decoded = m_decode(image.filename, image);
+			lock.lock();
+
+			m_busy = false;
+			if (!image.decoded)
+			{
+				image.pixels.clear();
+				image.width = image.height = 0;
+			}
+
+			m_results.push_back(std::move(image));
+		}
+	}
+
+	DecodeFunc m_decode;
+
+	std::thread m_thread;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::deque<std::string> m_queue;
+	std::deque<DecodedImage> m_results;
+	bool m_busy = false;
+	bool m_stop = false;
+};
+
+} // namespace mq
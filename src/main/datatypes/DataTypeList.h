@@ -108,6 +108,7 @@ DATATYPE(MQ2AchievementObjectiveType, pAchievementObjectiveType, nullptr);
 DATATYPE(MQIniFileSectionKeyType, pIniFileSectionKeyType, nullptr);
 DATATYPE(MQIniFileSectionType, pIniFileSectionType, nullptr);
 DATATYPE(MQIniFileType, pIniFileType, nullptr);
+DATATYPE(MQActorTraceType, pActorTraceType, nullptr);
 DATATYPE(MQIniType, pIniType, nullptr);
 DATATYPE(MQ2TradeskillDepotType, pTradeskillDepotType, nullptr);
 DATATYPE(MQBankType, pBankType, nullptr);
@@ -1403,6 +1403,20 @@ public:
 	static bool dataFrameLimiter(const char* szIndex, MQTypeVar& Ret);
 };
 
+//============================================================================
+// MQActorTraceType
+
+class MQActorTraceType : public MQ2Type
+{
+public:
+	MQActorTraceType();
+
+	bool GetMember(MQVarPtr VarPtr, const char* Member, char* Index, MQTypeVar& Dest) override;
+	bool ToString(MQVarPtr VarPtr, char* Destination) override;
+
+	static bool dataActorTrace(const char* szIndex, MQTypeVar& Ret);
+};
+
 //============================================================================
 // MQIniType
 
@@ -33,6 +33,10 @@ enum class MacroMembers
 	IsOuterVariable,
 	CurSub,
 	Variable,
+	EventCount,
+	EventsDropped,
+	LineHits,
+	SubCalls,
 };
 
 enum class MacroMethods
@@ -57,6 +61,10 @@ MQ2MacroType::MQ2MacroType()
 	ScopedTypeMember(MacroMembers, IsOuterVariable);
 	ScopedTypeMember(MacroMembers, CurSub);
 	ScopedTypeMember(MacroMembers, Variable);
+	ScopedTypeMember(MacroMembers, EventCount);
+	ScopedTypeMember(MacroMembers, EventsDropped);
+	ScopedTypeMember(MacroMembers, LineHits);
+	ScopedTypeMember(MacroMembers, SubCalls);
 
 	ScopedTypeMethod(MacroMethods, Undeclared);
 }
@@ -294,6 +302,66 @@ bool MQ2MacroType::GetMember(MQVarPtr VarPtr, const char* Member, char* Index, M
 		return true;
 	}
 
+	case MacroMembers::EventCount:
+		Dest.DWord = 0;
+		Dest.Type = pIntType;
+		if (Index[0])
+		{
+			if (MQEventBucket* pBucket = GetMacroEventBucket(Index))
+				Dest.DWord = pBucket->Count;
+		}
+		else
+		{
+			for (MQEventQueue* pEvent = gEventQueue; pEvent; pEvent = pEvent->pNext)
+				Dest.DWord++;
+		}
+		return true;
+
+	case MacroMembers::EventsDropped:
+		Dest.UInt64 = 0;
+		Dest.Type = pInt64Type;
+		if (MQEventBucket* pBucket = GetMacroEventBucket(Index))
+			Dest.UInt64 = pBucket->Dropped;
+		return true;
+
+	case MacroMembers::LineHits:
+		// LineHits[line] for a line in the current file, or LineHits[line@file]
+		Dest.DWord = 0;
+		Dest.Type = pIntType;
+		if (gMacroBlock && Index[0])
+		{
+			const char* szFile = strchr(Index, '@');
+			const int lineNumber = GetIntFromString(Index, 0);
+			const std::string& sourceFile = szFile ? std::string(szFile + 1) : gMacroBlock->Line.at(gMacroBlock->CurrIndex).SourceFile;
+
+			for (const auto& [index, line] : gMacroBlock->Line)
+			{
+				if (line.LineNumber == lineNumber && ci_equals(line.SourceFile, sourceFile))
+				{
+					Dest.DWord = line.HitCount;
+					break;
+				}
+			}
+			return true;
+		}
+		break;
+
+	case MacroMembers::SubCalls:
+		Dest.DWord = 0;
+		Dest.Type = pIntType;
+		if (gMacroBlock && Index[0])
+		{
+			auto subIter = gMacroSubLookupMap.find(Index);
+			if (subIter != gMacroSubLookupMap.end())
+			{
+				auto lineIter = gMacroBlock->Line.find(subIter->second);
+				if (lineIter != gMacroBlock->Line.end())
+					Dest.DWord = lineIter->second.CallCount;
+			}
+			return true;
+		}
+		break;
+
 	default: break;
 	}
 
@@ -1071,7 +1071,7 @@ bool MQ2SpawnType::GetMember(SPAWNINFO* pSpawn, const char* Member, char* Index,
 		return true;
 
 	case SpawnMembers::LineOfSight:
-		Dest.Set(pControlledPlayer->CanSee(*pSpawn));
+		Dest.Set(CachedLineOfSight(pControlledPlayer, pSpawn));
 		Dest.Type = pBoolType;
 		return true;
 
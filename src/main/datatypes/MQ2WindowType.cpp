@@ -253,25 +253,22 @@ bool MQ2WindowType::GetMember(MQVarPtr VarPtr, const char* Member, char* Index,
 		case WindowMethods::Move: {
 			if (Index[0])
 			{
-				char szLeft[MAX_STRING] = { 0 };
-				char szTop[MAX_STRING] = { 0 };
-				char szWidth[MAX_STRING] = { 0 };
-				char szHeight[MAX_STRING] = { 0 };
-				GetArg(szLeft, Index, 1, false, false, false, ',');
-				GetArg(szTop, Index, 2, false, false, false, ',');
-				GetArg(szWidth, Index, 3, false, false, false, ',');
-				GetArg(szHeight, Index, 4, false, false, false, ',');
+				ArgTokenizer args(Index, false, ',');
+				std::string_view left = args[0];
+				std::string_view top = args[1];
+				std::string_view width = args[2];
+				std::string_view height = args[3];
 
 				CXRect rc = pWnd->GetLocation();
 
-				if (szLeft[0])
-					rc.left = GetIntFromString(szLeft, rc.left);
-				if (szTop[0])
-					rc.top = GetIntFromString(szTop, rc.top);
-				if (szWidth[0])
-					rc.right = rc.left + GetIntFromString(szWidth, rc.right - rc.left);
-				if (szHeight[0])
-					rc.bottom = rc.top + GetIntFromString(szHeight, rc.bottom - rc.top);
+				if (!left.empty())
+					rc.left = GetIntFromString(left, rc.left);
+				if (!top.empty())
+					rc.top = GetIntFromString(top, rc.top);
+				if (!width.empty())
+					rc.right = rc.left + GetIntFromString(width, rc.right - rc.left);
+				if (!height.empty())
+					rc.bottom = rc.top + GetIntFromString(height, rc.bottom - rc.top);
 
 				pWnd->Move(rc, true, true, true, true);
 			}
@@ -0,0 +1,153 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "LineOfSightKey.h"
+
+#include "TestCheck.h"
+
+#include <unordered_map>
+
+using namespace mq;
+
+struct Vector
+{
+	float X;
+	float Y;
+	float Z;
+};
+
+static LineOfSightKey SpawnKey(uint32_t sourceID, uint32_t targetID, const Vector& source, const Vector& target, float tolerance)
+{
+	LineOfSightKey key;
+	key.sourceID = sourceID;
+	key.targetID = targetID;
+	key.SetPositions(source, target, tolerance);
+	return key;
+}
+
+static LineOfSightKey LocationKey(int race, const Vector& source, const Vector& target, float tolerance)
+{
+	LineOfSightKey key;
+	key.race = race;
+	key.SetPositions(source, target, tolerance);
+	return key;
+}
+
+static bool SameKey(const LineOfSightKey& a, const LineOfSightKey& b)
+{
+	const bool equal = a == b;
+
+	// equal keys have to hash the same, and equality has to be symmetric
+	CHECK(equal == (b == a));
+	if (equal)
+		CHECK(LineOfSightKeyHash()(a) == LineOfSightKeyHash()(b));
+
+	return equal;
+}
+
+static void TestExactPositions()
+{
+	const Vector source = { 100.25f, -42.5f, 3.0f };
+	const Vector target = { 120.0f, -40.0f, 3.0f };
+
+	CHECK(SameKey(SpawnKey(1, 2, source, target, 0.0f), SpawnKey(1, 2, source, target, 0.0f)));
+
+	// any difference in position is a different key
+	CHECK(!SameKey(SpawnKey(1, 2, source, target, 0.0f), SpawnKey(1, 2, { 100.26f, -42.5f, 3.0f }, target, 0.0f)));
+	CHECK(!SameKey(SpawnKey(1, 2, source, target, 0.0f), SpawnKey(1, 2, source, { 120.0f, -40.0f, 3.001f }, 0.0f)));
+
+	// swapping source and target is a different check
+	CHECK(!SameKey(SpawnKey(1, 2, source, target, 0.0f), SpawnKey(1, 2, target, source, 0.0f)));
+
+	CHECK(QuantizeLineOfSightPosition(0.0f, 0.0f) == QuantizeLineOfSightPosition(-0.0f, 0.0f));
+	CHECK(QuantizeLineOfSightPosition(1.0f, 0.0f) != QuantizeLineOfSightPosition(-1.0f, 0.0f));
+}
+
+static void TestTolerance()
+{
+	CHECK(QuantizeLineOfSightPosition(0.0f, 5.0f) == 0);
+	CHECK(QuantizeLineOfSightPosition(4.99f, 5.0f) == 0);
+	CHECK(QuantizeLineOfSightPosition(5.0f, 5.0f) == 1);
+	CHECK(QuantizeLineOfSightPosition(-0.01f, 5.0f) == -1);
+	CHECK(QuantizeLineOfSightPosition(-5.0f, 5.0f) == -1);
+	CHECK(QuantizeLineOfSightPosition(-5.01f, 5.0f) == -2);
+	CHECK(QuantizeLineOfSightPosition(1234.5f, 0.5f) == 2469);
+
+	const Vector source = { 101.0f, 202.0f, 3.0f };
+	const Vector target = { 151.0f, 252.0f, 4.0f };
+
+	// positions in the same cell share a key
+	CHECK(SameKey(SpawnKey(1, 2, source, target, 5.0f), SpawnKey(1, 2, { 104.9f, 200.0f, 0.5f }, { 150.0f, 254.0f, 0.0f }, 5.0f)));
+
+	// and ones across a cell boundary don't, however close they are
+	CHECK(!SameKey(SpawnKey(1, 2, { 104.99f, 202.0f, 3.0f }, target, 5.0f), SpawnKey(1, 2, { 105.0f, 202.0f, 3.0f }, target, 5.0f)));
+	CHECK(!SameKey(SpawnKey(1, 2, source, { 151.0f, 252.0f, -0.01f }, 5.0f), SpawnKey(1, 2, source, target, 5.0f)));
+
+	// positions that share a cell at one tolerance don't at a smaller one
+	CHECK(!SameKey(SpawnKey(1, 2, source, target, 1.0f), SpawnKey(1, 2, { 104.9f, 200.0f, 0.5f }, target, 1.0f)));
+}
+
+static void TestSpawnAndLocationKeys()
+{
+	const Vector source = { 10.0f, 20.0f, 30.0f };
+	const Vector target = { 40.0f, 50.0f, 60.0f };
+
+	// spawn checks are per pair of spawns
+	CHECK(!SameKey(SpawnKey(1, 2, source, target, 0.0f), SpawnKey(1, 3, source, target, 0.0f)));
+	CHECK(!SameKey(SpawnKey(1, 2, source, target, 0.0f), SpawnKey(2, 1, source, target, 0.0f)));
+
+	// location checks are per race
+	CHECK(SameKey(LocationKey(1, source, target, 0.0f), LocationKey(1, source, target, 0.0f)));
+	CHECK(!SameKey(LocationKey(1, source, target, 0.0f), LocationKey(2, source, target, 0.0f)));
+	CHECK(SameKey(LocationKey(1, source, target, 5.0f), LocationKey(1, { 11.0f, 21.0f, 31.0f }, target, 5.0f)));
+
+	// and never match a spawn check from the same place
+	CHECK(!SameKey(SpawnKey(1, 2, source, target, 0.0f), LocationKey(-1, source, target, 0.0f)));
+	CHECK(!SameKey(SpawnKey(1, 2, source, target, 0.0f), LocationKey(1, source, target, 0.0f)));
+}
+
+static void TestCache()
+{
+	std::unordered_map<LineOfSightKey, bool, LineOfSightKeyHash> cache;
+
+	for (uint32_t id = 1; id <= 100; ++id)
+	{
+		const Vector position = { static_cast<float>(id), 0.0f, 0.0f };
+		cache.emplace(SpawnKey(1, id, { 0.0f, 0.0f, 0.0f }, position, 0.0f), id % 2 == 0);
+		cache.emplace(LocationKey(static_cast<int>(id), { 0.0f, 0.0f, 0.0f }, position, 0.0f), id % 3 == 0);
+	}
+
+	CHECK(cache.size() == 200);
+
+	for (uint32_t id = 1; id <= 100; ++id)
+	{
+		const Vector position = { static_cast<float>(id), 0.0f, 0.0f };
+
+		auto spawn = cache.find(SpawnKey(1, id, { 0.0f, -0.0f, 0.0f }, position, 0.0f));
+		CHECK(spawn != cache.end() && spawn->second == (id % 2 == 0));
+
+		auto location = cache.find(LocationKey(static_cast<int>(id), { 0.0f, 0.0f, 0.0f }, position, 0.0f));
+		CHECK(location != cache.end() && location->second == (id % 3 == 0));
+	}
+}
+
+int main()
+{
+	TestExactPositions();
+	TestTolerance();
+	TestSpawnAndLocationKeys();
+	TestCache();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,124 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "TestCheck.h"
+#include "LoadTimeline.h"
+
+using namespace mq;
+using namespace std::chrono_literals;
+
+static void TestNestedPhases()
+{
+	LoadTimeline timeline;
+	const auto start = LoadTimeline::clock::now();
+
+	int outer = timeline.Begin("Plugins", 1, start);
+	int inner = timeline.Begin("MQ2Foo", 1, start + 1ms);
+	int innermost = timeline.Begin("LoadLibrary", 1, start + 2ms);
+	timeline.End(innermost, start + 5ms);
+	timeline.End(inner, start + 6ms);
+
+	// A sibling goes back to the depth of the phase it follows
+	int sibling = timeline.Begin("MQ2Bar", 1, start + 7ms);
+	timeline.End(sibling, start + 9ms);
+	timeline.End(outer, start + 10ms);
+
+	const std::vector<LoadTimelineEntry> entries = timeline.GetEntries();
+	CHECK(entries.size() == 4);
+	if (entries.size() != 4)
+		return;
+
+	CHECK(entries[0].Name == "Plugins" && entries[0].Depth == 0);
+	CHECK(entries[1].Name == "MQ2Foo" && entries[1].Depth == 1);
+	CHECK(entries[2].Name == "LoadLibrary" && entries[2].Depth == 2);
+	CHECK(entries[3].Name == "MQ2Bar" && entries[3].Depth == 1);
+
+	CHECK(entries[0].Finished && entries[0].Duration == 10ms);
+	CHECK(entries[1].Duration == 5ms);
+	CHECK(entries[2].Duration == 3ms);
+	CHECK(entries[3].Duration == 2ms);
+
+	CHECK(LoadTimeline::GetOffsetMS(entries[0], entries[0]) == 0.0);
+	CHECK(LoadTimeline::GetOffsetMS(entries[3], entries[0]) == 7.0);
+	CHECK(LoadTimeline::GetDurationMS(entries[2]) == 3.0);
+
+	// Everything has ended, so the next phase starts at the top again
+	timeline.Begin("Later", 1, start + 20ms);
+	CHECK(timeline.GetEntries().back().Depth == 0);
+}
+
+static void TestThreadsNestSeparately()
+{
+	LoadTimeline timeline;
+	const auto start = LoadTimeline::clock::now();
+
+	int mainPhase = timeline.Begin("Main", 1, start);
+	int spellPhase = timeline.Begin("Spell DB", 2, start + 1ms);
+	int mainChild = timeline.Begin("Plugins", 1, start + 2ms);
+
+	const std::vector<LoadTimelineEntry> entries = timeline.GetEntries();
+	CHECK(entries[mainPhase].Depth == 0);
+	CHECK(entries[spellPhase].Depth == 0 && entries[spellPhase].ThreadId == 2);
+	CHECK(entries[mainChild].Depth == 1);
+
+	// A phase that is still running has no duration
+	CHECK(!entries[spellPhase].Finished);
+	CHECK(entries[spellPhase].Duration == std::chrono::microseconds::zero());
+}
+
+static void TestEndOnlyOnce()
+{
+	LoadTimeline timeline;
+	const auto start = LoadTimeline::clock::now();
+
+	int outer = timeline.Begin("Outer", 1, start);
+	int inner = timeline.Begin("Inner", 1, start);
+	timeline.End(inner, start + 1ms);
+	timeline.End(inner, start + 2ms);
+
+	// Ending twice neither changes the duration nor unwinds the outer phase
+	CHECK(timeline.GetEntries()[inner].Duration == 1ms);
+	timeline.Begin("Second", 1, start + 3ms);
+	CHECK(timeline.GetEntries().back().Depth == 1);
+
+	timeline.End(outer, start + 4ms);
+	timeline.End(-1, start + 5ms);
+	timeline.End(100, start + 5ms);
+	CHECK(timeline.GetEntries().size() == 3);
+}
+
+static void TestCapped()
+{
+	LoadTimeline timeline;
+
+	for (size_t i = 0; i < LoadTimeline::MaxEntries; ++i)
+		timeline.End(timeline.Begin("Plugin", 1));
+
+	int phase = timeline.Begin("One too many", 1);
+	CHECK(phase == -1);
+	timeline.End(phase);
+
+	CHECK(timeline.GetEntries().size() == LoadTimeline::MaxEntries);
+	CHECK(timeline.GetEntries().back().Depth == 0);
+}
+
+int main()
+{
+	TestNestedPhases();
+	TestThreadsNestSeparately();
+	TestEndOnlyOnce();
+	TestCapped();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,103 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "TestCheck.h"
+#include "MQPluginManifest.h"
+
+#include <fstream>
+
+using namespace mq;
+namespace fs = std::filesystem;
+
+static void TouchFile(const fs::path& path)
+{
+	std::ofstream(path).put('x');
+}
+
+static void TestCanonicalName()
+{
+	CHECK(GetCanonicalPluginName("MQ2Map.dll") == "Map");
+	CHECK(GetCanonicalPluginName("mq2map.DLL") == "map");
+	CHECK(GetCanonicalPluginName("MQNav") == "Nav");
+	CHECK(GetCanonicalPluginName("Nav") == "Nav");
+	CHECK(GetCanonicalPluginName("MQ2Map.dll", false) == "Map.dll");
+
+	// only a leading MQ is stripped
+	CHECK(GetCanonicalPluginName("aQuest") == "aQuest");
+	CHECK(GetCanonicalPluginName("aQ2Quest.dll") == "aQ2Quest");
+	CHECK(GetCanonicalPluginName("Mystic") == "Mystic");
+}
+
+static void TestFind(const fs::path& directory)
+{
+	TouchFile(directory / "MQ2Map.dll");
+	TouchFile(directory / "mqnav.DLL");
+	TouchFile(directory / "MQ2Notes.txt");
+	fs::create_directory(directory / "MQ2Folder.dll");
+
+	PluginDirectoryManifest manifest(directory);
+	CHECK(manifest.size() == 2);
+
+	// Canonical names take the prefix and casing of the file on disk
+	CHECK(manifest.Find("Map") == "MQ2Map");
+	CHECK(manifest.Find("MAP") == "MQ2Map");
+	CHECK(manifest.Find("map.dll") == "MQ2Map");
+	CHECK(manifest.Find("Nav") == "mqnav");
+
+	// Prefixed names have to match exactly, and keep the casing that was asked for
+	CHECK(manifest.Find("MQ2Map") == "MQ2Map");
+	CHECK(manifest.Find("mq2map") == "mq2map");
+	CHECK(manifest.Find("MQMap").empty());
+
+	// Only dll files count
+	CHECK(manifest.Find("Notes").empty());
+	CHECK(manifest.Find("Folder").empty());
+	CHECK(manifest.Find("Missing").empty());
+}
+
+static void TestIsCurrent(const fs::path& directory)
+{
+	PluginDirectoryManifest manifest(directory);
+	CHECK(manifest.IsCurrent());
+	CHECK(manifest.Find("Chat").empty());
+
+	// Move the write time along explicitly, the file system's resolution may be coarse
+	TouchFile(directory / "MQ2Chat.dll");
+	fs::last_write_time(directory, fs::last_write_time(directory) + std::chrono::hours(1));
+	CHECK(!manifest.IsCurrent());
+
+	PluginDirectoryManifest refreshed(directory);
+	CHECK(refreshed.IsCurrent());
+	CHECK(refreshed.Find("Chat") == "MQ2Chat");
+
+	// A directory that can't be read is never current
+	PluginDirectoryManifest missing(directory / "missing");
+	CHECK(missing.size() == 0);
+	CHECK(!missing.IsCurrent());
+}
+
+int main()
+{
+	const fs::path directory = fs::temp_directory_path() / "mq-plugin-manifest-tests";
+	fs::remove_all(directory);
+	fs::create_directories(directory);
+
+	TestCanonicalName();
+	TestFind(directory);
+	TestIsCurrent(directory);
+
+	fs::remove_all(directory);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,328 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+// Times the frame in which a zone's spawns are delivered to plugins, using a synthetic batch of
+// spawns (1,000 by default).
+//
+// "per spawn" is what PluginsAddSpawn did for every spawn before batching. It looks up the body
+// type, sets the caption, and then walks the modules and the plugins, each walk taking the plugin
+// lock. "batched" is DispatchAddSpawns with a PendingSpawnBatch. The batch is delivered with
+// one walk over the modules and one over the plugins. Its captions go to a SpawnCaptionQueue, and
+// the following frames set 50 each, as MQ2Spawns does.
+//
+// There's no game here, so a caption is a stand-in. It expands the default NPC caption
+// innermost ${...} first, the way the macro parser does, with the members looked up in a map.
+// The plugins are 20 fake plugins that record the spawn in a map, half of them through AddSpawns
+// and half through AddSpawn. The modules are 4 that do the same.
+//
+//   SpawnBatchBenchmark [spawns]
+
+#include "SpawnBatch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace mq;
+
+static constexpr int PLUGIN_COUNT = 20;
+static constexpr int MODULE_COUNT = 4;
+static constexpr int MAX_PENDING_CAPTIONS_PER_FRAME = 50;
+
+static const char* CAPTION = "${If[${NamingSpawn.Mark},${NamingSpawn.Mark} - ,]}${If[${NamingSpawn.Assist},>> ,]}"
+	"${NamingSpawn.DisplayName}${If[${NamingSpawn.Assist}, - ${NamingSpawn.PctHPs}%<<,]}"
+	"${If[${NamingSpawn.Surname.Length},\n(${NamingSpawn.Surname}),]}";
+
+struct Spawn
+{
+	uint32_t id = 0;
+	int bodyType = 0;
+	std::unordered_map<std::string, std::string> members;
+	std::string caption;
+};
+
+struct Plugin
+{
+	bool batched = false;
+	std::unordered_map<uint32_t, int> seen;
+
+	void AddSpawn(Spawn* spawn) { seen[spawn->id] = spawn->bodyType; }
+
+	void AddSpawns(Spawn* const* spawns, int count)
+	{
+		seen.reserve(seen.size() + count);
+		for (int i = 0; i < count; ++i)
+			seen[spawns[i]->id] = spawns[i]->bodyType;
+	}
+};
+
+struct Zone
+{
+	std::vector<Spawn> spawns;
+	std::unordered_map<uint32_t, Spawn*> spawnsByID;
+	std::vector<Plugin> modules;
+	std::vector<Plugin> plugins;
+	std::recursive_mutex pluginsMutex;
+	uint64_t captionBytes = 0;
+};
+
+// Evaluates the inside of one ${...}: either If[condition,then,else] or a NamingSpawn member.
+static std::string Evaluate(const Spawn& spawn, const std::string& expression)
+{
+	if (expression.compare(0, 3, "If[") == 0)
+	{
+		size_t comma1 = expression.find(',');
+		size_t comma2 = expression.rfind(',');
+		std::string condition = expression.substr(3, comma1 - 3);
+		bool result = !condition.empty() && condition != "0" && condition != "FALSE" && condition != "NULL";
+
+		return result ? expression.substr(comma1 + 1, comma2 - comma1 - 1)
+			: expression.substr(comma2 + 1, expression.size() - comma2 - 2);
+	}
+
+	auto iter = spawn.members.find(expression);
+	return iter != spawn.members.end() ? iter->second : "NULL";
+}
+
+static void SetCaption(Zone& zone, Spawn& spawn)
+{
+	std::string text = CAPTION;
+
+	size_t start;
+	while ((start = text.rfind("${")) != std::string::npos)
+	{
+		size_t end = text.find('}', start);
+		if (end == std::string::npos)
+			break;
+
+		text.replace(start, end - start + 1, Evaluate(spawn, text.substr(start + 2, end - start - 2)));
+	}
+
+	spawn.caption = std::move(text);
+	zone.captionBytes += spawn.caption.size();
+}
+
+static int GetBodyType(const Spawn& spawn)
+{
+	return spawn.bodyType;
+}
+
+static void CreateZone(Zone& zone, int spawnCount)
+{
+	zone.spawns.resize(spawnCount);
+	for (int i = 0; i < spawnCount; ++i)
+	{
+		Spawn& spawn = zone.spawns[i];
+		spawn.id = i + 1;
+		spawn.bodyType = i % 30;
+		spawn.members = {
+			{ "NamingSpawn.Mark", i % 50 == 0 ? "1" : "0" },
+			{ "NamingSpawn.Assist", i % 100 == 0 ? "TRUE" : "FALSE" },
+			{ "NamingSpawn.DisplayName", "a decaying skeleton " + std::to_string(i) },
+			{ "NamingSpawn.PctHPs", "100" },
+			{ "NamingSpawn.Surname.Length", i % 10 == 0 ? "8" : "0" },
+			{ "NamingSpawn.Surname", "Merchant" },
+		};
+		zone.spawnsByID[spawn.id] = &spawn;
+	}
+
+	zone.modules.assign(MODULE_COUNT, Plugin());
+	zone.plugins.assign(PLUGIN_COUNT, Plugin());
+	for (int i = 0; i < PLUGIN_COUNT; i += 2)
+		zone.plugins[i].batched = true;
+}
+
+template <typename Callback>
+static void ForEachPlugin(Zone& zone, std::vector<Plugin>& plugins, Callback&& callback)
+{
+	std::scoped_lock lock(zone.pluginsMutex);
+
+	for (Plugin& plugin : plugins)
+		callback(plugin);
+}
+
+static void AddSpawnPerSpawn(Zone& zone, Spawn* spawn)
+{
+	spawn->bodyType = GetBodyType(*spawn);
+	SetCaption(zone, *spawn);
+
+	ForEachPlugin(zone, zone.modules, [spawn](Plugin& module) { module.AddSpawn(spawn); });
+	ForEachPlugin(zone, zone.plugins, [spawn](Plugin& plugin) { plugin.AddSpawn(spawn); });
+}
+
+static void DispatchAddSpawns(Zone& zone, SpawnCaptionQueue& captions, Spawn* const* spawns, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		spawns[i]->bodyType = GetBodyType(*spawns[i]);
+		captions.Push(spawns[i]->id);
+	}
+
+	ForEachPlugin(zone, zone.modules, [spawns, count](Plugin& module)
+		{
+			for (int i = 0; i < count; ++i)
+				module.AddSpawn(spawns[i]);
+		});
+
+	ForEachPlugin(zone, zone.plugins, [spawns, count](Plugin& plugin)
+		{
+			if (plugin.batched)
+			{
+				plugin.AddSpawns(spawns, count);
+			}
+			else
+			{
+				for (int i = 0; i < count; ++i)
+					plugin.AddSpawn(spawns[i]);
+			}
+		});
+}
+
+static double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Result
+{
+	double zoneInMs = 0;
+	int captionFrames = 0;
+	double maxCaptionFrameMs = 0;
+	double totalCaptionMs = 0;
+	bool delivered = false;
+};
+
+static bool AllDelivered(const Zone& zone)
+{
+	for (const Plugin& plugin : zone.plugins)
+	{
+		if (plugin.seen.size() != zone.spawns.size())
+			return false;
+	}
+
+	for (const Spawn& spawn : zone.spawns)
+	{
+		if (spawn.caption.empty())
+			return false;
+	}
+
+	return true;
+}
+
+static Result RunPerSpawn(int spawnCount)
+{
+	Zone zone;
+	CreateZone(zone, spawnCount);
+
+	Result result;
+	auto start = std::chrono::steady_clock::now();
+
+	for (Spawn& spawn : zone.spawns)
+		AddSpawnPerSpawn(zone, &spawn);
+
+	result.zoneInMs = ElapsedMs(start);
+	result.delivered = AllDelivered(zone);
+	return result;
+}
+
+static Result RunBatched(int spawnCount)
+{
+	Zone zone;
+	CreateZone(zone, spawnCount);
+
+	// The game creates the spawns while zoning, they're held until the zone is ready.
+	PendingSpawnBatch<Spawn> pending;
+	for (Spawn& spawn : zone.spawns)
+		pending.Add(&spawn);
+
+	SpawnCaptionQueue captions;
+
+	Result result;
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<Spawn*> spawns = pending.Take();
+	DispatchAddSpawns(zone, captions, spawns.data(), static_cast<int>(spawns.size()));
+
+	result.zoneInMs = ElapsedMs(start);
+
+	while (!captions.empty())
+	{
+		auto frameStart = std::chrono::steady_clock::now();
+
+		captions.Update(MAX_PENDING_CAPTIONS_PER_FRAME, [&zone](uint32_t spawnID)
+			{
+				auto iter = zone.spawnsByID.find(spawnID);
+				if (iter == zone.spawnsByID.end())
+					return false;
+
+				SetCaption(zone, *iter->second);
+				return true;
+			});
+
+		double frameMs = ElapsedMs(frameStart);
+		++result.captionFrames;
+		result.totalCaptionMs += frameMs;
+		if (frameMs > result.maxCaptionFrameMs)
+			result.maxCaptionFrameMs = frameMs;
+	}
+
+	result.delivered = AllDelivered(zone);
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	int spawnCount = argc > 1 ? std::atoi(argv[1]) : 1000;
+	if (spawnCount <= 0)
+		spawnCount = 1000;
+
+	constexpr int RUNS = 20;
+
+	// The best of several runs, so that one slow run doesn't decide it.
+	Result perSpawn, batched;
+	perSpawn.zoneInMs = batched.zoneInMs = 1e9;
+	bool delivered = true;
+
+	for (int run = 0; run < RUNS; ++run)
+	{
+		Result result = RunPerSpawn(spawnCount);
+		delivered &= result.delivered;
+		if (result.zoneInMs < perSpawn.zoneInMs)
+			perSpawn = result;
+
+		result = RunBatched(spawnCount);
+		delivered &= result.delivered;
+		if (result.zoneInMs < batched.zoneInMs)
+			batched = result;
+	}
+
+	std::printf("%d spawns, %d plugins, %d modules, best of %d\n\n", spawnCount, PLUGIN_COUNT, MODULE_COUNT, RUNS);
+	std::printf("%-10s  %14s  %14s  %16s\n", "", "zone-in frame", "caption frames", "max caption frame");
+	std::printf("%-10s  %11.3f ms  %14s  %16s\n", "per spawn", perSpawn.zoneInMs, "-", "-");
+	std::printf("%-10s  %11.3f ms  %14d  %13.3f ms\n", "batched", batched.zoneInMs, batched.captionFrames,
+		batched.maxCaptionFrameMs);
+	std::printf("\ncaptions: %.2f us each\n", batched.totalCaptionMs * 1000.0 / spawnCount);
+
+	if (!delivered)
+	{
+		std::printf("not every spawn was delivered and captioned\n");
+		return 1;
+	}
+
+	return 0;
+}
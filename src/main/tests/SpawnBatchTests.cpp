@@ -0,0 +1,141 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "SpawnBatch.h"
+
+#include "TestCheck.h"
+
+#include <vector>
+
+using namespace mq;
+
+struct Spawn
+{
+	uint32_t id;
+};
+
+static void TestBatchKeepsOrder()
+{
+	Spawn spawns[4] = { { 1 }, { 2 }, { 3 }, { 4 } };
+
+	PendingSpawnBatch<Spawn> batch;
+	CHECK(batch.empty());
+
+	for (Spawn& spawn : spawns)
+		batch.Add(&spawn);
+	CHECK(batch.size() == 4);
+
+	std::vector<Spawn*> taken = batch.Take();
+	CHECK(batch.empty());
+	CHECK(taken.size() == 4);
+	for (size_t i = 0; i < taken.size() && i < 4; ++i)
+		CHECK(taken[i] == &spawns[i]);
+
+	// Spawns added after the batch was taken start a new one.
+	batch.Add(&spawns[0]);
+	CHECK(batch.size() == 1);
+	CHECK(batch.Take().front() == &spawns[0]);
+}
+
+static void TestBatchRemove()
+{
+	std::vector<Spawn> spawns(1000);
+	for (uint32_t i = 0; i < spawns.size(); ++i)
+		spawns[i].id = i;
+
+	PendingSpawnBatch<Spawn> batch;
+	for (Spawn& spawn : spawns)
+		batch.Add(&spawn);
+
+	// Every odd spawn goes away, plus one that was never in the batch.
+	Spawn other = { 5000 };
+	std::vector<Spawn*> removed = { &other };
+	for (size_t i = 1; i < spawns.size(); i += 2)
+		removed.push_back(&spawns[i]);
+
+	batch.Remove(removed.data(), static_cast<int>(removed.size()));
+	CHECK(batch.size() == 500);
+
+	std::vector<Spawn*> taken = batch.Take();
+	bool evenInOrder = taken.size() == 500;
+	for (size_t i = 0; evenInOrder && i < taken.size(); ++i)
+		evenInOrder = taken[i]->id == i * 2;
+	CHECK(evenInOrder);
+
+	// Removing from an empty batch, or removing nothing, is fine.
+	batch.Remove(removed.data(), static_cast<int>(removed.size()));
+	batch.Add(&spawns[0]);
+	batch.Remove(nullptr, 0);
+	CHECK(batch.size() == 1);
+
+	batch.Clear();
+	CHECK(batch.empty());
+}
+
+static void TestCaptionsSpreadOverFrames()
+{
+	SpawnCaptionQueue queue;
+	for (uint32_t id = 1; id <= 120; ++id)
+		queue.Push(id);
+	CHECK(queue.size() == 120);
+
+	std::vector<uint32_t> captioned;
+	auto setCaption = [&captioned](uint32_t spawnID) { captioned.push_back(spawnID); return true; };
+
+	CHECK(queue.Update(50, setCaption) == 50);
+	CHECK(queue.Update(50, setCaption) == 50);
+	CHECK(queue.Update(50, setCaption) == 20);
+	CHECK(queue.empty());
+	CHECK(queue.Update(50, setCaption) == 0);
+
+	bool inOrder = captioned.size() == 120;
+	for (size_t i = 0; inOrder && i < captioned.size(); ++i)
+		inOrder = captioned[i] == i + 1;
+	CHECK(inOrder);
+}
+
+static void TestCaptionsSkipGoneSpawns()
+{
+	SpawnCaptionQueue queue;
+	for (uint32_t id = 1; id <= 10; ++id)
+		queue.Push(id);
+
+	// Odd spawns have gone away. They're dropped without using up the frame's captions.
+	std::vector<uint32_t> captioned;
+	int count = queue.Update(3, [&captioned](uint32_t spawnID)
+		{
+			if (spawnID % 2 != 0)
+				return false;
+
+			captioned.push_back(spawnID);
+			return true;
+		});
+
+	CHECK(count == 3);
+	CHECK((captioned == std::vector<uint32_t>{ 2, 4, 6 }));
+	CHECK(queue.size() == 4);
+
+	queue.Clear();
+	CHECK(queue.empty());
+}
+
+int main()
+{
+	TestBatchKeepsOrder();
+	TestBatchRemove();
+	TestCaptionsSpreadOverFrames();
+	TestCaptionsSkipGoneSpawns();
+
+	return TEST_RESULT();
+}
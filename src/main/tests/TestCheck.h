@@ -0,0 +1,32 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks for the standalone tests. A failed check is reported and the test carries on,
+// TEST_RESULT() is the exit code.
+
+inline int g_testFailures = 0;
+
+#define CHECK(expr) \
+	do { \
+		if (!(expr)) { \
+			std::fprintf(stderr, "%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #expr); \
+			++g_testFailures; \
+		} \
+	} while (0)
+
+#define TEST_RESULT() (std::printf("%s\n", g_testFailures == 0 ? "passed" : "FAILED"), g_testFailures == 0 ? 0 : 1)
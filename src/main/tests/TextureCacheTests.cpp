@@ -0,0 +1,149 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "TestCheck.h"
+#include "TextureCache.h"
+
+using namespace mq;
+using namespace std::chrono_literals;
+
+struct FakeTexture
+{
+	bool loading = false;
+	bool valid = true;
+
+	bool IsLoading() const { return loading; }
+	bool IsValid() const { return valid; }
+};
+
+using Cache = TextureCache<FakeTexture>;
+
+static void TestSharedByFilename()
+{
+	Cache cache;
+	auto now = Cache::clock::now();
+
+	auto texture = std::make_shared<FakeTexture>();
+	cache.Add("Icons/Sword.png", texture, now);
+
+	Cache::Entry* entry = cache.Find("icons/sword.PNG", now);
+	CHECK(entry != nullptr);
+	CHECK(entry && entry->texture == texture);
+	CHECK(cache.Get("ICONS/SWORD.PNG") == texture.get());
+	CHECK(cache.Find("icons/shield.png", now) == nullptr);
+}
+
+static void TestEviction()
+{
+	Cache cache;
+	auto now = Cache::clock::now();
+
+	auto held = std::make_shared<FakeTexture>();
+	cache.Add("held.png", held, now);
+	cache.Add("dropped.png", std::make_shared<FakeTexture>(), now);
+	cache.Add("raw.png", std::make_shared<FakeTexture>(), now);
+	cache.Find("raw.png", now)->rawRefs = 1;
+
+	auto loading = std::make_shared<FakeTexture>();
+	loading->loading = true;
+	cache.Add("loading.png", loading, now);
+	loading.reset();
+
+	// nothing goes before the evict time
+	cache.Evict(now + Cache::EvictTime / 2);
+	CHECK(cache.size() == 4);
+
+	// only the texture that nothing references is evicted
+	cache.Evict(now + Cache::EvictTime + 1s);
+	CHECK(cache.Get("dropped.png") == nullptr);
+	CHECK(cache.Get("held.png") == held.get());
+	CHECK(cache.Get("raw.png") != nullptr);
+	CHECK(cache.Get("loading.png") != nullptr);
+
+	// a lookup keeps a texture alive
+	held.reset();
+	auto later = now + Cache::EvictTime + 1s;
+	CHECK(cache.Find("held.png", later + Cache::EvictTime - 1s) != nullptr);
+	cache.Evict(later + Cache::EvictTime + 1s);
+	CHECK(cache.Get("held.png") != nullptr);
+	cache.Evict(later + Cache::EvictTime * 3);
+	CHECK(cache.Get("held.png") == nullptr);
+
+	// releasing the last raw reference lets it go
+	FakeTexture* raw = cache.Get("raw.png");
+	cache.Release("raw.png", raw, false);
+	CHECK(cache.Find("raw.png", later)->rawRefs == 0);
+	cache.Evict(later + Cache::EvictTime * 3);
+	CHECK(cache.Get("raw.png") == nullptr);
+}
+
+static void TestFailedLoadsAreRetried()
+{
+	Cache cache;
+	auto now = Cache::clock::now();
+
+	cache.Add("missing.png", nullptr, now);
+
+	// polling a failed load every frame must not keep it cached
+	auto time = now;
+	for (int frame = 0; frame < 100 && time - now < Cache::RetryTime; ++frame, time += 16ms)
+	{
+		Cache::Entry* entry = cache.Find("missing.png", time);
+		CHECK(entry != nullptr);
+		CHECK(entry && !entry->texture);
+	}
+
+	CHECK(cache.Find("missing.png", now + Cache::RetryTime) == nullptr);
+	CHECK(cache.size() == 0);
+
+	// a texture that finished loading but isn't valid is a failed load too
+	auto invalid = std::make_shared<FakeTexture>();
+	invalid->valid = false;
+	cache.Add("broken.png", invalid, now);
+	CHECK(cache.Find("broken.png", now + 1s) != nullptr);
+	cache.Evict(now + Cache::RetryTime);
+	CHECK(cache.size() == 0);
+
+	// but not while it is still loading
+	auto loading = std::make_shared<FakeTexture>();
+	loading->loading = true;
+	loading->valid = false;
+	cache.Add("loading.png", loading, now);
+	CHECK(cache.Find("loading.png", now + Cache::RetryTime * 2) != nullptr);
+}
+
+static void TestClear()
+{
+	Cache cache;
+	auto now = Cache::clock::now();
+
+	cache.Add("a.png", std::make_shared<FakeTexture>(), now);
+	cache.Add("b.png", std::make_shared<FakeTexture>(), now).rawRefs = 1;
+	cache.Clear();
+	CHECK(cache.size() == 1);
+
+	// after shutdown the last raw reference removes the entry
+	cache.Release("b.png", cache.Get("b.png"), true);
+	CHECK(cache.size() == 0);
+}
+
+int main()
+{
+	TestSharedByFilename();
+	TestEviction();
+	TestFailedLoadsAreRetried();
+	TestClear();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,154 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "TestCheck.h"
+#include "TextureDecoder.h"
+
+#include <atomic>
+#include <chrono>
+
+using namespace mq;
+using namespace std::chrono_literals;
+
+// Decodes "<width>x<height>" into a solid image, anything else fails.
+static bool FakeDecode(const std::string& filename, DecodedImage& image)
+{
+	int width = 0, height = 0;
+	if (std::sscanf(filename.c_str(), "%dx%d", &width, &height) != 2)
+	{
+		image.width = 1; // should be cleared for failed decodes
+		return false;
+	}
+
+	image.pixels.assign(static_cast<size_t>(width) * height * 4, 0xff);
+	image.width = width;
+	image.height = height;
+	return true;
+}
+
+// Takes count results, waiting for the worker for up to a few seconds.
+static std::vector<DecodedImage> TakeResults(TextureDecoder& decoder, size_t count)
+{
+	std::vector<DecodedImage> results;
+	auto timeout = std::chrono::steady_clock::now() + 5s;
+
+	while (results.size() < count && std::chrono::steady_clock::now() < timeout)
+	{
+		DecodedImage image;
+		if (decoder.TakeResult(image))
+			results.push_back(std::move(image));
+		else
+			std::this_thread::sleep_for(1ms);
+	}
+
+	return results;
+}
+
+static void TestDecodesInOrder()
+{
+	TextureDecoder decoder(FakeDecode);
+
+	DecodedImage image;
+	CHECK(!decoder.TakeResult(image));
+
+	decoder.Queue("16x8");
+	decoder.Queue("missing.dds");
+	decoder.Queue("2x2");
+
+	std::vector<DecodedImage> results = TakeResults(decoder, 3);
+	CHECK(results.size() == 3);
+	CHECK(decoder.GetPendingCount() == 0);
+	if (results.size() != 3)
+		return;
+
+	CHECK(results[0].filename == "16x8");
+	CHECK(results[0].decoded);
+	CHECK(results[0].width == 16 && results[0].height == 8);
+	CHECK(results[0].pixels.size() == 16 * 8 * 4);
+
+	CHECK(results[1].filename == "missing.dds");
+	CHECK(!results[1].decoded);
+	CHECK(results[1].width == 0 && results[1].pixels.empty());
+
+	CHECK(results[2].filename == "2x2");
+	CHECK(results[2].decoded);
+}
+
+static void TestDecodesOnWorkerThread()
+{
+	std::atomic<std::thread::id> decodeThread;
+
+	TextureDecoder decoder([&](const std::string& filename, DecodedImage& image)
+		{
+			decodeThread = std::this_thread::get_id();
+			return FakeDecode(filename, image);
+		});
+
+	decoder.Queue("1x1");
+	CHECK(TakeResults(decoder, 1).size() == 1);
+	CHECK(decodeThread.load() != std::thread::id());
+	CHECK(decodeThread.load() != std::this_thread::get_id());
+}
+
+static void TestStopDropsPendingWork()
+{
+	std::atomic<int> decoded = 0;
+
+	TextureDecoder decoder([&](const std::string& filename, DecodedImage& image)
+		{
+			std::this_thread::sleep_for(1ms);
+			++decoded;
+			return FakeDecode(filename, image);
+		});
+
+	for (int i = 0; i < 100; ++i)
+		decoder.Queue("4x4");
+
+	decoder.Stop();
+	CHECK(decoded < 100);
+	CHECK(decoder.GetPendingCount() == 0);
+
+	DecodedImage image;
+	CHECK(!decoder.TakeResult(image));
+
+	// Queueing again starts a new worker
+	decoder.Queue("8x8");
+	std::vector<DecodedImage> results = TakeResults(decoder, 1);
+	CHECK(results.size() == 1 && results[0].width == 8);
+}
+
+static void TestDestroyWithPendingWork()
+{
+	auto decoder = std::make_unique<TextureDecoder>([](const std::string& filename, DecodedImage& image)
+		{
+			std::this_thread::sleep_for(1ms);
+			return FakeDecode(filename, image);
+		});
+
+	for (int i = 0; i < 50; ++i)
+		decoder->Queue("32x32");
+
+	// Must join the worker without decoding everything that is left
+	decoder.reset();
+}
+
+int main()
+{
+	TestDecodesInOrder();
+	TestDecodesOnWorkerThread();
+	TestStopDropsPendingWork();
+	TestDestroyWithPendingWork();
+
+	return TEST_RESULT();
+}
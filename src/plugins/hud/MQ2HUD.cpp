@@ -17,7 +17,10 @@
 
 #include <mq/Plugin.h>
 
+#include <chrono>
+#include <filesystem>
 #include <mutex>
+#include <unordered_map>
 
 PreSetup("MQ2HUD");
 
@@ -40,11 +43,24 @@ struct HUDELEMENT
 	char        Text[MAX_STRING];
 	char        PreParsed[MAX_STRING];
 
+	std::string Name;                             // section and key the element was loaded from
+	int         Refresh = 1;                      // frames between two parses of the text
+	int         Phase = 0;                        // spreads the elements with the same refresh over different frames
+	bool        Static = false;                   // no ${} in the text, PreParsed is set once when loaded
+	std::vector<std::string> MacroNames;          // names that must exist before a macro element is parsed
+
+	// stats for /hudstats
+	uint32_t    ParseCount = 0;
+	std::chrono::microseconds LastParse{ 0 };
+	std::chrono::microseconds MaxParse{ 0 };
+	std::chrono::microseconds TotalParse{ 0 };
+
 	HUDELEMENT* pNext;
 };
 HUDELEMENT* pHud = nullptr;
 
 struct _stat LastRead;
+HANDLE hINIChange = INVALID_HANDLE_VALUE;
 char HUDNames[MAX_STRING] = "Elements";
 char HUDSection[MAX_STRING] = "MQ2HUD";
 int SkipParse = 1;
@@ -54,8 +70,14 @@ bool bClassHUD = true;
 bool bZoneHUD = true;
 bool bUseFontSize = false;
 bool bEQHasFocus = true;
+bool bShowStats = false;
+uint32_t HUDFrame = 0;
+std::chrono::microseconds LastFrameParse{ 0 };
+std::chrono::microseconds MaxFrameParse{ 0 };
 std::recursive_mutex s_mutex;
 
+bool ParseMacroLine(char* szOriginal, size_t BufferSize, std::list<std::string>& out);
+
 bool Stat(const char* Filename, struct _stat& Dest)
 {
 	int client = 0;
@@ -67,6 +89,30 @@ bool Stat(const char* Filename, struct _stat& Dest)
 	return true;
 }
 
+void WatchINI()
+{
+	if (hINIChange != INVALID_HANDLE_VALUE)
+	{
+		FindCloseChangeNotification(hINIChange);
+		hINIChange = INVALID_HANDLE_VALUE;
+	}
+
+	// Only directories can be watched, the notification is checked against the mtime of the ini.
+	std::error_code ec;
+	std::filesystem::path path = std::filesystem::absolute(INIFileName, ec).parent_path();
+	hINIChange = FindFirstChangeNotificationW(path.c_str(), FALSE,
+		FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+}
+
+void UnwatchINI()
+{
+	if (hINIChange != INVALID_HANDLE_VALUE)
+	{
+		FindCloseChangeNotification(hINIChange);
+		hINIChange = INVALID_HANDLE_VALUE;
+	}
+}
+
 void ClearElements()
 {
 	std::scoped_lock lock(s_mutex);
@@ -79,23 +125,29 @@ void ClearElements()
 	}
 }
 
-void AddElement(char* IniString)
+void AddElement(const char* Section, const char* Key, char* IniString)
 {
 	std::scoped_lock lock(s_mutex);
 
 	int X = 0;
 	int Y = 0;
 	int Type = 0;  // FIXME: What is a sane default value for Type?
+	int Refresh = SkipParse;
 	ARGBCOLOR Color;
 	Color.A = 0xFF;
 
-	// x,y,color,string
+	// type[:refresh],x,y,color,string
 	int Size = 0;
 
 	char* pComma = strchr(IniString, ',');
 	if (!pComma)
 		return;
 	*pComma = 0;
+	if (char* pColon = strchr(IniString, ':'))
+	{
+		*pColon = 0;
+		Refresh = std::max(GetIntFromString(&pColon[1], SkipParse), 1);
+	}
 	Type = GetIntFromString(IniString, Type);
 	IniString = &pComma[1];
 
@@ -166,6 +218,25 @@ void AddElement(char* IniString)
 	strcpy_s(pElement->Text, IniString);
 	ZeroMemory(pElement->PreParsed, sizeof(pElement->PreParsed));
 	pElement->Size = Size;
+	pElement->Name = fmt::format("{}:{}", Section, Key);
+	pElement->Refresh = Refresh;
+
+	// Compile the element: text without ${} never changes, and the names a macro element depends
+	// on are found once here instead of every time it is parsed.
+	if (!strstr(pElement->Text, "${"))
+	{
+		pElement->Static = true;
+		strcpy_s(pElement->PreParsed, pElement->Text);
+	}
+	else if (pElement->Type & HUDTYPE_MACRO)
+	{
+		char szTemp[MAX_STRING] = { 0 };
+		strcpy_s(szTemp, pElement->Text);
+
+		std::list<std::string> out;
+		ParseMacroLine(szTemp, MAX_STRING, out);
+		pElement->MacroNames.assign(out.begin(), out.end());
+	}
 
 	DebugSpew("New element '%s' in color %X", pElement->Text, pElement->Color);
 }
@@ -191,7 +262,7 @@ void LoadElements()
 		while (pElementList[0] != 0) {
 			GetPrivateProfileString(CurrentHUD, pElementList, "", szBuffer, MAX_STRING, INIFileName);
 			if (szBuffer[0] != 0) {
-				AddElement(szBuffer);
+				AddElement(CurrentHUD, pElementList, szBuffer);
 			}
 			pElementList += strlen(pElementList) + 1;
 		}
@@ -214,7 +285,7 @@ void LoadElements()
 
 					if (szBuffer[0] != 0)
 					{
-						AddElement(szBuffer);
+						AddElement(ClassDesc, pElementList, szBuffer);
 					}
 
 					pElementList += strlen(pElementList) + 1;
@@ -234,7 +305,7 @@ void LoadElements()
 
 				if (szBuffer[0] != 0)
 				{
-					AddElement(szBuffer);
+					AddElement(ZoneName, pElementList, szBuffer);
 				}
 
 				pElementList += strlen(pElementList) + 1;
@@ -242,6 +313,20 @@ void LoadElements()
 		}
 	}
 
+	// Give the elements sharing a refresh interval consecutive phases, so that a big HUD parses
+	// a few elements every frame instead of all of them every Nth frame.
+	std::unordered_map<int, int> phases;
+	for (HUDELEMENT* pElement = pHud; pElement; pElement = pElement->pNext)
+	{
+		if (!pElement->Static)
+		{
+			pElement->Phase = phases[pElement->Refresh]++ % pElement->Refresh;
+		}
+	}
+
+	LastFrameParse = {};
+	MaxFrameParse = {};
+
 	if (!Stat(INIFileName, LastRead))
 	{
 		ZeroMemory(&LastRead, sizeof(struct _stat));
@@ -410,6 +495,38 @@ void ZoneHUD(SPAWNINFO* pChar, char* szLine)
 	HandleINI();
 }
 
+void ResetStats()
+{
+	std::scoped_lock lock(s_mutex);
+
+	for (HUDELEMENT* pElement = pHud; pElement; pElement = pElement->pNext)
+	{
+		pElement->ParseCount = 0;
+		pElement->LastParse = {};
+		pElement->MaxParse = {};
+		pElement->TotalParse = {};
+	}
+
+	MaxFrameParse = {};
+}
+
+void HUDStats(SPAWNINFO* pChar, char* szLine)
+{
+	if (!_stricmp(szLine, "reset"))
+	{
+		ResetStats();
+		WriteChatColor("MQ2HUD::Stats reset");
+	}
+	else if (szLine[0] == 0)
+	{
+		bShowStats = !bShowStats;
+	}
+	else
+	{
+		WriteChatColor("Usage: /hudstats [reset]");
+	}
+}
+
 bool dataHUD(const char* szIndex, MQTypeVar& Ret)
 {
 	Ret.Ptr = HUDNames;
@@ -421,6 +538,7 @@ PLUGIN_API void InitializePlugin()
 {
 	GetPrivateProfileString(HUDSection, "Last", "Elements", HUDNames, MAX_STRING, INIFileName);
 	HandleINI();
+	WatchINI();
 
 	AddCommand("/defaulthud", DefaultHUD);
 	AddCommand("/loadhud", LoadHUD);
@@ -428,12 +546,14 @@ PLUGIN_API void InitializePlugin()
 	AddCommand("/backgroundhud", BackgroundHUD);
 	AddCommand("/classhud", ClassHUD);
 	AddCommand("/zonehud", ZoneHUD);
+	AddCommand("/hudstats", HUDStats);
 	AddMQ2Data("HUD", dataHUD);
 }
 
 PLUGIN_API void ShutdownPlugin()
 {
 	ClearElements();
+	UnwatchINI();
 
 	RemoveCommand("/loadhud");
 	RemoveCommand("/unloadhud");
@@ -441,6 +561,7 @@ PLUGIN_API void ShutdownPlugin()
 	RemoveCommand("/backgroundhud");
 	RemoveCommand("/classhud");
 	RemoveCommand("/zonehud");
+	RemoveCommand("/hudstats");
 	RemoveMQ2Data("HUD");
 }
 
@@ -572,12 +693,48 @@ bool ParseMacroLine(char* szOriginal, size_t BufferSize, std::list<std::string>&
 	return Changed;
 }
 
+void ParseElement(HUDELEMENT* pElement)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	bool bOkToCheck = true;
+	strcpy_s(pElement->PreParsed, pElement->Text);
+
+	if (pElement->Type & HUDTYPE_MACRO && gRunning)
+	{
+		// each name must be a tlo or a variable of the running macro
+		for (const std::string& name : pElement->MacroNames)
+		{
+			if (!FindTopLevelObject(name.c_str()) && !IsMacroVariable(name.c_str()))
+			{
+				bOkToCheck = false;
+				break;
+			}
+		}
+	}
+
+	if (bOkToCheck)
+	{
+		ParseMacroParameter(pElement->PreParsed);
+	}
+	else
+	{
+		pElement->PreParsed[0] = '\0';
+	}
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	pElement->ParseCount++;
+	pElement->LastParse = elapsed;
+	pElement->MaxParse = std::max(pElement->MaxParse, elapsed);
+	pElement->TotalParse += elapsed;
+	LastFrameParse += elapsed;
+}
+
 // Called every frame that the "HUD" is drawn -- e.g. net status / packet loss bar
 PLUGIN_API void OnDrawHUD()
 {
 	std::scoped_lock lock(s_mutex);
 
-	static bool bOkToCheck = true;
 	static int FrameCount = 0;
 	char szBuffer[MAX_STRING] = { 0 };
 
@@ -585,8 +742,17 @@ PLUGIN_API void OnDrawHUD()
 	{
 		FrameCount = 0;
 
+		// the ini is only looked at when something was written in its directory
+		bool bChanged = true;
+		if (hINIChange != INVALID_HANDLE_VALUE)
+		{
+			bChanged = WaitForSingleObject(hINIChange, 0) == WAIT_OBJECT_0;
+			if (bChanged)
+				FindNextChangeNotification(hINIChange);
+		}
+
 		struct _stat now;
-		if (Stat(INIFileName, now) && now.st_mtime != LastRead.st_mtime)
+		if (bChanged && Stat(INIFileName, now) && now.st_mtime != LastRead.st_mtime)
 			LoadElements();
 
 		// check for EQ in foreground
@@ -606,7 +772,8 @@ PLUGIN_API void OnDrawHUD()
 	}
 
 	HUDELEMENT* pElement = pHud;
-	bool bCheckParse = !(FrameCount % SkipParse);
+	++HUDFrame;
+	LastFrameParse = {};
 
 	DWORD X, Y;
 	while (pElement)
@@ -627,60 +794,9 @@ PLUGIN_API void OnDrawHUD()
 				Y = SX + pElement->Y;
 			}
 
-			if (bCheckParse)
+			if (!pElement->Static && (HUDFrame + pElement->Phase) % pElement->Refresh == 0)
 			{
-				bOkToCheck = true;
-				strcpy_s(pElement->PreParsed, pElement->Text);
-
-				if (pElement->Type & HUDTYPE_MACRO)
-				{
-					if (gRunning)
-					{
-						char szTemp[MAX_STRING] = { 0 };
-						strcpy_s(szTemp, pElement->Text);
-
-						std::list<std::string> out;
-						ParseMacroLine(szTemp, MAX_STRING, out);
-
-						for (auto& line : out)
-						{
-							bOkToCheck = false;
-							const char* pChar = line.c_str();
-
-							if (FindTopLevelObject(pChar))
-							{
-								bOkToCheck = true;
-								continue;
-							}
-
-							if (!bOkToCheck)
-							{
-								// ok fine we didn't find it in the tlo map...
-								// lets check variables
-								if (IsMacroVariable(pChar))
-								{
-									bOkToCheck = true;
-									continue;
-								}
-							}
-
-							if (!bOkToCheck)
-							{
-								// still not found...
-								break;
-							}
-						}
-					}
-				}
-
-				if (bOkToCheck)
-				{
-					ParseMacroParameter(pElement->PreParsed);
-				}
-				else
-				{
-					pElement->PreParsed[0] = '\0';
-				}
+				ParseElement(pElement);
 			}
 
 			strcpy_s(szBuffer, pElement->PreParsed);
@@ -692,4 +808,66 @@ PLUGIN_API void OnDrawHUD()
 
 		pElement = pElement->pNext;
 	}
+
+	MaxFrameParse = std::max(MaxFrameParse, LastFrameParse);
+}
+
+PLUGIN_API void OnUpdateImGui()
+{
+	if (!bShowStats)
+		return;
+
+	ImGui::SetNextWindowSize(ImVec2(600, 300), ImGuiCond_FirstUseEver);
+	if (ImGui::Begin("HUD Stats", &bShowStats, ImGuiWindowFlags_None))
+	{
+		std::scoped_lock lock(s_mutex);
+
+		ImGui::Text("Parse time last frame: %lld us, worst frame: %lld us", LastFrameParse.count(), MaxFrameParse.count());
+		ImGui::SameLine();
+		if (ImGui::SmallButton("Reset"))
+		{
+			ResetStats();
+		}
+
+		if (ImGui::BeginTable("##HUDStats", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY))
+		{
+			ImGui::TableSetupScrollFreeze(0, 1);
+			ImGui::TableSetupColumn("Element");
+			ImGui::TableSetupColumn("Refresh");
+			ImGui::TableSetupColumn("Parses");
+			ImGui::TableSetupColumn("Last (us)");
+			ImGui::TableSetupColumn("Avg (us)");
+			ImGui::TableSetupColumn("Max (us)");
+			ImGui::TableHeadersRow();
+
+			for (HUDELEMENT* pElement = pHud; pElement; pElement = pElement->pNext)
+			{
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(pElement->Name.c_str());
+				if (ImGui::IsItemHovered())
+				{
+					ImGui::SetTooltip("%s", pElement->Text);
+				}
+
+				ImGui::TableNextColumn();
+				if (pElement->Static)
+					ImGui::TextUnformatted("static");
+				else
+					ImGui::Text("%d", pElement->Refresh);
+
+				ImGui::TableNextColumn();
+				ImGui::Text("%u", pElement->ParseCount);
+				ImGui::TableNextColumn();
+				ImGui::Text("%lld", pElement->LastParse.count());
+				ImGui::TableNextColumn();
+				ImGui::Text("%lld", pElement->ParseCount ? pElement->TotalParse.count() / pElement->ParseCount : 0);
+				ImGui::TableNextColumn();
+				ImGui::Text("%lld", pElement->MaxParse.count());
+			}
+
+			ImGui::EndTable();
+		}
+	}
+	ImGui::End();
 }
@@ -0,0 +1,163 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <lua.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace mq::lua {
+
+struct LuaMemoryStats
+{
+	size_t liveBytes = 0;
+	size_t peakBytes = 0;
+	uint64_t allocations = 0;                       // blocks allocated, not counting reallocations
+	uint64_t allocatedBytes = 0;                    // total bytes requested, including growth from reallocations
+	double allocationRate = 0.0;                    // bytes per second over the last sample period
+};
+
+enum class LuaMemoryLimit
+{
+	None,
+	Soft,                                           // live bytes are over the soft limit
+	Hard,                                           // an allocation was refused because of the hard limit
+};
+
+//----------------------------------------------------------------------------
+// Wraps the allocator of a lua state to keep track of how much memory the state holds.
+//
+// The allocator the state was created with is kept and every call is forwarded to it, so
+// this works with whatever allocator the lua build uses (luajit only allows its own on
+// 64-bit builds). An allocation that would take the state over the hard limit is refused,
+// which raises a "not enough memory" error in the script. Only the first one is refused:
+// after that the state is allowed to allocate so that it can report the error and clean up,
+// and it is up to the owner to end the script. The soft limit is never enforced here, the
+// owner checks it between time slices.
+
+class LuaAllocator
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	LuaAllocator() = default;
+	LuaAllocator(const LuaAllocator&) = delete;
+	LuaAllocator& operator=(const LuaAllocator&) = delete;
+
+	// Installs the allocator on L. Memory that the state already holds is counted as live.
+	void Attach(lua_State* L)
+	{
+		m_alloc = lua_getallocf(L, &m_allocUserData);
+		m_stats = LuaMemoryStats();
+		m_stats.liveBytes = static_cast<size_t>(lua_gc(L, LUA_GCCOUNT, 0)) * 1024
+			+ static_cast<size_t>(lua_gc(L, LUA_GCCOUNTB, 0));
+		m_stats.peakBytes = m_stats.liveBytes;
+		m_sampleTime = clock::now();
+		m_sampleBytes = 0;
+		m_hardLimitHit = false;
+
+		lua_setallocf(L, &LuaAllocator::Alloc, this);
+	}
+
+	// Limits are in bytes, zero for no limit.
+	void SetLimits(size_t softLimit, size_t hardLimit)
+	{
+		m_softLimit = softLimit;
+		m_hardLimit = hardLimit;
+	}
+
+	size_t GetSoftLimit() const { return m_softLimit; }
+	size_t GetHardLimit() const { return m_hardLimit; }
+
+	LuaMemoryLimit CheckLimits() const
+	{
+		if (m_hardLimitHit)
+			return LuaMemoryLimit::Hard;
+
+		if (m_softLimit != 0 && m_stats.liveBytes > m_softLimit)
+			return LuaMemoryLimit::Soft;
+
+		return LuaMemoryLimit::None;
+	}
+
+	// Updates the allocation rate. The rate is only recalculated once the sample period has
+	// passed, so this can be called every pulse.
+	void Sample(clock::time_point now = clock::now(), clock::duration period = std::chrono::seconds(1))
+	{
+		const clock::duration elapsed = now - m_sampleTime;
+		if (elapsed < period)
+			return;
+
+		const double seconds = std::chrono::duration<double>(elapsed).count();
+		m_stats.allocationRate = static_cast<double>(m_stats.allocatedBytes - m_sampleBytes) / seconds;
+		m_sampleBytes = m_stats.allocatedBytes;
+		m_sampleTime = now;
+	}
+
+	const LuaMemoryStats& GetStats() const { return m_stats; }
+
+	static void* Alloc(void* ud, void* ptr, size_t osize, size_t nsize)
+	{
+		LuaAllocator* self = static_cast<LuaAllocator*>(ud);
+
+		// osize is only the size of the block when there is a block (5.4 puts the object type in it)
+		const size_t oldSize = ptr != nullptr ? osize : 0;
+		LuaMemoryStats& stats = self->m_stats;
+
+		if (nsize > oldSize
+			&& self->m_hardLimit != 0
+			&& !self->m_hardLimitHit
+			&& stats.liveBytes - oldSize + nsize > self->m_hardLimit)
+		{
+			self->m_hardLimitHit = true;
+			return nullptr;
+		}
+
+		void* result = self->m_alloc(self->m_allocUserData, ptr, osize, nsize);
+
+		// a failed allocation leaves the old block alone. Freeing and shrinking never fail.
+		if (result == nullptr && nsize != 0)
+			return nullptr;
+
+		stats.liveBytes = (stats.liveBytes > oldSize ? stats.liveBytes - oldSize : 0) + nsize;
+		if (stats.liveBytes > stats.peakBytes)
+			stats.peakBytes = stats.liveBytes;
+
+		if (nsize > oldSize)
+		{
+			stats.allocatedBytes += nsize - oldSize;
+			if (ptr == nullptr)
+				++stats.allocations;
+		}
+
+		return result;
+	}
+
+private:
+	lua_Alloc m_alloc = nullptr;
+	void* m_allocUserData = nullptr;
+
+	LuaMemoryStats m_stats;
+	size_t m_softLimit = 0;
+	size_t m_hardLimit = 0;
+	bool m_hardLimitHit = false;
+
+	clock::time_point m_sampleTime;
+	uint64_t m_sampleBytes = 0;
+};
+
+} // namespace mq::lua
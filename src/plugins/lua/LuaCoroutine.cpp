@@ -20,6 +20,8 @@
 
 namespace mq::lua {
 
+LuaDelayStats luaDelayStats;
+
 template <typename T>
 CoroutineResult Run(const std::vector<T>& args, LuaCoroutine* co)
 {
@@ -53,6 +55,11 @@ CoroutineResult LuaCoroutine::RunCoroutine(const std::vector<std::string>& args)
 	return Run(args, this);
 }
 
+CoroutineResult LuaCoroutine::RunCoroutine(const std::vector<std::string_view>& args)
+{
+	return Run(args, this);
+}
+
 CoroutineResult LuaCoroutine::RunCoroutine(const std::vector<sol::object>& args)
 {
 	return Run(args, this);
@@ -70,30 +77,34 @@ std::shared_ptr<LuaCoroutine> LuaCoroutine::Create(sol::thread& thread, LuaThrea
 	return co_ptr;
 }
 
-bool LuaCoroutine::CheckCondition(std::optional<sol::function>& func)
+bool LuaCoroutine::CheckCondition()
 {
-	if (!func)
+	if (!m_delayCondition)
 		return false;
 
+	++luaDelayStats.conditionChecks;
+
 	try
 	{
-		auto check_thread = sol::thread::create(thread.state());
-		sol::function check(check_thread.state(), *func);
-		return check();
+		return m_checkFunction();
 	}
 	catch (sol::error& ex)
 	{
 		LuaError("Failed to check delay condition check with error '%s'", ex.what());
-		func = std::nullopt;
+		++luaDelayStats.conditionErrors;
+
+		// don't trust the state of the check thread after an error, the next condition gets a new one
+		m_delayCondition = std::nullopt;
+		m_delay.DropCondition();
+		m_checkFunction = sol::function();
+		m_checkThread = sol::thread();
 	}
 
 	return false;
 }
 
-void LuaCoroutine::Delay(sol::object delayObj, std::optional<sol::object> conditionObj, sol::state_view s)
+static std::optional<int64_t> GetDelayMilliseconds(const sol::object& delayObj, sol::state_view s)
 {
-	using namespace std::chrono_literals;
-
 	auto delay_int = delayObj.as<std::optional<const int64_t>>();
 	if (!delay_int)
 	{
@@ -117,11 +128,19 @@ void LuaCoroutine::Delay(sol::object delayObj, std::optional<sol::object> condit
 			else
 			{
 				luaL_error(s, "Units are required when passing delay as a string.");
-				return;
+				return std::nullopt;
 			}
 		}
 	}
 
+	return delay_int;
+}
+
+void LuaCoroutine::Delay(sol::object delayObj, std::optional<sol::object> conditionObj, std::optional<sol::object> intervalObj, sol::state_view s)
+{
+	using namespace std::chrono_literals;
+
+	auto delay_int = GetDelayMilliseconds(delayObj, s);
 	if (delay_int.has_value())
 	{
 		uint64_t delay_ms = std::max(0ms, std::chrono::milliseconds(*delay_int)).count();
@@ -129,7 +148,20 @@ void LuaCoroutine::Delay(sol::object delayObj, std::optional<sol::object> condit
 		if (conditionObj)
 			condition = conditionObj->as<std::optional<sol::function>>();
 
-		SetDelay(delay_ms + MQGetTickCount64(), condition);
+		uint64_t interval_ms = 0L;
+		if (condition && intervalObj && intervalObj->get_type() != sol::type::lua_nil)
+		{
+			auto interval_int = GetDelayMilliseconds(*intervalObj, s);
+			if (!interval_int.has_value())
+			{
+				luaL_error(s, "Invalid condition interval passed to mq.delay");
+				return;
+			}
+
+			interval_ms = std::max(0ms, std::chrono::milliseconds(*interval_int)).count();
+		}
+
+		SetDelay(delay_ms + MQGetTickCount64(), condition, interval_ms);
 	}
 	else
 	{
@@ -137,24 +169,55 @@ void LuaCoroutine::Delay(sol::object delayObj, std::optional<sol::object> condit
 	}
 }
 
-void LuaCoroutine::SetDelay(uint64_t time, std::optional<sol::function> condition /* = std::nullopt */)
+void LuaCoroutine::SetDelay(uint64_t time, std::optional<sol::function> condition /* = std::nullopt */, uint64_t interval /* = 0L */)
 {
 	if (luaThread == nullptr)
 		return;
 
-	if (time > MQGetTickCount64() && !CheckCondition(condition))
+	const uint64_t now = MQGetTickCount64();
+	if (time <= now)
+		return;
+
+	m_delayCondition = std::move(condition);
+	m_delay.Set(now, time, m_delayCondition.has_value(), interval);
+
+	if (m_delayCondition)
 	{
-		luaThread->DoYield();
-		//lua_yield(coroutine.lua_state(), 0); // only yield from the current coroutine
-		m_delayTime = time;
-		m_delayCondition = condition;
+		if (!m_checkThread.valid())
+		{
+			m_checkThread = sol::thread::create(thread.state());
+			++luaDelayStats.checkThreads;
+		}
+
+		m_checkFunction = sol::function(m_checkThread.state(), *m_delayCondition);
+
+		if (CheckCondition())
+		{
+			ClearDelay();
+			return;
+		}
 	}
+
+	luaThread->DoYield();
+	//lua_yield(coroutine.lua_state(), 0); // only yield from the current coroutine
+
+	++luaDelayStats.delays;
+	if (m_delayCondition)
+		++luaDelayStats.conditionDelays;
 }
 
 void LuaCoroutine::ClearDelay()
 {
-	m_delayTime = 0L;
+	m_delay.Clear();
 	m_delayCondition = std::nullopt;
+
+	// let go of the condition, but keep the thread it ran on for the next one
+	m_checkFunction = sol::function();
+}
+
+uint64_t LuaCoroutine::GetWakeTime() const
+{
+	return m_delay.GetWakeTime();
 }
 
 bool LuaCoroutine::ShouldRun()
@@ -165,13 +228,27 @@ bool LuaCoroutine::ShouldRun()
 	}
 
 	// check delayed status
-	if (m_delayTime <= MQGetTickCount64() || CheckCondition(m_delayCondition))
+	switch (m_delay.Update(MQGetTickCount64()))
 	{
+	case LuaDelaySchedule::Poll::Expired:
 		ClearDelay();
 		return true;
-	}
 
-	return false;
+	case LuaDelaySchedule::Poll::CheckCondition:
+		if (CheckCondition())
+		{
+			ClearDelay();
+			return true;
+		}
+		return false;
+
+	case LuaDelaySchedule::Poll::Skipped:
+		++luaDelayStats.conditionsSkipped;
+		return false;
+
+	default:
+		return false;
+	}
 }
 
 } // namespace mq::lua
@@ -15,6 +15,7 @@
 #pragma once
 
 #include "LuaCommon.h"
+#include "LuaDelaySchedule.h"
 
 #include <sol/sol.hpp>
 
@@ -22,23 +23,52 @@ namespace mq::lua {
 
 class LuaThread;
 
+// Counters for mq.delay, shared by all scripts. Shown by /lua delays.
+struct LuaDelayStats
+{
+	uint64_t delays = 0;              // calls to mq.delay that yielded
+	uint64_t conditionDelays = 0;     // ... of which had a condition
+	uint64_t conditionChecks = 0;     // times a condition function was called
+	uint64_t conditionsSkipped = 0;   // checks skipped because the condition interval hadn't passed
+	uint64_t conditionErrors = 0;     // condition functions that raised an error
+	uint64_t checkThreads = 0;        // lua threads created to run condition checks
+	uint64_t pulsesSlept = 0;         // pulses a script was not run because it was waiting on a delay
+	uint64_t wakes = 0;               // scripts taken out of the wait queue
+
+	void Reset() { *this = LuaDelayStats(); }
+};
+
+extern LuaDelayStats luaDelayStats;
+
 struct LuaCoroutine
 {
 	LuaThread* luaThread;
 
 	sol::coroutine coroutine;
 	sol::thread thread;
-	uint64_t m_delayTime = 0L;
 	std::optional<sol::function> m_delayCondition = std::nullopt;
 
-	bool CheckCondition(std::optional<sol::function>& func);
-	void Delay(sol::object delayObj, std::optional<sol::object> conditionObj, sol::state_view s);
-	void SetDelay(uint64_t time, std::optional<sol::function> condition = std::nullopt);
+	// When the delay expires, and how often the condition is checked
+	LuaDelaySchedule m_delay;
+
+	// Conditions can't be called on the coroutine while it is suspended, so they run on a separate
+	// thread. The thread is kept and reused for every check made by this coroutine.
+	sol::thread m_checkThread;
+	sol::function m_checkFunction;
+
+	bool CheckCondition();
+	void Delay(sol::object delayObj, std::optional<sol::object> conditionObj, std::optional<sol::object> intervalObj, sol::state_view s);
+	void SetDelay(uint64_t time, std::optional<sol::function> condition = std::nullopt, uint64_t interval = 0L);
 	void ClearDelay();
 
+	// The tick at which this coroutine next needs attention: when the delay expires, or when the
+	// condition is next due to be checked. Returns 0 if the coroutine isn't delayed.
+	uint64_t GetWakeTime() const;
+
 	bool ShouldRun();
 	CoroutineResult RunCoroutine();
 	CoroutineResult RunCoroutine(const std::vector<std::string>& args);
+	CoroutineResult RunCoroutine(const std::vector<std::string_view>& args);
 	CoroutineResult RunCoroutine(const std::vector<sol::object>& args);
 	static std::shared_ptr<LuaCoroutine> Create(sol::thread& thread, LuaThread* luaThread);
 
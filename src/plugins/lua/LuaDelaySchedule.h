@@ -0,0 +1,158 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <vector>
+
+namespace mq::lua {
+
+//----------------------------------------------------------------------------
+// When a coroutine waiting on mq.delay needs attention. Times are ticks in milliseconds.
+//
+// A delay can have a condition that ends it early. The condition is checked at most once every
+// interval, an interval of 0 checks it every frame. This only decides when the condition is due,
+// the coroutine runs it.
+
+class LuaDelaySchedule
+{
+public:
+	enum class Poll
+	{
+		Waiting,                                    // nothing to do yet
+		Expired,                                    // the delay is over, the delay was cleared
+		CheckCondition,                             // the condition is due to be checked
+		Skipped,                                    // the condition isn't due yet
+	};
+
+	void Set(uint64_t now, uint64_t delayTime, bool hasCondition, uint64_t interval = 0)
+	{
+		m_delayTime = delayTime;
+		m_hasCondition = hasCondition;
+		m_conditionInterval = hasCondition ? interval : 0;
+		m_nextConditionCheck = hasCondition ? now + interval : 0;
+	}
+
+	void Clear()
+	{
+		*this = LuaDelaySchedule();
+	}
+
+	// The delay keeps going until it runs out, without checking the condition again.
+	void DropCondition()
+	{
+		m_hasCondition = false;
+		m_conditionInterval = 0;
+		m_nextConditionCheck = 0;
+	}
+
+	bool IsDelayed() const { return m_delayTime != 0; }
+	bool HasCondition() const { return m_hasCondition; }
+
+	// The tick at which the coroutine next needs attention: when the delay expires, or when the
+	// condition is next due to be checked. Returns 0 if it isn't delayed.
+	uint64_t GetWakeTime() const
+	{
+		if (m_hasCondition)
+			return std::min(m_delayTime, m_nextConditionCheck);
+
+		return m_delayTime;
+	}
+
+	// Called every time the coroutine could run. When the condition is due, the next check is
+	// scheduled an interval from now.
+	Poll Update(uint64_t now)
+	{
+		if (m_delayTime <= now)
+		{
+			Clear();
+			return Poll::Expired;
+		}
+
+		if (!m_hasCondition)
+			return Poll::Waiting;
+
+		if (now < m_nextConditionCheck)
+			return Poll::Skipped;
+
+		m_nextConditionCheck = now + m_conditionInterval;
+		return Poll::CheckCondition;
+	}
+
+private:
+	uint64_t m_delayTime = 0;
+	bool m_hasCondition = false;
+	uint64_t m_conditionInterval = 0;
+	uint64_t m_nextConditionCheck = 0;
+};
+
+//----------------------------------------------------------------------------
+// Threads that are sleeping until a delay is due, ordered by the time they need to run again.
+//
+// A thread that is woken early or stopped leaves its entry behind, so an entry only counts if it
+// still matches the thread. Thread needs GetSleepUntil() and Wake().
+
+template <typename Thread>
+class LuaSleepQueue
+{
+public:
+	void Push(uint64_t wakeTime, const std::shared_ptr<Thread>& thread)
+	{
+		m_entries.push({ wakeTime, thread });
+	}
+
+	// Wakes the threads that are due at now and drops their entries, and any stale entries that
+	// are due. Returns the number of threads woken.
+	size_t WakeDue(uint64_t now)
+	{
+		size_t woken = 0;
+
+		while (!m_entries.empty() && m_entries.top().wakeTime <= now)
+		{
+			if (std::shared_ptr<Thread> thread = m_entries.top().thread.lock())
+			{
+				if (thread->GetSleepUntil() == m_entries.top().wakeTime)
+				{
+					thread->Wake();
+					++woken;
+				}
+			}
+
+			m_entries.pop();
+		}
+
+		return woken;
+	}
+
+	size_t size() const { return m_entries.size(); }
+	bool empty() const { return m_entries.empty(); }
+
+private:
+	struct Entry
+	{
+		uint64_t wakeTime;
+		std::weak_ptr<Thread> thread;
+
+		bool operator>(const Entry& other) const { return wakeTime > other.wakeTime; }
+	};
+
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<>> m_entries;
+};
+
+} // namespace mq::lua
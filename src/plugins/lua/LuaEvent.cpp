@@ -21,6 +21,15 @@
 
 namespace mq::lua {
 
+uint32_t bmLuaEventProcess = 0;
+uint32_t bmLuaEventRun = 0;
+
+// The number of finished handler functions kept for reuse, per event or bind
+static constexpr size_t MAX_POOLED_FUNCTIONS = 8;
+
+// The number of argument buffers kept for reuse
+static constexpr size_t MAX_POOLED_ARGS = 32;
+
 //============================================================================
 
 unsigned int CALLBACK LuaVarProcess(char* VarName, char* Value, size_t ValueLen)
@@ -40,6 +49,7 @@ LuaEventProcessor::LuaEventProcessor(LuaThread* thread)
 
 LuaEventProcessor::~LuaEventProcessor()
 {
+	m_functionPool.clear();
 	m_eventDefinitions.clear();
 }
 
@@ -57,6 +67,7 @@ bool LuaEventProcessor::AddEvent(std::string_view name, std::string_view express
 	}
 
 	m_eventDefinitions.push_back(std::make_unique<LuaEvent>(name, expression, function, this, *m_blech));
+	m_functionPool.emplace(m_eventDefinitions.back().get(), std::vector<std::shared_ptr<LuaEventFunction>>{});
 	return true;
 }
 
@@ -67,6 +78,7 @@ bool LuaEventProcessor::RemoveEvent(std::string_view name)
 		[&name](const std::unique_ptr<LuaEvent>& event) { return event->GetName() == name; });
 	if (it != m_eventDefinitions.end())
 	{
+		m_functionPool.erase(it->get());
 		m_eventDefinitions.erase(it);
 		return true;
 	}
@@ -89,6 +101,7 @@ bool LuaEventProcessor::AddBind(std::string_view name, const sol::function& func
 	}
 
 	m_bindDefinitions.push_back(std::make_unique<LuaBind>(bind_name, function, this));
+	m_functionPool.emplace(m_bindDefinitions.back().get(), std::vector<std::shared_ptr<LuaEventFunction>>{});
 	return true;
 }
 
@@ -103,6 +116,7 @@ bool LuaEventProcessor::RemoveBind(std::string_view name)
 
 	if (it != m_bindDefinitions.end())
 	{
+		m_functionPool.erase(it->get());
 		m_bindDefinitions.erase(it);
 		return true;
 	}
@@ -110,8 +124,10 @@ bool LuaEventProcessor::RemoveBind(std::string_view name)
 	return false;
 }
 
-void LuaEventProcessor::Process(std::string_view line) const
+void LuaEventProcessor::Process(std::string_view line)
 {
+	MQScopedBenchmark bm(bmLuaEventProcess);
+
 	if (!m_thread->IsValid())
 		return;
 	if (m_eventDefinitions.empty())
@@ -135,17 +151,15 @@ void LuaEventProcessor::Process(std::string_view line) const
 	// since we initialized to 0, we know that any remaining members will be 0, so just in case we Get an overflow, re-set the last character to 0
 	line_char[MAX_STRING - 1] = 0;
 
-	sol::state_view state = m_thread->GetState();
-
-	state["_mq_event_line"] = line_char;
+	m_currentLine = line_char;
 	m_blech->Feed(line_char);
-	state["_mq_event_line"] = sol::lua_nil;
+	m_currentLine = {};
 }
 
-static void loop_and_run(LuaThread& thread, std::vector<std::shared_ptr<LuaEventFunction>>& vec)
+void LuaEventProcessor::RunFunctions(LuaThread& thread, std::vector<std::shared_ptr<LuaEventFunction>>& running)
 {
-	vec.erase(std::remove_if(vec.begin(), vec.end(),
-		[&thread](std::shared_ptr<LuaEventFunction> co) -> bool
+	running.erase(std::remove_if(running.begin(), running.end(),
+		[this, &thread](const std::shared_ptr<LuaEventFunction>& co) -> bool
 	{
 		// return false for everything else because we need to yield to the frame
 		if (thread.ShouldYield()) return false;
@@ -156,28 +170,86 @@ static void loop_and_run(LuaThread& thread, std::vector<std::shared_ptr<LuaEvent
 		// check if we are paused or if this thread is delayed
 		if (!co->coroutine->ShouldRun()) return false;
 
-		auto result = co->coroutine->RunCoroutine(co->args);
+		// we can only submit args the first time, after that the storage can be reused
+		CoroutineResult result;
+		if (co->args)
+		{
+			result = co->coroutine->RunCoroutine(co->args->GetViews());
+			ReleaseArgs(std::move(co->args));
+		}
+		else
+		{
+			result = co->coroutine->RunCoroutine();
+		}
+
+		if (result && result->status() == sol::call_status::yielded)
+			return false;
 
-		// a bit of mutation here, but we can only submit a non-empty args the first time
-		if (!co->args.empty()) co->args.clear();
+		// now just erase events that finished. If it finished without an error the thread
+		// can be used by the next handler.
+		if (result && result->status() == sol::call_status::ok)
+			ReleaseFunction(co);
 
-		// now just erase events that finished
-		return !result || result->status() != sol::call_status::yielded;
-	}), vec.end());
+		return true;
+	}), running.end());
 }
 
 void LuaEventProcessor::RunEvents(LuaThread& thread)
 {
-	loop_and_run(thread, m_bindsRunning);
-	if (!thread.ShouldYield()) loop_and_run(thread, m_eventsRunning);
+	MQScopedBenchmark bm(bmLuaEventRun);
+
+	RunFunctions(thread, m_bindsRunning);
+	if (!thread.ShouldYield()) RunFunctions(thread, m_eventsRunning);
+}
+
+template <typename T>
+void LuaEventProcessor::StartFunction(std::vector<std::shared_ptr<LuaEventFunction>>& running, LuaEventInstance<T>& instance)
+{
+	std::shared_ptr<LuaEventFunction> function;
+
+	auto iter = m_functionPool.find(instance.definition);
+	if (iter != m_functionPool.end() && !iter->second.empty())
+	{
+		function = std::move(iter->second.back());
+		iter->second.pop_back();
+	}
+	else
+	{
+		function = std::make_shared<LuaEventFunction>(m_thread, instance.definition);
+	}
+
+	function->Start(instance.definition->GetFunction(), std::move(instance.args));
+	running.push_back(std::move(function));
+}
+
+void LuaEventProcessor::ReleaseFunction(const std::shared_ptr<LuaEventFunction>& function)
+{
+	// The definition may have been removed while the handler was running, in which case
+	// there is nothing to return it to.
+	auto iter = m_functionPool.find(function->definition);
+	if (iter != m_functionPool.end() && iter->second.size() < MAX_POOLED_FUNCTIONS)
+	{
+		iter->second.push_back(function);
+	}
 }
 
-template <typename R>
-static void emplace_running(
-	std::vector<std::shared_ptr<LuaEventFunction>>& running_vec,
-	LuaEventInstance<R>& to_run)
+std::unique_ptr<LuaEventArgs> LuaEventProcessor::AcquireArgs()
 {
-	running_vec.emplace_back(std::make_shared<LuaEventFunction>(to_run));
+	if (m_argsPool.empty())
+		return std::make_unique<LuaEventArgs>();
+
+	std::unique_ptr<LuaEventArgs> args = std::move(m_argsPool.back());
+	m_argsPool.pop_back();
+	return args;
+}
+
+void LuaEventProcessor::ReleaseArgs(std::unique_ptr<LuaEventArgs> args)
+{
+	if (args && m_argsPool.size() < MAX_POOLED_ARGS)
+	{
+		args->Clear();
+		m_argsPool.push_back(std::move(args));
+	}
 }
 
 void LuaEventProcessor::PrepareEvents(const std::vector<std::string>& events)
@@ -186,7 +258,7 @@ void LuaEventProcessor::PrepareEvents(const std::vector<std::string>& events)
 	{
 		for (LuaEventInstance<LuaEvent>& ev : m_eventsPending)
 		{
-			emplace_running(m_eventsRunning, ev);
+			StartFunction(m_eventsRunning, ev);
 		}
 
 		m_eventsPending.clear();
@@ -198,7 +270,7 @@ void LuaEventProcessor::PrepareEvents(const std::vector<std::string>& events)
 		{
 			if (std::find(events.cbegin(), events.cend(), ev.definition->GetName()) != events.cend())
 			{
-				emplace_running(m_eventsRunning, ev);
+				StartFunction(m_eventsRunning, ev);
 				return true;
 			}
 
@@ -225,7 +297,7 @@ void LuaEventProcessor::PrepareBinds()
 {
 	for (auto& b : m_bindsPending)
 	{
-		emplace_running(m_bindsRunning, b);
+		StartFunction(m_bindsRunning, b);
 	}
 
 	m_bindsPending.clear();
@@ -247,34 +319,19 @@ void LuaEventProcessor::RemoveBinds(const std::vector<std::string>& binds)
 
 void LuaEventProcessor::HandleBlechEvent(LuaEvent* pEvent, BLECHVALUE* pValues)
 {
-	std::vector<std::pair<uint32_t, std::string>> args;
-
-	std::optional<std::string> line = m_thread->GetState()["_mq_event_line"];
-	args.emplace_back(0, line.value_or(""));
+	std::unique_ptr<LuaEventArgs> args = AcquireArgs();
+	args->Set(0, m_currentLine);
 
 	auto value = pValues;
 	while (value != nullptr)
 	{
 		auto num = GetIntFromString(value->Name, 0);
 		if (num > 0) // this will skip any '*' instances for me -- it will in fact only Get valid argument positions
-			args.emplace_back(num, value->Value);
+			args->Set(num, value->Value);
 		value = value->pNext;
 	}
 
-	if (args.empty())
-	{
-		m_eventsPending.emplace_back(pEvent);
-	}
-	else
-	{
-		std::sort(args.begin(), args.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
-
-		std::vector<std::string> ordered_args(args.back().first + 1, "");
-		for (const auto& a : args)
-			ordered_args[a.first] = a.second;
-
-		m_eventsPending.emplace_back(pEvent, std::move(ordered_args));
-	}
+	m_eventsPending.emplace_back(pEvent, std::move(args));
 }
 
 void LuaEventProcessor::HandleBindCallback(LuaBind* bind, const char* args)
@@ -286,9 +343,15 @@ void LuaEventProcessor::HandleBindCallback(LuaBind* bind, const char* args)
 	}
 	else
 	{
-		std::vector<std::string> args_vector(args_view.begin(), args_view.end());
-		m_bindsPending.emplace_back(bind, std::move(args_vector));
+		std::unique_ptr<LuaEventArgs> bind_args = AcquireArgs();
+		for (size_t i = 0; i < args_view.size(); ++i)
+			bind_args->Set(i, args_view[i]);
+
+		m_bindsPending.emplace_back(bind, std::move(bind_args));
 	}
+
+	// the bind needs to run on the next pulse even if the script is waiting on a delay
+	m_thread->Wake();
 }
 
 //============================================================================
@@ -339,27 +402,24 @@ LuaBind::~LuaBind()
 
 //----------------------------------------------------------------------------
 
-template<> LuaEventFunction::LuaEventFunction(LuaEventInstance<LuaBind>& instance)
-	: luaThread(instance.definition->GetEventProcessor()->GetThread())
+LuaEventFunction::LuaEventFunction(LuaThread* luaThread, const void* definition)
+	: luaThread(luaThread)
+	, definition(definition)
 	, solThreadInfo(luaThread->CreateThread())
-	, args(std::move(instance.args))
 	, coroutine(LuaCoroutine::Create(solThreadInfo.second, luaThread))
 {
-	coroutine->coroutine = sol::coroutine(solThreadInfo.second.state(), instance.definition->GetFunction());
 }
 
-template<> LuaEventFunction::LuaEventFunction(LuaEventInstance<LuaEvent>& instance)
-	: luaThread(instance.definition->GetEventProcessor()->GetThread())
-	, solThreadInfo(luaThread->CreateThread())
-	, args(std::move(instance.args))
-	, coroutine(LuaCoroutine::Create(solThreadInfo.second, luaThread))
+LuaEventFunction::~LuaEventFunction()
 {
-	coroutine->coroutine = sol::coroutine(solThreadInfo.second.state(), instance.definition->GetFunction());
+	luaThread->RemoveThread(solThreadInfo.first);
 }
 
-LuaEventFunction::~LuaEventFunction()
+void LuaEventFunction::Start(const sol::function& function, std::unique_ptr<LuaEventArgs> args)
 {
-	luaThread->RemoveThread(solThreadInfo.first);
+	coroutine->ClearDelay();
+	coroutine->coroutine = sol::coroutine(solThreadInfo.second.state(), function);
+	this->args = std::move(args);
 }
 
 } // namespace mq::lua
@@ -15,8 +15,10 @@
 #pragma once
 
 #include "LuaCommon.h"
+#include "LuaEventArgs.h"
 
 #include <queue>
+#include <unordered_map>
 
 class Blech;
 struct BLECHVALUE;
@@ -27,6 +29,9 @@ class LuaThread;
 class LuaEventProcessor;
 struct LuaCoroutine;
 
+extern uint32_t bmLuaEventProcess;
+extern uint32_t bmLuaEventRun;
+
 //============================================================================
 
 class LuaEvent
@@ -78,9 +83,9 @@ template <typename T>
 struct LuaEventInstance
 {
 	T* definition;
-	std::vector<std::string> args;
+	std::unique_ptr<LuaEventArgs> args;
 
-	LuaEventInstance(T* definition, std::vector<std::string> args)
+	LuaEventInstance(T* definition, std::unique_ptr<LuaEventArgs> args)
 		: definition(definition)
 		, args(std::move(args))
 	{}
@@ -92,17 +97,21 @@ struct LuaEventInstance
 
 //----------------------------------------------------------------------------
 
+// The thread and coroutine that a handler runs on. These are pooled per definition and
+// reused by the next handler once the previous one has finished.
 struct LuaEventFunction
 {
 	LuaThread* luaThread;
+	const void* definition;
 
 	std::pair<uint32_t, sol::thread> solThreadInfo;
 	std::shared_ptr<LuaCoroutine> coroutine;
-	std::vector<std::string> args;
+	std::unique_ptr<LuaEventArgs> args;
 
-	template<typename T>
-	LuaEventFunction(LuaEventInstance<T>& instance);
+	LuaEventFunction(LuaThread* luaThread, const void* definition);
 	~LuaEventFunction();
+
+	void Start(const sol::function& function, std::unique_ptr<LuaEventArgs> args);
 };
 
 //----------------------------------------------------------------------------
@@ -119,7 +128,7 @@ public:
 	bool AddBind(std::string_view name, const sol::function& function);
 	bool RemoveBind(std::string_view name);
 
-	void Process(std::string_view line) const;
+	void Process(std::string_view line);
 
 	// this is guaranteed to always run at the exact same time, so we can run binds and events in it
 	void RunEvents(LuaThread& thread);
@@ -132,13 +141,31 @@ public:
 
 	LuaThread* GetThread() const { return m_thread; }
 
+	// True if there are binds waiting to start or handlers that are part way through
+	bool HasPendingWork() const { return !m_bindsPending.empty() || !m_bindsRunning.empty() || !m_eventsRunning.empty(); }
+
 	void HandleBlechEvent(LuaEvent* event, BLECHVALUE* pValues);
 	void HandleBindCallback(LuaBind* bind, const char* args);
 
 private:
+	template <typename T>
+	void StartFunction(std::vector<std::shared_ptr<LuaEventFunction>>& running, LuaEventInstance<T>& instance);
+	void RunFunctions(LuaThread& thread, std::vector<std::shared_ptr<LuaEventFunction>>& running);
+	void ReleaseFunction(const std::shared_ptr<LuaEventFunction>& function);
+
+	std::unique_ptr<LuaEventArgs> AcquireArgs();
+	void ReleaseArgs(std::unique_ptr<LuaEventArgs> args);
+
 	LuaThread* m_thread;
 	std::unique_ptr<Blech> m_blech;
 
+	// The line currently being fed to blech
+	std::string_view m_currentLine;
+
+	// Finished handler functions, by definition, ready to be reused
+	std::unordered_map<const void*, std::vector<std::shared_ptr<LuaEventFunction>>> m_functionPool;
+	std::vector<std::unique_ptr<LuaEventArgs>> m_argsPool;
+
 	// Events
 	std::vector<std::unique_ptr<LuaEvent>> m_eventDefinitions;
 	std::vector<LuaEventInstance<LuaEvent>> m_eventsPending;
@@ -0,0 +1,65 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace mq::lua {
+
+// Arguments for an event or bind. The strings are stored in a single buffer and handed
+// to the handler as views, and the storage is reused once the handler has started.
+class LuaEventArgs
+{
+public:
+	void Clear()
+	{
+		m_buffer.clear();
+		m_offsets.clear();
+		m_views.clear();
+	}
+
+	// Sets the argument at index. Any arguments before it that haven't been set are empty.
+	void Set(size_t index, std::string_view value)
+	{
+		if (index >= m_offsets.size())
+			m_offsets.resize(index + 1, { 0, 0 });
+
+		m_offsets[index] = { m_buffer.size(), value.size() };
+		m_buffer.append(value);
+	}
+
+	bool empty() const { return m_offsets.empty(); }
+	size_t size() const { return m_offsets.size(); }
+
+	// The views are only valid until the next call to Set or Clear
+	const std::vector<std::string_view>& GetViews()
+	{
+		m_views.clear();
+		for (const auto& [offset, length] : m_offsets)
+			m_views.emplace_back(m_buffer.data() + offset, length);
+
+		return m_views;
+	}
+
+private:
+	std::string m_buffer;
+	std::vector<std::pair<size_t, size_t>> m_offsets;
+	std::vector<std::string_view> m_views;
+};
+
+} // namespace mq::lua
@@ -113,6 +113,8 @@ LuaThread::LuaThread(this_is_private&&, LuaEnvironmentSettings* environment)
 	, m_pid(NextID())
 	, m_coroutine(LuaCoroutine::Create(sol::thread::create(m_globalState), this))
 {
+	m_allocator.Attach(m_globalState.lua_state());
+
 	m_globalState.open_libraries();
 	m_luaEnvironmentSettings->ConfigureLuaState(m_globalState);
 
@@ -171,11 +173,137 @@ void LuaThread::Exit(LuaThreadExitReason reason)
 {
 	m_exitReason = reason;
 	YieldAt(0);
+	Wake();
 
 	OnLuaThreadDestroyed(this);
 	m_coroutine->thread.abandon();
 }
 
+bool LuaThread::CheckMemoryLimits()
+{
+	// already on its way out
+	if (m_exitReason == LuaThreadExitReason::MemoryLimit)
+		return false;
+
+	m_allocator.Sample();
+
+	switch (m_allocator.CheckLimits())
+	{
+	case LuaMemoryLimit::Hard:
+		m_exitReason = LuaThreadExitReason::MemoryLimit;
+		return true;
+
+	case LuaMemoryLimit::Soft:
+		// only give up on the script if a full collection doesn't get it back under the limit.
+		// luajit only shrinks its string table on the collection after the strings were freed,
+		// so it gets a second one.
+		for (int i = 0; i < 2; ++i)
+		{
+			CollectGarbage();
+			if (m_allocator.CheckLimits() == LuaMemoryLimit::None)
+				return false;
+		}
+
+		m_exitReason = LuaThreadExitReason::MemoryLimit;
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+//----------------------------------------------------------------------------
+
+// A managed state starts a new cycle once it has doubled since the last one, the same as lua's
+// default pause
+static constexpr size_t GC_STEP_PAUSE = 200;
+
+static void RecordGCTime(LuaGCStats& stats, std::chrono::nanoseconds time)
+{
+	stats.time += time;
+	if (time > stats.maxTime)
+		stats.maxTime = time;
+}
+
+void LuaThread::SetManagedGC(bool managed)
+{
+	lua_State* L = m_globalState.lua_state();
+
+	if (managed)
+	{
+		if (!m_managedGC)
+		{
+			m_managedGC = true;
+			m_gcInCycle = false;
+			m_gcEstimate = GetMemoryStats().liveBytes;
+		}
+
+		// always stop it, anything that collects (including the script) starts it again
+		lua_gc(L, LUA_GCSTOP, 0);
+	}
+	else if (m_managedGC)
+	{
+		m_managedGC = false;
+		lua_gc(L, LUA_GCRESTART, 0);
+	}
+}
+
+bool LuaThread::NeedsGCStep() const
+{
+	return m_managedGC
+		&& (m_gcInCycle || GetMemoryStats().liveBytes >= m_gcEstimate / 100 * GC_STEP_PAUSE);
+}
+
+bool LuaThread::StepGC()
+{
+	lua_State* L = m_globalState.lua_state();
+
+	const auto start = std::chrono::steady_clock::now();
+	const bool finished = lua_gc(L, LUA_GCSTEP, 0) != 0;
+	lua_gc(L, LUA_GCSTOP, 0);
+	RecordGCTime(m_gcStats, std::chrono::steady_clock::now() - start);
+
+	++m_gcStats.steps;
+	m_gcInCycle = !finished;
+
+	if (finished)
+	{
+		++m_gcStats.cycles;
+		m_gcEstimate = GetMemoryStats().liveBytes;
+	}
+
+	return finished;
+}
+
+bool LuaThread::CheckGCThreshold(uint32_t growthPercent)
+{
+	if (!m_managedGC || growthPercent == 0
+		|| GetMemoryStats().liveBytes < m_gcEstimate / 100 * growthPercent)
+	{
+		return false;
+	}
+
+	CollectGarbage();
+	return true;
+}
+
+void LuaThread::CollectGarbage()
+{
+	lua_State* L = m_globalState.lua_state();
+
+	const auto start = std::chrono::steady_clock::now();
+	lua_gc(L, LUA_GCCOLLECT, 0);
+	if (m_managedGC)
+		lua_gc(L, LUA_GCSTOP, 0);
+	RecordGCTime(m_gcStats, std::chrono::steady_clock::now() - start);
+
+	++m_gcStats.fullCollections;
+	m_gcInCycle = false;
+	m_gcEstimate = GetMemoryStats().liveBytes;
+}
+
+//----------------------------------------------------------------------------
+
 std::pair<uint32_t, sol::thread> LuaThread::CreateThread()
 {
 	auto thread = sol::thread::create(m_globalState);
@@ -510,8 +638,19 @@ LuaThread::RunResult LuaThread::RunOnce()
 	return { m_coroutine->thread.status(), std::nullopt };
 }
 
+uint64_t LuaThread::GetWakeTime() const
+{
+	// paused threads still run their events, and anything in flight has to finish first
+	if (m_paused || (m_eventProcessor && m_eventProcessor->HasPendingWork()))
+		return 0;
+
+	return m_coroutine->GetWakeTime();
+}
+
 LuaThreadStatus LuaThread::Pause()
 {
+	Wake();
+
 	if (m_paused)
 	{
 		YieldAt(m_turboNum);
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include "LuaAllocator.h"
 #include "LuaCommon.h"
 
 #include "mq/api/MacroAPI.h"
@@ -53,6 +54,7 @@ enum class LuaThreadExitReason
 	Unspecified = 0,
 	Exit = 1,
 	DependencyRemoved = 2,
+	MemoryLimit = 3,
 };
 
 enum class YieldDisabledReason
@@ -61,6 +63,15 @@ enum class YieldDisabledReason
 	Require,
 };
 
+struct LuaGCStats
+{
+	uint64_t steps = 0;
+	uint64_t cycles = 0;                            // incremental cycles finished by stepping
+	uint64_t fullCollections = 0;
+	std::chrono::nanoseconds time{ 0 };             // time spent in steps and full collections
+	std::chrono::nanoseconds maxTime{ 0 };          // longest single step or full collection
+};
+
 struct LuaThreadInfo
 {
 	uint32_t pid;
@@ -72,6 +83,9 @@ struct LuaThreadInfo
 	std::vector<std::string> returnValues;
 	LuaThreadStatus status;
 	bool isString;
+	LuaThreadExitReason exitReason = LuaThreadExitReason::Unspecified;
+	LuaMemoryStats memory;
+	LuaGCStats gc;
 
 	std::string_view status_string() const
 	{
@@ -153,7 +167,36 @@ public:
 
 	bool ShouldYield() const { return m_yieldToFrame; }
 	void DoYield() { YieldAt(0); }
+
+	// The tick at which this thread next has work to do. Returns 0 if it should be run on the next pulse.
+	uint64_t GetWakeTime() const;
+
+	// A sleeping thread is waiting on a delay and is not run until it is woken.
+	bool IsSleeping() const { return m_sleepUntil != 0; }
+	uint64_t GetSleepUntil() const { return m_sleepUntil; }
+	void Sleep(uint64_t until) { m_sleepUntil = until; }
+	void Wake() { m_sleepUntil = 0; }
 	void Exit(LuaThreadExitReason reason = LuaThreadExitReason::Unspecified);
+	LuaThreadExitReason GetExitReason() const { return m_exitReason; }
+
+	// Memory limits are in bytes, zero for no limit. Going over the soft limit ends the script
+	// between time slices, going over the hard limit fails the allocation that did it.
+	void SetMemoryLimits(size_t softLimit, size_t hardLimit) { m_allocator.SetLimits(softLimit, hardLimit); }
+	const LuaMemoryStats& GetMemoryStats() const { return m_allocator.GetStats(); }
+
+	// Called after each time slice. Returns true if the script is over its memory limit and
+	// needs to be ended.
+	bool CheckMemoryLimits();
+
+	// While the collector is managed, lua never collects on its own. The collector only runs when it
+	// is stepped, or when the state is collected in full because it has grown past its threshold.
+	void SetManagedGC(bool managed);
+	bool IsManagedGC() const { return m_managedGC; }
+	bool NeedsGCStep() const;
+	bool StepGC(); // returns true if this finished a cycle
+	bool CheckGCThreshold(uint32_t growthPercent); // returns true if the state was collected
+	void CollectGarbage();
+	const LuaGCStats& GetGCStats() const { return m_gcStats; }
 
 	std::pair<uint32_t, sol::thread> CreateThread();
 	void RemoveThread(uint32_t index);
@@ -206,6 +249,9 @@ private:
 private:
 	LuaEnvironmentSettings* m_luaEnvironmentSettings = nullptr;
 
+	// the state frees everything through the allocator when it is closed, so it has to outlive it
+	LuaAllocator m_allocator;
+
 	// this needs to be first in initialization order because other things depend on it
 	sol::state m_globalState;
 	std::shared_ptr<LuaCoroutine> m_coroutine;
@@ -220,10 +266,15 @@ private:
 	bool m_yieldToFrame = false;
 	bool m_isString = false;
 	bool m_paused = false;
+	uint64_t m_sleepUntil = 0;
 	bool m_evaluateResult = false;
 	bool m_allowYield = true;
 	YieldDisabledReason m_yieldDisabledReason = YieldDisabledReason::Default;
 	LuaThreadExitReason m_exitReason = LuaThreadExitReason::Unspecified;
+	bool m_managedGC = false;
+	bool m_gcInCycle = false;
+	size_t m_gcEstimate = 0;                        // live bytes after the last cycle or full collection
+	LuaGCStats m_gcStats;
 	std::vector<const void*> m_dependencies;
 	std::unordered_set<std::string> m_namedDependencies;
 
@@ -16,6 +16,7 @@
 
 #include "LuaInterface.h"
 #include "LuaCommon.h"
+#include "LuaCoroutine.h"
 #include "LuaThread.h"
 #include "LuaEvent.h"
 #include "LuaActor.h"
@@ -36,6 +37,7 @@
 
 #include <yaml-cpp/yaml.h>
 
+#include <cmath>
 #include <string>
 #include <fstream>
 
@@ -58,6 +60,11 @@ static const std::string KEY_DLL_REQUIRE_PATHS = "dllRequirePaths";
 static const std::string KEY_INFO_GC = "infoGC";
 static const std::string KEY_SQUELCH_STATUS = "squelchStatus";
 static const std::string KEY_SHOW_MENU = "showMenu";
+static const std::string KEY_MEMORY_SOFT_LIMIT = "memorySoftLimit";
+static const std::string KEY_MEMORY_HARD_LIMIT = "memoryHardLimit";
+static const std::string KEY_MEMORY_LIMITS = "memoryLimits";
+static const std::string KEY_GC_BUDGET = "gcBudget";
+static const std::string KEY_GC_FULL_COLLECT_GROWTH = "gcFullCollectGrowth";
 
 // configurable options, defaults provided where needed
 static uint32_t s_turboNum = 500;
@@ -67,6 +74,10 @@ static LuaEnvironmentSettings s_environment;
 static std::chrono::milliseconds s_infoGC = 3600s; // 1 hour
 static bool s_squelchStatus = false;
 static bool s_verboseErrors = true;
+static uint32_t s_memorySoftLimit = 0; // MB, 0 for no limit
+static uint32_t s_memoryHardLimit = 0; // MB, 0 for no limit
+static uint32_t s_gcBudget = 0; // microseconds per pulse, 0 to let lua collect on its own
+static uint32_t s_gcFullCollectGrowth = 400; // percent of the size after the last collection
 
 // this is static and will never change
 static std::string s_configPath = (std::filesystem::path(gPathConfig) / "MQ2Lua.yaml").string();
@@ -83,6 +94,41 @@ static imgui::TextEditor* s_luaCodeViewer = nullptr;
 std::vector<std::shared_ptr<LuaThread>> s_running;
 std::vector<std::shared_ptr<LuaThread>> s_pending;
 
+// scripts that are waiting on a delay, ordered by the time they need to run again
+LuaSleepQueue<LuaThread> s_sleeping;
+
+// /lua delays bench: times the pulse while a number of scripts wait on mq.delay
+struct LuaDelayBenchmark
+{
+	bool active = false;
+	int count = 0;
+	uint64_t endTime = 0;
+	uint64_t pulses = 0;
+	std::chrono::nanoseconds pulseTime{ 0 };
+	LuaDelayStats startStats;
+};
+static LuaDelayBenchmark s_delayBenchmark;
+static constexpr uint64_t DELAY_BENCHMARK_DURATION = 10000;
+
+// the next script to get a garbage collection step
+static size_t s_gcNext = 0;
+
+// /lua gc bench: times the pulse while scripts allocate as fast as they can, first with lua
+// collecting on its own and then with the collector stepped within the budget
+struct LuaGCBenchmark
+{
+	bool active = false;
+	bool budgeted = false;
+	int count = 0;
+	uint32_t budget = 0;
+	uint64_t phaseEndTime = 0;
+	std::vector<uint32_t> pids;
+	std::vector<float> pulseTimes[2]; // microseconds, without and with the budget
+};
+static LuaGCBenchmark s_gcBenchmark;
+static constexpr uint64_t GC_BENCHMARK_PHASE_DURATION = 10000;
+static constexpr uint32_t GC_BENCHMARK_BUDGET = 1000; // used if gcBudget is not set
+
 std::unordered_map<uint32_t, LuaThreadInfo> s_infoMap;
 
 #pragma region Shared Function Definitions
@@ -172,6 +218,10 @@ void EndScript(const std::shared_ptr<LuaThread>& thread, const LuaThread::RunRes
 	auto fin_it = s_infoMap.find(thread->GetPID());
 	if (fin_it != s_infoMap.end())
 	{
+		fin_it->second.exitReason = thread->GetExitReason();
+		fin_it->second.memory = thread->GetMemoryStats();
+		fin_it->second.gc = thread->GetGCStats();
+
 		if (result.second)
 			fin_it->second.SetResult(*result.second, thread->GetEvaluateResult());
 		else
@@ -196,6 +246,38 @@ std::shared_ptr<LuaThread> GetLuaThreadByPID(int pid)
 	return nullptr;
 }
 
+// A script gets the limits from its entry in memoryLimits if it has one, and the default
+// limits otherwise.
+static void ApplyMemoryLimits(const std::shared_ptr<LuaThread>& thread, std::string_view name)
+{
+	uint32_t softLimit = s_memorySoftLimit;
+	uint32_t hardLimit = s_memoryHardLimit;
+
+	YAML::Node limits = s_configNode[KEY_MEMORY_LIMITS];
+	if (limits.IsMap())
+	{
+		for (const auto& entry : limits)
+		{
+			if (ci_equals(entry.first.as<std::string>(), name))
+			{
+				softLimit = entry.second["soft"].as<uint32_t>(softLimit);
+				hardLimit = entry.second["hard"].as<uint32_t>(hardLimit);
+				break;
+			}
+		}
+	}
+
+	thread->SetMemoryLimits(static_cast<size_t>(softLimit) * 1024 * 1024, static_cast<size_t>(hardLimit) * 1024 * 1024);
+}
+
+static std::string FormatMemorySize(size_t bytes)
+{
+	if (bytes >= 1024 * 1024)
+		return fmt::format("{:.1f} MB", bytes / (1024.0 * 1024.0));
+
+	return fmt::format("{:.1f} KB", bytes / 1024.0);
+}
+
 void OnLuaThreadDestroyed(LuaThread* destroyedThread)
 {
 	s_running.erase(std::remove_if(s_running.begin(), s_running.end(),
@@ -586,6 +668,7 @@ static uint32_t LuaRunCommand(const std::string& script, const std::vector<std::
 	entry->SetTurbo(s_turboNum);
 	entry->EnableEvents();
 	entry->EnableImGui();
+	ApplyMemoryLimits(entry, script_name);
 	s_pending.push_back(entry);
 
 	WriteChatStatus("Running lua script '%s' with PID %d", script_name.c_str(), entry->GetPID());
@@ -631,6 +714,7 @@ static uint32_t LuaParseCommand(const std::string& script, std::string_view name
 		entry->SetEvaluateResult(true);
 	}
 
+	ApplyMemoryLimits(entry, name);
 	s_pending.push_back(entry);
 
 	//WriteChatStatus("Running lua string with PID %d", entry->GetPID());
@@ -940,6 +1024,15 @@ static void ReadSettings()
 
 	s_squelchStatus = s_configNode[KEY_SQUELCH_STATUS].as<bool>(s_squelchStatus);
 	s_showMenu = s_configNode[KEY_SHOW_MENU].as<bool>(s_showMenu);
+
+	s_memorySoftLimit = s_configNode[KEY_MEMORY_SOFT_LIMIT].as<uint32_t>(0);
+	s_memoryHardLimit = s_configNode[KEY_MEMORY_HARD_LIMIT].as<uint32_t>(0);
+	s_gcBudget = s_configNode[KEY_GC_BUDGET].as<uint32_t>(0);
+	s_gcFullCollectGrowth = s_configNode[KEY_GC_FULL_COLLECT_GROWTH].as<uint32_t>(400);
+	for (const std::shared_ptr<LuaThread>& thread : s_running)
+	{
+		ApplyMemoryLimits(thread, thread->GetName());
+	}
 }
 
 static void LuaConfCommand(const std::string& setting, const std::string& value)
@@ -1026,6 +1119,29 @@ static void LuaPSCommand(const std::vector<std::string>& filters = {})
 
 static void LuaInfoCommand(const std::optional<std::string>& script = std::nullopt)
 {
+	// running scripts report what they hold now, ended scripts what they held when they ended
+	auto getMemoryStats = [](const LuaThreadInfo& info) -> LuaMemoryStats
+	{
+		if (info.status != LuaThreadStatus::Exited)
+		{
+			if (std::shared_ptr<LuaThread> thread = GetLuaThreadByPID(info.pid))
+				return thread->GetMemoryStats();
+		}
+
+		return info.memory;
+	};
+
+	auto getGCStats = [](const LuaThreadInfo& info) -> LuaGCStats
+	{
+		if (info.status != LuaThreadStatus::Exited)
+		{
+			if (std::shared_ptr<LuaThread> thread = GetLuaThreadByPID(info.pid))
+				return thread->GetGCStats();
+		}
+
+		return info.gc;
+	};
+
 	if (script)
 	{
 		auto thread_it = s_infoMap.end();
@@ -1045,11 +1161,15 @@ static void LuaInfoCommand(const std::optional<std::string>& script = std::nullo
 		if (thread_it != s_infoMap.end())
 		{
 			const LuaThreadInfo& info = thread_it->second;
+			const LuaMemoryStats memory = getMemoryStats(info);
+			const LuaGCStats gc = getGCStats(info);
 
 			fmt::memory_buffer line;
 			fmt::format_to(
 				fmt::appender(line),
-				"pid: {}\nname: {}\npath: {}\narguments: {}\nstartTime: {}\nendTime: {}\nreturnValues: {}\nstatus: {}",
+				"pid: {}\nname: {}\npath: {}\narguments: {}\nstartTime: {}\nendTime: {}\nreturnValues: {}\nstatus: {}\nexitReason: {}\n"
+				"memory: {}\npeakMemory: {}\nallocations: {}\nallocationRate: {}/s\n"
+				"gcTime: {:.2f} ms\ngcMaxTime: {:.2f} ms\ngcSteps: {}\ngcCycles: {}\ngcFullCollections: {}",
 				info.pid,
 				info.name,
 				info.path,
@@ -1057,7 +1177,17 @@ static void LuaInfoCommand(const std::optional<std::string>& script = std::nullo
 				info.startTime,
 				info.endTime,
 				join(info.returnValues, ", "),
-				static_cast<int>(info.status));
+				static_cast<int>(info.status),
+				static_cast<int>(info.exitReason),
+				FormatMemorySize(memory.liveBytes),
+				FormatMemorySize(memory.peakBytes),
+				memory.allocations,
+				FormatMemorySize(static_cast<size_t>(memory.allocationRate)),
+				std::chrono::duration<double, std::milli>(gc.time).count(),
+				std::chrono::duration<double, std::milli>(gc.maxTime).count(),
+				gc.steps,
+				gc.cycles,
+				gc.fullCollections);
 
 			WriteChatStatus("%.*s", line.size(), line.data());
 		}
@@ -1068,22 +1198,287 @@ static void LuaInfoCommand(const std::optional<std::string>& script = std::nullo
 	}
 	else
 	{
-		WriteChatStatus("|  PID  |         NAME         |    START    |     END     |   STATUS   |");
+		WriteChatStatus("|  PID  |         NAME         |    START    |     END     |   STATUS   |   MEMORY   |");
 
 		for (const auto& [pid, info] : s_infoMap)
 		{
 			fmt::memory_buffer line;
-			fmt::format_to(fmt::appender(line), "|{:^7}|{:^22}|{:^13}|{:^13}|{:^12}|",
+			fmt::format_to(fmt::appender(line), "|{:^7}|{:^22}|{:^13}|{:^13}|{:^12}|{:^12}|",
 				pid,
 				info.name.length() > 22 ? info.name.substr(0, 19) + "..." : info.name,
 				(info.startTime != std::chrono::system_clock::time_point() ? fmt::format("{:%H:%M:%S}", info.startTime) : std::string()),
 				(info.endTime != std::chrono::system_clock::time_point() ? fmt::format("{:%H:%M:%S}", info.endTime) : std::string()),
-				static_cast<int>(info.status));
+				static_cast<int>(info.status),
+				FormatMemorySize(getMemoryStats(info).liveBytes));
 			WriteChatStatus("%.*s", line.size(), line.data());
 		}
 	}
 }
 
+static void LuaDelayBenchmarkStart(int count)
+{
+	if (s_delayBenchmark.active)
+	{
+		WriteChatStatus("Lua delay benchmark is already running.");
+		return;
+	}
+
+	s_delayBenchmark = LuaDelayBenchmark();
+	s_delayBenchmark.count = count;
+	s_delayBenchmark.startStats = luaDelayStats;
+
+	// an even mix of plain delays, conditions checked every frame, and conditions checked at an interval
+	for (int i = 0; i < count; ++i)
+	{
+		std::string script;
+		switch (i % 3)
+		{
+		case 0: script = fmt::format("mq.delay({})", DELAY_BENCHMARK_DURATION); break;
+		case 1: script = fmt::format("mq.delay({}, function() return false end)", DELAY_BENCHMARK_DURATION); break;
+		default: script = fmt::format("mq.delay({}, function() return false end, 100)", DELAY_BENCHMARK_DURATION); break;
+		}
+
+		LuaParseCommand(script, fmt::format("delaybench{}", i));
+	}
+
+	s_delayBenchmark.endTime = MQGetTickCount64() + DELAY_BENCHMARK_DURATION;
+	s_delayBenchmark.active = true;
+
+	WriteChatStatus("Started %d waiting scripts, results in %llu seconds.", count, DELAY_BENCHMARK_DURATION / 1000);
+}
+
+static void LuaDelayBenchmarkFinish()
+{
+	s_delayBenchmark.active = false;
+
+	const LuaDelayStats& start = s_delayBenchmark.startStats;
+	const uint64_t pulses = std::max<uint64_t>(s_delayBenchmark.pulses, 1);
+	const double pulseUs = std::chrono::duration<double, std::micro>(s_delayBenchmark.pulseTime).count();
+
+	WriteChatStatus("Lua delay benchmark: %d scripts, %llu pulses, %.2f us per pulse",
+		s_delayBenchmark.count, s_delayBenchmark.pulses, pulseUs / pulses);
+	WriteChatStatus("Condition checks: %llu, skipped by interval: %llu, check threads created: %llu, pulses slept through: %llu",
+		luaDelayStats.conditionChecks - start.conditionChecks,
+		luaDelayStats.conditionsSkipped - start.conditionsSkipped,
+		luaDelayStats.checkThreads - start.checkThreads,
+		luaDelayStats.pulsesSlept - start.pulsesSlept);
+}
+
+static void LuaDelaysCommand(const std::string& action, int count)
+{
+	if (ci_equals(action, "reset"))
+	{
+		luaDelayStats.Reset();
+		WriteChatStatus("Lua delay statistics have been reset.");
+		return;
+	}
+
+	if (ci_equals(action, "bench"))
+	{
+		LuaDelayBenchmarkStart(count > 0 ? count : 300);
+		return;
+	}
+
+	const auto waiting = std::count_if(s_running.cbegin(), s_running.cend(),
+		[](const std::shared_ptr<LuaThread>& thread) { return thread->GetWakeTime() != 0; });
+	const auto sleeping = std::count_if(s_running.cbegin(), s_running.cend(),
+		[](const std::shared_ptr<LuaThread>& thread) { return thread->IsSleeping(); });
+
+	WriteChatStatus("Scripts: %d running, %d delayed, %d sleeping (%d queued wakeups)",
+		static_cast<int>(s_running.size()), static_cast<int>(waiting), static_cast<int>(sleeping), static_cast<int>(s_sleeping.size()));
+	WriteChatStatus("Delays: %llu, with a condition: %llu", luaDelayStats.delays, luaDelayStats.conditionDelays);
+	WriteChatStatus("Conditions: %llu checked, %llu skipped by interval, %llu errors, %llu check threads created",
+		luaDelayStats.conditionChecks, luaDelayStats.conditionsSkipped, luaDelayStats.conditionErrors, luaDelayStats.checkThreads);
+	WriteChatStatus("Pulses slept through: %llu, wakeups: %llu", luaDelayStats.pulsesSlept, luaDelayStats.wakes);
+}
+
+// Steps the collectors of the running scripts, one step for each script in turn, until the budget
+// is used up or none of them have anything to do. Without a budget lua collects on its own.
+static void StepGarbageCollection(uint32_t budgetUs)
+{
+	for (const std::shared_ptr<LuaThread>& thread : s_running)
+	{
+		thread->SetManagedGC(budgetUs > 0);
+
+		// a script that has grown too much is collected in full, whatever the budget
+		thread->CheckGCThreshold(s_gcFullCollectGrowth);
+	}
+
+	if (budgetUs == 0 || s_running.empty())
+		return;
+
+	const auto start = std::chrono::steady_clock::now();
+	const std::chrono::microseconds budget{ budgetUs };
+	const size_t count = s_running.size();
+
+	size_t index = s_gcNext % count;
+	size_t idle = 0; // scripts in a row that had nothing to do
+
+	while (idle < count && std::chrono::steady_clock::now() - start < budget)
+	{
+		const std::shared_ptr<LuaThread>& thread = s_running[index];
+		index = (index + 1) % count;
+
+		if (thread->NeedsGCStep())
+		{
+			thread->StepGC();
+			idle = 0;
+		}
+		else
+		{
+			++idle;
+		}
+	}
+
+	s_gcNext = index;
+}
+
+static void LuaGCBenchmarkStart(int count)
+{
+	if (s_gcBenchmark.active)
+	{
+		WriteChatStatus("Lua gc benchmark is already running.");
+		return;
+	}
+
+	s_gcBenchmark = LuaGCBenchmark();
+	s_gcBenchmark.count = count;
+	s_gcBenchmark.budget = s_gcBudget > 0 ? s_gcBudget : GC_BENCHMARK_BUDGET;
+
+	// each script keeps a few hundred small tables alive and throws the rest away
+	for (int i = 0; i < count; ++i)
+	{
+		uint32_t pid = LuaParseCommand(
+			"local keep = {} local i = 0 while true do i = i + 1 keep[i % 500 + 1] = { i, tostring(i), { x = i } } end",
+			fmt::format("gcbench{}", i));
+
+		if (pid != 0)
+			s_gcBenchmark.pids.push_back(pid);
+	}
+
+	s_gcBenchmark.phaseEndTime = MQGetTickCount64() + GC_BENCHMARK_PHASE_DURATION;
+	s_gcBenchmark.active = true;
+
+	WriteChatStatus("Started %d allocating scripts, results in %llu seconds.", count, GC_BENCHMARK_PHASE_DURATION * 2 / 1000);
+}
+
+static void LuaGCBenchmarkFinish()
+{
+	s_gcBenchmark.active = false;
+
+	std::chrono::nanoseconds gcTime{ 0 };
+	for (uint32_t pid : s_gcBenchmark.pids)
+	{
+		if (std::shared_ptr<LuaThread> thread = GetLuaThreadByPID(pid))
+		{
+			gcTime += thread->GetGCStats().time;
+			thread->Exit();
+		}
+	}
+
+	WriteChatStatus("Lua gc benchmark: %d scripts, %u us budget, %.2f ms spent in budgeted collection",
+		s_gcBenchmark.count, s_gcBenchmark.budget, std::chrono::duration<double, std::milli>(gcTime).count());
+
+	for (int phase = 0; phase < 2; ++phase)
+	{
+		std::vector<float>& times = s_gcBenchmark.pulseTimes[phase];
+		if (times.empty())
+			continue;
+
+		double mean = 0.0;
+		for (float time : times)
+			mean += time;
+		mean /= times.size();
+
+		double variance = 0.0;
+		for (float time : times)
+			variance += (time - mean) * (time - mean);
+		variance /= times.size();
+
+		std::sort(times.begin(), times.end());
+
+		WriteChatStatus("%s: %d pulses, mean %.1f us, stddev %.1f us, p99 %.1f us, max %.1f us",
+			phase == 0 ? "Without budget" : "With budget", static_cast<int>(times.size()),
+			mean, std::sqrt(variance), times[times.size() * 99 / 100], times.back());
+	}
+
+	s_gcBenchmark.pids.clear();
+}
+
+static void LuaGCCommand(const std::string& action, int count)
+{
+	if (ci_equals(action, "bench"))
+	{
+		LuaGCBenchmarkStart(count > 0 ? count : 20);
+		return;
+	}
+
+	if (s_gcBudget > 0)
+		WriteChatStatus("Lua gc: %u us budget per pulse, full collection at %u%% growth", s_gcBudget, s_gcFullCollectGrowth);
+	else
+		WriteChatStatus("Lua gc: no budget, scripts collect on their own");
+
+	WriteChatStatus("|  PID  |         NAME         |  STEPS  | CYCLES |  FULL  |  TIME (ms)  |  MAX (ms)  |");
+
+	for (const std::shared_ptr<LuaThread>& thread : s_running)
+	{
+		const LuaGCStats& gc = thread->GetGCStats();
+
+		fmt::memory_buffer line;
+		fmt::format_to(fmt::appender(line), "|{:^7}|{:^22}|{:^9}|{:^8}|{:^8}|{:^13.2f}|{:^12.2f}|",
+			thread->GetPID(),
+			thread->GetName().length() > 22 ? thread->GetName().substr(0, 19) + "..." : thread->GetName(),
+			gc.steps,
+			gc.cycles,
+			gc.fullCollections,
+			std::chrono::duration<double, std::milli>(gc.time).count(),
+			std::chrono::duration<double, std::milli>(gc.maxTime).count());
+		WriteChatStatus("%.*s", line.size(), line.data());
+	}
+}
+
+// Compares mq.getFilteredSpawns with a Lua predicate against the native filter and mq.spawns.
+// The queries are repeated until about count spawns have been checked.
+static void LuaSpawnBenchmarkCommand(int count)
+{
+	static constexpr std::string_view script = R"(
+local spawns = #mq.getAllSpawns()
+if spawns == 0 then
+	print('spawnbench: there are no spawns to check')
+	return
+end
+
+local passes = math.max(1, math.ceil(total / spawns))
+local function bench(name, query)
+	local found = 0
+	local start = os.clock()
+	for _ = 1, passes do
+		found = query()
+	end
+	local ms = (os.clock() - start) * 1000
+	print(string.format('spawnbench: %s: %d matches, %.3f ms per query, %.3f us per spawn', name, found, ms / passes,
+		ms * 1000 / (passes * spawns)))
+end
+
+print(string.format('spawnbench: %d spawns, %d passes', spawns, passes))
+bench('predicate', function()
+	return #mq.getFilteredSpawns(function(spawn) return spawn.Type() == 'NPC' and spawn.Distance3D() <= 100 end)
+end)
+bench('filter', function()
+	return #mq.getFilteredSpawns({ type = 'npc', radius = 100 })
+end)
+bench('iterator', function()
+	local found = 0
+	for _ in mq.spawns({ type = 'npc', radius = 100 }) do
+		found = found + 1
+	end
+	return found
+end)
+)";
+
+	LuaParseCommand(fmt::format("local total = {}\n{}", count, script), "spawnbench");
+}
+
 static void LuaGuiCommand()
 {
 	s_showMenu = !s_showMenu;
@@ -1203,6 +1598,41 @@ void LuaCommand(SPAWNINFO* pChar, char* Buffer)
 			else LuaInfoCommand();
 		});
 
+	args::Command delays(commands, "delays", "show statistics for mq.delay and waiting scripts",
+		[](args::Subparser& parser)
+		{
+			args::Group arguments(parser, "", args::Group::Validators::DontCare);
+			args::Positional<std::string> action(arguments, "action", "optional action: 'reset' to reset the statistics, or 'bench' to time the pulse while a number of scripts wait on a delay");
+			args::Positional<int> count(arguments, "count", "the number of scripts to start for 'bench', defaults to 300");
+			auto h = HelpFlag(parser);
+			parser.Parse();
+
+			LuaDelaysCommand(action ? action.Get() : std::string(), count ? count.Get() : 0);
+		});
+
+	args::Command gc(commands, "gc", "show garbage collection statistics for running scripts",
+		[](args::Subparser& parser)
+		{
+			args::Group arguments(parser, "", args::Group::Validators::DontCare);
+			args::Positional<std::string> action(arguments, "action", "optional action: 'bench' to time the pulse while a number of scripts allocate, with and without the gc budget");
+			args::Positional<int> count(arguments, "count", "the number of scripts to start for 'bench', defaults to 20");
+			auto h = HelpFlag(parser);
+			parser.Parse();
+
+			LuaGCCommand(action ? action.Get() : std::string(), count ? count.Get() : 0);
+		});
+
+	args::Command spawnbench(commands, "spawnbench", "time the native spawn filters against a Lua predicate",
+		[](args::Subparser& parser)
+		{
+			args::Group arguments(parser, "", args::Group::Validators::DontCare);
+			args::Positional<int> count(arguments, "count", "the number of spawns to check with each query type, defaults to 5000");
+			auto h = HelpFlag(parser);
+			parser.Parse();
+
+			LuaSpawnBenchmarkCommand(count ? count.Get() : 5000);
+		});
+
 	args::Command gui(commands, "gui", "toggle the lua GUI",
 		[](args::Subparser& parser)
 		{
@@ -1298,6 +1728,7 @@ public:
 	{
 		LuaScriptPtr entry = LuaThread::Create(&s_environment);
 		entry->SetTurbo(s_turboNum);
+		ApplyMemoryLimits(entry, std::string_view());
 		s_pending.push_back(entry);
 
 		return entry;
@@ -1680,6 +2111,9 @@ PLUGIN_API void InitializePlugin()
 
 	bindings::InitializeBindings_MQMacroData();
 
+	bmLuaEventProcess = AddMQ2Benchmark("LuaEventProcess");
+	bmLuaEventRun = AddMQ2Benchmark("LuaEventRun");
+
 	LuaActors::Start();
 }
 
@@ -1691,6 +2125,9 @@ PLUGIN_API void ShutdownPlugin()
 
 	bindings::ShutdownBindings_MQMacroData();
 
+	RemoveMQ2Benchmark(bmLuaEventProcess);
+	RemoveMQ2Benchmark(bmLuaEventRun);
+
 	RemoveCommand("/lua");
 
 	RemoveMQ2Data("Lua");
@@ -1718,20 +2155,96 @@ PLUGIN_API void OnPulse()
 		s_pending.clear();
 	}
 
+	const uint64_t now = MQGetTickCount64();
+	const auto pulseStart = std::chrono::steady_clock::now();
+
+	// wake up any scripts whose delay is due
+	luaDelayStats.wakes += s_sleeping.WakeDue(now);
+
+	// scripts over their memory limit are stopped after the loop, stopping a script can end others
+	std::vector<std::shared_ptr<LuaThread>> overMemoryLimit;
+
 	s_running.erase(std::remove_if(s_running.begin(), s_running.end(),
-		[](const std::shared_ptr<LuaThread>& thread) -> bool
+		[now, &overMemoryLimit](const std::shared_ptr<LuaThread>& thread) -> bool
 		{
+			if (thread->IsSleeping())
+			{
+				++luaDelayStats.pulsesSlept;
+				return false;
+			}
+
 			LuaThread::RunResult result = thread->Run();
 
+			if (thread->CheckMemoryLimits())
+			{
+				const LuaMemoryStats& memory = thread->GetMemoryStats();
+				LuaError("Lua script '%s' with PID %d is over its memory limit (%s in use, peak %s)",
+					thread->GetName().c_str(), thread->GetPID(),
+					FormatMemorySize(memory.liveBytes).c_str(), FormatMemorySize(memory.peakBytes).c_str());
+
+				if (result.first == sol::thread_status::yielded)
+				{
+					overMemoryLimit.push_back(thread);
+					return false;
+				}
+			}
+
 			if (result.first != sol::thread_status::yielded)
 			{
 				EndScript(thread, result, true);
 				return true;
 			}
 
+			// if the script has nothing to do until its delay is up, don't run it again until then
+			const uint64_t wakeTime = thread->GetWakeTime();
+			if (wakeTime > now)
+			{
+				thread->Sleep(wakeTime);
+				s_sleeping.Push(wakeTime, thread);
+			}
+
 			return false;
 		}), s_running.end());
 
+	// these are cleaned up on the next pulse, when they no longer run
+	for (const std::shared_ptr<LuaThread>& thread : overMemoryLimit)
+	{
+		thread->Exit(LuaThreadExitReason::MemoryLimit);
+	}
+
+	if (s_gcBenchmark.active)
+		StepGarbageCollection(s_gcBenchmark.budgeted ? s_gcBenchmark.budget : 0);
+	else
+		StepGarbageCollection(s_gcBudget);
+
+	if (s_gcBenchmark.active)
+	{
+		s_gcBenchmark.pulseTimes[s_gcBenchmark.budgeted].push_back(
+			std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - pulseStart).count());
+
+		if (now >= s_gcBenchmark.phaseEndTime)
+		{
+			if (s_gcBenchmark.budgeted)
+			{
+				LuaGCBenchmarkFinish();
+			}
+			else
+			{
+				s_gcBenchmark.budgeted = true;
+				s_gcBenchmark.phaseEndTime = now + GC_BENCHMARK_PHASE_DURATION;
+			}
+		}
+	}
+
+	if (s_delayBenchmark.active)
+	{
+		++s_delayBenchmark.pulses;
+		s_delayBenchmark.pulseTime += std::chrono::steady_clock::now() - pulseStart;
+
+		if (now >= s_delayBenchmark.endTime)
+			LuaDelayBenchmarkFinish();
+	}
+
 	// Process messages after any threads have ended or started (the order likely won't matter since cleanup is checked)
 	LuaActors::Process();
 
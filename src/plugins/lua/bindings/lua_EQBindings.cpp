@@ -42,46 +42,233 @@ static std::unique_ptr<CTextureAnimation> FindTextureAnimation(std::string_view
 
 #pragma region MQ Data Bindings
 
-static sol::table lua_getAllSpawns(sol::this_state L)
+// A declarative spawn filter, checked in C++ instead of calling into Lua for every spawn.
+// The filter is either a spawn search string, like "npc radius 100", or a table:
+//   { type = "npc", radius = 100, zradius = 20, minLevel = 10, maxLevel = 20, name = "orc",
+//     exact = false, conColor = "BLUE" or { "BLUE", "WHITE" }, search = "<spawn search>" }
+struct LuaSpawnFilter
 {
-	auto table = sol::state_view(L).create_table();
+	MQSpawnSearch search;
+	uint32_t conColors = 0;                    // one bit per CONCOLOR_ value, 0 matches any
 
-	if (pSpawnManager)
+	bool Matches(PlayerClient* pOrigin, PlayerClient* pSpawn)
 	{
-		auto spawn = pSpawnManager->FirstSpawn;
-		while (spawn != nullptr)
+		if (!SpawnMatchesSearch(&search, pOrigin, pSpawn))
+			return false;
+
+		return conColors == 0 || (conColors & (1u << ConColor(pSpawn))) != 0;
+	}
+};
+
+static bool AddSpawnFilterConColor(LuaSpawnFilter& filter, std::string_view name)
+{
+	static const std::pair<std::string_view, int> conColors[] = {
+		{ "GREY", CONCOLOR_GREY },
+		{ "GREEN", CONCOLOR_GREEN },
+		{ "LIGHT BLUE", CONCOLOR_LIGHTBLUE },
+		{ "BLUE", CONCOLOR_BLUE },
+		{ "WHITE", CONCOLOR_WHITE },
+		{ "YELLOW", CONCOLOR_YELLOW },
+		{ "RED", CONCOLOR_RED },
+	};
+
+	for (const auto& [colorName, color] : conColors)
+	{
+		if (ci_equals(name, colorName))
 		{
-			auto lua_spawn = lua_MQTypeVar(datatypes::pSpawnType->MakeTypeVar(spawn));
-			table.add(std::move(lua_spawn));
+			filter.conColors |= 1u << color;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static LuaSpawnFilter MakeSpawnFilter(const sol::object& object, sol::this_state L)
+{
+	LuaSpawnFilter filter;
+	ClearSearchSpawn(&filter.search);
+
+	if (object.is<std::string>())
+	{
+		ParseSearchSpawn(object.as<std::string>().c_str(), &filter.search);
+		return filter;
+	}
+
+	if (!object.is<sol::table>())
+	{
+		if (object != sol::lua_nil)
+			luaL_error(L, "Spawn filter must be a search string or a table");
+
+		return filter;
+	}
 
-			spawn = spawn->GetNext();
+	sol::table table = object.as<sol::table>();
+
+	// A search string goes first so that the other fields can refine it
+	if (auto search = table.get<std::optional<std::string>>("search"))
+		ParseSearchSpawn(search->c_str(), &filter.search);
+
+	for (const auto& [key, value] : table)
+	{
+		std::string field = key.is<std::string>() ? key.as<std::string>() : std::string();
+		if (ci_equals(field, "search"))
+			continue;
+
+		if (ci_equals(field, "type") && value.is<std::string>())
+		{
+			ParseSearchSpawn(value.as<std::string>().c_str(), &filter.search);
+		}
+		else if (ci_equals(field, "radius") && value.is<double>())
+		{
+			filter.search.FRadius = value.as<double>();
+		}
+		else if (ci_equals(field, "zradius") && value.is<double>())
+		{
+			filter.search.ZRadius = value.as<double>();
+		}
+		else if (ci_equals(field, "minLevel") && value.is<double>())
+		{
+			filter.search.MinLevel = static_cast<int>(value.as<double>());
+		}
+		else if (ci_equals(field, "maxLevel") && value.is<double>())
+		{
+			filter.search.MaxLevel = static_cast<int>(value.as<double>());
+		}
+		else if (ci_equals(field, "name") && value.is<std::string>())
+		{
+			strcpy_s(filter.search.szName, value.as<std::string>().c_str());
+		}
+		else if (ci_equals(field, "exact") && value.is<bool>())
+		{
+			filter.search.bExactName = value.as<bool>();
+		}
+		else if (ci_equals(field, "conColor") && value.is<std::string>())
+		{
+			if (!AddSpawnFilterConColor(filter, value.as<std::string>()))
+				luaL_error(L, "Unknown con color in spawn filter: %s", value.as<std::string>().c_str());
+		}
+		else if (ci_equals(field, "conColor") && value.is<sol::table>())
+		{
+			for (const auto& [index, color] : value.as<sol::table>())
+			{
+				if (!color.is<std::string>() || !AddSpawnFilterConColor(filter, color.as<std::string>()))
+					luaL_error(L, "Unknown con color in spawn filter");
+			}
+		}
+		else
+		{
+			luaL_error(L, "Invalid spawn filter field: %s", field.c_str());
 		}
 	}
 
-	return table;
+	return filter;
 }
 
-static sol::table lua_getFilteredSpawns(sol::this_state L, std::optional<sol::unsafe_function> predicate)
+static PlayerClient* GetSpawnFilterOrigin()
 {
-	auto table = sol::state_view(L).create_table();
+	return pControlledPlayer ? pControlledPlayer : pLocalPlayer;
+}
+
+static sol::table lua_getAllSpawns(sol::this_state L)
+{
+	if (!pSpawnManager)
+		return sol::state_view(L).create_table();
+
+	int count = 0;
+	for (PlayerClient* spawn = pSpawnManager->FirstSpawn; spawn != nullptr; spawn = spawn->GetNext())
+		++count;
+
+	auto table = sol::state_view(L).create_table(count, 0);
 
-	if (pSpawnManager && predicate)
+	int index = 0;
+	for (PlayerClient* spawn = pSpawnManager->FirstSpawn; spawn != nullptr; spawn = spawn->GetNext())
+		table.raw_set(++index, lua_MQTypeVar(datatypes::pSpawnType->MakeTypeVar(spawn)));
+
+	return table;
+}
+
+// mq.getFilteredSpawns(predicate) calls the predicate for every spawn. mq.getFilteredSpawns(filter)
+// matches the spawns in C++ and only makes spawn objects for the matches.
+static sol::table lua_getFilteredSpawns(sol::this_state L, sol::object filterObject)
+{
+	if (filterObject.is<sol::function>())
 	{
-		auto spawn = pSpawnManager->FirstSpawn;
-		const auto& predicate_value = predicate.value();
-		while (spawn != nullptr)
+		auto table = sol::state_view(L).create_table();
+
+		if (pSpawnManager)
 		{
-			auto lua_spawn = lua_MQTypeVar(datatypes::pSpawnType->MakeTypeVar(spawn));
-			if (predicate_value(lua_spawn))
-				table.add(std::move(lua_spawn));
+			auto spawn = pSpawnManager->FirstSpawn;
+			const auto predicate_value = filterObject.as<sol::unsafe_function>();
+			while (spawn != nullptr)
+			{
+				auto lua_spawn = lua_MQTypeVar(datatypes::pSpawnType->MakeTypeVar(spawn));
+				if (predicate_value(lua_spawn))
+					table.add(std::move(lua_spawn));
 
-			spawn = spawn->GetNext();
+				spawn = spawn->GetNext();
+			}
 		}
+
+		return table;
 	}
 
+	if (filterObject == sol::lua_nil || !pSpawnManager)
+		return sol::state_view(L).create_table();
+
+	LuaSpawnFilter filter = MakeSpawnFilter(filterObject, L);
+	PlayerClient* pOrigin = GetSpawnFilterOrigin();
+
+	std::vector<PlayerClient*> matches;
+	for (PlayerClient* spawn = pSpawnManager->FirstSpawn; spawn != nullptr; spawn = spawn->GetNext())
+	{
+		if (filter.Matches(pOrigin, spawn))
+			matches.push_back(spawn);
+	}
+
+	auto table = sol::state_view(L).create_table(static_cast<int>(matches.size()), 0);
+	for (size_t i = 0; i < matches.size(); ++i)
+		table.raw_set(i + 1, lua_MQTypeVar(datatypes::pSpawnType->MakeTypeVar(matches[i])));
+
 	return table;
 }
 
+// for spawn in mq.spawns(filter) do ... end
+// Matches one spawn per step. The iterator holds spawn IDs rather than spawns, so it is safe to
+// yield inside the loop: spawns that despawn in the meantime are skipped.
+static sol::object lua_spawns(sol::this_state L, sol::object filterObject)
+{
+	struct SpawnIterator
+	{
+		LuaSpawnFilter filter;
+		std::vector<uint32_t> spawnIDs;
+		size_t next = 0;
+	};
+
+	auto iterator = std::make_shared<SpawnIterator>();
+	iterator->filter = MakeSpawnFilter(filterObject, L);
+
+	if (pSpawnManager)
+	{
+		for (PlayerClient* spawn = pSpawnManager->FirstSpawn; spawn != nullptr; spawn = spawn->GetNext())
+			iterator->spawnIDs.push_back(spawn->SpawnID);
+	}
+
+	return sol::make_object(L, [iterator](sol::this_state L) -> sol::object
+		{
+			PlayerClient* pOrigin = GetSpawnFilterOrigin();
+
+			while (pSpawnManager && iterator->next < iterator->spawnIDs.size())
+			{
+				PlayerClient* spawn = GetSpawnByID(iterator->spawnIDs[iterator->next++]);
+				if (spawn && iterator->filter.Matches(pOrigin, spawn))
+					return sol::make_object(L, lua_MQTypeVar(datatypes::pSpawnType->MakeTypeVar(spawn)));
+			}
+
+			return sol::lua_nil;
+		});
+}
+
 static sol::table lua_getAllGroundItems(sol::this_state L)
 {
 	auto table = sol::state_view(L).create_table();
@@ -159,6 +346,7 @@ void RegisterBindings_EQ(LuaThread* thread, sol::table& mq)
 	// Direct Data Bindings
 	mq.set_function("getAllSpawns", &lua_getAllSpawns);
 	mq.set_function("getFilteredSpawns", &lua_getFilteredSpawns);
+	mq.set_function("spawns", &lua_spawns);
 	mq.set_function("getAllGroundItems", &lua_getAllGroundItems);
 	mq.set_function("getFilteredGroundItems", &lua_getFilteredGroundItems);
 }
@@ -83,7 +83,7 @@ static std::string lua_Parse(sol::this_state s, const char* text)
 
 #pragma region Thread Bindings
 
-static void lua_delay(sol::object delayObj, std::optional<sol::object> conditionObj, sol::this_state s)
+static void lua_delay(sol::object delayObj, std::optional<sol::object> conditionObj, std::optional<sol::object> intervalObj, sol::this_state s)
 {
 	if (std::shared_ptr<LuaThread> thread_ptr = LuaThread::get_from(s))
 	{
@@ -105,7 +105,7 @@ static void lua_delay(sol::object delayObj, std::optional<sol::object> condition
 		if (auto co_ptr = thread_ptr->GetCurrentCoroutine())
 		{
 			const bool toggled = luaJIT_setmode(s, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_OFF) == 1;
-			co_ptr->Delay(delayObj, conditionObj, s);
+			co_ptr->Delay(delayObj, conditionObj, intervalObj, s);
 			if (toggled)
 				luaJIT_setmode(s, 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_ON);
 		}
@@ -568,9 +568,12 @@ void RegisterBindings_MQ(LuaThread* thread, sol::table& mq)
 		"MQTexture"                  , sol::no_constructor,
 		"size"                       , sol::property([](const MQTexture& mThis) -> ImVec2 { return mThis.GetTextureSize(); }),
 		"fileName"                   , sol::property(&mq::MQTexture::GetFilename),
+		"loading"                    , sol::property(&mq::MQTexture::IsLoading),
+		"valid"                      , sol::property(&mq::MQTexture::IsValid),
 		"GetTextureID"               , &mq::MQTexture::GetTextureID
 	);
 	mq.set_function("CreateTexture", [](const std::string& name) { return CreateTexturePtr(name); });
+	mq.set_function("LoadTexture", [](const std::string& name) { return LoadTexture(name); });
 }
 
 } // namespace mq::lua::bindings
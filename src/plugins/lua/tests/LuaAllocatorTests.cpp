@@ -0,0 +1,193 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "TestCheck.h"
+#include "LuaAllocator.h"
+
+#include <cstring>
+#include <string>
+
+using namespace mq::lua;
+using namespace std::chrono_literals;
+
+// What the state itself thinks it holds, which is what the allocator has to agree with.
+static size_t GetStateBytes(lua_State* L)
+{
+	return static_cast<size_t>(lua_gc(L, LUA_GCCOUNT, 0)) * 1024
+		+ static_cast<size_t>(lua_gc(L, LUA_GCCOUNTB, 0));
+}
+
+static bool Run(lua_State* L, const char* chunk)
+{
+	if (luaL_dostring(L, chunk) != 0)
+	{
+		lua_pop(L, 1);
+		return false;
+	}
+
+	return true;
+}
+
+static void TestAccounting()
+{
+	LuaAllocator allocator;
+	lua_State* L = luaL_newstate();
+	luaL_openlibs(L);
+
+	allocator.Attach(L);
+	CHECK(allocator.GetStats().liveBytes == GetStateBytes(L));
+	CHECK(allocator.GetStats().allocations == 0);
+
+	CHECK(Run(L, "t = {} for i = 1, 10000 do t[i] = tostring(i) end"));
+
+	const LuaMemoryStats grown = allocator.GetStats();
+	CHECK(grown.liveBytes == GetStateBytes(L));
+	CHECK(grown.allocations >= 10000);
+	CHECK(grown.peakBytes >= grown.liveBytes);
+	CHECK(grown.allocatedBytes >= 10000);
+
+	CHECK(Run(L, "t = nil collectgarbage()"));
+
+	// The peak doesn't come down with the live bytes. It can still go up a little, compiling
+	// the chunk above allocates before anything is collected.
+	const LuaMemoryStats collected = allocator.GetStats();
+	CHECK(collected.liveBytes == GetStateBytes(L));
+	CHECK(collected.liveBytes < grown.liveBytes);
+	CHECK(collected.peakBytes >= grown.peakBytes);
+	CHECK(collected.peakBytes < grown.peakBytes + 4096);
+	CHECK(collected.allocatedBytes >= grown.allocatedBytes);
+
+	lua_close(L);
+}
+
+// Blocks allocated before the allocator was attached are freed through it as well.
+static void TestBlocksBeforeAttach()
+{
+	LuaAllocator allocator;
+	lua_State* L = luaL_newstate();
+	luaL_openlibs(L);
+
+	CHECK(Run(L, "before = {} for i = 1, 10000 do before[i] = string.rep('x', 100) .. i end"));
+	const size_t withBlocks = GetStateBytes(L);
+
+	allocator.Attach(L);
+	CHECK(allocator.GetStats().liveBytes == withBlocks);
+
+	CHECK(Run(L, "before = nil collectgarbage()"));
+
+	// Freeing them doesn't wrap the count around, it comes down to what is left
+	const LuaMemoryStats stats = allocator.GetStats();
+	CHECK(stats.liveBytes == GetStateBytes(L));
+	CHECK(stats.liveBytes < withBlocks);
+	CHECK(stats.allocations < 10000);
+
+	lua_close(L);
+}
+
+static void TestSoftLimit()
+{
+	LuaAllocator allocator;
+	lua_State* L = luaL_newstate();
+	luaL_openlibs(L);
+	allocator.Attach(L);
+
+	allocator.SetLimits(allocator.GetStats().liveBytes + 64 * 1024, 0);
+	CHECK(allocator.CheckLimits() == LuaMemoryLimit::None);
+
+	// The soft limit never fails an allocation
+	CHECK(Run(L, "t = {} for i = 1, 20000 do t[i] = string.rep('x', 50) .. i end"));
+	CHECK(allocator.CheckLimits() == LuaMemoryLimit::Soft);
+
+	// LuaJIT only shrinks its string table on the collection after the strings were freed
+	CHECK(Run(L, "t = nil collectgarbage() collectgarbage()"));
+	CHECK(allocator.CheckLimits() == LuaMemoryLimit::None);
+
+	lua_close(L);
+}
+
+static void TestHardLimit()
+{
+	LuaAllocator allocator;
+	lua_State* L = luaL_newstate();
+	luaL_openlibs(L);
+	allocator.Attach(L);
+
+	const size_t hardLimit = allocator.GetStats().liveBytes + 256 * 1024;
+	allocator.SetLimits(0, hardLimit);
+
+	CHECK(Run(L, "small = {} for i = 1, 100 do small[i] = i end"));
+	CHECK(allocator.CheckLimits() == LuaMemoryLimit::None);
+
+	// Going over the limit raises a memory error in the script
+	CHECK(Run(L, "ok, err = pcall(function() local t = {} for i = 1, 1000000 do t[i] = string.rep('x', 50) .. i end end)"));
+
+	lua_getglobal(L, "ok");
+	CHECK(lua_isboolean(L, -1) && !lua_toboolean(L, -1));
+	lua_getglobal(L, "err");
+	const char* err = lua_tostring(L, -1);
+	CHECK(err != nullptr && std::strstr(err, "not enough memory") != nullptr);
+	lua_pop(L, 2);
+
+	CHECK(allocator.CheckLimits() == LuaMemoryLimit::Hard);
+	CHECK(allocator.GetStats().liveBytes == GetStateBytes(L));
+
+	// Only the first allocation over the limit is refused, so the state can still clean up
+	CHECK(Run(L, "after = string.rep('y', 1024 * 1024)"));
+	CHECK(allocator.GetStats().liveBytes > hardLimit);
+	CHECK(allocator.CheckLimits() == LuaMemoryLimit::Hard);
+
+	lua_close(L);
+}
+
+static void TestAllocationRate()
+{
+	LuaAllocator allocator;
+	lua_State* L = luaL_newstate();
+	luaL_openlibs(L);
+	allocator.Attach(L);
+
+	// Start a sample period at a known time
+	const LuaAllocator::clock::time_point start = LuaAllocator::clock::now() + 1s;
+	allocator.Sample(start);
+	const uint64_t startBytes = allocator.GetStats().allocatedBytes;
+
+	CHECK(Run(L, "t = {} for i = 1, 10000 do t[i] = tostring(i) end"));
+	const uint64_t allocated = allocator.GetStats().allocatedBytes - startBytes;
+	CHECK(allocated > 0);
+
+	// Nothing changes until the period has passed
+	const double before = allocator.GetStats().allocationRate;
+	allocator.Sample(start + 500ms);
+	CHECK(allocator.GetStats().allocationRate == before);
+
+	allocator.Sample(start + 2s);
+	CHECK(allocator.GetStats().allocationRate == static_cast<double>(allocated) / 2.0);
+
+	// A quiet period brings it back down
+	allocator.Sample(start + 4s);
+	CHECK(allocator.GetStats().allocationRate == 0.0);
+
+	lua_close(L);
+}
+
+int main()
+{
+	TestAccounting();
+	TestBlocksBeforeAttach();
+	TestSoftLimit();
+	TestHardLimit();
+	TestAllocationRate();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,182 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+// Times the pulse while scripts wait on mq.delay, the same mix as /lua delays bench: an even mix
+// of plain delays, conditions checked every frame, and conditions checked every 100 ms. Scripts
+// start another delay as soon as one runs out. Simulated time moves 16 ms per pulse.
+//
+// "poll" runs every script on every pulse, which is what the plugin did before scripts could
+// sleep. "sleep queue" only runs the scripts that the sleep queue wakes up. Running a script here
+// only updates its delay, so this times the scheduling and counts how often scripts would be
+// resumed, not the cost of resuming them.
+//
+//   LuaDelayBenchmark [scripts] [seconds]
+
+#include "LuaDelaySchedule.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace mq::lua;
+
+static constexpr uint64_t PULSE_TIME = 16;
+static constexpr uint64_t DELAY_TIME = 10000;
+static constexpr uint64_t CONDITION_INTERVAL = 100;
+
+struct Script
+{
+	LuaDelaySchedule delay;
+	uint64_t sleepUntil = 0;
+	int kind = 0;
+
+	uint64_t GetSleepUntil() const { return sleepUntil; }
+	void Wake() { sleepUntil = 0; }
+};
+
+struct Result
+{
+	double pulseUs = 0;
+	uint64_t resumes = 0;
+	uint64_t conditionChecks = 0;
+};
+
+static volatile uint64_t s_conditionResult = 0;
+
+static void StartDelay(Script& script, uint64_t now)
+{
+	switch (script.kind)
+	{
+	case 0: script.delay.Set(now, now + DELAY_TIME, false); break;
+	case 1: script.delay.Set(now, now + DELAY_TIME, true); break;
+	default: script.delay.Set(now, now + DELAY_TIME, true, CONDITION_INTERVAL); break;
+	}
+}
+
+// What a script does when it gets to run: the conditions never pass, so it only runs again once
+// its delay is up.
+static void RunScript(Script& script, uint64_t now, Result& result)
+{
+	++result.resumes;
+
+	switch (script.delay.Update(now))
+	{
+	case LuaDelaySchedule::Poll::Expired:
+		StartDelay(script, now);
+		break;
+
+	case LuaDelaySchedule::Poll::CheckCondition:
+		++result.conditionChecks;
+		s_conditionResult = s_conditionResult + 1;
+		break;
+
+	default:
+		break;
+	}
+}
+
+static std::vector<std::shared_ptr<Script>> CreateScripts(int count)
+{
+	std::vector<std::shared_ptr<Script>> scripts;
+	for (int i = 0; i < count; ++i)
+	{
+		auto script = std::make_shared<Script>();
+		script->kind = i % 3;
+		StartDelay(*script, 0);
+		scripts.push_back(script);
+	}
+
+	return scripts;
+}
+
+static Result RunPoll(int count, uint64_t pulses)
+{
+	std::vector<std::shared_ptr<Script>> scripts = CreateScripts(count);
+	Result result;
+
+	const auto start = std::chrono::steady_clock::now();
+	for (uint64_t pulse = 1; pulse <= pulses; ++pulse)
+	{
+		const uint64_t now = pulse * PULSE_TIME;
+		for (const std::shared_ptr<Script>& script : scripts)
+			RunScript(*script, now, result);
+	}
+
+	result.pulseUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / pulses;
+	return result;
+}
+
+static Result RunSleepQueue(int count, uint64_t pulses)
+{
+	std::vector<std::shared_ptr<Script>> scripts = CreateScripts(count);
+	LuaSleepQueue<Script> sleeping;
+	Result result;
+
+	const auto start = std::chrono::steady_clock::now();
+	for (uint64_t pulse = 1; pulse <= pulses; ++pulse)
+	{
+		const uint64_t now = pulse * PULSE_TIME;
+		sleeping.WakeDue(now);
+
+		for (const std::shared_ptr<Script>& script : scripts)
+		{
+			if (script->sleepUntil != 0)
+				continue;
+
+			RunScript(*script, now, result);
+
+			const uint64_t wakeTime = script->delay.GetWakeTime();
+			if (wakeTime > now)
+			{
+				script->sleepUntil = wakeTime;
+				sleeping.Push(wakeTime, script);
+			}
+		}
+	}
+
+	result.pulseUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / pulses;
+	return result;
+}
+
+static void Print(const char* name, const Result& result, uint64_t pulses)
+{
+	std::printf("%-12s %8.2f us per pulse, %10.1f resumes per pulse, %8llu condition checks\n",
+		name, result.pulseUs, static_cast<double>(result.resumes) / pulses,
+		static_cast<unsigned long long>(result.conditionChecks));
+}
+
+int main(int argc, char* argv[])
+{
+	const int count = argc > 1 ? std::atoi(argv[1]) : 300;
+	const int seconds = argc > 2 ? std::atoi(argv[2]) : 60;
+	const uint64_t pulses = static_cast<uint64_t>(seconds) * 1000 / PULSE_TIME;
+
+	std::printf("%d scripts, %d simulated seconds (%llu pulses)\n", count, seconds, static_cast<unsigned long long>(pulses));
+
+	const Result poll = RunPoll(count, pulses);
+	const Result queue = RunSleepQueue(count, pulses);
+
+	Print("poll", poll, pulses);
+	Print("sleep queue", queue, pulses);
+
+	// Both check the conditions the same number of times, sleeping only skips the scripts that have nothing to do
+	if (poll.conditionChecks != queue.conditionChecks)
+	{
+		std::printf("condition checks differ\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "TestCheck.h"
+#include "LuaDelaySchedule.h"
+
+using namespace mq::lua;
+
+using Poll = LuaDelaySchedule::Poll;
+
+struct FakeThread
+{
+	uint64_t sleepUntil = 0;
+
+	uint64_t GetSleepUntil() const { return sleepUntil; }
+	void Wake() { sleepUntil = 0; }
+};
+
+static void TestPlainDelay()
+{
+	LuaDelaySchedule delay;
+	CHECK(!delay.IsDelayed());
+	CHECK(delay.GetWakeTime() == 0);
+
+	// Not delayed runs right away
+	CHECK(delay.Update(1000) == Poll::Expired);
+
+	delay.Set(1000, 1500, false);
+	CHECK(delay.IsDelayed());
+	CHECK(!delay.HasCondition());
+	CHECK(delay.GetWakeTime() == 1500);
+
+	CHECK(delay.Update(1000) == Poll::Waiting);
+	CHECK(delay.Update(1499) == Poll::Waiting);
+	CHECK(delay.Update(1500) == Poll::Expired);
+	CHECK(!delay.IsDelayed());
+	CHECK(delay.GetWakeTime() == 0);
+}
+
+static void TestConditionEveryFrame()
+{
+	LuaDelaySchedule delay;
+	delay.Set(1000, 5000, true);
+	CHECK(delay.HasCondition());
+
+	// Always due, so the script never sleeps
+	CHECK(delay.GetWakeTime() == 1000);
+	CHECK(delay.Update(1016) == Poll::CheckCondition);
+	CHECK(delay.GetWakeTime() == 1016);
+	CHECK(delay.Update(1032) == Poll::CheckCondition);
+	CHECK(delay.Update(5000) == Poll::Expired);
+}
+
+static void TestConditionInterval()
+{
+	LuaDelaySchedule delay;
+	delay.Set(1000, 5000, true, 100);
+	CHECK(delay.GetWakeTime() == 1100);
+
+	CHECK(delay.Update(1016) == Poll::Skipped);
+	CHECK(delay.Update(1099) == Poll::Skipped);
+
+	// The next check is an interval after this one, not after when it was due
+	CHECK(delay.Update(1110) == Poll::CheckCondition);
+	CHECK(delay.GetWakeTime() == 1210);
+	CHECK(delay.Update(1200) == Poll::Skipped);
+	CHECK(delay.Update(1210) == Poll::CheckCondition);
+
+	// The delay running out wins over the condition
+	CHECK(delay.Update(5000) == Poll::Expired);
+}
+
+static void TestIntervalLongerThanDelay()
+{
+	LuaDelaySchedule delay;
+	delay.Set(1000, 1500, true, 10000);
+	CHECK(delay.GetWakeTime() == 1500);
+	CHECK(delay.Update(1400) == Poll::Skipped);
+	CHECK(delay.Update(1500) == Poll::Expired);
+}
+
+static void TestDropCondition()
+{
+	LuaDelaySchedule delay;
+	delay.Set(1000, 5000, true, 100);
+	delay.DropCondition();
+
+	CHECK(delay.IsDelayed());
+	CHECK(!delay.HasCondition());
+	CHECK(delay.GetWakeTime() == 5000);
+	CHECK(delay.Update(1200) == Poll::Waiting);
+	CHECK(delay.Update(5000) == Poll::Expired);
+}
+
+static void TestSleepQueueWakesInOrder()
+{
+	LuaSleepQueue<FakeThread> queue;
+	CHECK(queue.empty());
+
+	auto early = std::make_shared<FakeThread>();
+	auto late = std::make_shared<FakeThread>();
+
+	late->sleepUntil = 2000;
+	queue.Push(2000, late);
+	early->sleepUntil = 1500;
+	queue.Push(1500, early);
+	CHECK(queue.size() == 2);
+
+	CHECK(queue.WakeDue(1499) == 0);
+	CHECK(early->sleepUntil == 1500);
+
+	CHECK(queue.WakeDue(1500) == 1);
+	CHECK(early->sleepUntil == 0);
+	CHECK(late->sleepUntil == 2000);
+	CHECK(queue.size() == 1);
+
+	CHECK(queue.WakeDue(5000) == 1);
+	CHECK(late->sleepUntil == 0);
+	CHECK(queue.empty());
+}
+
+static void TestSleepQueueStaleEntries()
+{
+	LuaSleepQueue<FakeThread> queue;
+
+	// Woken early by a bind, then went back to sleep until later
+	auto rescheduled = std::make_shared<FakeThread>();
+	rescheduled->sleepUntil = 1500;
+	queue.Push(1500, rescheduled);
+	rescheduled->Wake();
+	rescheduled->sleepUntil = 3000;
+	queue.Push(3000, rescheduled);
+
+	// Stopped while it was sleeping
+	auto stopped = std::make_shared<FakeThread>();
+	stopped->sleepUntil = 1500;
+	queue.Push(1500, stopped);
+	stopped.reset();
+
+	CHECK(queue.size() == 3);
+	CHECK(queue.WakeDue(2000) == 0);
+	CHECK(rescheduled->sleepUntil == 3000);
+	CHECK(queue.size() == 1);
+
+	CHECK(queue.WakeDue(3000) == 1);
+	CHECK(rescheduled->sleepUntil == 0);
+}
+
+int main()
+{
+	TestPlainDelay();
+	TestConditionEveryFrame();
+	TestConditionInterval();
+	TestIntervalLongerThanDelay();
+	TestDropCondition();
+	TestSleepQueueWakesInOrder();
+	TestSleepQueueStaleEntries();
+
+	return TEST_RESULT();
+}
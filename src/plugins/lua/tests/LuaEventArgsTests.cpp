@@ -0,0 +1,92 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "TestCheck.h"
+#include "LuaEventArgs.h"
+
+using namespace mq::lua;
+
+static void TestSetInOrder()
+{
+	LuaEventArgs args;
+	CHECK(args.empty());
+
+	args.Set(0, "Bob tells you, 'inc'");
+	args.Set(1, "Bob");
+	args.Set(2, "inc");
+
+	const std::vector<std::string_view>& views = args.GetViews();
+	CHECK(views.size() == 3);
+	CHECK(views[0] == "Bob tells you, 'inc'");
+	CHECK(views[1] == "Bob");
+	CHECK(views[2] == "inc");
+}
+
+// Blech hands out captures in any order, and skips the ones that aren't numbered
+static void TestSetOutOfOrder()
+{
+	LuaEventArgs args;
+	args.Set(0, "line");
+	args.Set(3, "third");
+	args.Set(1, "first");
+
+	const std::vector<std::string_view>& views = args.GetViews();
+	CHECK(args.size() == 4);
+	CHECK(views[0] == "line");
+	CHECK(views[1] == "first");
+	CHECK(views[2].empty());
+	CHECK(views[3] == "third");
+}
+
+// The views still point at the right strings after the buffer has grown
+static void TestBufferGrowth()
+{
+	LuaEventArgs args;
+	const std::string big(4096, 'x');
+
+	args.Set(0, "small");
+	args.Set(1, big);
+	args.Set(2, big + "y");
+
+	const std::vector<std::string_view>& views = args.GetViews();
+	CHECK(views[0] == "small");
+	CHECK(views[1] == big);
+	CHECK(views[2] == big + "y");
+}
+
+static void TestReuse()
+{
+	LuaEventArgs args;
+	args.Set(0, "first line");
+	args.Set(2, "capture");
+
+	args.Clear();
+	CHECK(args.empty());
+	CHECK(args.GetViews().empty());
+
+	args.Set(0, "second");
+	const std::vector<std::string_view>& views = args.GetViews();
+	CHECK(views.size() == 1);
+	CHECK(views[0] == "second");
+}
+
+int main()
+{
+	TestSetInOrder();
+	TestSetOutOfOrder();
+	TestBufferGrowth();
+	TestReuse();
+
+	return TEST_RESULT();
+}
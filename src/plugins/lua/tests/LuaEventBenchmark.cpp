@@ -0,0 +1,379 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+// Feeds synthetic chat through blech and runs a lua handler for every match, the way
+// LuaEventProcessor does. Every line matches one of four events.
+//
+// "per event thread" is what the processor did before handlers were pooled: the line goes
+// through a lua global, the captures are sorted and copied into strings, and every handler gets
+// a new lua thread. "pooled" writes the captures into a pooled LuaEventArgs and reuses the
+// handler's thread once it has finished. Both use the lua C API where the plugin uses sol.
+//
+//   LuaEventBenchmark [events]
+
+#include "BlechPlatform.h"
+#include "Blech.h"
+#include "LuaAllocator.h"
+#include "LuaEventArgs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+
+using namespace mq::lua;
+
+static constexpr size_t MAX_POOLED_FUNCTIONS = 8;
+static constexpr size_t MAX_POOLED_ARGS = 32;
+
+static const char* s_eventExpressions[] = {
+	"#1# hits #2# for #3# points of damage.",
+	"#1# tells you, '#2#'",
+	"#*#has been slain by #1#!",
+	"You have gained #1# experience#*#",
+};
+
+static unsigned int CALLBACK VariableValue(char* name, char* value, size_t length)
+{
+	strcpy_s(value, length, name);
+	return static_cast<unsigned int>(std::strlen(value));
+}
+
+// The lua side of a script: its handlers, the environment its threads run in, and the table
+// that keeps its threads alive.
+struct Script
+{
+	lua_State* L = nullptr;
+	LuaAllocator allocator;
+	int handlers[4] = {};
+	int environment = LUA_NOREF;
+	int threadTable = LUA_NOREF;
+	int threadIndex = 0;
+
+	Script()
+	{
+		L = luaL_newstate();
+		luaL_openlibs(L);
+		allocator.Attach(L);
+
+		luaL_dostring(L, "handled = 0");
+		for (int& handler : handlers)
+		{
+			luaL_dostring(L, "return function(line, a, b, c) handled = handled + 1 end");
+			handler = luaL_ref(L, LUA_REGISTRYINDEX);
+		}
+
+		lua_pushvalue(L, LUA_GLOBALSINDEX);
+		environment = luaL_ref(L, LUA_REGISTRYINDEX);
+		lua_newtable(L);
+		threadTable = luaL_ref(L, LUA_REGISTRYINDEX);
+	}
+
+	~Script()
+	{
+		lua_close(L);
+	}
+
+	// LuaThread::CreateThread
+	std::pair<int, lua_State*> CreateThread()
+	{
+		lua_State* thread = lua_newthread(L);
+		lua_rawgeti(L, LUA_REGISTRYINDEX, environment);
+		lua_setfenv(L, -2);
+
+		const int index = threadIndex++;
+		lua_rawgeti(L, LUA_REGISTRYINDEX, threadTable);
+		lua_pushvalue(L, -2);
+		lua_rawseti(L, -2, index);
+		lua_pop(L, 2);
+
+		return { index, thread };
+	}
+
+	// LuaThread::RemoveThread
+	void RemoveThread(int index)
+	{
+		lua_rawgeti(L, LUA_REGISTRYINDEX, threadTable);
+		lua_pushnil(L);
+		lua_rawseti(L, -2, index);
+		lua_pop(L, 1);
+	}
+
+	int GetHandled()
+	{
+		lua_getglobal(L, "handled");
+		const int handled = static_cast<int>(lua_tointeger(L, -1));
+		lua_pop(L, 1);
+		return handled;
+	}
+};
+
+// Starts a handler on thread with args and runs it. Returns true if it finished without an error.
+template <typename Strings>
+static bool RunHandler(Script& script, lua_State* thread, int handler, const Strings& args)
+{
+	lua_rawgeti(thread, LUA_REGISTRYINDEX, handler);
+	for (const auto& arg : args)
+		lua_pushlstring(thread, arg.data(), arg.size());
+
+	const int status = lua_resume(thread, static_cast<int>(args.size()));
+	lua_settop(thread, 0);
+	return status == 0;
+}
+
+//----------------------------------------------------------------------------
+
+class PerEventThreadProcessor
+{
+public:
+	explicit PerEventThreadProcessor(Script& script)
+		: m_script(script)
+		, m_blech('#', '|', VariableValue)
+	{
+		for (int i = 0; i < 4; ++i)
+			m_blech.AddEvent(s_eventExpressions[i], Callback, &m_script.handlers[i]);
+		s_current = this;
+	}
+
+	void Process(const char* line)
+	{
+		lua_State* L = m_script.L;
+		lua_pushstring(L, line);
+		lua_setglobal(L, "_mq_event_line");
+		m_blech.Feed(line, std::strlen(line) + 1);
+		lua_pushnil(L);
+		lua_setglobal(L, "_mq_event_line");
+	}
+
+	void RunEvents()
+	{
+		for (auto& [handler, args] : m_pending)
+		{
+			auto [index, thread] = m_script.CreateThread();
+			RunHandler(m_script, thread, handler, args);
+			m_script.RemoveThread(index);
+		}
+
+		m_pending.clear();
+	}
+
+private:
+	static void CALLBACK Callback(unsigned int, void* data, BLECHVALUE* values)
+	{
+		s_current->HandleBlechEvent(*static_cast<int*>(data), values);
+	}
+
+	void HandleBlechEvent(int handler, BLECHVALUE* values)
+	{
+		std::vector<std::pair<uint32_t, std::string>> args;
+
+		lua_getglobal(m_script.L, "_mq_event_line");
+		args.emplace_back(0, lua_tostring(m_script.L, -1));
+		lua_pop(m_script.L, 1);
+
+		for (BLECHVALUE* value = values; value != nullptr; value = value->pNext)
+		{
+			const int num = std::atoi(value->Name.c_str());
+			if (num > 0)
+				args.emplace_back(num, value->Value);
+		}
+
+		std::sort(args.begin(), args.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+		std::vector<std::string> ordered(args.back().first + 1, "");
+		for (const auto& arg : args)
+			ordered[arg.first] = arg.second;
+
+		m_pending.emplace_back(handler, std::move(ordered));
+	}
+
+	static inline PerEventThreadProcessor* s_current = nullptr;
+
+	Script& m_script;
+	Blech m_blech;
+	std::vector<std::pair<int, std::vector<std::string>>> m_pending;
+};
+
+//----------------------------------------------------------------------------
+
+class PooledProcessor
+{
+public:
+	explicit PooledProcessor(Script& script)
+		: m_script(script)
+		, m_blech('#', '|', VariableValue)
+	{
+		for (int i = 0; i < 4; ++i)
+			m_blech.AddEvent(s_eventExpressions[i], Callback, &m_script.handlers[i]);
+		s_current = this;
+	}
+
+	void Process(const char* line)
+	{
+		m_currentLine = line;
+		m_blech.Feed(line, std::strlen(line) + 1);
+		m_currentLine = {};
+	}
+
+	void RunEvents()
+	{
+		for (auto& [handler, args] : m_pending)
+		{
+			std::vector<std::pair<int, lua_State*>>& pool = m_functionPool[handler];
+
+			std::pair<int, lua_State*> thread;
+			if (!pool.empty())
+			{
+				thread = pool.back();
+				pool.pop_back();
+			}
+			else
+			{
+				thread = m_script.CreateThread();
+			}
+
+			const bool ok = RunHandler(m_script, thread.second, handler, args->GetViews());
+
+			if (m_argsPool.size() < MAX_POOLED_ARGS)
+			{
+				args->Clear();
+				m_argsPool.push_back(std::move(args));
+			}
+
+			if (ok && pool.size() < MAX_POOLED_FUNCTIONS)
+				pool.push_back(thread);
+			else
+				m_script.RemoveThread(thread.first);
+		}
+
+		m_pending.clear();
+	}
+
+private:
+	static void CALLBACK Callback(unsigned int, void* data, BLECHVALUE* values)
+	{
+		s_current->HandleBlechEvent(*static_cast<int*>(data), values);
+	}
+
+	void HandleBlechEvent(int handler, BLECHVALUE* values)
+	{
+		std::unique_ptr<LuaEventArgs> args;
+		if (m_argsPool.empty())
+		{
+			args = std::make_unique<LuaEventArgs>();
+		}
+		else
+		{
+			args = std::move(m_argsPool.back());
+			m_argsPool.pop_back();
+		}
+
+		args->Set(0, m_currentLine);
+		for (BLECHVALUE* value = values; value != nullptr; value = value->pNext)
+		{
+			const int num = std::atoi(value->Name.c_str());
+			if (num > 0)
+				args->Set(num, value->Value);
+		}
+
+		m_pending.emplace_back(handler, std::move(args));
+	}
+
+	static inline PooledProcessor* s_current = nullptr;
+
+	Script& m_script;
+	Blech m_blech;
+	std::string_view m_currentLine;
+	std::map<int, std::vector<std::pair<int, lua_State*>>> m_functionPool;
+	std::vector<std::unique_ptr<LuaEventArgs>> m_argsPool;
+	std::vector<std::pair<int, std::unique_ptr<LuaEventArgs>>> m_pending;
+};
+
+//----------------------------------------------------------------------------
+
+struct Result
+{
+	double ms = 0;
+	int handled = 0;
+	uint64_t luaAllocations = 0;
+	uint64_t luaBytes = 0;
+};
+
+// Lines are processed in pulses of a hundred, and the handlers run at the end of each pulse.
+template <typename Processor>
+static Result Run(const std::vector<std::string>& lines)
+{
+	Script script;
+	Processor processor(script);
+
+	lua_gc(script.L, LUA_GCCOLLECT, 0);
+	const LuaMemoryStats before = script.allocator.GetStats();
+	const auto start = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < lines.size(); ++i)
+	{
+		processor.Process(lines[i].c_str());
+		if (i % 100 == 99 || i + 1 == lines.size())
+			processor.RunEvents();
+	}
+
+	Result result;
+	result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	result.handled = script.GetHandled();
+	result.luaAllocations = script.allocator.GetStats().allocations - before.allocations;
+	result.luaBytes = script.allocator.GetStats().allocatedBytes - before.allocatedBytes;
+	return result;
+}
+
+static void Print(const char* name, const Result& result)
+{
+	std::printf("%-18s %8.1f ms, %6.0f ns per event, %5.2f lua allocations and %6.0f lua bytes per event\n",
+		name, result.ms, result.ms * 1e6 / result.handled,
+		static_cast<double>(result.luaAllocations) / result.handled,
+		static_cast<double>(result.luaBytes) / result.handled);
+}
+
+int main(int argc, char* argv[])
+{
+	const int count = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 100000;
+
+	std::vector<std::string> lines;
+	std::mt19937 rng(1);
+
+	for (int i = 0; i < count; ++i)
+	{
+		switch (rng() % 4)
+		{
+		case 0: lines.push_back("A gnoll hits YOU for " + std::to_string(rng() % 500) + " points of damage."); break;
+		case 1: lines.push_back("Bob tells you, 'inc " + std::to_string(rng() % 50) + "'"); break;
+		case 2: lines.push_back("a gnoll pup has been slain by Bob!"); break;
+		default: lines.push_back("You have gained " + std::to_string(rng() % 1000) + " experience!"); break;
+		}
+	}
+
+	const Result perEvent = Run<PerEventThreadProcessor>(lines);
+	const Result pooled = Run<PooledProcessor>(lines);
+
+	std::printf("%d events\n", count);
+	Print("per event thread", perEvent);
+	Print("pooled", pooled);
+
+	if (perEvent.handled != count || pooled.handled != count)
+	{
+		std::printf("handled %d and %d events, expected %d\n", perEvent.handled, pooled.handled, count);
+		return 1;
+	}
+
+	return 0;
+}
@@ -330,6 +330,8 @@ PLUGIN_API void InitializePlugin()
 	// Do not use Custom, since the string isn't stored
 	MapFilterOptions[static_cast<size_t>(MapFilter::Custom)].Enabled = false;
 
+	LoadMapRules();
+
 	AddCommand("/mapfilter", MapFilters, false, true, true);
 	AddCommand("/maphide", MapHideCmd, false, true, true);
 	AddCommand("/mapshow", MapShowCmd, false, true, true);
@@ -338,6 +340,7 @@ PLUGIN_API void InitializePlugin()
 	AddCommand("/mapclick", MapClickCommand, false, true, false);
 	AddCommand("/mapactivelayer", MapActiveLayerCmd, false, true, true);
 	AddCommand("/maploc", MapSetLocationCmd, false, true, true);
+	AddCommand("/maprule", MapRuleCmd, false, true, true);
 
 	// Hook the map window
 	if (pMapViewWnd)
@@ -346,6 +349,7 @@ PLUGIN_API void InitializePlugin()
 	}
 
 	AddMQ2Data("MapSpawn", dataMapSpawn);
+	AddMQ2Data("MapRule", dataMapRule);
 	ClearSearchSpawn(&MapFilterNamed);
 	ParseSearchSpawn("#", &MapFilterNamed);
 
@@ -356,6 +360,7 @@ PLUGIN_API void InitializePlugin()
 PLUGIN_API void ShutdownPlugin()
 {
 	RemoveMQ2Data("MapSpawn");
+	RemoveMQ2Data("MapRule");
 
 	RemoveDetour(CMapViewWnd__CMapViewWnd);
 
@@ -370,6 +375,7 @@ PLUGIN_API void ShutdownPlugin()
 	RemoveCommand("/mapclick");
 	RemoveCommand("/mapactivelayer");
 	RemoveCommand("/maploc");
+	RemoveCommand("/maprule");
 
 	RemoveSettingsPanel("plugins/Map");
 }
@@ -106,6 +106,57 @@ struct MapFilterOption
 	bool IsObject() const { return Flags & Object; }
 };
 
+enum class MapRuleType
+{
+	Highlight,
+	Hide,
+};
+
+// A named spawn filter that stays active as spawns come and go. Each rule is evaluated once
+// when a spawn is added to the map and again only when one of the fields it depends on changes.
+struct MapRule
+{
+	enum Dependency {
+		DependsOnType     = 0x01,    // spawn type, master and deity (corpse type)
+		DependsOnLevel    = 0x02,
+		DependsOnName     = 0x04,
+		DependsOnGuild    = 0x08,
+		DependsOnState    = 0x10,    // LFG, trader, GM and player state flags
+		DependsOnPosition = 0x20,    // the spawn's own location
+		DependsOnWorld    = 0x40,    // anything outside the spawn: our location, group, alerts, line of sight
+	};
+
+	std::string      Name;
+	MapRuleType      Type = MapRuleType::Highlight;
+	std::string      Filter;
+	MQSpawnSearch    Search;
+	MQColor          Color;
+	uint32_t         Dependencies = 0;
+	int              Count = 0;        // number of spawns currently matching the rule
+};
+
+// Per-spawn rule state: the fields that rules depend on as of the last evaluation, and
+// which rules matched.
+struct MapRuleState
+{
+	eSpawnType       Type = NONE;
+	uint32_t         MasterID = 0;
+	int              Deity = 0;
+	int              Level = 0;
+	char             Name[EQ_MAX_NAME] = { 0 };
+	int64_t          GuildID = 0;
+	bool             LFG = false;
+	bool             Trader = false;
+	bool             GM = false;
+	uint32_t         PlayerState = 0;
+	CVector3         Position;
+
+	uint64_t         Matches = 0;      // bit per rule index
+	bool             Evaluated = false;
+};
+
+constexpr size_t MAX_MAP_RULES = 64;
+
 extern uint32_t bmMapRefresh;
 extern int activeLayer;
 extern float CampX;
@@ -139,6 +190,8 @@ extern bool repeatMaphide;
 extern std::vector<MapFilterOption*> mapFilterObjectOptions;
 extern std::vector<MapFilterOption*> mapFilterGeneralOptions;
 
+extern std::vector<MapRule> MapRules;
+
 /* COMMANDS */
 void MapFilters(PlayerClient* pChar, const char* szLine);
 void MapFilterSetting(PlayerClient* pChar, MapFilter nMapFilter, const char* szValue = nullptr);
@@ -150,6 +203,7 @@ void MapNames(PlayerClient* pChar, const char* szLine);
 void MapClickCommand(PlayerClient* pChar, const char* szLine);
 void MapActiveLayerCmd(PlayerClient* pChar, const char* szLine);
 void MapSetLocationCmd(PlayerClient* pChar, const char* szLine);
+void MapRuleCmd(PlayerClient* pChar, const char* szLine);
 char* FormatMarker(const char* szLine, char* szDest, size_t BufferSize);
 bool IsFloat(const std::string& in);
 
@@ -164,6 +218,21 @@ void MapUpdate();
 void MapAttach();
 void MapDetach();
 
+void LoadMapRules();
+void SaveMapRules();
+MapRule* FindMapRule(std::string_view name);
+bool SetMapRule(std::string_view name, MapRuleType type, const char* szFilter, MQColor color);
+bool RemoveMapRule(std::string_view name);
+void ClearMapRules();
+void ResetMapRules();
+void EvaluateMapRules(SPAWNINFO* pSpawn, MapRuleState& state);
+void ReleaseMapRuleState(MapRuleState& state);
+bool IsHiddenByMapRules(const MapRuleState& state);
+bool IsHighlightedByMapRules(const MapRuleState& state);
+MQColor GetMapRuleColor(const MapRuleState& state);
+bool HideSpawnByMapRules(SPAWNINFO* pSpawn);
+void MapRulesBenchmark(int numRules, int numObjects);
+
 void MapLocSyntaxOutput();
 void MapRemoveLocation(const char* szLine);
 
@@ -174,6 +243,7 @@ int MakeTime();
 void DrawMapSettingsPanel();
 
 bool dataMapSpawn(const char* szIndex, MQTypeVar& Ret);
+bool dataMapRule(const char* szIndex, MQTypeVar& Ret);
 
 MapObject* AddSpawn(SPAWNINFO* pNewSpawn, bool ExplicitAllow = false);
 bool RemoveSpawn(SPAWNINFO* pSpawn);
@@ -18,6 +18,7 @@
 #include <mq/Plugin.h>
 
 #include <fmt/format.h>
+#include <chrono>
 #include <sstream>
 
 extern MapObject* gpActiveMapObjects;
@@ -100,8 +101,15 @@ void RemoveMapObject(MapObject* pMapSpawn)
 	delete pMapSpawn;
 }
 
+static void ForgetHiddenSpawn(SPAWNINFO* pSpawn);
+static void HideMapObject(MapObject* pMapObject);
+static void UpdateHiddenSpawns();
+static void ClearHiddenSpawns();
+
 bool RemoveSpawn(SPAWNINFO* pSpawn)
 {
+	ForgetHiddenSpawn(pSpawn);
+
 	MapObject* pMapObject = FindMapObject(pSpawn);
 	if (pMapObject)
 	{
@@ -153,6 +161,7 @@ void MapGenerate()
 void MapClear()
 {
 	MapObjects_Clear();
+	ClearHiddenSpawns();
 
 	pLastTarget = nullptr;
 
@@ -220,12 +229,20 @@ void MapUpdate()
 			RemoveMapObject(mapObject);
 			mapObject = pNext;
 		}
+		else if (mapObject->IsHiddenByRules())
+		{
+			MapObject* pNext = mapObject->GetNext();
+			HideMapObject(mapObject);
+			mapObject = pNext;
+		}
 		else
 		{
 			mapObject = mapObject->GetNext();
 		}
 	}
 
+	UpdateHiddenSpawns();
+
 	if (IsOptionEnabled(MapFilter::CastRadius))
 	{
 		const MapFilterOption& option = GetMapFilterOption(MapFilter::CastRadius);
@@ -595,6 +612,487 @@ int MapShow(MQSpawnSearch& Search)
 	return Count;
 }
 
+//============================================================================
+// Map Rules
+
+std::vector<MapRule> MapRules;
+
+// Spawns that are currently hidden by a rule. They have no map object, so their rule
+// state is kept here to notice when the rule no longer applies.
+static std::map<SPAWNINFO*, MapRuleState> HiddenSpawns;
+
+static uint64_t MapRuleHideMask = 0;
+static uint64_t MapRuleHighlightMask = 0;
+static uint32_t MapRuleDependencies = 0;
+
+static uint32_t GetSearchDependencies(const MQSpawnSearch& search)
+{
+	// The spawn type is checked by nearly every search, including the group and corpse tests.
+	uint32_t dependencies = MapRule::DependsOnType;
+
+	if (search.MinLevel || search.MaxLevel)
+		dependencies |= MapRule::DependsOnLevel;
+	if (search.szName[0] || search.bNamed)
+		dependencies |= MapRule::DependsOnName;
+	if (search.GuildID != -1 || search.bNoGuild)
+		dependencies |= MapRule::DependsOnGuild;
+	if (search.bLFG || search.bTrader || search.bGM || search.PlayerState)
+		dependencies |= MapRule::DependsOnState;
+
+	if (search.ZRadius < 10000.0f || gZFilter < 10000.0f
+		|| (search.bKnownLocation && search.FRadius < 10000.0f))
+	{
+		dependencies |= MapRule::DependsOnPosition;
+	}
+
+	if ((!search.bKnownLocation && search.FRadius < 10000.0f)
+		|| search.Radius > 0.0f
+		|| search.bLoS
+		|| search.bLight
+		|| search.bTargetable
+		|| search.bGroup || search.bNoGroup || search.bRaid || search.bFellowship
+		|| search.bXTarHater
+		|| search.bAlert || search.bNoAlert || search.bNearAlert || search.bNotNearAlert)
+	{
+		dependencies |= MapRule::DependsOnWorld;
+	}
+
+	// Class, race, body type, spawn id and the class groupings never change for a spawn,
+	// so they are only checked when the spawn is first evaluated.
+	return dependencies;
+}
+
+static void UpdateMapRuleMasks()
+{
+	MapRuleHideMask = 0;
+	MapRuleHighlightMask = 0;
+	MapRuleDependencies = 0;
+
+	for (size_t i = 0; i < MapRules.size(); ++i)
+	{
+		const MapRule& rule = MapRules[i];
+
+		if (rule.Type == MapRuleType::Hide)
+			MapRuleHideMask |= uint64_t{ 1 } << i;
+		else
+			MapRuleHighlightMask |= uint64_t{ 1 } << i;
+
+		MapRuleDependencies |= rule.Dependencies;
+	}
+}
+
+// Takes a new snapshot of the fields rules depend on and returns the set of dependencies that changed.
+static uint32_t UpdateMapRuleSnapshot(SPAWNINFO* pSpawn, MapRuleState& state)
+{
+	uint32_t changed = MapRule::DependsOnWorld;
+
+	if (test_and_set(state.Type, GetSpawnType(pSpawn))
+		| test_and_set(state.MasterID, static_cast<uint32_t>(pSpawn->MasterID))
+		| test_and_set(state.Deity, static_cast<int>(pSpawn->Deity)))
+	{
+		changed |= MapRule::DependsOnType;
+	}
+
+	if (test_and_set(state.Level, static_cast<int>(pSpawn->Level)))
+		changed |= MapRule::DependsOnLevel;
+
+	if (strcmp(state.Name, pSpawn->Name) != 0)
+	{
+		strcpy_s(state.Name, pSpawn->Name);
+		changed |= MapRule::DependsOnName;
+	}
+
+	if (test_and_set(state.GuildID, static_cast<int64_t>(pSpawn->GuildID)))
+		changed |= MapRule::DependsOnGuild;
+
+	if (test_and_set(state.LFG, pSpawn->LFG != 0)
+		| test_and_set(state.Trader, pSpawn->Trader != 0)
+		| test_and_set(state.GM, pSpawn->GM != 0)
+		| test_and_set(state.PlayerState, static_cast<uint32_t>(pSpawn->PlayerState)))
+	{
+		changed |= MapRule::DependsOnState;
+	}
+
+	if (test_and_set(state.Position, CVector3{ pSpawn->X, pSpawn->Y, pSpawn->Z }))
+		changed |= MapRule::DependsOnPosition;
+
+	return changed;
+}
+
+void EvaluateMapRules(SPAWNINFO* pSpawn, MapRuleState& state)
+{
+	if (MapRules.empty() || !pSpawn || !pLocalPlayer)
+		return;
+
+	uint32_t changed = UpdateMapRuleSnapshot(pSpawn, state);
+	if (!state.Evaluated)
+	{
+		changed = 0xffffffff;
+		state.Evaluated = true;
+	}
+	else if (!(changed & MapRuleDependencies))
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < MapRules.size(); ++i)
+	{
+		MapRule& rule = MapRules[i];
+		if (!(rule.Dependencies & changed))
+			continue;
+
+		uint64_t bit = uint64_t{ 1 } << i;
+		bool matched = (state.Matches & bit) != 0;
+
+		if (SpawnMatchesSearch(&rule.Search, pLocalPlayer, pSpawn) != matched)
+		{
+			state.Matches ^= bit;
+			rule.Count += matched ? -1 : 1;
+		}
+	}
+}
+
+void ReleaseMapRuleState(MapRuleState& state)
+{
+	for (size_t i = 0; i < MapRules.size() && state.Matches; ++i)
+	{
+		uint64_t bit = uint64_t{ 1 } << i;
+		if (state.Matches & bit)
+		{
+			--MapRules[i].Count;
+			state.Matches &= ~bit;
+		}
+	}
+
+	state.Evaluated = false;
+}
+
+bool IsHiddenByMapRules(const MapRuleState& state)
+{
+	return (state.Matches & MapRuleHideMask) != 0;
+}
+
+bool IsHighlightedByMapRules(const MapRuleState& state)
+{
+	return (state.Matches & MapRuleHighlightMask) != 0;
+}
+
+MQColor GetMapRuleColor(const MapRuleState& state)
+{
+	// First matching highlight rule wins
+	uint64_t matches = state.Matches & MapRuleHighlightMask;
+
+	for (size_t i = 0; i < MapRules.size() && matches; ++i)
+	{
+		if (matches & (uint64_t{ 1 } << i))
+			return MapRules[i].Color;
+	}
+
+	return HighlightColor;
+}
+
+bool HideSpawnByMapRules(SPAWNINFO* pSpawn)
+{
+	if (!MapRuleHideMask)
+		return false;
+
+	auto iter = HiddenSpawns.find(pSpawn);
+	if (iter != HiddenSpawns.end())
+		return true;
+
+	MapRuleState state;
+	EvaluateMapRules(pSpawn, state);
+
+	if (IsHiddenByMapRules(state))
+	{
+		HiddenSpawns.emplace(pSpawn, state);
+		return true;
+	}
+
+	ReleaseMapRuleState(state);
+	return false;
+}
+
+static void ForgetHiddenSpawn(SPAWNINFO* pSpawn)
+{
+	auto iter = HiddenSpawns.find(pSpawn);
+	if (iter != HiddenSpawns.end())
+	{
+		ReleaseMapRuleState(iter->second);
+		HiddenSpawns.erase(iter);
+	}
+}
+
+// Moves a map object that a rule just hid into the hidden list, keeping its rule state.
+static void HideMapObject(MapObject* pMapObject)
+{
+	SPAWNINFO* pSpawn = pMapObject->GetSpawn();
+	MapRuleState* pState = pMapObject->GetRuleState();
+
+	if (pSpawn && pState)
+	{
+		HiddenSpawns.emplace(pSpawn, *pState);
+		*pState = MapRuleState();
+	}
+
+	RemoveMapObject(pMapObject);
+}
+
+// Re-checks the hidden spawns and puts back the ones that no hide rule matches anymore.
+static void UpdateHiddenSpawns()
+{
+	for (auto iter = HiddenSpawns.begin(); iter != HiddenSpawns.end();)
+	{
+		SPAWNINFO* pSpawn = iter->first;
+		MapRuleState& state = iter->second;
+
+		EvaluateMapRules(pSpawn, state);
+
+		if (!IsHiddenByMapRules(state))
+		{
+			ReleaseMapRuleState(state);
+			iter = HiddenSpawns.erase(iter);
+
+			AddSpawn(pSpawn);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+}
+
+static void ClearHiddenSpawns()
+{
+	for (auto& [pSpawn, state] : HiddenSpawns)
+		ReleaseMapRuleState(state);
+
+	HiddenSpawns.clear();
+}
+
+void ResetMapRules()
+{
+	UpdateMapRuleMasks();
+
+	std::vector<SPAWNINFO*> unhidden;
+	unhidden.reserve(HiddenSpawns.size());
+
+	for (auto& [pSpawn, state] : HiddenSpawns)
+		unhidden.push_back(pSpawn);
+
+	HiddenSpawns.clear();
+
+	for (MapRule& rule : MapRules)
+		rule.Count = 0;
+
+	// Rule indices may have moved, so everything is evaluated from scratch.
+	for (MapObject* pMapObject = gpActiveMapObjects; pMapObject; pMapObject = pMapObject->GetNext())
+	{
+		if (MapRuleState* pState = pMapObject->GetRuleState())
+		{
+			*pState = MapRuleState();
+			EvaluateMapRules(pMapObject->GetSpawn(), *pState);
+		}
+	}
+
+	for (SPAWNINFO* pSpawn : unhidden)
+		AddSpawn(pSpawn);
+}
+
+MapRule* FindMapRule(std::string_view name)
+{
+	auto iter = std::find_if(MapRules.begin(), MapRules.end(),
+		[&](const MapRule& rule) { return ci_equals(rule.Name, name); });
+
+	return iter == MapRules.end() ? nullptr : &*iter;
+}
+
+bool SetMapRule(std::string_view name, MapRuleType type, const char* szFilter, MQColor color)
+{
+	MapRule* pRule = FindMapRule(name);
+	if (!pRule)
+	{
+		if (MapRules.size() >= MAX_MAP_RULES)
+			return false;
+
+		pRule = &MapRules.emplace_back();
+		pRule->Name = name;
+	}
+
+	pRule->Type = type;
+	pRule->Filter = szFilter;
+	pRule->Color = color;
+
+	ClearSearchSpawn(&pRule->Search);
+	ParseSearchSpawn(szFilter, &pRule->Search);
+	pRule->Dependencies = GetSearchDependencies(pRule->Search);
+
+	ResetMapRules();
+	return true;
+}
+
+bool RemoveMapRule(std::string_view name)
+{
+	auto iter = std::find_if(MapRules.begin(), MapRules.end(),
+		[&](const MapRule& rule) { return ci_equals(rule.Name, name); });
+	if (iter == MapRules.end())
+		return false;
+
+	MapRules.erase(iter);
+	ResetMapRules();
+	return true;
+}
+
+void ClearMapRules()
+{
+	MapRules.clear();
+	ResetMapRules();
+}
+
+void LoadMapRules()
+{
+	MapRules.clear();
+
+	for (const auto& [name, value] : GetPrivateProfileKeyValues<MAX_STRING * 4>("Map Rules", INIFileName))
+	{
+		// <name>=<highlight|hide> <r> <g> <b> <spawn filter>
+		char szType[MAX_STRING] = { 0 };
+		int r = 0, g = 0, b = 0;
+		int offset = 0;
+
+		if (sscanf_s(value.c_str(), "%s %d %d %d %n", szType, (unsigned)sizeof(szType), &r, &g, &b, &offset) < 4)
+			continue;
+
+		MapRule& rule = MapRules.emplace_back();
+		rule.Name = name;
+		rule.Type = ci_equals(szType, "hide") ? MapRuleType::Hide : MapRuleType::Highlight;
+		rule.Filter = value.substr(offset);
+		rule.Color = MQColor(r, g, b);
+
+		ClearSearchSpawn(&rule.Search);
+		ParseSearchSpawn(rule.Filter.c_str(), &rule.Search);
+		rule.Dependencies = GetSearchDependencies(rule.Search);
+
+		if (MapRules.size() == MAX_MAP_RULES)
+			break;
+	}
+
+	ResetMapRules();
+}
+
+void SaveMapRules()
+{
+	WritePrivateProfileSection("Map Rules", "", INIFileName);
+
+	for (const MapRule& rule : MapRules)
+	{
+		WritePrivateProfileString("Map Rules", rule.Name,
+			fmt::format("{} {} {} {} {}", rule.Type == MapRuleType::Hide ? "hide" : "highlight",
+				rule.Color.Red, rule.Color.Green, rule.Color.Blue, rule.Filter), INIFileName);
+	}
+}
+
+// Runs numRules rules against numObjects map objects: once as the one-shot /highlight scan did,
+// and once through the incremental path with nothing changed since the last evaluation.
+void MapRulesBenchmark(int numRules, int numObjects)
+{
+	static const char* BenchmarkFilters[] = {
+		"npc", "pc", "npc named", "npc range 1 50", "npc range 60 125", "corpse", "pccorpse",
+		"npc merchant", "npc banker", "pet", "pcpet", "mercenary", "untargetable", "npc guard",
+		"npc orc", "pc lfg", "pc trader", "npc class warrior", "npc race gnoll", "npc radius 200",
+	};
+
+	std::vector<SPAWNINFO*> spawns;
+	for (MapObject* pMapObject = gpActiveMapObjects; pMapObject; pMapObject = pMapObject->GetNext())
+	{
+		if (SPAWNINFO* pSpawn = pMapObject->GetSpawn())
+			spawns.push_back(pSpawn);
+	}
+
+	if (spawns.empty() || !pLocalPlayer)
+	{
+		WriteChatf("MapRules benchmark needs spawns on the map");
+		return;
+	}
+
+	// Repeat the spawns on the map until we have enough objects.
+	std::vector<SPAWNINFO*> objects;
+	objects.reserve(numObjects);
+	for (int i = 0; i < numObjects; ++i)
+		objects.push_back(spawns[i % spawns.size()]);
+
+	// Swap in a temporary rule set so the live rule counts aren't touched.
+	std::vector<MapRule> savedRules = std::move(MapRules);
+	uint32_t savedDependencies = MapRuleDependencies;
+	MapRules.clear();
+	MapRuleDependencies = 0;
+
+	for (int i = 0; i < numRules; ++i)
+	{
+		MapRule& rule = MapRules.emplace_back();
+		rule.Name = fmt::format("Benchmark{}", i);
+		rule.Filter = BenchmarkFilters[i % lengthof(BenchmarkFilters)];
+
+		ClearSearchSpawn(&rule.Search);
+		ParseSearchSpawn(rule.Filter.c_str(), &rule.Search);
+		rule.Dependencies = GetSearchDependencies(rule.Search);
+		MapRuleDependencies |= rule.Dependencies;
+	}
+
+	std::vector<MapRuleState> states(objects.size());
+	int fullMatches = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (SPAWNINFO* pSpawn : objects)
+	{
+		for (MapRule& rule : MapRules)
+		{
+			if (SpawnMatchesSearch(&rule.Search, pLocalPlayer, pSpawn))
+				++fullMatches;
+		}
+	}
+	auto fullScan = std::chrono::steady_clock::now() - start;
+
+	for (size_t i = 0; i < objects.size(); ++i)
+		EvaluateMapRules(objects[i], states[i]);
+
+	start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < objects.size(); ++i)
+		EvaluateMapRules(objects[i], states[i]);
+	auto incremental = std::chrono::steady_clock::now() - start;
+
+	int worldRules = static_cast<int>(std::count_if(MapRules.begin(), MapRules.end(),
+		[](const MapRule& rule) { return (rule.Dependencies & MapRule::DependsOnWorld) != 0; }));
+
+	MapRules = std::move(savedRules);
+	MapRuleDependencies = savedDependencies;
+
+	WriteChatf("MapRules benchmark: %d rules x %d objects, %d matches", numRules, numObjects, fullMatches);
+	WriteChatf("  Full scan: \ag%.3f\ax ms", std::chrono::duration<double, std::milli>(fullScan).count());
+	WriteChatf("  Incremental (%d rules checked every update): \ag%.3f\ax ms", worldRules,
+		std::chrono::duration<double, std::milli>(incremental).count());
+}
+
+bool dataMapRule(const char* szIndex, MQTypeVar& Ret)
+{
+	// ${MapRule} is the number of rules, ${MapRule[name]} the number of spawns matching it.
+	if (!szIndex || !szIndex[0])
+	{
+		Ret.DWord = static_cast<uint32_t>(MapRules.size());
+		Ret.Type = datatypes::pIntType;
+		return true;
+	}
+
+	if (MapRule* pRule = FindMapRule(szIndex))
+	{
+		Ret.DWord = pRule->Count;
+		Ret.Type = datatypes::pIntType;
+		return true;
+	}
+
+	return false;
+}
+
 bool dataMapSpawn(const char* szIndex, MQTypeVar& Ret)
 {
 	if (MapObject* pMapSpawn = GetCurrentMapObject())
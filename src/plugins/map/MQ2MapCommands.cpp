@@ -905,6 +905,137 @@ void MapShowCmd(PlayerClient* pChar, const char* szLine)
 	}
 }
 
+// ***************************************************************************
+// Function:    MapRuleCmd
+// Description: Our '/maprule' command
+//              Manages persistent highlight and hide rules
+// Usage:       /maprule [list|add|color|remove|clear|benchmark]
+// ***************************************************************************
+static void MapRuleSyntax()
+{
+	SyntaxError("Usage: /maprule [list | add <name> highlight|hide <spawnfilter> | color <name> r g b | remove <name> | clear | benchmark [rules] [objects]]");
+}
+
+void MapRuleCmd(PlayerClient* pChar, const char* szLine)
+{
+	char szArg[MAX_STRING] = { 0 };
+	char szName[MAX_STRING] = { 0 };
+	bRunNextCommand = true;
+
+	GetArg(szArg, szLine, 1);
+
+	if (szArg[0] == 0 || !_stricmp(szArg, "list"))
+	{
+		if (MapRules.empty())
+		{
+			WriteChatf("No map rules defined");
+			return;
+		}
+
+		for (const MapRule& rule : MapRules)
+		{
+			WriteChatf("%s: \ay%s\ax [%s] color %d %d %d, \ag%d\ax matching", rule.Name.c_str(),
+				rule.Type == MapRuleType::Hide ? "hide" : "highlight", rule.Filter.c_str(),
+				rule.Color.Red, rule.Color.Green, rule.Color.Blue, rule.Count);
+		}
+		return;
+	}
+
+	if (!_stricmp(szArg, "add"))
+	{
+		char szType[MAX_STRING] = { 0 };
+		GetArg(szName, szLine, 2);
+		GetArg(szType, szLine, 3);
+		const char* szFilter = GetNextArg(szLine, 3);
+
+		if (szName[0] == 0 || (_stricmp(szType, "highlight") && _stricmp(szType, "hide")))
+		{
+			MapRuleSyntax();
+			return;
+		}
+
+		MapRule* pRule = FindMapRule(szName);
+		MQColor color = pRule ? pRule->Color : HighlightColor;
+		MapRuleType type = !_stricmp(szType, "hide") ? MapRuleType::Hide : MapRuleType::Highlight;
+
+		if (!SetMapRule(szName, type, szFilter, color))
+		{
+			WriteChatf("\arCannot add map rule %s, the limit of %d rules has been reached", szName, (int)MAX_MAP_RULES);
+			return;
+		}
+
+		SaveMapRules();
+		WriteChatf("Map rule %s: %s [%s], \ag%d\ax matching", szName, szType, szFilter, FindMapRule(szName)->Count);
+		return;
+	}
+
+	if (!_stricmp(szArg, "color"))
+	{
+		char red[MAX_STRING] = { 0 };
+		char green[MAX_STRING] = { 0 };
+		char blue[MAX_STRING] = { 0 };
+		GetArg(szName, szLine, 2);
+		GetArg(red, szLine, 3);
+		GetArg(green, szLine, 4);
+		GetArg(blue, szLine, 5);
+
+		MapRule* pRule = FindMapRule(szName);
+		if (!pRule)
+		{
+			WriteChatf("\arNo map rule named %s", szName);
+			return;
+		}
+
+		if (GetIntFromString(red, -1) < 0 || GetIntFromString(red, 256) > 255 || GetIntFromString(green, -1) < 0 || GetIntFromString(green, 256) > 255 || GetIntFromString(blue, -1) < 0 || GetIntFromString(blue, 256) > 255)
+		{
+			MapRuleSyntax();
+			return;
+		}
+
+		pRule->Color = MQColor(GetIntFromString(red, 255), GetIntFromString(green, 255), GetIntFromString(blue, 255));
+
+		SaveMapRules();
+		WriteChatf("Map rule %s color: %d %d %d", pRule->Name.c_str(), pRule->Color.Red, pRule->Color.Green, pRule->Color.Blue);
+		return;
+	}
+
+	if (!_stricmp(szArg, "remove"))
+	{
+		GetArg(szName, szLine, 2);
+
+		if (!RemoveMapRule(szName))
+		{
+			WriteChatf("\arNo map rule named %s", szName);
+			return;
+		}
+
+		SaveMapRules();
+		WriteChatf("Map rule %s removed", szName);
+		return;
+	}
+
+	if (!_stricmp(szArg, "clear"))
+	{
+		ClearMapRules();
+		SaveMapRules();
+		WriteChatf("Map rules cleared");
+		return;
+	}
+
+	if (!_stricmp(szArg, "benchmark"))
+	{
+		GetArg(szArg, szLine, 2);
+		int numRules = std::clamp(GetIntFromString(szArg, 20), 1, (int)MAX_MAP_RULES);
+		GetArg(szArg, szLine, 3);
+		int numObjects = std::max(GetIntFromString(szArg, 1000), 1);
+
+		MapRulesBenchmark(numRules, numObjects);
+		return;
+	}
+
+	MapRuleSyntax();
+}
+
 void MapNames(PlayerClient* pChar, const char* szLine)
 {
 	bRunNextCommand = true;
@@ -1933,6 +2064,74 @@ static void DrawMapSettings_MapLocs()
 	}
 }
 
+static void DrawMapSettings_Rules()
+{
+	if (MapRules.empty())
+	{
+		ImGui::TextWrapped("No map rules defined. Use /maprule add <name> highlight|hide <spawnfilter> to add one.");
+		return;
+	}
+
+	std::string removeRule;
+	bool changed = false;
+
+	if (ImGui::BeginTable("##MapRules", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingStretchProp))
+	{
+		ImGui::TableSetupColumn("Name");
+		ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_WidthFixed);
+		ImGui::TableSetupColumn("Filter");
+		ImGui::TableSetupColumn("Matching", ImGuiTableColumnFlags_WidthFixed);
+		ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed);
+		ImGui::TableHeadersRow();
+
+		for (MapRule& rule : MapRules)
+		{
+			ImGui::PushID(&rule);
+			ImGui::TableNextRow();
+
+			ImGui::TableNextColumn();
+			if (rule.Type == MapRuleType::Highlight)
+			{
+				ImColor color = rule.Color.ToImColor();
+				if (ImGui::ColorEdit3("##Color", &color.Value.x, ImGuiColorEditFlags_NoInputs))
+				{
+					rule.Color = MQColor(color);
+					rule.Color.Alpha = 255;
+					changed = true;
+				}
+				ImGui::SameLine();
+			}
+			ImGui::TextUnformatted(rule.Name.c_str());
+
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(rule.Type == MapRuleType::Hide ? "Hide" : "Highlight");
+
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(rule.Filter.c_str());
+
+			ImGui::TableNextColumn();
+			ImGui::Text("%d", rule.Count);
+
+			ImGui::TableNextColumn();
+			if (ImGui::SmallButton("Remove"))
+				removeRule = rule.Name;
+
+			ImGui::PopID();
+		}
+
+		ImGui::EndTable();
+	}
+
+	if (!removeRule.empty())
+	{
+		RemoveMapRule(removeRule);
+		changed = true;
+	}
+
+	if (changed)
+		SaveMapRules();
+}
+
 void DrawMapSettingsPanel()
 {
 	if (ImGui::BeginTabBar("MQ2Map TabBar", ImGuiTabBarFlags_NoCloseWithMiddleMouseButton))
@@ -1961,6 +2160,14 @@ void DrawMapSettingsPanel()
 			ImGui::EndTabItem();
 		}
 
+		if (ImGui::BeginTabItem("Rules"))
+		{
+			ImGui::BeginChild("RulesChild", ImVec2(ImGui::GetContentRegionAvail().x, ImGui::GetContentRegionAvail().y));
+			DrawMapSettings_Rules();
+			ImGui::EndChild();
+			ImGui::EndTabItem();
+		}
+
 		ImGui::EndTabBar();
 	}
 }
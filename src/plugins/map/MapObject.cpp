@@ -525,6 +525,7 @@ MapObjectSpawn::MapObjectSpawn(SPAWNINFO* pSpawn, bool Explicit)
 MapObjectSpawn::~MapObjectSpawn()
 {
 	SpawnMap.erase(m_spawn);
+	ReleaseMapRuleState(m_rules);
 
 	if (pLastTarget == this)
 		pLastTarget = nullptr;
@@ -548,6 +549,8 @@ void MapObjectSpawn::Update(bool forced)
 
 	changed |= test_and_set(m_type, GetSpawnType(m_spawn));
 
+	EvaluateMapRules(m_spawn, m_rules);
+
 	m_pos.X = m_spawn->X;
 	m_pos.Y = m_spawn->Y;
 	m_pos.Z = m_spawn->Z;
@@ -580,6 +583,11 @@ MQColor MapObjectSpawn::GetSpawnColor() const
 		return MQColor();
 	}
 
+	if (IsHighlightedByMapRules(m_rules))
+	{
+		return GetMapRuleColor(m_rules);
+	}
+
 	// TODO: Maybe this switch can partially be de-duplicated from GetMapFilter()
 
 	switch (m_type)
@@ -798,6 +806,11 @@ bool MapObjectSpawn::CanDisplayObject() const
 	return CanDisplaySpawnObject(m_type, m_spawn);
 }
 
+bool MapObjectSpawn::IsHiddenByRules() const
+{
+	return !m_explicit && IsHiddenByMapRules(m_rules);
+}
+
 #pragma region Vectors
 
 void MapObjectSpawn::GenerateVector()
@@ -922,6 +935,9 @@ MapObject* MakeMapObject(SPAWNINFO* pSpawn, bool Explicit)
 	if (!Explicit && !CanDisplaySpawnObject(GetSpawnType(pSpawn), pSpawn))
 		return nullptr;
 
+	if (!Explicit && HideSpawnByMapRules(pSpawn))
+		return nullptr;
+
 	MapObject* obj = new MapObjectSpawn(pSpawn, Explicit);
 	obj->PostInit();
 
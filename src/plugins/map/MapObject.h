@@ -49,6 +49,9 @@ public:
 	virtual SPAWNINFO* GetSpawn() const { return nullptr; }
 	virtual GROUNDITEM* GetGroundItem() const { return nullptr; }
 
+	virtual MapRuleState* GetRuleState() { return nullptr; }
+	virtual bool IsHiddenByRules() const { return false; }
+
 protected:
 	virtual void HandleFormatSpecifier(char spec, CXStr& output);
 
@@ -97,6 +100,9 @@ public:
 	virtual bool CanDisplayObject() const override;
 	virtual SPAWNINFO* GetSpawn() const { return m_spawn; }
 
+	virtual MapRuleState* GetRuleState() override { return &m_rules; }
+	virtual bool IsHiddenByRules() const override;
+
 	MQColor GetSpawnColor() const;
 
 private:
@@ -112,6 +118,7 @@ private:
 	SPAWNINFO* m_spawn = nullptr;
 	eSpawnType m_type = NONE;
 	bool       m_explicit = false;
+	MapRuleState m_rules;
 };
 
 //============================================================================
@@ -0,0 +1,191 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "MessageTracer.h"
+
+#include <windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+
+namespace mq::postoffice {
+
+const char* GetTraceRouteName(TraceRoute route)
+{
+	switch (route)
+	{
+	case TraceRoute::ClientToLauncher: return "client_launcher";
+	case TraceRoute::LauncherToClient: return "launcher_client";
+	case TraceRoute::InProcess: return "in_process";
+	case TraceRoute::Mailbox: return "mailbox";
+	case TraceRoute::Total: return "total";
+	default: return "unknown";
+	}
+}
+
+void LatencyHistogram::Add(uint64_t microseconds)
+{
+	size_t bucket = 0;
+	while (bucket < BucketCount - 1 && (uint64_t(1) << bucket) <= microseconds)
+		++bucket;
+
+	++m_buckets[bucket];
+
+	m_min = m_count ? std::min(m_min, microseconds) : microseconds;
+	m_max = std::max(m_max, microseconds);
+	m_total += microseconds;
+	++m_count;
+}
+
+void LatencyHistogram::Clear()
+{
+	*this = LatencyHistogram();
+}
+
+uint64_t LatencyHistogram::GetPercentile(double percentile) const
+{
+	if (m_count == 0)
+		return 0;
+
+	uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * m_count));
+	uint64_t seen = 0;
+
+	for (size_t bucket = 0; bucket < BucketCount; ++bucket)
+	{
+		seen += m_buckets[bucket];
+		if (seen >= rank && seen > 0)
+		{
+			// the last bucket has no upper bound of its own
+			if (bucket == BucketCount - 1)
+				return m_max;
+
+			return std::min(m_max, uint64_t(1) << bucket);
+		}
+	}
+
+	return m_max;
+}
+
+bool MessageTracer::Start(proto::routing::Envelope& envelope, bool force)
+{
+	if (envelope.has_trace())
+		return true;
+
+	if (!m_enabled && !force)
+		return false;
+
+	proto::routing::Trace& trace = *envelope.mutable_trace();
+	trace.set_id((static_cast<uint64_t>(GetCurrentProcessId()) << 32) | ++m_nextId);
+	return true;
+}
+
+void MessageTracer::AddHop(proto::routing::Trace& trace, proto::routing::TraceStage stage)
+{
+	auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::system_clock::now().time_since_epoch());
+
+	proto::routing::TraceHop& hop = *trace.add_hops();
+	hop.set_pid(GetCurrentProcessId());
+	hop.set_stage(stage);
+	hop.set_timestamp(now.count());
+}
+
+void MessageTracer::Complete(const proto::routing::Trace& trace)
+{
+	++m_completed;
+
+	const auto& hops = trace.hops();
+	for (int i = 1; i < hops.size(); ++i)
+	{
+		const proto::routing::TraceHop& from = hops[i - 1];
+		const proto::routing::TraceHop& to = hops[i];
+
+		TraceRoute route;
+		switch (to.stage())
+		{
+		case proto::routing::TraceStage::Forwarded:
+			route = from.pid() == to.pid() ? TraceRoute::InProcess : TraceRoute::ClientToLauncher;
+			break;
+		case proto::routing::TraceStage::Delivered:
+			route = from.pid() == to.pid() ? TraceRoute::InProcess : TraceRoute::LauncherToClient;
+			break;
+		case proto::routing::TraceStage::Received:
+			route = TraceRoute::Mailbox;
+			break;
+		default:
+			continue;
+		}
+
+		// the clocks of different processes on the same machine agree, but don't trust them with a negative time
+		m_histograms[static_cast<size_t>(route)].Add(
+			to.timestamp() > from.timestamp() ? to.timestamp() - from.timestamp() : 0);
+	}
+
+	if (hops.size() > 1)
+	{
+		uint64_t first = hops[0].timestamp();
+		uint64_t last = hops[hops.size() - 1].timestamp();
+		m_histograms[static_cast<size_t>(TraceRoute::Total)].Add(last > first ? last - first : 0);
+	}
+
+	AddRecent(trace, 0);
+}
+
+void MessageTracer::Drop(const proto::routing::Envelope& envelope, int status)
+{
+	++m_dropped;
+
+	if (envelope.has_trace())
+		AddRecent(envelope.trace(), status);
+}
+
+void MessageTracer::Clear()
+{
+	m_completed = 0;
+	m_dropped = 0;
+	m_recent.clear();
+
+	for (LatencyHistogram& histogram : m_histograms)
+		histogram.Clear();
+}
+
+void MessageTracer::AddRecent(const proto::routing::Trace& trace, int status)
+{
+	if (m_recent.size() >= MaxRecentTraces)
+		m_recent.pop_front();
+
+	m_recent.push_back({ trace, status });
+}
+
+std::string FormatTraceCsv(const CompletedTrace& trace)
+{
+	std::string rows;
+	char row[256];
+
+	const auto& hops = trace.Trace.hops();
+	for (int i = 0; i < hops.size(); ++i)
+	{
+		snprintf(row, sizeof(row), "%016" PRIx64 ",%d,%d,%u,%s,%" PRIu64 ",%.3f\n", trace.Trace.id(), trace.Status, i,
+			hops[i].pid(), proto::routing::TraceStage_Name(hops[i].stage()).c_str(), hops[i].timestamp(),
+			static_cast<int64_t>(hops[i].timestamp() - hops[0].timestamp()) / 1000.0);
+		rows += row;
+	}
+
+	return rows;
+}
+
+} // namespace mq::postoffice
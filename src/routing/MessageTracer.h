@@ -0,0 +1,166 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+#include "Routing.pb.h"
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+namespace mq::postoffice {
+
+/**
+ * The legs of a route that traced messages are measured over
+ */
+enum class TraceRoute
+{
+	ClientToLauncher,   // from the sender's post office to the launcher
+	LauncherToClient,   // from the launcher to the destination mailbox
+	InProcess,          // from the sender's post office to a mailbox in the same process
+	Mailbox,            // waiting in the destination mailbox
+	Total,              // from the first hop to the last
+
+	Count
+};
+
+/**
+ * Gets the name of a trace route, as used by commands and exports
+ *
+ * @param route the route
+ * @return the name of the route
+ */
+const char* GetTraceRouteName(TraceRoute route);
+
+/**
+ * A latency histogram with power of two buckets, in microseconds
+ */
+class LatencyHistogram
+{
+public:
+	static constexpr size_t BucketCount = 24; // the last bucket holds everything over ~8 seconds
+
+	void Add(uint64_t microseconds);
+	void Clear();
+
+	uint64_t GetCount() const { return m_count; }
+	uint64_t GetMin() const { return m_count ? m_min : 0; }
+	uint64_t GetMax() const { return m_max; }
+	double GetAverage() const { return m_count ? static_cast<double>(m_total) / m_count : 0.0; }
+
+	/**
+	 * Estimates a percentile from the buckets
+	 *
+	 * @param percentile the percentile to estimate, from 0 to 100
+	 * @return the upper bound of the bucket that holds the percentile, in microseconds
+	 */
+	uint64_t GetPercentile(double percentile) const;
+
+	const std::array<uint64_t, BucketCount>& GetBuckets() const { return m_buckets; }
+
+private:
+	std::array<uint64_t, BucketCount> m_buckets{};
+	uint64_t m_count = 0;
+	uint64_t m_total = 0;
+	uint64_t m_min = 0;
+	uint64_t m_max = 0;
+};
+
+struct CompletedTrace
+{
+	proto::routing::Trace Trace;
+	int Status = 0; // 0 if the message was received, otherwise the routing error that dropped it
+};
+
+/**
+ * The header row of the CSV that FormatTraceCsv writes the rows for
+ */
+inline constexpr const char* TraceCsvHeader = "TraceId,Status,Hop,PID,Stage,Timestamp,ElapsedMS\n";
+
+/**
+ * Formats a trace as CSV, one row per hop. Elapsed times are from the first hop.
+ *
+ * @param trace the trace to format
+ * @return the rows, each ending in a newline
+ */
+std::string FormatTraceCsv(const CompletedTrace& trace);
+
+/**
+ * Stamps hops on traced messages and aggregates the latency of each route
+ *
+ * A trace is started by the sender's post office when tracing is enabled there. Every post office
+ * the message passes through adds a hop whether it is tracing or not, and the destination post
+ * office aggregates the trace once the message is handed to its actor.
+ */
+class MessageTracer
+{
+public:
+	static constexpr size_t MaxRecentTraces = 1000;
+
+	void SetEnabled(bool enabled) { m_enabled = enabled; }
+	bool IsEnabled() const { return m_enabled; }
+
+	/**
+	 * Starts a trace on an outgoing envelope if tracing is enabled and the envelope isn't traced yet
+	 *
+	 * @param envelope the envelope being routed
+	 * @param force start the trace even if tracing is disabled
+	 * @return true if the envelope is traced
+	 */
+	bool Start(proto::routing::Envelope& envelope, bool force = false);
+
+	/**
+	 * Adds a hop to a trace, stamped with this process and the current time
+	 *
+	 * @param trace the trace to add the hop to
+	 * @param stage the stage the message has reached
+	 */
+	static void AddHop(proto::routing::Trace& trace, proto::routing::TraceStage stage);
+
+	/**
+	 * Aggregates the trace of a message that was handed to its actor
+	 *
+	 * @param trace the completed trace
+	 */
+	void Complete(const proto::routing::Trace& trace);
+
+	/**
+	 * Counts a message that could not be routed, and keeps its trace if it has one
+	 *
+	 * @param envelope the envelope of the dropped message
+	 * @param status the routing error
+	 */
+	void Drop(const proto::routing::Envelope& envelope, int status);
+
+	const LatencyHistogram& GetHistogram(TraceRoute route) const { return m_histograms[static_cast<size_t>(route)]; }
+	uint64_t GetCompleted() const { return m_completed; }
+	uint64_t GetDropped() const { return m_dropped; }
+	const std::deque<CompletedTrace>& GetRecentTraces() const { return m_recent; }
+
+	void Clear();
+
+private:
+	void AddRecent(const proto::routing::Trace& trace, int status);
+
+	bool m_enabled = false;
+	uint32_t m_nextId = 0;
+	uint64_t m_completed = 0;
+	uint64_t m_dropped = 0;
+	std::array<LatencyHistogram, static_cast<size_t>(TraceRoute::Count)> m_histograms;
+	std::deque<CompletedTrace> m_recent;
+};
+
+} // namespace mq::postoffice
@@ -30,6 +30,13 @@ void Mailbox::Process(size_t howMany) const
 {
 	if (howMany > 0 && !m_receiveQueue.empty())
 	{
+		auto& trace = m_receiveQueue.front()->GetTrace();
+		if (trace && m_tracer != nullptr)
+		{
+			MessageTracer::AddHop(*trace, proto::routing::TraceStage::Received);
+			m_tracer->Complete(*trace);
+		}
+
 		m_receive(std::move(m_receiveQueue.front()));
 		m_receiveQueue.pop();
 
@@ -57,6 +64,12 @@ ProtoMessagePtr Mailbox::Open(proto::routing::Envelope&& envelope, const PipeMes
 	if (envelope.has_return_address())
 		unwrapped->SetSender(envelope.return_address());
 
+	if (envelope.has_trace())
+	{
+		MessageTracer::AddHop(*envelope.mutable_trace(), proto::routing::TraceStage::Delivered);
+		unwrapped->SetTrace(envelope.trace());
+	}
+
 	return unwrapped;
 }
 
@@ -110,7 +123,7 @@ void PostOffice::RouteMessage(const std::string& data, const PipeMessageResponse
 
 Dropbox PostOffice::RegisterAddress(const std::string& localAddress, ReceiveCallback&& receive)
 {
-	auto [mailbox, added] = m_mailboxes.emplace(localAddress, std::make_unique<Mailbox>(localAddress, std::move(receive)));
+	auto [mailbox, added] = m_mailboxes.emplace(localAddress, std::make_unique<Mailbox>(localAddress, std::move(receive), &m_tracer));
 	if (added)
 	{
 		return Dropbox(
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include "MessageTracer.h"
 #include "Routing.h"
 
 #include <string>
@@ -30,9 +31,10 @@ using DropboxDropper = std::function<void(const std::string&)>;
 class Mailbox
 {
 public:
-	Mailbox(std::string localAddress, ReceiveCallback&& receive)
+	Mailbox(std::string localAddress, ReceiveCallback&& receive, MessageTracer* tracer = nullptr)
 		: m_localAddress(localAddress)
 		, m_receive(std::move(receive))
+		, m_tracer(tracer)
 	{}
 
 	~Mailbox() {}
@@ -63,6 +65,7 @@ private:
 
 	const std::string m_localAddress;
 	const ReceiveCallback m_receive;
+	MessageTracer* m_tracer;
 
 	mutable std::queue<ProtoMessagePtr> m_receiveQueue;
 };
@@ -336,8 +339,16 @@ public:
 	 */
 	void Process(size_t howMany);
 
+	/**
+	 * Gets the tracer that stamps and aggregates traced messages in this post office
+	 *
+	 * @return the message tracer
+	 */
+	MessageTracer& GetTracer() { return m_tracer; }
+
 protected:
 	std::unordered_map<std::string, std::unique_ptr<Mailbox>> m_mailboxes;
+	MessageTracer m_tracer;
 };
 
 /**
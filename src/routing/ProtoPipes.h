@@ -60,8 +60,12 @@ public:
 	const std::optional<proto::routing::Address>& GetSender() { return m_returnAddress; }
 	void SetSender(const proto::routing::Address& address) { m_returnAddress = address; }
 
+	std::optional<proto::routing::Trace>& GetTrace() { return m_trace; }
+	void SetTrace(const proto::routing::Trace& trace) { m_trace = trace; }
+
 private:
 	std::optional<proto::routing::Address> m_returnAddress;
+	std::optional<proto::routing::Trace> m_trace;
 };
 using ProtoMessagePtr = std::unique_ptr<ProtoMessage>;
 
@@ -0,0 +1,241 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "MessageTracer.h"
+
+#include "TestCheck.h"
+
+#include <windows.h>
+
+#include <chrono>
+
+using namespace mq;
+using namespace mq::postoffice;
+using proto::routing::TraceStage;
+
+static void AddHop(proto::routing::Trace& trace, uint32_t pid, TraceStage stage, uint64_t timestamp)
+{
+	proto::routing::TraceHop& hop = *trace.add_hops();
+	hop.set_pid(pid);
+	hop.set_stage(stage);
+	hop.set_timestamp(timestamp);
+}
+
+static void TestHistogram()
+{
+	LatencyHistogram histogram;
+	CHECK(histogram.GetCount() == 0);
+	CHECK(histogram.GetMin() == 0);
+	CHECK(histogram.GetPercentile(50) == 0);
+
+	for (uint64_t microseconds : { 0, 1, 2, 3, 1000 })
+		histogram.Add(microseconds);
+
+	CHECK(histogram.GetCount() == 5);
+	CHECK(histogram.GetMin() == 0);
+	CHECK(histogram.GetMax() == 1000);
+	CHECK(histogram.GetAverage() == 201.2);
+
+	// Bucket n holds values below 2^n.
+	const auto& buckets = histogram.GetBuckets();
+	CHECK(buckets[0] == 1);
+	CHECK(buckets[1] == 1);
+	CHECK(buckets[2] == 2);
+	CHECK(buckets[10] == 1);
+
+	CHECK(histogram.GetPercentile(50) == 4);
+	CHECK(histogram.GetPercentile(80) == 4);
+	CHECK(histogram.GetPercentile(100) == 1000); // capped at the largest value seen
+
+	// Anything too large for the buckets goes in the last one.
+	histogram.Add(uint64_t(1) << 40);
+	CHECK(buckets[LatencyHistogram::BucketCount - 1] == 1);
+	CHECK(histogram.GetPercentile(100) == uint64_t(1) << 40);
+
+	histogram.Clear();
+	CHECK(histogram.GetCount() == 0);
+	CHECK(histogram.GetMax() == 0);
+	CHECK(buckets[2] == 0);
+}
+
+static void TestStart()
+{
+	MessageTracer tracer;
+	proto::routing::Envelope envelope;
+
+	CHECK(!tracer.Start(envelope));
+	CHECK(!envelope.has_trace());
+
+	CHECK(tracer.Start(envelope, true));
+	CHECK(envelope.has_trace());
+	uint64_t id = envelope.trace().id();
+	CHECK(id >> 32 == GetCurrentProcessId());
+
+	// An envelope that is already traced keeps its trace.
+	CHECK(tracer.Start(envelope));
+	CHECK(envelope.trace().id() == id);
+
+	tracer.SetEnabled(true);
+	proto::routing::Envelope other;
+	CHECK(tracer.Start(other));
+	CHECK(other.trace().id() == id + 1);
+}
+
+static void TestAddHop()
+{
+	proto::routing::Trace trace;
+
+	auto before = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	MessageTracer::AddHop(trace, TraceStage::Routed);
+	MessageTracer::AddHop(trace, TraceStage::Delivered);
+
+	CHECK(trace.hops_size() == 2);
+	CHECK(trace.hops(0).pid() == GetCurrentProcessId());
+	CHECK(trace.hops(0).stage() == TraceStage::Routed);
+	CHECK(trace.hops(1).stage() == TraceStage::Delivered);
+	CHECK(trace.hops(0).timestamp() >= static_cast<uint64_t>(before));
+	CHECK(trace.hops(1).timestamp() >= trace.hops(0).timestamp());
+}
+
+static void TestCompleteRoutes()
+{
+	MessageTracer tracer;
+
+	// client -> launcher -> client
+	proto::routing::Trace piped;
+	AddHop(piped, 100, TraceStage::Routed, 1000);
+	AddHop(piped, 200, TraceStage::Forwarded, 1500);
+	AddHop(piped, 300, TraceStage::Delivered, 2500);
+	AddHop(piped, 300, TraceStage::Received, 2600);
+	tracer.Complete(piped);
+
+	// within one client
+	proto::routing::Trace local;
+	AddHop(local, 100, TraceStage::Routed, 5000);
+	AddHop(local, 100, TraceStage::Delivered, 5040);
+	AddHop(local, 100, TraceStage::Received, 5050);
+	tracer.Complete(local);
+
+	// a clock that went backwards counts as no time
+	proto::routing::Trace skewed;
+	AddHop(skewed, 100, TraceStage::Routed, 9000);
+	AddHop(skewed, 200, TraceStage::Forwarded, 8000);
+	tracer.Complete(skewed);
+
+	CHECK(tracer.GetCompleted() == 3);
+
+	const LatencyHistogram& toLauncher = tracer.GetHistogram(TraceRoute::ClientToLauncher);
+	CHECK(toLauncher.GetCount() == 2);
+	CHECK(toLauncher.GetMin() == 0);
+	CHECK(toLauncher.GetMax() == 500);
+
+	const LatencyHistogram& toClient = tracer.GetHistogram(TraceRoute::LauncherToClient);
+	CHECK(toClient.GetCount() == 1);
+	CHECK(toClient.GetMax() == 1000);
+
+	const LatencyHistogram& inProcess = tracer.GetHistogram(TraceRoute::InProcess);
+	CHECK(inProcess.GetCount() == 1);
+	CHECK(inProcess.GetMax() == 40);
+
+	const LatencyHistogram& mailbox = tracer.GetHistogram(TraceRoute::Mailbox);
+	CHECK(mailbox.GetCount() == 2);
+	CHECK(mailbox.GetMin() == 10);
+	CHECK(mailbox.GetMax() == 100);
+
+	const LatencyHistogram& total = tracer.GetHistogram(TraceRoute::Total);
+	CHECK(total.GetCount() == 3);
+	CHECK(total.GetMin() == 0);
+	CHECK(total.GetMax() == 1600);
+
+	CHECK(std::string(GetTraceRouteName(TraceRoute::ClientToLauncher)) == "client_launcher");
+	CHECK(std::string(GetTraceRouteName(TraceRoute::Total)) == "total");
+}
+
+static void TestRecentTraces()
+{
+	MessageTracer tracer;
+
+	for (uint64_t id = 1; id <= MessageTracer::MaxRecentTraces + 5; ++id)
+	{
+		proto::routing::Trace trace;
+		trace.set_id(id);
+		tracer.Complete(trace);
+	}
+
+	// Only the most recent traces are kept.
+	const auto& recent = tracer.GetRecentTraces();
+	CHECK(recent.size() == MessageTracer::MaxRecentTraces);
+	CHECK(recent.front().Trace.id() == 6);
+	CHECK(recent.back().Trace.id() == MessageTracer::MaxRecentTraces + 5);
+	CHECK(recent.back().Status == 0);
+
+	// Dropped messages are counted, and kept if they were traced.
+	proto::routing::Envelope untraced;
+	tracer.Drop(untraced, 2);
+	CHECK(tracer.GetDropped() == 1);
+	CHECK(recent.back().Trace.id() == MessageTracer::MaxRecentTraces + 5);
+
+	proto::routing::Envelope traced;
+	traced.mutable_trace()->set_id(42);
+	tracer.Drop(traced, 3);
+	CHECK(tracer.GetDropped() == 2);
+	CHECK(recent.size() == MessageTracer::MaxRecentTraces);
+	CHECK(recent.back().Trace.id() == 42);
+	CHECK(recent.back().Status == 3);
+
+	tracer.Clear();
+	CHECK(tracer.GetCompleted() == 0);
+	CHECK(tracer.GetDropped() == 0);
+	CHECK(recent.empty());
+}
+
+static void TestFormatCsv()
+{
+	CompletedTrace trace;
+	trace.Trace.set_id(0x1234'0000'00abull);
+	trace.Status = 3;
+	AddHop(trace.Trace, 100, TraceStage::Routed, 1700000000000000);
+	AddHop(trace.Trace, 200, TraceStage::Forwarded, 1700000000000500);
+	AddHop(trace.Trace, 300, TraceStage::Received, 1700000000001600);
+
+	CHECK(FormatTraceCsv(trace) ==
+		"00001234000000ab,3,0,100,Routed,1700000000000000,0.000\n"
+		"00001234000000ab,3,1,200,Forwarded,1700000000000500,0.500\n"
+		"00001234000000ab,3,2,300,Received,1700000000001600,1.600\n");
+
+	// A hop stamped by a clock behind the first one shows a negative time.
+	CompletedTrace skewed;
+	skewed.Trace.set_id(1);
+	AddHop(skewed.Trace, 100, TraceStage::Routed, 2000);
+	AddHop(skewed.Trace, 200, TraceStage::Forwarded, 1750);
+	CHECK(FormatTraceCsv(skewed) ==
+		"0000000000000001,0,0,100,Routed,2000,0.000\n"
+		"0000000000000001,0,1,200,Forwarded,1750,-0.250\n");
+
+	CHECK(FormatTraceCsv(CompletedTrace()).empty());
+	CHECK(std::string(TraceCsvHeader) == "TraceId,Status,Hop,PID,Stage,Timestamp,ElapsedMS\n");
+}
+
+int main()
+{
+	TestHistogram();
+	TestStart();
+	TestAddHop();
+	TestCompleteRoutes();
+	TestRecentTraces();
+	TestFormatCsv();
+
+	return TEST_RESULT();
+}
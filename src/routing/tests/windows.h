@@ -0,0 +1,26 @@
+/*
+ * MacroQuest: The extension platform for EverQuest
+ * Copyright (C) 2002-present MacroQuest Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as published by
+ * the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#pragma once
+
+// Stands in for windows.h in routing sources that are built into the tests.
+
+#include <cstdint>
+
+#include <unistd.h>
+
+inline uint32_t GetCurrentProcessId()
+{
+	return static_cast<uint32_t>(getpid());
+}
@@ -206,6 +206,9 @@ PLUGIN_API bool OnIncomingChat(const char* Line, DWORD Color)
  * When zoning, this is called for all spawns in the zone after @ref OnEndZone is
  * called and before @ref OnZoned is called.
  *
+ * A plugin that exports OnAddSpawns(PlayerClient* const* spawns, int count) gets
+ * the spawns added while zoning as a single batch through it instead.
+ *
  * @param pNewSpawn PSPAWNINFO - The spawn that was added
  */
 PLUGIN_API void OnAddSpawn(PSPAWNINFO pNewSpawn)
@@ -222,6 +225,9 @@ PLUGIN_API void OnAddSpawn(PSPAWNINFO pNewSpawn)
  * When zoning, this is called for all spawns in the zone after @ref OnBeginZone is
  * called.
  *
+ * A plugin that exports OnRemoveSpawns(PlayerClient* const* spawns, int count) gets
+ * the spawns removed at once as a single batch through it instead.
+ *
  * @param pSpawn PSPAWNINFO - The spawn that was removed
  */
 PLUGIN_API void OnRemoveSpawn(PSPAWNINFO pSpawn)